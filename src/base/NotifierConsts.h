@@ -52,7 +52,7 @@ enum
     NF_L2_Q_DROP,
     NF_MAC_BECAME_IDLE,
     NF_L2_BEACON_LOST,   // missed several consecutive beacons (currently Ieee80211)
-    NF_L2_ASSOCIATED,    // successfully associated with an AP (currently Ieee80211)
+    NF_L2_ASSOCIATED,    // successfully associated with an AP (currently Ieee80211); detail: Ieee80211Prim_BSSDescription
 
     // - layer 3 (network)
     NF_INTERFACE_CREATED,
@@ -0,0 +1,105 @@
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef __INET_POOLEDALLOCATOR_H
+#define __INET_POOLEDALLOCATOR_H
+
+#include <new>
+#include <cstddef>
+#include "INETDefs.h"
+
+
+/**
+ * STL allocator that recycles single-object allocations, for node based
+ * containers (std::map, std::set, std::list) whose elements are inserted
+ * and erased at a high rate.
+ *
+ * Freed nodes are put on a free list (one per node type, shared by all
+ * containers using it) instead of being returned to the heap, and are
+ * handed out again on the next allocation. The free list is never
+ * shrunk, i.e. memory is kept at the high-water mark of the number of
+ * nodes in use. Allocations of more than one object (which node based
+ * containers don't make) go to the heap directly.
+ *
+ * Not thread-safe, which is fine for the simulation kernel.
+ */
+template <class T>
+class PooledAllocator
+{
+  public:
+    typedef T value_type;
+    typedef T *pointer;
+    typedef const T *const_pointer;
+    typedef T& reference;
+    typedef const T& const_reference;
+    typedef std::size_t size_type;
+    typedef std::ptrdiff_t difference_type;
+
+    template <class U>
+    struct rebind {typedef PooledAllocator<U> other;};
+
+  protected:
+    struct FreeNode {FreeNode *next;};
+
+    enum {NODE_SIZE = sizeof(T) > sizeof(FreeNode) ? sizeof(T) : sizeof(FreeNode)};
+
+    static FreeNode *& freeList() {static FreeNode *head = NULL; return head;}
+
+  public:
+    PooledAllocator() {}
+    PooledAllocator(const PooledAllocator&) {}
+    template <class U>
+    PooledAllocator(const PooledAllocator<U>&) {}
+
+    pointer address(reference x) const {return &x;}
+    const_pointer address(const_reference x) const {return &x;}
+    size_type max_size() const {return size_type(-1) / NODE_SIZE;}
+
+    pointer allocate(size_type n, const void * = NULL)
+    {
+        if (n != 1)
+            return static_cast<pointer>(::operator new(n * sizeof(T)));
+        FreeNode *& head = freeList();
+        if (!head)
+            return static_cast<pointer>(::operator new(NODE_SIZE));
+        FreeNode *node = head;
+        head = node->next;
+        return reinterpret_cast<pointer>(node);
+    }
+
+    void deallocate(pointer p, size_type n)
+    {
+        if (n != 1) {
+            ::operator delete(p);
+            return;
+        }
+        FreeNode *node = reinterpret_cast<FreeNode *>(p);
+        FreeNode *& head = freeList();
+        node->next = head;
+        head = node;
+    }
+
+    void construct(pointer p, const T& val) {new(static_cast<void *>(p)) T(val);}
+    void destroy(pointer p) {p->~T();}
+};
+
+template <class T, class U>
+inline bool operator==(const PooledAllocator<T>&, const PooledAllocator<U>&) {return true;}
+
+template <class T, class U>
+inline bool operator!=(const PooledAllocator<T>&, const PooledAllocator<U>&) {return false;}
+
+#endif
+
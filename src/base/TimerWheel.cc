@@ -0,0 +1,296 @@
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+
+
+#include <omnetpp.h>
+#include <math.h>
+#include "TimerWheel.h"
+
+
+TimerWheel::Timer::~Timer()
+{
+    if (wheel)
+        wheel->cancel(this);
+}
+
+simtime_t TimerWheel::Timer::getExpiryTime() const
+{
+    return wheel ? wheel->tickToTime(expiryTick) : MAXTIME;
+}
+
+
+TimerWheel::TimerWheel(double resolution)
+{
+    if (resolution <= 0)
+        opp_error("TimerWheel: resolution must be positive");
+    this->resolution = resolution;
+    currentTick = 0;
+
+    for (int l=0; l<NUM_LEVELS; l++)
+        for (int i=0; i<NUM_SLOTS; i++)
+            slots[l][i].prev = slots[l][i].next = &slots[l][i];
+    expired.prev = expired.next = &expired;
+
+    for (int l=0; l<=NUM_LEVELS; l++)
+        levelCount[l] = 0;
+}
+
+TimerWheel::~TimerWheel()
+{
+    // detach remaining timers, so that they don't try to unlink
+    // themselves from a wheel that no longer exists
+    for (int l=0; l<NUM_LEVELS; l++)
+        for (int i=0; i<NUM_SLOTS; i++)
+            while (slots[l][i].next != &slots[l][i])
+                cancel(slots[l][i].next);
+    while (expired.next != &expired)
+        cancel(expired.next);
+}
+
+void TimerWheel::setResolution(double resolution)
+{
+    if (!empty())
+        opp_error("TimerWheel: cannot change resolution while timers are scheduled");
+    if (resolution <= 0)
+        opp_error("TimerWheel: resolution must be positive");
+
+    // keep the current position in time
+    simtime_t now = tickToTime(currentTick);
+    this->resolution = resolution;
+    currentTick = timeToTick(now);
+}
+
+int64 TimerWheel::timeToTick(simtime_t t) const
+{
+    // round up, but don't let floating-point noise push exact multiples
+    // of the resolution into the next tick
+    return (int64) ceil(SIMTIME_DBL(t) / resolution - 1e-6);
+}
+
+void TimerWheel::linkBefore(Timer *sentinel, Timer *t)
+{
+    t->next = sentinel;
+    t->prev = sentinel->prev;
+    sentinel->prev->next = t;
+    sentinel->prev = t;
+}
+
+void TimerWheel::unlink(Timer *t)
+{
+    t->prev->next = t->next;
+    t->next->prev = t->prev;
+    t->prev = t->next = NULL;
+}
+
+void TimerWheel::place(Timer *t)
+{
+    int64 expiry = t->expiryTick;
+    int64 delta = expiry - currentTick;
+
+    if (delta < 0)
+    {
+        // already due: put it into the slot processed next
+        expiry = currentTick;
+        delta = 0;
+    }
+    else if (delta > (int64)0xffffffffUL)
+    {
+        // beyond the wheel's range: park it in the farthest slot,
+        // it will be placed again properly when that slot cascades
+        expiry = currentTick + (int64)0xffffffffUL;
+        delta = (int64)0xffffffffUL;
+    }
+
+    int level = 0;
+    while (level < NUM_LEVELS-1 && delta >= ((int64)1 << (LEVEL_BITS*(level+1))))
+        level++;
+
+    int index = (int)((expiry >> (LEVEL_BITS*level)) & SLOT_MASK);
+    t->level = level;
+    linkBefore(&slots[level][index], t);
+    levelCount[level]++;
+}
+
+int TimerWheel::cascade(int level, int index)
+{
+    // move all timers from the given slot to lower levels
+    Timer *sentinel = &slots[level][index];
+    Timer list;
+    list.prev = list.next = &list;
+    if (sentinel->next != sentinel)
+    {
+        // splice the whole slot list over to a local list first, since
+        // place() may put timers back into this very slot
+        list.next = sentinel->next;
+        list.prev = sentinel->prev;
+        list.next->prev = &list;
+        list.prev->next = &list;
+        sentinel->prev = sentinel->next = sentinel;
+    }
+
+    while (list.next != &list)
+    {
+        Timer *t = list.next;
+        unlink(t);
+        levelCount[level]--;
+        place(t);
+    }
+    list.prev = list.next = NULL; // empty now; keep ~Timer() from touching it
+    return index;
+}
+
+void TimerWheel::schedule(Timer *t, simtime_t expiryTime)
+{
+    if (t->wheel)
+        t->wheel->cancel(t);
+
+    t->expiryTick = timeToTick(expiryTime);
+    t->wheel = this;
+    place(t);
+}
+
+void TimerWheel::scheduleExpired(Timer *t)
+{
+    if (t->wheel)
+        t->wheel->cancel(t);
+
+    t->expiryTick = currentTick > 0 ? currentTick-1 : 0;
+    t->wheel = this;
+    t->level = EXPIRED_LEVEL;
+    linkBefore(&expired, t);
+    levelCount[EXPIRED_LEVEL]++;
+}
+
+void TimerWheel::cancel(Timer *t)
+{
+    if (t->wheel != this)
+        return;
+
+    unlink(t);
+    levelCount[t->level]--;
+    t->wheel = NULL;
+    t->level = -1;
+}
+
+void TimerWheel::advance(simtime_t now)
+{
+    int64 nowTick = (int64) floor(SIMTIME_DBL(now) / resolution + 1e-6);
+
+    while (currentTick <= nowTick)
+    {
+        int index = (int)(currentTick & SLOT_MASK);
+
+        if (index != 0 && levelCount[0] == 0)
+        {
+            // nothing in level 0: skip ahead to the next cascade point
+            int64 nextRound = (currentTick | SLOT_MASK) + 1;
+            if (nextRound > nowTick)
+            {
+                currentTick = nowTick + 1;
+                break;
+            }
+            currentTick = nextRound;
+            continue;
+        }
+
+        // at the start of each round, refill level 0 from the higher levels
+        if (index == 0)
+        {
+            for (int l=1; l<NUM_LEVELS; l++)
+                if (cascade(l, (int)((currentTick >> (LEVEL_BITS*l)) & SLOT_MASK)) != 0)
+                    break;
+        }
+
+        currentTick++;
+
+        Timer *sentinel = &slots[0][index];
+        while (sentinel->next != sentinel)
+        {
+            Timer *t = sentinel->next;
+            unlink(t);
+            levelCount[0]--;
+            t->level = EXPIRED_LEVEL;
+            linkBefore(&expired, t);
+            levelCount[EXPIRED_LEVEL]++;
+        }
+    }
+}
+
+TimerWheel::Timer *TimerWheel::popExpired()
+{
+    if (expired.next == &expired)
+        return NULL;
+    Timer *t = expired.next;
+    cancel(t);
+    return t;
+}
+
+simtime_t TimerWheel::getNextWakeupTime() const
+{
+    if (levelCount[EXPIRED_LEVEL] > 0)
+        return tickToTime(currentTick-1); // due timers not yet popped
+
+    int64 wakeupTick = -1;
+
+    // level 0 contains timers of the next NUM_SLOTS ticks, with exact expiry
+    if (levelCount[0] > 0)
+    {
+        for (int k=0; k<NUM_SLOTS; k++)
+        {
+            const Timer *sentinel = &slots[0][(currentTick+k) & SLOT_MASK];
+            if (sentinel->next != sentinel)
+            {
+                wakeupTick = currentTick+k;
+                break;
+            }
+        }
+    }
+
+    // for higher levels we only know when a slot gets cascaded, which is a
+    // lower bound for the expiry of the timers in it; it may come before
+    // the earliest level 0 timer, since higher-level timers approach
+    // the present as time passes
+    for (int l=1; l<NUM_LEVELS; l++)
+    {
+        if (levelCount[l] == 0)
+            continue;
+        int shift = LEVEL_BITS*l;
+        int64 base = currentTick >> shift;
+        // the slot of the current round at this level is cascaded when the
+        // lower levels wrap around next time, unless we are exactly at that point
+        int64 first = ((currentTick & (((int64)1<<shift)-1)) == 0) ? base : base+1;
+        for (int k=0; k<NUM_SLOTS; k++)
+        {
+            const Timer *sentinel = &slots[l][(first+k) & SLOT_MASK];
+            if (sentinel->next != sentinel)
+            {
+                int64 tick = (first+k) << shift;
+                if (wakeupTick < 0 || tick < wakeupTick)
+                    wakeupTick = tick;
+                break;
+            }
+        }
+    }
+    return wakeupTick < 0 ? MAXTIME : tickToTime(wakeupTick);
+}
+
+int TimerWheel::size() const
+{
+    int n = 0;
+    for (int l=0; l<=NUM_LEVELS; l++)
+        n += levelCount[l];
+    return n;
+}
+
@@ -0,0 +1,171 @@
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef __INET_TIMERWHEEL_H
+#define __INET_TIMERWHEEL_H
+
+#include "INETDefs.h"
+
+
+/**
+ * Hierarchical timing wheel (Varghese & Lauck), for modules that maintain
+ * a large number of timers. Instead of putting one self-message per timer
+ * into the future event set, the module keeps its timers in the wheel and
+ * schedules a single self-message at getNextWakeupTime(); when that message
+ * arrives, it calls advance() and then processes the due timers one by one
+ * with popExpired().
+ *
+ * Time is divided into ticks of a configurable resolution, and expiry times
+ * are rounded up to the next tick; all timers that fall into the same tick
+ * are fired in one batch. Timers with zero delay can bypass the rounding
+ * with scheduleExpired(). The wheel has 4 levels of 256 slots each, so
+ * timers up to 2^32 ticks ahead are stored without overflow handling.
+ *
+ * Timers are intrusive: users derive their timer records from
+ * TimerWheel::Timer. schedule() and cancel() are O(1). A Timer unlinks
+ * itself from the wheel when deleted, so it is safe to delete a timer
+ * record (even a due one that has not been popped yet) at any time.
+ */
+class INET_API TimerWheel
+{
+  public:
+    /**
+     * Base class for timer records kept in the wheel.
+     */
+    class INET_API Timer
+    {
+        friend class TimerWheel;
+      private:
+        Timer *prev, *next;  // slot list links (circular, with sentinel)
+        TimerWheel *wheel;   // the wheel we are linked into, or NULL
+        int64 expiryTick;
+        int level;           // wheel level, or EXPIRED_LEVEL
+      public:
+        Timer() {prev = next = NULL; wheel = NULL; expiryTick = 0; level = -1;}
+        Timer(const Timer&) {prev = next = NULL; wheel = NULL; expiryTick = 0; level = -1;}
+        Timer& operator=(const Timer&) {return *this;} // links are not copied
+        virtual ~Timer();
+
+        /** Returns true if the timer is in a wheel (scheduled or due). */
+        bool isScheduled() const {return wheel!=NULL;}
+
+        /** Returns the (rounded up) expiry time of a scheduled timer. */
+        simtime_t getExpiryTime() const;
+    };
+
+  protected:
+    enum {
+        LEVEL_BITS = 8,
+        NUM_SLOTS = 1 << LEVEL_BITS,
+        SLOT_MASK = NUM_SLOTS - 1,
+        NUM_LEVELS = 4,
+        EXPIRED_LEVEL = NUM_LEVELS
+    };
+
+    double resolution;      // length of one tick, in seconds
+    int64 currentTick;      // next tick to be processed by advance()
+    Timer slots[NUM_LEVELS][NUM_SLOTS];  // sentinels of the slot lists
+    Timer expired;          // sentinel of the list of due timers
+    int levelCount[NUM_LEVELS+1];  // number of timers per level (incl. expired list)
+
+  protected:
+    static void linkBefore(Timer *sentinel, Timer *t);
+    static void unlink(Timer *t);
+    void place(Timer *t);
+    int cascade(int level, int index);
+
+  public:
+    /**
+     * Creates a wheel with the given tick length, in seconds.
+     */
+    TimerWheel(double resolution = 0.001);
+
+    /**
+     * The destructor unlinks (but does not delete) remaining timers.
+     */
+    ~TimerWheel();
+
+    /**
+     * Changes the tick length. May only be called while the wheel is empty.
+     */
+    void setResolution(double resolution);
+
+    /**
+     * Returns the tick length, in seconds.
+     */
+    double getResolution() const {return resolution;}
+
+    /**
+     * Converts a tick number to simulation time.
+     */
+    simtime_t tickToTime(int64 tick) const {return tick * resolution;}
+
+    /**
+     * Converts a simulation time to the first tick not earlier than it.
+     */
+    int64 timeToTick(simtime_t t) const;
+
+    /**
+     * Inserts the timer so that it expires at the given time (rounded up to
+     * the tick resolution). If the timer is already in the wheel, it is
+     * moved. Times in the past are treated as "next tick".
+     */
+    void schedule(Timer *t, simtime_t expiryTime);
+
+    /**
+     * Puts the timer directly onto the list of due timers, without rounding
+     * to the tick resolution, so that it is returned by the next
+     * popExpired(). Meant for timers with zero delay. If the timer is
+     * already in the wheel, it is moved.
+     */
+    void scheduleExpired(Timer *t);
+
+    /**
+     * Removes the timer from the wheel, if it is there. O(1).
+     */
+    void cancel(Timer *t);
+
+    /**
+     * Moves all timers expiring at or before the given time to the list
+     * of due timers, which can then be drained with popExpired().
+     */
+    void advance(simtime_t now);
+
+    /**
+     * Removes and returns the next due timer, or NULL if there is none.
+     */
+    Timer *popExpired();
+
+    /**
+     * Returns the time at which advance() should be called next. This is
+     * either the expiry time of the earliest timer, or an earlier time when
+     * timers from a higher level must be redistributed. Returns MAXTIME
+     * if the wheel is empty.
+     */
+    simtime_t getNextWakeupTime() const;
+
+    /**
+     * Returns the number of timers in the wheel, including due ones.
+     */
+    int size() const;
+
+    /**
+     * Returns true if there are no timers in the wheel.
+     */
+    bool empty() const {return size()==0;}
+};
+
+#endif
+
@@ -27,6 +27,7 @@
 #include "InterfaceTableAccess.h"
 #include "ExtInterface.h"
 #include "IPSerializer.h"
+#include "IPv6Serializer.h"
 
 
 Define_Module(ExtInterface);
@@ -115,17 +116,77 @@ void ExtInterface::handleMessage(cMessage *msg)
 		for(uint32 i=0; i < packetLength; i++)
 			buffer[i] = rawPacket->getData(i);
 
-		IPDatagram *ipPacket = new IPDatagram("ip-from-wire");
-		IPSerializer().parse(buffer, packetLength, (IPDatagram *)ipPacket);
-		EV << "Delivering an IP packet from "
-		   << ipPacket->getSrcAddress()
-		   << " to "
-		   << ipPacket->getDestAddress()
-		   << " and length of"
-		   << ipPacket->getByteLength()
-		   << " bytes to IP layer.\n";
-		send(ipPacket, "netwOut");
-		numRcvd++;
+		if (packetLength > 0 && (buffer[0] >> 4) == 6)
+		{
+			IPv6Datagram *ipv6Packet = new IPv6Datagram("ipv6-from-wire");
+			IPv6Serializer().parse(buffer, packetLength, ipv6Packet);
+			EV << "Delivering an IPv6 packet from "
+			   << ipv6Packet->getSrcAddress()
+			   << " to "
+			   << ipv6Packet->getDestAddress()
+			   << " and length of "
+			   << ipv6Packet->getByteLength()
+			   << " bytes to IPv6 layer.\n";
+			send(ipv6Packet, "netwOut");
+			numRcvd++;
+		}
+		else
+		{
+			IPDatagram *ipPacket = new IPDatagram("ip-from-wire");
+			IPSerializer().parse(buffer, packetLength, (IPDatagram *)ipPacket);
+			EV << "Delivering an IP packet from "
+			   << ipPacket->getSrcAddress()
+			   << " to "
+			   << ipPacket->getDestAddress()
+			   << " and length of"
+			   << ipPacket->getByteLength()
+			   << " bytes to IP layer.\n";
+			send(ipPacket, "netwOut");
+			numRcvd++;
+		}
+	}
+	else if (dynamic_cast<IPv6Datagram *>(msg) != NULL)
+	{
+		memset(buffer, 0, 1<<16);
+		IPv6Datagram *ipv6Packet = check_and_cast<IPv6Datagram *>(msg);
+
+		if ((ipv6Packet->getTransportProtocol() != IP_PROT_IPv6_ICMP) &&
+		    (ipv6Packet->getTransportProtocol() != IP_PROT_IPv6EXT_MOB) &&
+		    (ipv6Packet->getTransportProtocol() != IP_PROT_IPv6) &&
+		    (ipv6Packet->getTransportProtocol() != IPPROTO_SCTP) &&
+		    (ipv6Packet->getTransportProtocol() != IPPROTO_UDP))
+		{
+			EV << "Can not send packet. Protocol " << ipv6Packet->getTransportProtocol() << " is not supported.\n";
+			numDropped++;
+			delete(msg);
+			return;
+		}
+
+		if(connected)
+		{
+			struct sockaddr_in6 addr;
+			memset(&addr, 0, sizeof(addr));
+			addr.sin6_family = AF_INET6;
+#if !defined(linux) && !defined(_WIN32)
+			addr.sin6_len    = sizeof(struct sockaddr_in6);
+#endif
+			IPv6Serializer::writeAddress(ipv6Packet->getDestAddress(), (unsigned char *)&addr.sin6_addr);
+			int32 packetLength = IPv6Serializer().serialize(ipv6Packet, buffer, sizeof(buffer));
+			EV << "Delivering an IPv6 packet from "
+			   << ipv6Packet->getSrcAddress()
+			   << " to "
+			   << ipv6Packet->getDestAddress()
+			   << " and length of "
+			   << ipv6Packet->getByteLength()
+			   << " bytes to link layer.\n";
+			rtScheduler->sendBytes(buffer, packetLength, (struct sockaddr *) &addr, sizeof(struct sockaddr_in6));
+			numSent++;
+		}
+		else
+		{
+			EV << "Interface is not connected, dropping packet " << msg << endl;
+			numDropped++;
+		}
 	}
 	else
 	{
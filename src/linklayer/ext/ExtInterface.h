@@ -30,6 +30,7 @@
 #include "ExtFrame_m.h"
 #include "cSocketRTScheduler.h"
 #include "IPDatagram.h"
+#include "IPv6Datagram.h"
 
 #ifndef IPPROTO_SCTP
 #define IPPROTO_SCTP 132
@@ -51,6 +51,7 @@ inline std::ostream& operator<<(std::ostream& out, const timeval& tv)
 cSocketRTScheduler::cSocketRTScheduler() : cScheduler()
 {
 	fd = INVALID_SOCKET;
+	fd6 = INVALID_SOCKET;
 }
 
 cSocketRTScheduler::~cSocketRTScheduler()
@@ -71,6 +72,11 @@ void cSocketRTScheduler::startRun()
 		throw cRuntimeError("cSocketRTScheduler: Root priviledges needed");
 	if (setsockopt(fd, IPPROTO_IP, IP_HDRINCL, (char *)&on, sizeof(on)) < 0)
 		throw cRuntimeError("cSocketRTScheduler: couldn't set sockopt for raw socket");
+	// on Linux, IPv6 raw sockets with IPPROTO_RAW expect the IPv6 header to be included;
+	// sending IPv6 is optional, so a host without IPv6 support is not an error
+	fd6 = socket(AF_INET6, SOCK_RAW, IPPROTO_RAW);
+	if (fd6 == INVALID_SOCKET)
+		EV << "cSocketRTScheduler: couldn't create IPv6 raw socket, IPv6 packets will not be sent.\n";
 #endif
 }
 
@@ -83,6 +89,9 @@ void cSocketRTScheduler::endRun()
 #endif
 	close(fd);
 	fd = INVALID_SOCKET;
+	if (fd6 != INVALID_SOCKET)
+		close(fd6);
+	fd6 = INVALID_SOCKET;
 #ifdef HAVE_PCAP
 
 	for (uint16 i=0; i<pds.size(); i++)
@@ -184,11 +193,11 @@ static void packet_handler(u_char *user, const struct pcap_pkthdr *hdr, const u_
 	headerLength = cSocketRTScheduler::headerLengths.at(i);
 	module = cSocketRTScheduler::modules.at(i);
 
-	// skip ethernet frames not encapsulating an IP packet.
+	// skip ethernet frames not encapsulating an IP or IPv6 packet.
 	if (datalink == DLT_EN10MB)
 	{
 		ethernet_hdr = (struct ether_header *)bytes;
-		if (ntohs(ethernet_hdr->ether_type) != ETHERTYPE_IP)
+		if (ntohs(ethernet_hdr->ether_type) != ETHERTYPE_IP && ntohs(ethernet_hdr->ether_type) != ETHERTYPE_IPV6)
 			return;
 	}
 
@@ -318,10 +327,11 @@ cMessage *cSocketRTScheduler::getNextEvent()
 
 void cSocketRTScheduler::sendBytes(uint8 *buf, size_t numBytes, struct sockaddr *to, socklen_t addrlen)
 {
-	if (fd == INVALID_SOCKET)
+	int sock = (to->sa_family == AF_INET6) ? fd6 : fd;
+	if (sock == INVALID_SOCKET)
 		throw cRuntimeError("cSocketRTScheduler::sendBytes(): no raw socket.");
 
-	ssize_t sent = sendto(fd, (char *)buf, numBytes, 0, to, addrlen);
+	ssize_t sent = sendto(sock, (char *)buf, numBytes, 0, to, addrlen);
 
 	if (sent == (ssize_t)numBytes)
 		EV << "Sent an IP packet with length of " << sent << " bytes.\n";
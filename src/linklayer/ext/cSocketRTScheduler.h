@@ -43,6 +43,7 @@ class cSocketRTScheduler : public cScheduler
 
 
 		int fd;
+		int fd6;  // raw socket for IPv6, may be INVALID_SOCKET
 
 		virtual bool receiveWithTimeout();
 		virtual int receiveUntil(const timeval& targetTime);
@@ -0,0 +1,38 @@
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef __INET_IEEE80211AARF_H
+#define __INET_IEEE80211AARF_H
+
+#include "Ieee80211ARF.h"
+
+
+/**
+ * Adaptive Auto Rate Fallback (M. Lacage, M.H. Manshaei, T. Turletti:
+ * IEEE 802.11 Rate Adaptation: A Practical Approach, MSWiM 2004).
+ *
+ * Works like Ieee80211ARF, but every failed probe of a higher bitrate
+ * doubles the number of successes needed before the next probe (up to
+ * 60), and a step down resets it to 10. On a stable link this saves most
+ * of the failed probes ARF makes every 10 frames.
+ */
+class INET_API Ieee80211AARF : public Ieee80211ARF
+{
+  public:
+    Ieee80211AARF();
+};
+
+#endif
+
@@ -0,0 +1,105 @@
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+
+#include <algorithm>
+#include "Ieee80211ARF.h"
+
+Register_Class(Ieee80211ARF);
+
+
+Ieee80211ARF::Ieee80211ARF()
+{
+    minSuccessThreshold = 10;
+    maxSuccessThreshold = 10;
+    minTimerThreshold = 15;
+    successK = 1;
+    timerK = 1;
+}
+
+void Ieee80211ARF::initialize(const std::vector<double>& bitrates)
+{
+    Ieee80211RateControl::initialize(bitrates);
+    ASSERT(!rates.empty());
+
+    rateIndex = rates.size() - 1;
+    successCount = 0;
+    timerCount = 0;
+    recovery = false;
+    successThreshold = minSuccessThreshold;
+    timerThreshold = minTimerThreshold;
+}
+
+double Ieee80211ARF::getBitrate(int retryCount)
+{
+    return rates[rateIndex];
+}
+
+void Ieee80211ARF::reportSuccess(double bitrate, int retryCount)
+{
+    timerCount++;
+    successCount++;
+    recovery = false;
+
+    if ((successCount >= successThreshold || timerCount >= timerThreshold) && rateIndex < (int)rates.size()-1)
+    {
+        // step up, and probe the new bitrate
+        rateIndex++;
+        timerCount = 0;
+        successCount = 0;
+        recovery = true;
+    }
+}
+
+void Ieee80211ARF::reportFailure(double bitrate, int retryCount)
+{
+    timerCount++;
+    successCount = 0;
+
+    if (recovery)
+    {
+        // the first attempt after stepping up failed: step back down
+        if (retryCount == 0)
+        {
+            successThreshold = std::min(successThreshold * successK, maxSuccessThreshold);
+            timerThreshold = std::max(timerThreshold * timerK, minTimerThreshold);
+            if (rateIndex > 0)
+                rateIndex--;
+        }
+        timerCount = 0;
+    }
+    else
+    {
+        // every second consecutive failure: step down
+        if (retryCount % 2 == 1)
+        {
+            successThreshold = minSuccessThreshold;
+            timerThreshold = minTimerThreshold;
+            if (rateIndex > 0)
+                rateIndex--;
+        }
+        if (retryCount >= 1)
+            timerCount = 0;
+    }
+}
+
+std::string Ieee80211ARF::info() const
+{
+    std::stringstream out;
+    out << "bitrate=" << rates[rateIndex]/1e6 << "Mbps successThreshold=" << successThreshold;
+    if (recovery)
+        out << " probing";
+    return out.str();
+}
+
@@ -0,0 +1,63 @@
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef __INET_IEEE80211ARF_H
+#define __INET_IEEE80211ARF_H
+
+#include "Ieee80211RateControl.h"
+
+
+/**
+ * Auto Rate Fallback (A. Kamerman, L. Monteban: WaveLAN-II: A High-
+ * Performance Wireless LAN for the Unlicensed Band, Bell Labs Technical
+ * Journal, 1997).
+ *
+ * Starts at the highest bitrate. Two consecutive failed attempts make it
+ * step down to the next lower bitrate; successThreshold consecutive
+ * successes, or timerThreshold attempts at the same bitrate, make it step
+ * up. If the first attempt after stepping up fails, it steps back down
+ * immediately.
+ *
+ * The thresholds are fixed here; Ieee80211AARF adapts them.
+ */
+class INET_API Ieee80211ARF : public Ieee80211RateControl
+{
+  protected:
+    // configuration, set in the ctor
+    int minSuccessThreshold;
+    int maxSuccessThreshold;
+    int minTimerThreshold;
+    int successK;  // successThreshold is multiplied by this on failed probing
+    int timerK;    // timerThreshold is multiplied by this on failed probing
+
+    // state
+    int rateIndex;        // index of the current bitrate in rates[]
+    int successCount;     // consecutive successes at this bitrate
+    int timerCount;       // attempts since the last bitrate change
+    bool recovery;        // true right after stepping up (probing)
+    int successThreshold;
+    int timerThreshold;
+
+  public:
+    Ieee80211ARF();
+    virtual void initialize(const std::vector<double>& bitrates);
+    virtual double getBitrate(int retryCount);
+    virtual void reportSuccess(double bitrate, int retryCount);
+    virtual void reportFailure(double bitrate, int retryCount);
+    virtual std::string info() const;
+};
+
+#endif
+
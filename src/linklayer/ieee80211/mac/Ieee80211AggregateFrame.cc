@@ -0,0 +1,68 @@
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+
+
+#include "Ieee80211AggregateFrame.h"
+
+Register_Class(Ieee80211AggregateFrame);
+
+
+Ieee80211AggregateFrame& Ieee80211AggregateFrame::operator=(const Ieee80211AggregateFrame& other)
+{
+    Ieee80211AggregateFrame_Base::operator=(other);
+
+    // addSubframe() adds the lengths again
+    setByteLength(0);
+    for (std::list<Ieee80211DataOrMgmtFrame *>::const_iterator i=other.subframes.begin(); i!=other.subframes.end(); ++i)
+        addSubframe((*i)->dup());
+
+    return *this;
+}
+
+Ieee80211AggregateFrame::~Ieee80211AggregateFrame()
+{
+    while (!subframes.empty())
+    {
+        Ieee80211DataOrMgmtFrame *frame = subframes.front();
+        subframes.pop_front();
+        dropAndDelete(frame);
+    }
+}
+
+int Ieee80211AggregateFrame::getSubframeLength(Ieee80211DataOrMgmtFrame *frame)
+{
+    // 4-octet delimiter (length, CRC, signature), then the frame padded to 4 octets
+    return 4 + (frame->getByteLength() + 3) / 4 * 4;
+}
+
+void Ieee80211AggregateFrame::addSubframe(Ieee80211DataOrMgmtFrame *frame)
+{
+    take(frame);
+    subframes.push_back(frame);
+    addByteLength(getSubframeLength(frame));
+}
+
+Ieee80211DataOrMgmtFrame *Ieee80211AggregateFrame::removeFirstSubframe()
+{
+    if (subframes.empty())
+        return NULL;
+
+    Ieee80211DataOrMgmtFrame *frame = subframes.front();
+    subframes.pop_front();
+    addByteLength(-getSubframeLength(frame));
+    drop(frame);
+    return frame;
+}
+
@@ -0,0 +1,63 @@
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef __INET_IEEE80211AGGREGATEFRAME_H
+#define __INET_IEEE80211AGGREGATEFRAME_H
+
+#include <list>
+#include "INETDefs.h"
+#include "Ieee80211Frame_m.h"
+
+/**
+ * Represents an aggregate of data frames. More info in the Ieee80211Frame.msg
+ * file (and the documentation generated from it).
+ */
+class INET_API Ieee80211AggregateFrame : public Ieee80211AggregateFrame_Base
+{
+  protected:
+    std::list<Ieee80211DataOrMgmtFrame *> subframes;
+
+  public:
+    Ieee80211AggregateFrame(const char *name=NULL, int kind=0) : Ieee80211AggregateFrame_Base(name,kind) {}
+    Ieee80211AggregateFrame(const Ieee80211AggregateFrame& other) : Ieee80211AggregateFrame_Base(other.getName()) {operator=(other);}
+    virtual ~Ieee80211AggregateFrame();
+    Ieee80211AggregateFrame& operator=(const Ieee80211AggregateFrame& other);
+    virtual Ieee80211AggregateFrame *dup() const {return new Ieee80211AggregateFrame(*this);}
+
+    /**
+     * Returns the length of the frame in octets as a subframe of an
+     * aggregate: with the delimiter, padded to a multiple of 4 octets.
+     */
+    static int getSubframeLength(Ieee80211DataOrMgmtFrame *frame);
+
+    /**
+     * Returns the number of subframes in this aggregate
+     */
+    virtual unsigned int getNumSubframes() const {return subframes.size();}
+
+    /**
+     * Adds a frame to the end of the aggregate, and its subframe length
+     * to the length of the aggregate.
+     */
+    virtual void addSubframe(Ieee80211DataOrMgmtFrame *frame);
+
+    /**
+     * Removes and returns the first subframe, or returns NULL if there's none.
+     */
+    virtual Ieee80211DataOrMgmtFrame *removeFirstSubframe();
+};
+
+#endif
+
@@ -29,6 +29,7 @@
 const unsigned int LENGTH_RTS = 160;
 const unsigned int LENGTH_CTS = 112;
 const unsigned int LENGTH_ACK = 112;
+const unsigned int LENGTH_BLOCKACK = 256;
 
 // time slot ST, short interframe space SIFS, distributed interframe
 // space DIFS, and extended interframe space EIFS
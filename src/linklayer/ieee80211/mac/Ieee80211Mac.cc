@@ -43,6 +43,11 @@ Register_Enum(RadioState,
     RadioState::TRANSMIT,
     RadioState::SLEEP));
 
+static std::ostream& operator<<(std::ostream& os, const Ieee80211RateControl& rateControl)
+{
+    return os << rateControl.info();
+}
+
 /****************************************************************
  * Construction functions.
  */
@@ -68,6 +73,9 @@ Ieee80211Mac::~Ieee80211Mac()
 
     if (pendingRadioConfigMsg)
         delete pendingRadioConfigMsg;
+
+    for (RateControlMap::iterator it = rateControlMap.begin(); it != rateControlMap.end(); ++it)
+        delete it->second;
 }
 
 /****************************************************************
@@ -86,6 +94,28 @@ void Ieee80211Mac::initialize(int stage)
         bitrate = par("bitrate");
         basicBitrate = 2e6; //FIXME make it parameter
         rtsThreshold = par("rtsThresholdBytes");
+        aggregationLimitBytes = par("aggregationLimitBytes");
+        aggregationLimitTime = par("aggregationLimitTime");
+
+        // rate control chooses among the 802.11b bitrates not above bitrate,
+        // and also the 802.11g ones if bitrate is above 11Mbps
+        rateControlClass = par("rateControlClass").stdstringValue();
+        if (!rateControlClass.empty())
+        {
+            static const double bitrates80211b[] = {1E+6, 2E+6, 5.5E+6, 11E+6};
+            static const double bitrates80211g[] = {6E+6, 9E+6, 12E+6, 18E+6, 24E+6, 36E+6, 48E+6, 54E+6};
+            for (unsigned int i = 0; i < sizeof(bitrates80211b)/sizeof(double); i++)
+                if (bitrates80211b[i] <= bitrate)
+                    rateControlBitrates.push_back(bitrates80211b[i]);
+            if (bitrate > 11E+6)
+                for (unsigned int i = 0; i < sizeof(bitrates80211g)/sizeof(double); i++)
+                    if (bitrates80211g[i] <= bitrate)
+                        rateControlBitrates.push_back(bitrates80211g[i]);
+            std::sort(rateControlBitrates.begin(), rateControlBitrates.end());
+            if (rateControlBitrates.empty())
+                error("no 802.11 bitrate is at or below the bitrate parameter (%g bps), cannot use rate control", bitrate);
+        }
+        dataFrameBitrate = bitrate;
 
         // the variable is renamed due to a confusion in the standard
         // the name retry limit would be misleading, see the header file comment
@@ -148,10 +178,12 @@ void Ieee80211Mac::initialize(int stage)
         numReceived = 0;
         numSentBroadcast = 0;
         numReceivedBroadcast = 0;
+        numAggregated = 0;
         stateVector.setName("State");
         stateVector.setEnum("Ieee80211Mac");
         radioStateVector.setName("RadioState");
         radioStateVector.setEnum("RadioState");
+        dataBitrateVector.setName("DataBitrate");
 
         // initialize watches
         WATCH(fsm);
@@ -168,6 +200,8 @@ void Ieee80211Mac::initialize(int stage)
         WATCH(numReceived);
         WATCH(numSentBroadcast);
         WATCH(numReceivedBroadcast);
+        WATCH(numAggregated);
+        WATCH_PTRMAP(rateControlMap);
     }
 }
 
@@ -218,6 +252,11 @@ void Ieee80211Mac::initializeQueueModule()
         queueModule->requestPacket();
         // needed for backoff: mandatory if next message is already present
         queueModule->requestPacket();
+
+        // aggregation needs more frames at hand: keep maxQueueSize of them
+        if (aggregationLimitBytes > 0)
+            for (int i = 2; i < maxQueueSize; i++)
+                queueModule->requestPacket();
     }
 }
 
@@ -364,6 +403,10 @@ void Ieee80211Mac::handleWithFSM(cMessage *msg)
         scheduleReservePeriod(frame);
     }
 
+    // the current frame is about to be sent (see the transitions below)
+    if ((msg == endDIFS && !backoff) || msg == endBackoff)
+        prepareCurrentTransmission();
+
     // TODO: fix bug according to the message: [omnetpp] A possible bug in the Ieee80211's FSM.
     FSMA_Switch(fsm)
     {
@@ -480,21 +523,24 @@ void Ieee80211Mac::handleWithFSM(cMessage *msg)
         {
             FSMA_Enter(scheduleDataTimeoutPeriod(getCurrentTransmission()));
             FSMA_Event_Transition(Receive-ACK,
-                                  isLowerMsg(msg) && isForUs(frame) && frameType == ST_ACK,
+                                  isLowerMsg(msg) && isForUs(frame) && (frameType == ST_ACK || frameType == ST_BLOCKACK),
                                   IDLE,
                 if (retryCounter == 0) numSentWithoutRetry++;
                 numSent++;
                 cancelTimeoutPeriod();
+                reportDataFrameAcked();
                 finishCurrentTransmission();
             );
             FSMA_Event_Transition(Transmit-Data-Failed,
                                   msg == endTimeout && retryCounter == transmissionLimit - 1,
                                   IDLE,
+                reportDataFrameNotAcked();
                 giveUpCurrentTransmission();
             );
             FSMA_Event_Transition(Receive-ACK-Timeout,
                                   msg == endTimeout,
                                   DEFER,
+                reportDataFrameNotAcked();
                 retryCurrentTransmission();
             );
         }
@@ -567,6 +613,11 @@ void Ieee80211Mac::handleWithFSM(cMessage *msg)
                 numReceivedBroadcast++;
                 resetStateVariables();
             );
+            FSMA_No_Event_Transition(Immediate-Receive-Aggregate,
+                                     isLowerMsg(msg) && isForUs(frame) && isAggregate(frame),
+                                     WAITSIFS,
+                sendUpAggregate(check_and_cast<Ieee80211AggregateFrame *>(frame));
+            );
             FSMA_No_Event_Transition(Immediate-Receive-Data,
                                      isLowerMsg(msg) && isForUs(frame) && isDataOrMgmtFrame(frame),
                                      WAITSIFS,
@@ -678,7 +729,7 @@ void Ieee80211Mac::cancelDIFSPeriod()
 void Ieee80211Mac::scheduleDataTimeoutPeriod(Ieee80211DataOrMgmtFrame *frameToSend)
 {
     EV << "scheduling data timeout period\n";
-    scheduleAt(simTime() + computeFrameDuration(frameToSend) + getSIFS() + computeFrameDuration(LENGTH_ACK, basicBitrate) + MAX_PROPAGATION_DELAY * 2, endTimeout);
+    scheduleAt(simTime() + computeFrameDuration(frameToSend) + getSIFS() + computeFrameDuration(getACKLength(frameToSend), basicBitrate) + MAX_PROPAGATION_DELAY * 2, endTimeout);
 }
 
 void Ieee80211Mac::scheduleBroadcastTimeoutPeriod(Ieee80211DataOrMgmtFrame *frameToSend)
@@ -780,8 +831,16 @@ void Ieee80211Mac::sendACKFrameOnEndSIFS()
 
 void Ieee80211Mac::sendACKFrame(Ieee80211DataOrMgmtFrame *frameToACK)
 {
-    EV << "sending ACK frame\n";
-    sendDown(setBasicBitrate(buildACKFrame(frameToACK)));
+    if (isAggregate(frameToACK))
+    {
+        EV << "sending Block Ack frame\n";
+        sendDown(setBasicBitrate(buildBlockAckFrame(frameToACK)));
+    }
+    else
+    {
+        EV << "sending ACK frame\n";
+        sendDown(setBasicBitrate(buildACKFrame(frameToACK)));
+    }
 }
 
 void Ieee80211Mac::sendDataFrameOnEndSIFS(Ieee80211DataOrMgmtFrame *frameToSend)
@@ -834,11 +893,19 @@ Ieee80211DataOrMgmtFrame *Ieee80211Mac::buildDataFrame(Ieee80211DataOrMgmtFrame
     if (isBroadcast(frameToSend))
         frame->setDuration(0);
     else if (!frameToSend->getMoreFragments())
-        frame->setDuration(getSIFS() + computeFrameDuration(LENGTH_ACK, basicBitrate));
+        frame->setDuration(getSIFS() + computeFrameDuration(getACKLength(frameToSend), basicBitrate));
     else
         // FIXME: shouldn't we use the next frame to be sent?
         frame->setDuration(3 * getSIFS() + 2 * computeFrameDuration(LENGTH_ACK, basicBitrate) + computeFrameDuration(frameToSend));
 
+    // with rate control, tell the radio the bitrate chosen for this attempt
+    if (!rateControlClass.empty() && !isBroadcast(frameToSend))
+    {
+        PhyControlInfo *ctrl = new PhyControlInfo();
+        ctrl->setBitrate(dataFrameBitrate);
+        frame->setControlInfo(ctrl);
+    }
+
     return frame;
 }
 
@@ -855,6 +922,17 @@ Ieee80211ACKFrame *Ieee80211Mac::buildACKFrame(Ieee80211DataOrMgmtFrame *frameTo
     return frame;
 }
 
+Ieee80211BlockAckFrame *Ieee80211Mac::buildBlockAckFrame(Ieee80211DataOrMgmtFrame *frameToACK)
+{
+    Ieee80211BlockAckFrame *frame = new Ieee80211BlockAckFrame("wlan-blockack");
+    frame->setReceiverAddress(frameToACK->getTransmitterAddress());
+    frame->setTransmitterAddress(address);
+    frame->setStartingSequenceNumber(frameToACK->getSequenceNumber());
+    frame->setDuration(0);
+
+    return frame;
+}
+
 Ieee80211RTSFrame *Ieee80211Mac::buildRTSFrame(Ieee80211DataOrMgmtFrame *frameToSend)
 {
     Ieee80211RTSFrame *frame = new Ieee80211RTSFrame("wlan-rts");
@@ -862,7 +940,7 @@ Ieee80211RTSFrame *Ieee80211Mac::buildRTSFrame(Ieee80211DataOrMgmtFrame *frameTo
     frame->setReceiverAddress(frameToSend->getReceiverAddress());
     frame->setDuration(3 * getSIFS() + computeFrameDuration(LENGTH_CTS, basicBitrate) +
                        computeFrameDuration(frameToSend) +
-                       computeFrameDuration(LENGTH_ACK, basicBitrate));
+                       computeFrameDuration(getACKLength(frameToSend), basicBitrate));
 
     return frame;
 }
@@ -892,6 +970,122 @@ Ieee80211Frame *Ieee80211Mac::setBasicBitrate(Ieee80211Frame *frame)
     return frame;
 }
 
+/****************************************************************
+ * Rate control functions.
+ */
+Ieee80211RateControl *Ieee80211Mac::getRateControl(const MACAddress& address)
+{
+    RateControlMap::iterator it = rateControlMap.find(address);
+    if (it != rateControlMap.end())
+        return it->second;
+
+    Ieee80211RateControl *rateControl = check_and_cast<Ieee80211RateControl *>(createOne(rateControlClass.c_str()));
+    rateControl->initialize(rateControlBitrates);
+    rateControlMap[address] = rateControl;
+    return rateControl;
+}
+
+void Ieee80211Mac::chooseDataFrameBitrate(Ieee80211DataOrMgmtFrame *frame)
+{
+    if (rateControlClass.empty())
+        return;
+
+    dataFrameBitrate = getRateControl(frame->getReceiverAddress())->getBitrate(retryCounter);
+    EV << "rate control chose " << dataFrameBitrate/1e6 << "Mbps for attempt " << retryCounter << endl;
+    dataBitrateVector.record(dataFrameBitrate);
+}
+
+void Ieee80211Mac::reportDataFrameAcked()
+{
+    if (!rateControlClass.empty())
+        getRateControl(getCurrentTransmission()->getReceiverAddress())->reportSuccess(dataFrameBitrate, retryCounter);
+}
+
+void Ieee80211Mac::reportDataFrameNotAcked()
+{
+    if (!rateControlClass.empty())
+        getRateControl(getCurrentTransmission()->getReceiverAddress())->reportFailure(dataFrameBitrate, retryCounter);
+}
+
+/****************************************************************
+ * Aggregation functions.
+ */
+void Ieee80211Mac::prepareCurrentTransmission()
+{
+    Ieee80211DataOrMgmtFrame *frame = getCurrentTransmission();
+    if (isBroadcast(frame))
+        return;
+
+    chooseDataFrameBitrate(frame);
+
+    // retransmissions are sent as they were
+    if (aggregationLimitBytes > 0 && retryCounter == 0)
+        aggregateCurrentTransmission();
+}
+
+void Ieee80211Mac::aggregateCurrentTransmission()
+{
+    // management frames are sent alone
+    Ieee80211DataFrame *first = dynamic_cast<Ieee80211DataFrame *>(getCurrentTransmission());
+    if (!first)
+        return;
+
+    Ieee80211AggregateFrame *aggregate = dynamic_cast<Ieee80211AggregateFrame *>(first);
+    int length = aggregate ? aggregate->getByteLength() : Ieee80211AggregateFrame::getSubframeLength(first);
+
+    // frames to other receivers keep their place in the queue; frames to
+    // the same receiver are taken in order, up to the first one that doesn't fit
+    Ieee80211DataOrMgmtFrameList::iterator it = transmissionQueue.begin();
+    for (++it; it != transmissionQueue.end(); )
+    {
+        Ieee80211DataOrMgmtFrame *frame = *it;
+        if (frame->getReceiverAddress() != first->getReceiverAddress())
+        {
+            ++it;
+            continue;
+        }
+
+        int subframeLength = Ieee80211AggregateFrame::getSubframeLength(frame);
+        if (!dynamic_cast<Ieee80211DataFrame *>(frame) || length + subframeLength > aggregationLimitBytes ||
+            computeFrameDuration(8 * (length + subframeLength), dataFrameBitrate) > aggregationLimitTime)
+            break;
+
+        if (!aggregate)
+        {
+            aggregate = new Ieee80211AggregateFrame("wlan-aggregate");
+            aggregate->setReceiverAddress(first->getReceiverAddress());
+            aggregate->setTransmitterAddress(first->getTransmitterAddress());
+            aggregate->setAddress3(first->getAddress3());
+            aggregate->setToDS(first->getToDS());
+            aggregate->setFromDS(first->getFromDS());
+            aggregate->setSequenceNumber(first->getSequenceNumber());
+            aggregate->addSubframe(first);
+            transmissionQueue.front() = aggregate;
+            numAggregated++;
+        }
+
+        EV << "adding frame " << frame << " to aggregate\n";
+        aggregate->addSubframe(frame);
+        length += subframeLength;
+        it = transmissionQueue.erase(it);
+        numAggregated++;
+
+        // the frame has left the queue, so make room for another one
+        if (queueModule)
+            queueModule->requestPacket();
+    }
+}
+
+void Ieee80211Mac::sendUpAggregate(Ieee80211AggregateFrame *aggregate)
+{
+    EV << "received aggregate of " << aggregate->getNumSubframes() << " frames\n";
+    while (Ieee80211DataOrMgmtFrame *frame = aggregate->removeFirstSubframe())
+    {
+        sendUp(frame);
+        numReceived++;
+    }
+}
+
 /****************************************************************
  * Helper functions.
  */
@@ -979,6 +1173,16 @@ bool Ieee80211Mac::isDataOrMgmtFrame(Ieee80211Frame *frame)
     return dynamic_cast<Ieee80211DataOrMgmtFrame*>(frame);
 }
 
+bool Ieee80211Mac::isAggregate(Ieee80211Frame *frame)
+{
+    return dynamic_cast<Ieee80211AggregateFrame*>(frame);
+}
+
+int Ieee80211Mac::getACKLength(Ieee80211DataOrMgmtFrame *frame)
+{
+    return isAggregate(frame) ? LENGTH_BLOCKACK : LENGTH_ACK;
+}
+
 Ieee80211Frame *Ieee80211Mac::getFrameReceivedBeforeSIFS()
 {
     return (Ieee80211Frame *)endSIFS->getContextPointer();
@@ -1001,7 +1205,7 @@ void Ieee80211Mac::popTransmissionQueue()
 
 double Ieee80211Mac::computeFrameDuration(Ieee80211Frame *msg)
 {
-    return computeFrameDuration(msg->getBitLength(), bitrate);
+    return computeFrameDuration(msg->getBitLength(), isBroadcast(msg) ? bitrate : dataFrameBitrate);
 }
 
 double Ieee80211Mac::computeFrameDuration(int bits, double bitrate)
@@ -22,13 +22,17 @@
 #define FSM_DEBUG
 
 #include <list>
+#include <map>
+#include <vector>
 #include "WirelessMacBase.h"
 #include "IPassiveQueue.h"
 #include "Ieee80211Frame_m.h"
+#include "Ieee80211AggregateFrame.h"
 #include "Ieee80211Consts.h"
 #include "NotificationBoard.h"
 #include "RadioState.h"
 #include "FSMA.h"
+#include "Ieee80211RateControl.h"
 
 /**
  * IEEE 802.11b Media Access Control Layer.
@@ -67,6 +71,8 @@ class INET_API Ieee80211Mac : public WirelessMacBase, public INotifiable
 
   typedef std::list<Ieee80211ASFTuple*> Ieee80211ASFTupleList;
 
+  typedef std::map<MACAddress,Ieee80211RateControl*> RateControlMap;
+
   protected:
     /**
      * @name Configuration parameters
@@ -76,9 +82,18 @@ class INET_API Ieee80211Mac : public WirelessMacBase, public INotifiable
     /** MAC address */
     MACAddress address;
 
-    /** The bitrate is used to send data and mgmt frames; be sure to use a valid 802.11 bitrate */
+    /**
+     * The bitrate is used to send data and mgmt frames; be sure to use a valid 802.11 bitrate.
+     * With rate control, unicast frames are sent at this bitrate or at a lower one.
+     */
     double bitrate;
 
+    /** Class name of the rate control algorithm (Ieee80211RateControl subclass), or empty for fixed bitrate */
+    std::string rateControlClass;
+
+    /** The bitrates the rate control algorithm can choose from, in increasing order */
+    std::vector<double> rateControlBitrates;
+
     /** The basic bitrate (1 or 2 Mbps) is used to transmit control frames */
     double basicBitrate;
 
@@ -104,6 +119,15 @@ class INET_API Ieee80211Mac : public WirelessMacBase, public INotifiable
      */
     int transmissionLimit;
 
+    /**
+     * Maximum length in bytes of an aggregate of data frames to the same
+     * receiver, sent in one transmission; 0 means no aggregation.
+     */
+    int aggregationLimitBytes;
+
+    /** Maximum duration of the transmission of an aggregate */
+    simtime_t aggregationLimitTime;
+
     /** Minimum contention window. */
     int cwMinData;
 
@@ -170,6 +194,12 @@ class INET_API Ieee80211Mac : public WirelessMacBase, public INotifiable
      */
     int retryCounter;
 
+    /** Bitrate of the current transmission attempt of a unicast data or mgmt frame */
+    double dataFrameBitrate;
+
+    /** Rate control state per destination address, created on demand */
+    RateControlMap rateControlMap;
+
     /** Physical radio (medium) state copied from physical layer */
     RadioState::State radioState;
 
@@ -226,8 +256,10 @@ class INET_API Ieee80211Mac : public WirelessMacBase, public INotifiable
     long numReceived;
     long numSentBroadcast;
     long numReceivedBroadcast;
+    long numAggregated;
     cOutVector stateVector;
     cOutVector radioStateVector;
+    cOutVector dataBitrateVector;
     //@}
 
   public:
@@ -346,12 +378,48 @@ class INET_API Ieee80211Mac : public WirelessMacBase, public INotifiable
     virtual Ieee80211DataOrMgmtFrame *buildBroadcastFrame(Ieee80211DataOrMgmtFrame *frameToSend);
     //@}
 
+    virtual Ieee80211BlockAckFrame *buildBlockAckFrame(Ieee80211DataOrMgmtFrame *frameToACK);
+
     /**
      * @brief Attaches a PhyControlInfo to the frame which will cause it to be sent at
      * basicBitrate not bitrate (e.g. 2Mbps instead of 11Mbps). Used with ACK, CTS, RTS.
      */
     virtual Ieee80211Frame *setBasicBitrate(Ieee80211Frame *frame);
 
+  protected:
+    /**
+     * @name Rate control functions
+     */
+    //@{
+    /** @brief Returns the rate control object of the destination, creating it on first use */
+    virtual Ieee80211RateControl *getRateControl(const MACAddress& address);
+
+    /** @brief Sets dataFrameBitrate for the next transmission attempt of the frame */
+    virtual void chooseDataFrameBitrate(Ieee80211DataOrMgmtFrame *frame);
+
+    /** @brief Reports the outcome of the current transmission attempt to the rate control */
+    virtual void reportDataFrameAcked();
+    virtual void reportDataFrameNotAcked();
+    //@}
+
+  protected:
+    /**
+     * @name Aggregation functions
+     */
+    //@{
+    /** @brief Chooses the bitrate of the current frame and aggregates it, right before it is sent */
+    virtual void prepareCurrentTransmission();
+
+    /**
+     * @brief Replaces the current frame with an aggregate of it and the data frames queued
+     * after it for the same receiver, as many as fit into the aggregation limits.
+     */
+    virtual void aggregateCurrentTransmission();
+
+    /** @brief Sends up the subframes of a received aggregate */
+    virtual void sendUpAggregate(Ieee80211AggregateFrame *aggregate);
+    //@}
+
   protected:
     /**
      * @name Utility functions
@@ -389,6 +457,12 @@ class INET_API Ieee80211Mac : public WirelessMacBase, public INotifiable
     /** @brief Checks if the frame is a data or management frame */
     virtual bool isDataOrMgmtFrame(Ieee80211Frame *frame);
 
+    /** @brief Checks if the frame is an aggregate of data frames */
+    virtual bool isAggregate(Ieee80211Frame *frame);
+
+    /** @brief Returns the length in bits of the ACK or block ack that acknowledges the frame */
+    virtual int getACKLength(Ieee80211DataOrMgmtFrame *frame);
+
     /** @brief Returns the last frame received before the SIFS period. */
     virtual Ieee80211Frame *getFrameReceivedBeforeSIFS();
 
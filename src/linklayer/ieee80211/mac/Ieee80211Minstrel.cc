@@ -0,0 +1,194 @@
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+
+#include "Ieee80211Minstrel.h"
+#include "Ieee80211Consts.h"
+
+Register_Class(Ieee80211Minstrel);
+
+
+Ieee80211Minstrel::Ieee80211Minstrel()
+{
+    updateInterval = 0.1;
+    ewmaLevel = 0.75;
+    lookaroundInterval = 10;
+    referenceFrameBits = 1200*8;
+}
+
+void Ieee80211Minstrel::initialize(const std::vector<double>& bitrates)
+{
+    Ieee80211RateControl::initialize(bitrates);
+    ASSERT(!rates.empty());
+
+    int n = rates.size();
+    stats.resize(n);
+    for (int i=0; i<n; i++)
+    {
+        stats[i].attempts = stats[i].successes = 0;
+        stats[i].prob = -1;
+        stats[i].throughput = 0;
+        stats[i].txTime = computeTxTime(rates[i]);
+    }
+
+    // start optimistic, sampling will correct it
+    maxTp = n-1;
+    maxTp2 = n>1 ? n-2 : 0;
+    maxProb = 0;
+    nextUpdate = simTime() + updateInterval;
+    frameCount = 0;
+}
+
+double Ieee80211Minstrel::computeTxTime(double bitrate)
+{
+    // DIFS, average backoff, the frame, SIFS and the ACK (see Ieee80211Mac;
+    // control frames go at 2Mbps)
+    return SIMTIME_DBL(DIFS) + CW_MIN * SIMTIME_DBL(ST) / 2 +
+           PHY_HEADER_LENGTH / BITRATE_HEADER + referenceFrameBits / bitrate +
+           SIMTIME_DBL(SIFS) +
+           PHY_HEADER_LENGTH / BITRATE_HEADER + LENGTH_ACK / 2E+6;
+}
+
+void Ieee80211Minstrel::updateStats()
+{
+    int n = rates.size();
+    for (int i=0; i<n; i++)
+    {
+        RateStats& s = stats[i];
+        if (s.attempts > 0)
+        {
+            double p = (double)s.successes / s.attempts;
+            s.prob = s.prob < 0 ? p : ewmaLevel * s.prob + (1-ewmaLevel) * p;
+            s.attempts = s.successes = 0;
+        }
+        // bitrates that rarely get through are not worth trying
+        s.throughput = s.prob < 0.1 ? 0 : s.prob * referenceFrameBits / s.txTime;
+    }
+
+    // best and second best throughput
+    int tp1 = -1, tp2 = -1;
+    for (int i=0; i<n; i++)
+    {
+        if (stats[i].throughput == 0)
+            continue;
+        if (tp1 < 0 || stats[i].throughput > stats[tp1].throughput)
+            {tp2 = tp1; tp1 = i;}
+        else if (tp2 < 0 || stats[i].throughput > stats[tp2].throughput)
+            tp2 = i;
+    }
+
+    // most reliable: the fastest one that succeeds at least 95% of the
+    // time, or if there's none, the one with the highest probability
+    int pr = -1;
+    for (int i=0; i<n; i++)
+    {
+        if (stats[i].prob < 0)
+            continue;
+        if (pr < 0)
+            pr = i;
+        else if (stats[i].prob >= 0.95)
+        {
+            if (stats[pr].prob < 0.95 || stats[i].throughput > stats[pr].throughput)
+                pr = i;
+        }
+        else if (stats[pr].prob < 0.95 && stats[i].prob > stats[pr].prob)
+            pr = i;
+    }
+
+    // keep the previous choices until there are measurements
+    if (tp1 >= 0)
+        maxTp = tp1;
+    maxTp2 = tp2 >= 0 ? tp2 : maxTp;
+    if (pr >= 0)
+        maxProb = pr;
+
+    nextUpdate = simTime() + updateInterval;
+}
+
+void Ieee80211Minstrel::buildRetryChain()
+{
+    int n = rates.size();
+    int sample = -1;
+    frameCount++;
+    if (n > 1 && frameCount % lookaroundInterval == 0)
+    {
+        // any bitrate except the current best one
+        sample = intrand(n-1);
+        if (sample >= maxTp)
+            sample++;
+    }
+
+    if (sample < 0)
+    {
+        retryChain[0] = maxTp;   chainLength[0] = 2;
+        retryChain[1] = maxTp2;  chainLength[1] = 2;
+    }
+    else if (stats[sample].txTime < stats[maxTp].txTime)
+    {
+        retryChain[0] = sample;  chainLength[0] = 1;
+        retryChain[1] = maxTp;   chainLength[1] = 2;
+    }
+    else
+    {
+        retryChain[0] = maxTp;   chainLength[0] = 2;
+        retryChain[1] = sample;  chainLength[1] = 1;
+    }
+    retryChain[2] = maxProb;  chainLength[2] = 2;
+    retryChain[3] = 0;
+}
+
+int Ieee80211Minstrel::findRate(double bitrate)
+{
+    for (int i=0; i<(int)rates.size(); i++)
+        if (rates[i] == bitrate)
+            return i;
+    throw cRuntimeError("Ieee80211Minstrel: bitrate %g is not in the rate set", bitrate);
+}
+
+double Ieee80211Minstrel::getBitrate(int retryCount)
+{
+    if (simTime() >= nextUpdate)
+        updateStats();
+    if (retryCount == 0)
+        buildRetryChain();
+
+    for (int i=0; i<3; i++)
+    {
+        if (retryCount < chainLength[i])
+            return rates[retryChain[i]];
+        retryCount -= chainLength[i];
+    }
+    return rates[retryChain[3]];
+}
+
+void Ieee80211Minstrel::reportSuccess(double bitrate, int retryCount)
+{
+    RateStats& s = stats[findRate(bitrate)];
+    s.attempts++;
+    s.successes++;
+}
+
+void Ieee80211Minstrel::reportFailure(double bitrate, int retryCount)
+{
+    stats[findRate(bitrate)].attempts++;
+}
+
+std::string Ieee80211Minstrel::info() const
+{
+    std::stringstream out;
+    out << "maxTp=" << rates[maxTp]/1e6 << "Mbps maxTp2=" << rates[maxTp2]/1e6
+        << "Mbps maxProb=" << rates[maxProb]/1e6 << "Mbps";
+    return out.str();
+}
+
@@ -0,0 +1,83 @@
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef __INET_IEEE80211MINSTREL_H
+#define __INET_IEEE80211MINSTREL_H
+
+#include "Ieee80211RateControl.h"
+
+
+/**
+ * Rate control in the style of Minstrel (the Linux mac80211 default).
+ *
+ * The success probability of every bitrate is measured: attempts and
+ * successes are counted, and every updateInterval they are folded into
+ * an exponentially weighted moving average. The expected throughput of
+ * a bitrate is its success probability divided by the time needed to
+ * transmit a reference frame at that bitrate.
+ *
+ * Each frame is sent along a retry chain: first at the bitrate of the
+ * highest expected throughput, then at the second highest, then at the
+ * most reliable one, and finally at the lowest bitrate. Every
+ * lookaroundInterval-th frame samples a randomly chosen bitrate instead,
+ * so that changes in the channel are noticed. A sample bitrate slower
+ * than the current best one is only tried on the second attempt.
+ *
+ * Unlike ARF, this does not assume that lower bitrates are more robust,
+ * so it also works when the error model does not rank the bitrates
+ * that way.
+ */
+class INET_API Ieee80211Minstrel : public Ieee80211RateControl
+{
+  protected:
+    struct RateStats
+    {
+        long attempts;     // in the current interval
+        long successes;    // in the current interval
+        double prob;       // EWMA of the success probability; -1 if not yet measured
+        double throughput; // expected throughput, bits per second
+        double txTime;     // duration of a successful attempt with the reference frame
+    };
+
+    // configuration, set in the ctor
+    simtime_t updateInterval;
+    double ewmaLevel;         // weight of the old value in the moving average
+    int lookaroundInterval;   // sample a bitrate every this many frames
+    int referenceFrameBits;   // frame size used to compute throughputs
+
+    // state
+    std::vector<RateStats> stats; // indexed like rates[]
+    int maxTp, maxTp2, maxProb;   // rate indices
+    simtime_t nextUpdate;
+    long frameCount;
+    int retryChain[4];  // rate indices for the current frame
+    int chainLength[3]; // attempts at each of the first three chain elements
+
+    virtual double computeTxTime(double bitrate);
+    virtual void updateStats();
+    virtual void buildRetryChain();
+    virtual int findRate(double bitrate);
+
+  public:
+    Ieee80211Minstrel();
+    virtual void initialize(const std::vector<double>& bitrates);
+    virtual double getBitrate(int retryCount);
+    virtual void reportSuccess(double bitrate, int retryCount);
+    virtual void reportFailure(double bitrate, int retryCount);
+    virtual std::string info() const;
+};
+
+#endif
+
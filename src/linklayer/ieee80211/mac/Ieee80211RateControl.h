@@ -0,0 +1,75 @@
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef __INET_IEEE80211RATECONTROL_H
+#define __INET_IEEE80211RATECONTROL_H
+
+#include <vector>
+#include <omnetpp.h>
+#include "INETDefs.h"
+
+
+/**
+ * Abstract base class for 802.11 rate control algorithms, which choose
+ * the bitrate of unicast data and management frames from the outcome
+ * (ACK received or not) of earlier transmissions.
+ *
+ * Ieee80211Mac creates one instance per destination address, of the class
+ * given in its rateControlClass parameter. For every transmission attempt
+ * it calls getBitrate(), and after the attempt either reportSuccess()
+ * or reportFailure().
+ */
+class INET_API Ieee80211RateControl : public cPolymorphic
+{
+  protected:
+    std::vector<double> rates; // bitrates to choose from, in increasing order
+
+  public:
+    /**
+     * Ctor.
+     */
+    Ieee80211RateControl() {}
+
+    /**
+     * Virtual dtor.
+     */
+    virtual ~Ieee80211RateControl() {}
+
+    /**
+     * Sets the bitrates to choose from (in increasing order), and
+     * initializes the object. Called once, before any other method.
+     */
+    virtual void initialize(const std::vector<double>& bitrates) {rates = bitrates;}
+
+    /**
+     * Returns the bitrate for the next transmission attempt of the current
+     * frame. retryCount is 0 for the first attempt of a frame, and it is
+     * incremented with every retransmission of the same frame.
+     */
+    virtual double getBitrate(int retryCount) = 0;
+
+    /**
+     * Called when the attempt made at the given bitrate was acknowledged.
+     */
+    virtual void reportSuccess(double bitrate, int retryCount) = 0;
+
+    /**
+     * Called when the attempt made at the given bitrate was not acknowledged.
+     */
+    virtual void reportFailure(double bitrate, int retryCount) = 0;
+};
+
+#endif
+
@@ -728,7 +728,15 @@ void Ieee80211MgmtSTA::handleAssociationResponseFrame(Ieee80211AssociationRespon
         isAssociated = true;
         (APInfo&)assocAP = (*ap);
 
-        nb->fireChangeNotification(NF_L2_ASSOCIATED, NULL); //XXX detail: InterfaceEntry?
+        // detail: the AP we are now associated with (e.g. for FMIPv6 in xMIPv6)
+        Ieee80211Prim_BSSDescription bssDesc;
+        bssDesc.setChannelNumber(ap->channel);
+        bssDesc.setBSSID(ap->address);
+        bssDesc.setSSID(ap->ssid.c_str());
+        bssDesc.setSupportedRates(ap->supportedRates);
+        bssDesc.setBeaconInterval(ap->beaconInterval);
+        bssDesc.setRxPower(ap->rxPower);
+        nb->fireChangeNotification(NF_L2_ASSOCIATED, &bssDesc); //XXX detail: InterfaceEntry?
 
         assocAP.beaconTimeoutMsg = new cMessage("beaconTimeout", MK_BEACON_TIMEOUT);
         scheduleAt(simTime()+MAX_BEACONS_MISSED*assocAP.beaconInterval, assocAP.beaconTimeoutMsg);
@@ -80,6 +80,7 @@ void AbstractRadio::initialize(int stage)
 
         receptionModel = createReceptionModel();
         receptionModel->initializeFrom(this);
+        receivedPowerCacheEpoch = 0;
 
         radioModel = createRadioModel();
         radioModel->initializeFrom(this);
@@ -365,6 +366,39 @@ void AbstractRadio::handleSelfMsg(cMessage *msg)
 }
 
 
+double AbstractRadio::calculateReceivedPower(AirFrame *airframe)
+{
+    // forget everything if we have moved since the cache was filled
+    unsigned int epoch = cc->getHostPositionEpoch(myHostRef);
+    if (epoch != receivedPowerCacheEpoch)
+    {
+        receivedPowerCache.clear();
+        receivedPowerCacheEpoch = epoch;
+    }
+
+    // the frame carries the sender's position at the time of sending, so
+    // a transmitter that has moved since the entry was made is detected
+    // by comparing positions (exactly, not with Coord's operator==).
+    // As the power only depends on the positions and pSend, the key only
+    // affects the hit rate, not correctness (frames picked up in
+    // changeChannel() are sent by ourselves, for example)
+    const Coord& framePos = airframe->getSenderPos();
+    ReceivedPowerCache::iterator it = receivedPowerCache.find(airframe->getSenderModuleId());
+    if (it != receivedPowerCache.end() && it->second.senderPos.x == framePos.x && it->second.senderPos.y == framePos.y
+        && it->second.pSend == airframe->getPSend())
+        return it->second.rcvdPower;
+
+    // calculate distance and receive power
+    double distance = getMyPosition().distance(framePos);
+    double rcvdPower = receptionModel->calculateReceivedPower(airframe->getPSend(), carrierFrequency, distance);
+
+    ReceivedPowerEntry& entry = receivedPowerCache[airframe->getSenderModuleId()];
+    entry.senderPos = framePos;
+    entry.pSend = airframe->getPSend();
+    entry.rcvdPower = rcvdPower;
+    return rcvdPower;
+}
+
 /**
  * This function is called right after a packet arrived, i.e. right
  * before it is buffered for 'transmission time'.
@@ -391,17 +425,10 @@ void AbstractRadio::handleSelfMsg(cMessage *msg)
 void AbstractRadio::handleLowerMsgStart(AirFrame * airframe)
 {
     // Calculate the receive power of the message
-
-    // calculate distance
-    const Coord& myPos = getMyPosition();
-    const Coord& framePos = airframe->getSenderPos();
-    double distance = myPos.distance(framePos);
-
-    // calculate receive power
-    double rcvdPower = receptionModel->calculateReceivedPower(airframe->getPSend(), carrierFrequency, distance);
+    double rcvdPower = calculateReceivedPower(airframe);
 
     // store the receive power in the recvBuff
-    recvBuff[airframe] = rcvdPower;
+    recvBuff.push_back(std::make_pair(airframe, rcvdPower));
 
     // if receive power is bigger than sensitivity and if not sending
     // and currently not receiving another message and the message has
@@ -413,10 +440,10 @@ void AbstractRadio::handleLowerMsgStart(AirFrame * airframe)
         EV << "receiving frame " << airframe->getName() << endl;
 
         // Put frame and related SnrList in receive buffer
-        SnrList snrList;
+        // (clear() keeps the list's storage for reuse)
         snrInfo.ptr = airframe;
         snrInfo.rcvdPower = rcvdPower;
-        snrInfo.sList = snrList;
+        snrInfo.sList.clear();
 
         // add initial snr value
         addNewSnr();
@@ -470,39 +497,41 @@ void AbstractRadio::handleLowerMsgEnd(AirFrame * airframe)
     if (snrInfo.ptr == airframe)
     {
         EV << "reception of frame over, preparing to send packet to upper layer\n";
-        // get Packet and list out of the receive buffer:
-        SnrList list;
-        list = snrInfo.sList;
-
-        // delete the pointer to indicate that no message is currently
-        // being received and clear the list
-        snrInfo.ptr = NULL;
-        snrInfo.sList.clear();
 
         // delete the frame from the recvBuff
-        recvBuff.erase(airframe);
+        removeFromRecvBuff(airframe);
 
         //XXX send up the frame:
         //if (radioModel->isReceivedCorrectly(airframe, list))
         //    sendUp(airframe);
         //else
         //    delete airframe;
+        // (the list is evaluated in place, and cleared afterwards)
+        const SnrList& list = snrInfo.sList;
         if (!radioModel->isReceivedCorrectly(airframe, list))
         {
             airframe->getEncapsulatedMsg()->setKind(list.size()>1 ? COLLISION : BITERROR);
             airframe->setName(list.size()>1 ? "COLLISION" : "BITERROR");
         }
+
+        // delete the pointer to indicate that no message is currently
+        // being received and clear the list
+        snrInfo.ptr = NULL;
+        snrInfo.sList.clear();
+
         sendUp(airframe);
     }
     // all other messages are noise
     else
     {
         EV << "reception of noise message over, removing recvdPower from noiseLevel....\n";
-        // get the rcvdPower and subtract it from the noiseLevel
-        noiseLevel -= recvBuff[airframe];
+        // get the rcvdPower and subtract it from the noiseLevel,
+        // and delete message from the recvBuff
+        noiseLevel -= removeFromRecvBuff(airframe);
 
-        // delete message from the recvBuff
-        recvBuff.erase(airframe);
+        // nothing on the air: drop rounding errors accumulated in noiseLevel
+        if (recvBuff.empty())
+            noiseLevel = thermalNoise;
 
         // update snr info for message currently being received if any
         if (snrInfo.ptr != NULL)
@@ -527,6 +556,22 @@ void AbstractRadio::handleLowerMsgEnd(AirFrame * airframe)
     }
 }
 
+double AbstractRadio::removeFromRecvBuff(AirFrame *airframe)
+{
+    for (RecvBuff::iterator it = recvBuff.begin(); it != recvBuff.end(); ++it)
+    {
+        if (it->first == airframe)
+        {
+            double rcvdPower = it->second;
+            *it = recvBuff.back();
+            recvBuff.pop_back();
+            return rcvdPower;
+        }
+    }
+    error("frame not found in recvBuff");
+    return 0;
+}
+
 void AbstractRadio::addNewSnr()
 {
     SnrListEntry listEntry;     // create a new entry
@@ -98,6 +98,15 @@ class INET_API AbstractRadio : public ChannelAccess
     /** Returns the current channel the radio is tuned to */
     virtual int getChannelNumber() const {return rs.getChannelNumber();}
 
+    /**
+     * Returns the received power of the frame, using the reception model.
+     * The result is cached per transmitter until either end moves.
+     */
+    virtual double calculateReceivedPower(AirFrame *airframe);
+
+    /** Removes the frame from recvBuff, and returns its receive power */
+    virtual double removeFromRecvBuff(AirFrame *airframe);
+
     /** Updates the SNR information of the relevant AirFrame */
     virtual void addNewSnr();
 
@@ -166,9 +175,10 @@ class INET_API AbstractRadio : public ChannelAccess
 
     /**
      * Typedef used to store received messages together with
-     * receive power.
+     * receive power. There are only a few frames on the air at a time,
+     * so a vector is used instead of a map.
      */
-    typedef std::map<AirFrame*,double> RecvBuff;
+    typedef std::vector<std::pair<AirFrame*,double> > RecvBuff;
 
     /**
      * State: A buffer to store a pointer to a message and the related
@@ -176,6 +186,30 @@ class INET_API AbstractRadio : public ChannelAccess
      */
     RecvBuff recvBuff;
 
+    /**
+     * Cached received power from a transmitter, valid as long as
+     * the transmitter and this host stay where they are.
+     */
+    struct ReceivedPowerEntry
+    {
+        Coord senderPos;  ///< sender position the power was calculated for
+        double pSend;     ///< transmit power the power was calculated for
+        double rcvdPower; ///< the received power
+    };
+
+    /**
+     * Typedef used to store the received power cache, keyed by the
+     * module ID of the transmitting radio.
+     */
+    typedef std::map<int,ReceivedPowerEntry> ReceivedPowerCache;
+
+    /**
+     * State: cache of received powers; it is cleared when this host moves,
+     * i.e. when its position epoch differs from receivedPowerCacheEpoch.
+     */
+    ReceivedPowerCache receivedPowerCache;
+    unsigned int receivedPowerCacheEpoch;
+
     /** State: the current RadioState of the NIC; includes channel number */
     RadioState rs;
 
@@ -37,6 +37,8 @@ class INET_API IReceptionModel : public cPolymorphic
 
     /**
      * To be redefined to calculate the received power of a transmission.
+     * The result must only depend on the arguments, because AbstractRadio
+     * caches it for transmitters that have not moved.
      */
     virtual double calculateReceivedPower(double pSend, double carrierFrequency, double distance) = 0;
 
@@ -45,8 +45,13 @@ bool Ieee80211RadioModel::isReceivedCorrectly(AirFrame *airframe, const SnrList&
         if (iter->snr < snirMin)
             snirMin = iter->snr;
 
-    cPacket *frame = airframe->getEncapsulatedMsg();
-    EV << "packet (" << frame->getClassName() << ")" << frame->getName() << " (" << frame->info() << ") snrMin=" << snirMin << endl;
+    // NOTE: getEncapsulatedMsg() makes a private copy of the frame if it is
+    // shared with the AirFrames sent to other hosts, so don't call it just for logging
+    if (!ev.isDisabled())
+    {
+        cPacket *frame = airframe->getEncapsulatedMsg();
+        EV << "packet (" << frame->getClassName() << ")" << frame->getName() << " (" << frame->info() << ") snrMin=" << snirMin << endl;
+    }
 
     if (snirMin <= snirThreshold)
     {
@@ -54,7 +59,8 @@ bool Ieee80211RadioModel::isReceivedCorrectly(AirFrame *airframe, const SnrList&
         EV << "COLLISION! Packet got lost\n";
         return false;
     }
-    else if (isPacketOK(snirMin, airframe->getEncapsulatedMsg()->getBitLength(), airframe->getBitrate()))
+    // AirFrame length == frame length
+    else if (isPacketOK(snirMin, airframe->getBitLength(), airframe->getBitrate()))
     {
         EV << "packet was received correctly, it is now handed to upper layer...\n";
         return true;
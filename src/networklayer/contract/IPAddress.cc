@@ -211,8 +211,8 @@ int IPAddress::getNumMatchingPrefixBits(const IPAddress& to_cmp) const
 int IPAddress::getNetmaskLength() const
 {
     int i;
-    for (i=0; i<31; i++)
-        if (addr & (1 << i))
+    for (i=0; i<32; i++)
+        if (addr & (1U << i))
             return 32-i;
     return 0;
 }
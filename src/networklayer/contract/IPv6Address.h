@@ -132,6 +132,20 @@ class INET_API IPv6Address
                    d[3]<addr.d[3] ? -1 : d[3]>addr.d[3] ? 1 : 0;
         }
 
+        /**
+         * Returns a 32-bit hash of the address, suitable for indexing
+         * hash tables keyed by IPv6 address. All four words contribute,
+         * so addresses sharing a common prefix still spread well.
+         */
+        uint32 hash() const  {
+            uint32 h = d[0];
+            h = h*0x9e3779b1U ^ d[1];
+            h = h*0x9e3779b1U ^ d[2];
+            h = h*0x9e3779b1U ^ d[3];
+            h *= 0x9e3779b1U;
+            return h ^ (h>>16);
+        }
+
         /**
          *  Try parsing an IPv6 address.
          *  Return true if the string contained a well-formed IPv6 address,
@@ -233,6 +233,21 @@ class INET_API IPvXAddress
      */
     bool operator!=(const IPvXAddress& addr) const {return !equals(addr);}
 
+    /**
+     * Returns a 32-bit hash of the address, suitable for indexing hash
+     * tables keyed by IPvXAddress.
+     */
+    uint32 hash() const {
+        uint32 h = d[0];
+        if (isv6) {
+            h = h*0x9e3779b1U ^ d[1];
+            h = h*0x9e3779b1U ^ d[2];
+            h = h*0x9e3779b1U ^ d[3];
+        }
+        h *= 0x9e3779b1U;
+        return h ^ (h>>16);
+    }
+
     /**
      * Compares two addresses.
      */
@@ -2125,14 +2125,19 @@ void IPv6NeighbourDiscovery::sendSolicitedNA(IPv6NeighbourSolicitation *ns,
 }
 
 void IPv6NeighbourDiscovery::sendUnsolicitedNA(InterfaceEntry *ie)
+{
+    sendUnsolicitedNA(ie, ie->ipv6Data()->getPreferredAddress());
+}
+
+void IPv6NeighbourDiscovery::sendUnsolicitedNA(InterfaceEntry *ie, const IPv6Address& target)
 {
     //RFC 2461
     //Section 7.2.6: Sending Unsolicited Neighbor Advertisements
 	Enter_Method_Silent();
-	EV << "sending unsolicited NA" << endl;
+	EV << "sending unsolicited NA for " << target << endl;
 
     IPv6NeighbourAdvertisement *na = new IPv6NeighbourAdvertisement("NApacket");
-    IPv6Address myIPv6Addr = ie->ipv6Data()->getPreferredAddress();
+    IPv6Address myIPv6Addr = target;
     //RFC 2461: Section 7.2.6
     /*The Target Address field in the unsolicited advertisement is set to
 	  an IP address of the interface, and the Target Link-Layer Address
@@ -2185,6 +2190,59 @@ void IPv6NeighbourDiscovery::sendUnsolicitedNA(InterfaceEntry *ie)
     sendPacketToIPv6Module(na, IPv6Address::ALL_NODES_2, myIPv6Addr, ie->getInterfaceId());
 }
 
+void IPv6NeighbourDiscovery::bufferPacketsForNeighbour(const IPv6Address& addr,
+    InterfaceEntry *ie, simtime_t bufferTime)
+{
+    Enter_Method_Silent();
+
+    if (neighbourCache.lookup(addr, ie->getInterfaceId()) != NULL)
+    {
+        // the MN has already made itself known on the link (e.g. reactive handover)
+        EV << "Neighbour " << addr << " already known, no buffering needed\n";
+        return;
+    }
+
+    EV << "Buffering packets for " << addr << " on " << ie->getName()
+       << " for " << bufferTime << "s\n";
+    Neighbour *nce = neighbourCache.addNeighbour(addr, ie->getInterfaceId());
+    nce->nsSrcAddr = ie->ipv6Data()->getPreferredAddress();
+
+    // the MN is not on the link yet, so there is no point in sending NSs:
+    // the entry is created as if all of them had already been sent, and
+    // processARTimeout() drops the queued packets once bufferTime is over
+    nce->numOfARNSSent = ie->ipv6Data()->_getMaxMulticastSolicit();
+    cMessage *msg = new cMessage("arTimeout", MK_AR_TIMEOUT);
+    nce->arTimer = msg;
+    msg->setContextPointer(nce);
+    scheduleAt(simTime()+bufferTime, msg);
+}
+
+void IPv6NeighbourDiscovery::attachToNewAccessRouter(InterfaceEntry *ie, const IPv6Address& routerAddr,
+    const MACAddress& routerMACAddr, simtime_t routerLifetime, const IPv6Address& prefix,
+    int prefixLength, const IPv6Address& CoA, simtime_t validLifetime, simtime_t preferredLifetime)
+{
+    Enter_Method_Silent();
+    int ifID = ie->getInterfaceId();
+
+    EV << "Attaching to new access router " << routerAddr << " with CoA " << CoA << endl;
+
+    // same as on receiving a RA from a new default router, see processRAForRouterUpdates()
+    routersUnreachabilityDetection(ie);
+    if (neighbourCache.lookup(routerAddr, ifID) == NULL)
+        neighbourCache.addRouter(routerAddr, ifID, routerMACAddr, simTime()+routerLifetime);
+    rt6->addDefaultRoute(routerAddr, ifID, simTime()+routerLifetime);
+    rt6->addOrUpdateOnLinkPrefix(prefix, prefixLength, ifID, simTime()+validLifetime);
+
+    // RFC 5568, 5.2: the NCoA is used without DAD; the NAR has already
+    // accepted it in the HAck (predictive mode), otherwise the MN takes
+    // the (small) risk of a collision as with optimistic DAD
+    if (!ie->ipv6Data()->hasAddress(CoA))
+        ie->ipv6Data()->assignAddress(CoA, false, simTime()+validLifetime, simTime()+preferredLifetime);
+
+    // this also delivers the packets the NAR has buffered for the NCoA
+    sendUnsolicitedNA(ie, CoA);
+}
+
 void IPv6NeighbourDiscovery::processNAPacket(IPv6NeighbourAdvertisement *na,
     IPv6ControlInfo *naCtrlInfo)
 {
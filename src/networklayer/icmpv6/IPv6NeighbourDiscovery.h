@@ -339,6 +339,32 @@ class INET_API IPv6NeighbourDiscovery : public cSimpleModule
             IPv6ControlInfo *nsCtrlInfo, InterfaceEntry *ie);
 public: // update 12.9.07 - CB
         virtual void sendUnsolicitedNA(InterfaceEntry *ie);
+
+        /**
+         * Like sendUnsolicitedNA(InterfaceEntry*), but advertises the given
+         * address of the interface instead of its preferred address.
+         */
+        virtual void sendUnsolicitedNA(InterfaceEntry *ie, const IPv6Address& target);
+
+        /**
+         * FMIPv6 (RFC 5568) support for new access routers: creates an
+         * INCOMPLETE neighbour entry for the new CoA of a MN that is about to
+         * arrive on the interface. Packets for it are queued without sending
+         * NSs until the MN announces itself with an unsolicited NA, and
+         * dropped if it has not done so within bufferTime.
+         */
+        virtual void bufferPacketsForNeighbour(const IPv6Address& addr, InterfaceEntry *ie, simtime_t bufferTime);
+
+        /**
+         * FMIPv6 (RFC 5568) support for mobile nodes: makes the given router
+         * the default router of the interface and assigns the new CoA
+         * formed from its prefix, without waiting for a RA and without DAD,
+         * then announces the CoA with an unsolicited NA. The router and
+         * prefix information come from a Proxy Router Advertisement.
+         */
+        virtual void attachToNewAccessRouter(InterfaceEntry *ie, const IPv6Address& routerAddr,
+            const MACAddress& routerMACAddr, simtime_t routerLifetime, const IPv6Address& prefix,
+            int prefixLength, const IPv6Address& CoA, simtime_t validLifetime, simtime_t preferredLifetime);
 protected: // update 12.9.07 - CB
         virtual void processNAPacket(IPv6NeighbourAdvertisement *na, IPv6ControlInfo *naCtrlInfo);
         virtual bool validateNAPacket(IPv6NeighbourAdvertisement *na, IPv6ControlInfo *naCtrlInfo);
@@ -0,0 +1,198 @@
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+
+
+#include <algorithm>
+#include "IPRouteTrie.h"
+#include "IPRoute.h"
+
+
+IPRouteTrie::IPRouteTrie()
+{
+    clear();
+}
+
+void IPRouteTrie::clear()
+{
+    nodes.clear();
+    prefixes.clear();
+    freeNodes = freePrefixes = -1;
+    numRoutes = 0;
+    allocateNode();  // the root
+}
+
+int IPRouteTrie::allocateNode()
+{
+    int i;
+    if (freeNodes >= 0)
+    {
+        i = freeNodes;
+        freeNodes = nodes[i].firstPrefix;
+    }
+    else
+    {
+        i = nodes.size();
+        nodes.push_back(Node());
+    }
+
+    Node& node = nodes[i];
+    for (int k = 0; k < 16; k++)
+        node.slot[k].child = node.slot[k].prefix = -1;
+    node.firstPrefix = -1;
+    node.numChildren = 0;
+    return i;
+}
+
+int IPRouteTrie::allocatePrefix()
+{
+    if (freePrefixes < 0)
+    {
+        prefixes.push_back(Prefix());
+        return prefixes.size() - 1;
+    }
+    int i = freePrefixes;
+    freePrefixes = prefixes[i].next;
+    return i;
+}
+
+int IPRouteTrie::findPrefix(int node, uint32 addr, int length) const
+{
+    for (int p = nodes[node].firstPrefix; p >= 0; p = prefixes[p].next)
+        if (prefixes[p].length == length && prefixes[p].addr == addr)
+            return p;
+    return -1;
+}
+
+bool IPRouteTrie::covers(const Prefix& p, int depth, int slot) const
+{
+    // all prefixes of a node agree in the bits above the node,
+    // so only the bits within this node's nibble need to be checked
+    int bits = p.length - 4*depth;
+    return bits <= 0 || (nibble(p.addr, depth) >> (4 - bits)) == (slot >> (4 - bits));
+}
+
+void IPRouteTrie::insert(IPRoute *route)
+{
+    int length = route->getNetmask().getNetmaskLength();
+    uint32 addr = route->getHost().getInt() & route->getNetmask().getInt();
+    int depth = depthOf(length);
+
+    // find or create the node that holds prefixes of this length
+    int node = 0;
+    for (int d = 0; d < depth; d++)
+    {
+        int k = nibble(addr, d);
+        if (nodes[node].slot[k].child < 0)
+        {
+            int child = allocateNode();  // may reallocate nodes[]
+            nodes[node].slot[k].child = child;
+            nodes[node].numChildren++;
+        }
+        node = nodes[node].slot[k].child;
+    }
+    numRoutes++;
+
+    int p = findPrefix(node, addr, length);
+    if (p >= 0)
+    {
+        // the first route of the prefix stays the one in use
+        prefixes[p].routes.push_back(route);
+        return;
+    }
+
+    p = allocatePrefix();
+    Prefix& prefix = prefixes[p];
+    prefix.addr = addr;
+    prefix.length = length;
+    prefix.routes.push_back(route);
+    prefix.next = nodes[node].firstPrefix;
+    nodes[node].firstPrefix = p;
+
+    // expand it to the slots it covers, unless a longer prefix is already there
+    int bits = length - 4*depth;
+    int first = bits <= 0 ? 0 : nibble(addr, depth) & ~((1 << (4 - bits)) - 1);
+    int count = bits <= 0 ? 16 : 1 << (4 - bits);
+    for (int k = first; k < first + count; k++)
+    {
+        Slot& s = nodes[node].slot[k];
+        if (s.prefix < 0 || prefixes[s.prefix].length < length)
+            s.prefix = p;
+    }
+}
+
+bool IPRouteTrie::remove(IPRoute *route)
+{
+    int length = route->getNetmask().getNetmaskLength();
+    uint32 addr = route->getHost().getInt() & route->getNetmask().getInt();
+    int depth = depthOf(length);
+
+    // find the node, remembering the path to it
+    int path[8];
+    int node = 0;
+    for (int d = 0; d < depth; d++)
+    {
+        path[d] = node;
+        node = nodes[node].slot[nibble(addr, d)].child;
+        if (node < 0)
+            return false;
+    }
+
+    int p = findPrefix(node, addr, length);
+    if (p < 0)
+        return false;
+    std::vector<IPRoute *>& routes = prefixes[p].routes;
+    std::vector<IPRoute *>::iterator it = std::find(routes.begin(), routes.end(), route);
+    if (it == routes.end())
+        return false;
+    routes.erase(it);
+    numRoutes--;
+    if (!routes.empty())
+        return true;
+
+    // last route of the prefix: unlink it from the node...
+    int *link = &nodes[node].firstPrefix;
+    while (*link != p)
+        link = &prefixes[*link].next;
+    *link = prefixes[p].next;
+    prefixes[p].next = freePrefixes;
+    freePrefixes = p;
+
+    // ...and give its slots to the longest remaining prefix covering them
+    int bits = length - 4*depth;
+    int first = bits <= 0 ? 0 : nibble(addr, depth) & ~((1 << (4 - bits)) - 1);
+    int count = bits <= 0 ? 16 : 1 << (4 - bits);
+    for (int k = first; k < first + count; k++)
+    {
+        Slot& s = nodes[node].slot[k];
+        if (s.prefix != p)
+            continue;
+        s.prefix = -1;
+        for (int q = nodes[node].firstPrefix; q >= 0; q = prefixes[q].next)
+            if (covers(prefixes[q], depth, k) && (s.prefix < 0 || prefixes[q].length > prefixes[s.prefix].length))
+                s.prefix = q;
+    }
+
+    // free nodes that became empty, bottom up (the root is kept)
+    while (depth > 0 && nodes[node].firstPrefix < 0 && nodes[node].numChildren == 0)
+    {
+        nodes[node].firstPrefix = freeNodes;
+        freeNodes = node;
+
+        node = path[--depth];
+        nodes[node].slot[nibble(addr, depth)].child = -1;
+        nodes[node].numChildren--;
+    }
+    return true;
+}
@@ -0,0 +1,138 @@
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef __IPROUTETRIE_H
+#define __IPROUTETRIE_H
+
+#include <vector>
+#include "INETDefs.h"
+#include "IPAddress.h"
+
+class IPRoute;
+
+
+/**
+ * Forwarding table of RoutingTable: a multibit trie with a stride of 4 bits,
+ * holding the unicast routes that have a contiguous netmask.
+ *
+ * Each node has 16 slots; a slot points to the child node for the next 4 bits
+ * of the address, and to the longest prefix stored in this node that covers
+ * the slot (prefixes are expanded to the slots they cover). A lookup reads
+ * at most 8 slots, remembering the last prefix seen. Inserting or removing a
+ * prefix only updates the slots of its own node, so routes can be changed
+ * one by one without rebuilding anything.
+ *
+ * Routes with the same prefix are kept in insertion order, and the first one
+ * is returned by longestMatch(); this is the order RoutingTable keeps its
+ * routes in, so the result is the same as that of a linear search for the
+ * first route with the longest matching netmask.
+ *
+ * Nodes and prefixes are stored in vectors and referred to by index;
+ * unused ones are kept on free lists.
+ */
+class INET_API IPRouteTrie
+{
+  protected:
+    struct Slot
+    {
+        int child;   // child node, or -1
+        int prefix;  // longest prefix of this node covering the slot, or -1
+    };
+
+    struct Node
+    {
+        Slot slot[16];
+        int firstPrefix;  // prefixes stored in this node, linked via Prefix::next
+        int numChildren;  // number of slots with a child
+    };
+
+    struct Prefix
+    {
+        uint32 addr;
+        int length;
+        int next;                    // next prefix in the same node (or in the free list)
+        std::vector<IPRoute *> routes;  // routes with this prefix, in insertion order
+    };
+
+    std::vector<Node> nodes;  // nodes[0] is the root
+    std::vector<Prefix> prefixes;
+    int freeNodes;            // unused nodes, linked via firstPrefix
+    int freePrefixes;         // unused prefixes, linked via next
+    int numRoutes;
+
+  protected:
+    static int nibble(uint32 addr, int depth) {return (addr >> (28 - 4*depth)) & 15;}
+    static int depthOf(int length) {return length == 0 ? 0 : (length - 1) / 4;}
+    int allocateNode();
+    int allocatePrefix();
+    int findPrefix(int node, uint32 addr, int length) const;
+    bool covers(const Prefix& p, int depth, int slot) const;
+
+  public:
+    IPRouteTrie();
+
+    /**
+     * Adds a route. Its netmask must be contiguous.
+     */
+    void insert(IPRoute *route);
+
+    /**
+     * Removes the given route, and returns true if it was found.
+     */
+    bool remove(IPRoute *route);
+
+    /**
+     * Returns the first route with the longest prefix matching the
+     * address, or NULL if there is no such route.
+     */
+    IPRoute *longestMatch(const IPAddress& dest) const
+    {
+        uint32 addr = dest.getInt();
+        int best = -1;
+        int node = 0;
+        for (int depth = 0; depth < 8; depth++)
+        {
+            const Slot& s = nodes[node].slot[nibble(addr, depth)];
+            if (s.prefix >= 0)
+                best = s.prefix;
+            if (s.child < 0)
+                break;
+            node = s.child;
+        }
+        return best < 0 ? NULL : prefixes[best].routes.front();
+    }
+
+    /**
+     * Returns the number of routes in the trie.
+     */
+    int size() const {return numRoutes;}
+
+    /**
+     * Removes all routes.
+     */
+    void clear();
+
+    /**
+     * Returns true if the netmask consists of a run of 1 bits followed
+     * by 0 bits, i.e. a route with it can be stored in the trie.
+     */
+    static bool isContiguousNetmask(const IPAddress& netmask)
+    {
+        uint32 inv = ~netmask.getInt();
+        return (inv & (inv + 1)) == 0;
+    }
+};
+
+#endif
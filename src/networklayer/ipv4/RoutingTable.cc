@@ -65,6 +65,7 @@ void RoutingTable::initialize(int stage)
         ift = InterfaceTableAccess().get();
 
         IPForward = par("IPForward").boolValue();
+        routingCacheSize = par("routingCacheSize");
 
         nb->subscribe(this, NF_INTERFACE_CREATED);
         nb->subscribe(this, NF_INTERFACE_DELETED);
@@ -221,6 +222,40 @@ void RoutingTable::invalidateCache()
     localAddresses.clear();
 }
 
+void RoutingTable::invalidateCache(const IPRoute *entry)
+{
+    // only lookups of destinations within the route's prefix are affected;
+    // with a contiguous netmask, these are a range of the cache
+    if (routingCache.empty())
+        return;
+    if (!IPRouteTrie::isContiguousNetmask(entry->getNetmask()))
+    {
+        routingCache.clear();
+        return;
+    }
+    uint32 addr = entry->getHost().getInt() & entry->getNetmask().getInt();
+    routingCache.erase(routingCache.lower_bound(addr),
+                       routingCache.upper_bound(addr | ~entry->getNetmask().getInt()));
+}
+
+void RoutingTable::addToFib(IPRoute *entry)
+{
+    if (IPRouteTrie::isContiguousNetmask(entry->getNetmask()))
+        fib.insert(entry);
+    else
+        irregularRoutes.push_back(entry);
+    invalidateCache(entry);
+}
+
+void RoutingTable::removeFromFib(IPRoute *entry)
+{
+    if (IPRouteTrie::isContiguousNetmask(entry->getNetmask()))
+        fib.remove(entry);
+    else
+        irregularRoutes.erase(std::find(irregularRoutes.begin(), irregularRoutes.end(), entry));
+    invalidateCache(entry);
+}
+
 void RoutingTable::printRoutingTable() const
 {
     EV << "-- Routing table --\n";
@@ -320,25 +355,40 @@ const IPRoute *RoutingTable::findBestMatchingRoute(const IPAddress& dest) const
 {
     Enter_Method("findBestMatchingRoute(%x)", dest.getInt()); // note: str().c_str() too slow here
 
-    RoutingCache::iterator it = routingCache.find(dest);
-    if (it != routingCache.end())
-        return it->second;
+    if (routingCacheSize > 0)
+    {
+        RoutingCache::iterator it = routingCache.find(dest);
+        if (it != routingCache.end())
+            return it->second;
+    }
 
     // find best match (one with longest prefix)
     // default route has zero prefix length, so (if exists) it'll be selected as last resort
-    const IPRoute *bestRoute = NULL;
-    uint32 longestNetmask = 0;
-    for (RouteVector::const_iterator i=routes.begin(); i!=routes.end(); ++i)
+    const IPRoute *bestRoute = fib.longestMatch(dest);
+
+    // routes with a non-contiguous netmask are not in the trie; like for the
+    // others, the one with the numerically largest netmask wins
+    if (!irregularRoutes.empty())
     {
-        const IPRoute *e = *i;
-        if (IPAddress::maskedAddrAreEqual(dest, e->getHost(), e->getNetmask()) &&  // match
-            (!bestRoute || e->getNetmask().getInt() > longestNetmask))  // longest so far
+        uint32 longestNetmask = bestRoute ? bestRoute->getNetmask().getInt() : 0;
+        for (RouteVector::const_iterator i=irregularRoutes.begin(); i!=irregularRoutes.end(); ++i)
         {
-            bestRoute = e;
-            longestNetmask = e->getNetmask().getInt();
+            const IPRoute *e = *i;
+            if (IPAddress::maskedAddrAreEqual(dest, e->getHost(), e->getNetmask()) &&  // match
+                (!bestRoute || e->getNetmask().getInt() > longestNetmask))  // longest so far
+            {
+                bestRoute = e;
+                longestNetmask = e->getNetmask().getInt();
+            }
         }
     }
-    routingCache[dest] = bestRoute;
+
+    if (routingCacheSize > 0)
+    {
+        if (routingCache.size() >= routingCacheSize)
+            routingCache.clear();
+        routingCache[dest] = bestRoute;
+    }
     return bestRoute;
 }
 
@@ -436,11 +486,13 @@ void RoutingTable::addRoute(const IPRoute *entry)
 
     // add to tables
     if (!entry->getHost().isMulticast())
+    {
         routes.push_back(const_cast<IPRoute*>(entry));
+        addToFib(const_cast<IPRoute*>(entry));
+    }
     else
         multicastRoutes.push_back(const_cast<IPRoute*>(entry));
 
-    invalidateCache();
     updateDisplayString();
 
     nb->fireChangeNotification(NF_IPv4_ROUTE_ADDED, entry);
@@ -456,8 +508,8 @@ bool RoutingTable::deleteRoute(const IPRoute *entry)
     {
         nb->fireChangeNotification(NF_IPv4_ROUTE_DELETED, entry); // rather: going to be deleted
         routes.erase(i);
+        removeFromFib(const_cast<IPRoute*>(entry));
         delete entry;
-        invalidateCache();
         updateDisplayString();
         return true;
     }
@@ -467,7 +519,6 @@ bool RoutingTable::deleteRoute(const IPRoute *entry)
         nb->fireChangeNotification(NF_IPv4_ROUTE_DELETED, entry); // rather: going to be deleted
         multicastRoutes.erase(i);
         delete entry;
-        invalidateCache();
         updateDisplayString();
         return true;
     }
@@ -497,8 +548,13 @@ void RoutingTable::updateNetmaskRoutes()
 {
     // first, delete all routes with src=IFACENETMASK
     for (unsigned int k=0; k<routes.size(); k++)
+    {
         if (routes[k]->getSource()==IPRoute::IFACENETMASK)
+        {
+            removeFromFib(routes[k]);
             routes.erase(routes.begin()+(k--));  // '--' is necessary because indices shift down
+        }
+    }
 
     // then re-add them, according to actual interface configuration
     for (int i=0; i<ift->getNumInterfaces(); i++)
@@ -515,6 +571,7 @@ void RoutingTable::updateNetmaskRoutes()
             route->setMetric(ie->ipv4Data()->getMetric());
             route->setInterface(ie);
             routes.push_back(route);
+            addToFib(route);
         }
     }
 
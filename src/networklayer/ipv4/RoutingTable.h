@@ -35,6 +35,7 @@
 #include "IInterfaceTable.h"
 #include "NotificationBoard.h"
 #include "IRoutingTable.h"
+#include "IPRouteTrie.h"
 
 class RoutingTableParser;
 
@@ -85,9 +86,16 @@ class INET_API RoutingTable: public cSimpleModule, public IRoutingTable, protect
     RouteVector routes;          // Unicast route array
     RouteVector multicastRoutes; // Multicast route array
 
-    // routing cache: maps destination address to the route
+    // forwarding table: unicast routes with a contiguous netmask; the rest
+    // (if any) are searched linearly
+    IPRouteTrie fib;
+    RouteVector irregularRoutes;
+
+    // routing cache: maps destination address to the route; it is bounded
+    // by routingCacheSize (0 means no cache), and emptied when full
     typedef std::map<IPAddress, const IPRoute *> RoutingCache;
     mutable RoutingCache routingCache;
+    unsigned int routingCacheSize;
 
     // local addresses cache (to speed up isLocalAddress())
     typedef std::set<IPAddress> AddressSet;
@@ -117,6 +125,14 @@ class INET_API RoutingTable: public cSimpleModule, public IRoutingTable, protect
     // invalidates routing cache and local addresses cache
     virtual void invalidateCache();
 
+    // invalidates cached lookups that may be affected by adding or removing the route
+    virtual void invalidateCache(const IPRoute *entry);
+
+    // adds/removes a unicast route to/from the forwarding table, and removes
+    // the cached lookups it might affect
+    virtual void addToFib(IPRoute *entry);
+    virtual void removeFromFib(IPRoute *entry);
+
   public:
     RoutingTable();
     virtual ~RoutingTable();
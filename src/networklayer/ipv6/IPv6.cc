@@ -282,7 +282,10 @@ void IPv6::routePacket(IPv6Datagram *datagram, InterfaceEntry *destIE, bool from
 
     // tunneling support - CB
     // check if destination is covered by tunnel lists
-    if ( (datagram->getTransportProtocol() != IP_PROT_IPv6) && // if datagram was already tunneled, don't tunnel again
+    // datagrams that we have just tunneled ourselves are not tunneled again, but
+    // tunneled datagrams forwarded by a router may be (e.g. a FMIPv6 previous
+    // access router forwarding the HA's datagrams for the old CoA to the new one)
+    if ( (datagram->getTransportProtocol() != IP_PROT_IPv6 || !fromHL) &&
     	 (datagram->getExtensionHeaderArraySize() == 0 ) && // we do not already have extension headers - FIXME: check for RH2 existence
     	  ( (rt->isMobileNode() && rt->isHomeAddress( datagram->getSrcAddress() ) ) || // for MNs: only if source address is a HoA // 27.08.07 - CB
     		 rt->isHomeAgent() || // but always check for tunnel if node is a HA
@@ -728,20 +731,29 @@ bool IPv6::determineOutputInterface(const IPv6Address& destAddress, IPv6Address&
 {
 	// try destination cache
     //IPv6Address nextHop = rt->lookupDestCache(destAddress, interfaceId);
-	nextHop = rt->lookupDestCache(destAddress, interfaceId);
+    bool noRoute;
+	nextHop = rt->lookupDestCache(destAddress, interfaceId, noRoute);
 
     if (interfaceId==-1)
     {
-        // address not in destination cache: do longest prefix match in routing table
-        EV << "do longest prefix match in routing table" << endl;
-    	const IPv6Route *route = rt->doLongestPrefixMatch(destAddress);
-    	EV << "finished longest prefix match in routing table" << endl;
+        const IPv6Route *route = NULL;
+        if (noRoute)
+            EV << "destination is cached as unroutable\n";
+        else
+        {
+            // address not in destination cache: do longest prefix match in routing table
+            EV << "do longest prefix match in routing table" << endl;
+            route = rt->doLongestPrefixMatch(destAddress);
+            EV << "finished longest prefix match in routing table" << endl;
+        }
         if (!route)
         {
             if (rt->isRouter())
             {
                 EV << "unroutable, sending ICMPv6_DESTINATION_UNREACHABLE\n";
                 numUnroutable++;
+                if (!noRoute)
+                    rt->updateDestCacheNoRoute(destAddress);
                 icmp->sendErrorMessage(datagram, ICMPv6_DESTINATION_UNREACHABLE, 0); // FIXME check ICMP 'code'
             }
             else // host
@@ -0,0 +1,303 @@
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+
+
+#include "IPv6DestCache.h"
+
+#define DC_INITIAL_BUCKETS 16
+
+
+std::ostream& operator<<(std::ostream& os, const IPv6DestCache::Entry& e)
+{
+    os << e.dest << ": ";
+    if (e.noRoute)
+        os << "no route";
+    else
+        os << "if=" << e.interfaceId << " " << e.nextHopAddr;  //FIXME try printing interface name
+    return os;
+}
+
+IPv6DestCache::IPv6DestCache()
+{
+    maxEntries = 0;
+    clear();
+}
+
+void IPv6DestCache::clear()
+{
+    pool.clear();
+    buckets.assign(DC_INITIAL_BUCKETS, -1);
+    nextHopIndex.clear();
+    freeList = lruHead = lruTail = noRouteHead = -1;
+    numEntries = 0;
+}
+
+int IPv6DestCache::setMaxSize(int maxEntries)
+{
+    this->maxEntries = maxEntries;
+    int n = 0;
+    while (maxEntries > 0 && numEntries > maxEntries)
+    {
+        remove(lruTail);
+        n++;
+    }
+    return n;
+}
+
+int IPv6DestCache::find(const IPv6Address& dest) const
+{
+    for (int i = buckets[bucketOf(dest)]; i >= 0; i = pool[i].hashNext)
+        if (pool[i].dest == dest)
+            return i;
+    return -1;
+}
+
+void IPv6DestCache::touch(int i)
+{
+    if (i == lruHead)
+        return;
+
+    // unlink...
+    Entry& e = pool[i];
+    pool[e.lruPrev].lruNext = e.lruNext;
+    if (e.lruNext >= 0)
+        pool[e.lruNext].lruPrev = e.lruPrev;
+    else
+        lruTail = e.lruPrev;
+
+    // ...and insert at the front
+    e.lruPrev = -1;
+    e.lruNext = lruHead;
+    pool[lruHead].lruPrev = i;
+    lruHead = i;
+}
+
+void IPv6DestCache::linkNextHop(int i)
+{
+    Entry& e = pool[i];
+    int *head;
+    if (e.noRoute)
+        head = &noRouteHead;
+    else
+    {
+        // inserts a new chain (-1) if there is none for this next hop yet
+        std::pair<NextHopIndex::iterator,bool> res =
+            nextHopIndex.insert(std::make_pair(NextHopKey(e.interfaceId, e.nextHopAddr), -1));
+        head = &res.first->second;
+    }
+
+    e.nhPrev = -1;
+    e.nhNext = *head;
+    if (*head >= 0)
+        pool[*head].nhPrev = i;
+    *head = i;
+}
+
+void IPv6DestCache::unlinkNextHop(int i)
+{
+    Entry& e = pool[i];
+    if (e.nhNext >= 0)
+        pool[e.nhNext].nhPrev = e.nhPrev;
+
+    if (e.nhPrev >= 0)
+        pool[e.nhPrev].nhNext = e.nhNext;
+    else if (e.noRoute)
+        noRouteHead = e.nhNext;
+    else
+    {
+        // first of its chain: update the index, dropping the chain if it became empty
+        NextHopIndex::iterator it = nextHopIndex.find(NextHopKey(e.interfaceId, e.nextHopAddr));
+        ASSERT(it != nextHopIndex.end() && it->second == i);
+        if (e.nhNext >= 0)
+            it->second = e.nhNext;
+        else
+            nextHopIndex.erase(it);
+    }
+    e.nhPrev = e.nhNext = -1;
+}
+
+int IPv6DestCache::allocate(const IPv6Address& dest, bool& evicted)
+{
+    // make room if needed
+    evicted = false;
+    if (maxEntries > 0 && numEntries >= maxEntries)
+    {
+        remove(lruTail);
+        evicted = true;
+    }
+
+    if (numEntries >= (int)buckets.size())
+        rehash(buckets.size()*2);
+
+    int i;
+    if (freeList >= 0)
+    {
+        i = freeList;
+        freeList = pool[i].hashNext;
+    }
+    else
+    {
+        i = pool.size();
+        pool.push_back(Entry());
+    }
+
+    Entry& e = pool[i];
+    e.dest = dest;
+    int b = bucketOf(dest);
+    e.hashNext = buckets[b];
+    buckets[b] = i;
+
+    e.lruPrev = -1;
+    e.lruNext = lruHead;
+    if (lruHead >= 0)
+        pool[lruHead].lruPrev = i;
+    else
+        lruTail = i;
+    lruHead = i;
+
+    e.nhPrev = e.nhNext = -1;
+    numEntries++;
+    return i;
+}
+
+void IPv6DestCache::remove(int i)
+{
+    Entry& e = pool[i];
+    unlinkNextHop(i);
+
+    if (e.lruPrev >= 0)
+        pool[e.lruPrev].lruNext = e.lruNext;
+    else
+        lruHead = e.lruNext;
+    if (e.lruNext >= 0)
+        pool[e.lruNext].lruPrev = e.lruPrev;
+    else
+        lruTail = e.lruPrev;
+
+    int *link = &buckets[bucketOf(e.dest)];
+    while (*link != i)
+        link = &pool[*link].hashNext;
+    *link = e.hashNext;
+
+    e.hashNext = freeList;
+    freeList = i;
+    numEntries--;
+}
+
+void IPv6DestCache::rehash(int numBuckets)
+{
+    buckets.assign(numBuckets, -1);
+    for (int i = lruHead; i >= 0; i = pool[i].lruNext)
+    {
+        int b = bucketOf(pool[i].dest);
+        pool[i].hashNext = buckets[b];
+        buckets[b] = i;
+    }
+}
+
+const IPv6DestCache::Entry *IPv6DestCache::lookup(const IPv6Address& dest)
+{
+    int i = find(dest);
+    if (i < 0)
+        return NULL;
+    touch(i);
+    return &pool[i];
+}
+
+bool IPv6DestCache::update(const IPv6Address& dest, const IPv6Address& nextHopAddr, int interfaceId)
+{
+    bool evicted = false;
+    int i = find(dest);
+    if (i >= 0)
+    {
+        touch(i);
+        Entry& e = pool[i];
+        if (!e.noRoute && e.interfaceId == interfaceId && e.nextHopAddr == nextHopAddr)
+            return false;
+        unlinkNextHop(i);
+    }
+    else
+        i = allocate(dest, evicted);
+
+    Entry& e = pool[i];
+    e.nextHopAddr = nextHopAddr;
+    e.interfaceId = interfaceId;
+    e.noRoute = false;
+    linkNextHop(i);
+    return evicted;
+}
+
+bool IPv6DestCache::updateNoRoute(const IPv6Address& dest)
+{
+    bool evicted = false;
+    int i = find(dest);
+    if (i >= 0)
+    {
+        touch(i);
+        if (pool[i].noRoute)
+            return false;
+        unlinkNextHop(i);
+    }
+    else
+        i = allocate(dest, evicted);
+
+    Entry& e = pool[i];
+    e.nextHopAddr = IPv6Address::UNSPECIFIED_ADDRESS;
+    e.interfaceId = -1;
+    e.noRoute = true;
+    linkNextHop(i);
+    return evicted;
+}
+
+int IPv6DestCache::removeChain(int head)
+{
+    // remove() unlinks the first entry of the chain, so the
+    // chain head moves on; the index is updated there, too
+    int n = 0;
+    while (head >= 0)
+    {
+        int next = pool[head].nhNext;
+        remove(head);
+        head = next;
+        n++;
+    }
+    return n;
+}
+
+int IPv6DestCache::removeEntriesToNeighbour(const IPv6Address& nextHopAddr, int interfaceId)
+{
+    NextHopIndex::iterator it = nextHopIndex.find(NextHopKey(interfaceId, nextHopAddr));
+    if (it == nextHopIndex.end())
+        return 0;
+    return removeChain(it->second);
+}
+
+int IPv6DestCache::removeEntriesForInterface(int interfaceId)
+{
+    // the index is ordered by interfaceId first, so the chains
+    // of this interface are adjacent
+    int n = 0;
+    NextHopIndex::iterator it;
+    while ((it = nextHopIndex.lower_bound(NextHopKey(interfaceId, IPv6Address::UNSPECIFIED_ADDRESS))) != nextHopIndex.end()
+           && it->first.interfaceId == interfaceId)
+        n += removeChain(it->second);
+    return n;
+}
+
+int IPv6DestCache::removeNoRouteEntries()
+{
+    return removeChain(noRouteHead);
+}
+
@@ -0,0 +1,161 @@
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef __IPv6DESTCACHE_H__
+#define __IPv6DESTCACHE_H__
+
+#include <vector>
+#include <map>
+#include <iostream>
+#include "INETDefs.h"
+#include "IPv6Address.h"
+
+
+/**
+ * Destination Cache of RoutingTable6: maps destination addresses to
+ * next hop and interfaceId, or records that there is no route to them
+ * ("negative" entries).
+ *
+ * Entries are kept in a chained hash table over a pool of entries, and
+ * on a doubly linked LRU list; if a size limit is set, the least recently
+ * used entry is evicted when a new one would exceed it. Entries with the
+ * same next hop (and all negative entries) are also chained together, so
+ * that purging them when a neighbour becomes unreachable (or when a new
+ * route appears) costs time proportional to the number of affected
+ * entries, not the size of the cache.
+ *
+ * NOTE: nextHop might be a link-local address from which interfaceId cannot be deduced
+ */
+class INET_API IPv6DestCache
+{
+  public:
+    struct Entry
+    {
+        IPv6Address dest;
+        IPv6Address nextHopAddr;
+        int interfaceId;
+        bool noRoute;          // negative entry: no route to dest
+        // more destination specific data may be added here, e.g. path MTU
+
+      private:
+        friend class IPv6DestCache;
+        int hashNext;          // next entry in the hash bucket (or in the free list)
+        int lruPrev, lruNext;  // LRU list, most recently used first
+        int nhPrev, nhNext;    // entries with the same next hop, or negative entries
+    };
+
+  protected:
+    struct NextHopKey
+    {
+        int interfaceId;
+        IPv6Address addr;
+        NextHopKey(int interfaceId, const IPv6Address& addr) : interfaceId(interfaceId), addr(addr) {}
+        bool operator<(const NextHopKey& o) const {
+            return interfaceId!=o.interfaceId ? interfaceId<o.interfaceId : addr<o.addr;
+        }
+    };
+    typedef std::map<NextHopKey,int> NextHopIndex; // next hop -> first entry
+
+    std::vector<Entry> pool;   // entries are referred to by index
+    std::vector<int> buckets;  // heads of hash chains, size is a power of 2
+    int freeList;              // unused entries in pool, linked via hashNext
+    int lruHead, lruTail;
+    int noRouteHead;           // chain of negative entries
+    NextHopIndex nextHopIndex;
+    int numEntries;
+    int maxEntries;            // 0 means unlimited
+
+  protected:
+    int bucketOf(const IPv6Address& dest) const {return dest.hash() & (buckets.size()-1);}
+    int find(const IPv6Address& dest) const;
+    int allocate(const IPv6Address& dest, bool& evicted);
+    void remove(int i);
+    void rehash(int numBuckets);
+    void touch(int i);
+    void linkNextHop(int i);
+    void unlinkNextHop(int i);
+    int removeChain(int head);
+
+  public:
+    IPv6DestCache();
+
+    /**
+     * Sets the maximum number of entries (0 means unlimited), evicting
+     * least recently used entries if there are more. Returns the number
+     * of evicted entries.
+     */
+    int setMaxSize(int maxEntries);
+
+    /**
+     * Returns the maximum number of entries; 0 means unlimited.
+     */
+    int getMaxSize() const {return maxEntries;}
+
+    /**
+     * Returns the number of entries, including negative ones.
+     */
+    int size() const {return numEntries;}
+
+    /**
+     * Returns the entry for the given destination, or NULL. The entry
+     * becomes the most recently used one. The pointer is only valid until
+     * the next modification of the cache.
+     */
+    const Entry *lookup(const IPv6Address& dest);
+
+    /**
+     * Returns the most recently used entry, or NULL if the cache is empty.
+     */
+    const Entry *getMostRecent() const {return lruHead<0 ? NULL : &pool[lruHead];}
+
+    /**
+     * Adds or updates the entry for the given destination. Returns true
+     * if another entry had to be evicted to make room for it.
+     */
+    bool update(const IPv6Address& dest, const IPv6Address& nextHopAddr, int interfaceId);
+
+    /**
+     * Adds or updates a negative entry for the given destination. Returns
+     * true if another entry had to be evicted to make room for it.
+     */
+    bool updateNoRoute(const IPv6Address& dest);
+
+    /**
+     * Removes entries with the given next hop on the given interface.
+     * Returns the number of removed entries.
+     */
+    int removeEntriesToNeighbour(const IPv6Address& nextHopAddr, int interfaceId);
+
+    /**
+     * Removes entries whose next hop is on the given interface.
+     * Returns the number of removed entries.
+     */
+    int removeEntriesForInterface(int interfaceId);
+
+    /**
+     * Removes all negative entries. Returns the number of removed entries.
+     */
+    int removeNoRouteEntries();
+
+    /**
+     * Removes all entries.
+     */
+    void clear();
+};
+
+std::ostream& operator<<(std::ostream& os, const IPv6DestCache::Entry& e);
+
+#endif
+
@@ -265,6 +265,7 @@ void IPv6InterfaceData::removeAddress(const IPv6Address& address)
     ASSERT(k!=-1);
     addresses.erase(addresses.begin()+k);
     choosePreferredAddress();
+    changed1();
 }
 
 bool IPv6InterfaceData::addrLess(const AddressData& a, const AddressData& b)
@@ -400,6 +401,7 @@ void IPv6InterfaceData::assignAddress(const IPv6Address& addr, bool tentative, s
 	}
 
     choosePreferredAddress();
+    changed1();
 }
 
 
@@ -424,6 +426,9 @@ IPv6Address IPv6InterfaceData::removeAddress(IPv6InterfaceData::AddressType type
 	// pick new address as we've removed the old one
 	choosePreferredAddress();
 
+	if (!addr.isUnspecified())
+		changed1();
+
 	return addr;
 }
 
@@ -0,0 +1,208 @@
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+
+
+#include <algorithm>
+#include "IPv6RouteTrie.h"
+#include "RoutingTable6.h"
+
+
+IPv6RouteTrie::IPv6RouteTrie()
+{
+    root = NULL;
+    numRoutes = 0;
+}
+
+IPv6RouteTrie::~IPv6RouteTrie()
+{
+    deleteSubtree(root);
+}
+
+void IPv6RouteTrie::deleteSubtree(Node *node)
+{
+    if (!node)
+        return;
+    deleteSubtree(node->child[0]);
+    deleteSubtree(node->child[1]);
+    delete node;
+}
+
+void IPv6RouteTrie::clear()
+{
+    deleteSubtree(root);
+    root = NULL;
+    numRoutes = 0;
+}
+
+int IPv6RouteTrie::commonPrefixLength(const IPv6Address& a, const IPv6Address& b)
+{
+    const uint32 *wa = a.words();
+    const uint32 *wb = b.words();
+    for (int i=0; i<4; i++)
+    {
+        uint32 x = wa[i] ^ wb[i];
+        if (x)
+        {
+            int n = 0;
+            if (!(x & 0xffff0000U)) {n += 16; x <<= 16;}
+            if (!(x & 0xff000000U)) {n += 8; x <<= 8;}
+            if (!(x & 0xf0000000U)) {n += 4; x <<= 4;}
+            if (!(x & 0xc0000000U)) {n += 2; x <<= 2;}
+            if (!(x & 0x80000000U)) {n += 1;}
+            return 32*i + n;
+        }
+    }
+    return 128;
+}
+
+IPv6RouteTrie::Node *IPv6RouteTrie::createNode(const IPv6Address& prefix, int length)
+{
+    Node *node = new Node();
+    node->prefix = prefix;
+    node->length = length;
+    node->child[0] = node->child[1] = NULL;
+    return node;
+}
+
+static bool metricLessThan(const IPv6Route *a, const IPv6Route *b)
+{
+    return a->getMetric() < b->getMetric();
+}
+
+void IPv6RouteTrie::insert(IPv6Route *route)
+{
+    int length = route->getPrefixLength();
+    IPv6Address prefix = route->getDestPrefix().getPrefix(length);
+
+    Node **link = &root;
+    while (true)
+    {
+        Node *node = *link;
+        if (!node)
+        {
+            node = *link = createNode(prefix, length);
+            node->routes.push_back(route);
+            break;
+        }
+
+        int common = std::min(commonPrefixLength(prefix, node->prefix), std::min(length, (int)node->length));
+        if (common < node->length)
+        {
+            // the new prefix branches off (or ends) inside this node's
+            // compressed path: insert a node for the common part above it
+            Node *split = createNode(prefix.getPrefix(common), common);
+            split->child[getBit(node->prefix, common)] = node;
+            *link = split;
+            if (common == length)
+                split->routes.push_back(route);
+            else
+            {
+                Node *leaf = createNode(prefix, length);
+                leaf->routes.push_back(route);
+                split->child[getBit(prefix, common)] = leaf;
+            }
+            break;
+        }
+
+        if (node->length == length)
+        {
+            // same prefix: keep routes ordered by metric (stable for equal metrics)
+            RouteVector& routes = node->routes;
+            routes.insert(std::upper_bound(routes.begin(), routes.end(), route, metricLessThan), route);
+            break;
+        }
+
+        link = &node->child[getBit(prefix, node->length)];
+    }
+    numRoutes++;
+}
+
+bool IPv6RouteTrie::remove(IPv6Route *route)
+{
+    int length = route->getPrefixLength();
+    IPv6Address prefix = route->getDestPrefix().getPrefix(length);
+
+    // find the node, remembering the links that lead to it
+    Node **links[129];
+    int depth = 0;
+    Node **link = &root;
+    while (*link && (*link)->length < length)
+    {
+        Node *node = *link;
+        if (commonPrefixLength(prefix, node->prefix) < node->length)
+            return false;
+        links[depth++] = link;
+        link = &node->child[getBit(prefix, node->length)];
+    }
+    Node *node = *link;
+    if (!node || node->length != length || node->prefix != prefix)
+        return false;
+
+    RouteVector::iterator it = std::find(node->routes.begin(), node->routes.end(), route);
+    if (it == node->routes.end())
+        return false;
+    node->routes.erase(it);
+    numRoutes--;
+
+    // remove nodes that no longer carry routes nor branch, bottom up
+    while (node && node->routes.empty() && (!node->child[0] || !node->child[1]))
+    {
+        *link = node->child[0] ? node->child[0] : node->child[1];
+        delete node;
+
+        if (depth == 0)
+            break;
+        link = links[--depth];
+        node = *link;
+    }
+    return true;
+}
+
+IPv6Route *IPv6RouteTrie::longestMatch(const IPv6Address& dest, simtime_t now, RouteVector& expiredRoutes) const
+{
+    // collect the nodes on the path whose prefix matches dest
+    const Node *matching[129];
+    int numMatching = 0;
+    const Node *node = root;
+    while (node)
+    {
+        if (node->length > 0 && commonPrefixLength(dest, node->prefix) < node->length)
+            break;
+        if (!node->routes.empty())
+            matching[numMatching++] = node;
+        if (node->length == 128)
+            break;
+        node = node->child[getBit(dest, node->length)];
+    }
+
+    // then take the first valid route, starting from the longest prefix
+    while (numMatching > 0)
+    {
+        const RouteVector& routes = matching[--numMatching]->routes;
+        for (RouteVector::const_iterator it=routes.begin(); it!=routes.end(); ++it)
+        {
+            IPv6Route *route = *it;
+            if (route->getExpiryTime() != 0 && now > route->getExpiryTime()) // 0 represents infinity
+            {
+                if (route->getSrc() == IPv6Route::FROM_RA)
+                    expiredRoutes.push_back(route);
+                continue;
+            }
+            return route;
+        }
+    }
+    return NULL;
+}
+
@@ -0,0 +1,98 @@
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef __IPv6ROUTETRIE_H__
+#define __IPv6ROUTETRIE_H__
+
+#include <vector>
+#include "INETDefs.h"
+#include "IPv6Address.h"
+
+class IPv6Route;
+
+
+/**
+ * Path-compressed binary trie (PATRICIA-style) over the 128-bit IPv6
+ * address space, used by RoutingTable6 as the index for longest prefix
+ * matching. Each node stands for one prefix and holds the routes with
+ * exactly that prefix, ordered by metric; nodes without routes only
+ * exist where two branches split.
+ *
+ * Insertion, removal and lookup cost O(W) node visits (W=128 at most, in
+ * practice the number of distinct prefix lengths on the path), independent
+ * of the number of routes. The trie does not own the routes.
+ */
+class INET_API IPv6RouteTrie
+{
+  public:
+    typedef std::vector<IPv6Route*> RouteVector;
+
+  protected:
+    struct Node
+    {
+        IPv6Address prefix;  // masked to length bits
+        short length;
+        Node *child[2];
+        RouteVector routes;  // routes with exactly this prefix, best metric first
+    };
+
+    Node *root;
+    int numRoutes;
+
+  protected:
+    static int getBit(const IPv6Address& addr, int pos) {
+        return (addr.words()[pos>>5] >> (31-(pos&31))) & 1;
+    }
+    static int commonPrefixLength(const IPv6Address& a, const IPv6Address& b);
+    static Node *createNode(const IPv6Address& prefix, int length);
+    void deleteSubtree(Node *node);
+
+  public:
+    IPv6RouteTrie();
+    ~IPv6RouteTrie();
+
+    /**
+     * Adds the route under its (masked) destination prefix.
+     */
+    void insert(IPv6Route *route);
+
+    /**
+     * Removes the route. Returns false if it was not in the trie.
+     */
+    bool remove(IPv6Route *route);
+
+    /**
+     * Removes all routes.
+     */
+    void clear();
+
+    /**
+     * Returns the route with the longest prefix matching the given address
+     * (best metric among equal prefixes), skipping routes that have expired
+     * by the given time (expiry time 0 means infinity). Expired routes of
+     * type FROM_RA that were encountered are appended to expiredRoutes, so
+     * that the caller can purge them; they are not removed here.
+     * Returns NULL if there is no valid matching route.
+     */
+    IPv6Route *longestMatch(const IPv6Address& dest, simtime_t now, RouteVector& expiredRoutes) const;
+
+    /**
+     * Returns the number of routes stored.
+     */
+    int size() const {return numRoutes;}
+};
+
+#endif
+
@@ -65,6 +65,7 @@ void IPv6Tunneling::initialize()
 
 	vIfIndexTop = INT_MAX; // virtual interface number set to maximum int value
 	noOfNonSplitTunnels = 0; // current number of non-split tunnels on this host
+	nonSplitVIfIndex = -1;
 
 	WATCH_MAP(tunnels);
 }
@@ -116,7 +117,7 @@ int IPv6Tunneling::createTunnel(TunnelType tunnelType, const IPv6Address& entry,
 		return search;
 	}
 
-	if ( vIfIndexTop == (ift->getNumInterfaces() - 1) )
+	if ( freeVIfIndexes.empty() && vIfIndexTop == (ift->getNumInterfaces() - 1) )
 		opp_error("Error: Not more than %d tunnels supported!", INT_MAX - ift->getNumInterfaces());
 
 	if ( (destTrigger == IPv6Address::UNSPECIFIED_ADDRESS) && (noOfNonSplitTunnels == 1) )
@@ -124,38 +125,53 @@ int IPv6Tunneling::createTunnel(TunnelType tunnelType, const IPv6Address& entry,
 
 	// 6.1-6.2
 	ASSERT( entry.isUnicast() );
-	tunnels[vIfIndexTop] = Tunnel(entry, exit, destTrigger);
+
+	// reuse the index of a destroyed tunnel if there is one
+	int vIfIndex;
+	if ( !freeVIfIndexes.empty() )
+	{
+		vIfIndex = freeVIfIndexes.back();
+		freeVIfIndexes.pop_back();
+	}
+	else
+		vIfIndex = vIfIndexTop--; // decrement vIfIndex for use with next createTunnel() call
+
+	Tunnels::iterator it = tunnels.insert( std::make_pair(vIfIndex, Tunnel(entry, exit, destTrigger)) ).first;
+	keyIndex.add( keyHash(entry, exit, destTrigger), it );
+	triggerIndex.add( destTrigger.hash(), it );
+	exitIndex.add( exit.hash(), it );
 
 	if ( tunnelType == NORMAL || tunnelType == SPLIT || tunnelType == NON_SPLIT )
 	{
 	 	if (destTrigger == IPv6Address::UNSPECIFIED_ADDRESS)
 		{
 			// this is a "full" tunnel over which everything gets routed
-			tunnels[vIfIndexTop].tunnelType = NON_SPLIT;
+			it->second.tunnelType = NON_SPLIT;
 			noOfNonSplitTunnels++;
+			nonSplitVIfIndex = vIfIndex;
 		}
 
 		// default values: 5.
 		// 6.4
-		tunnels[vIfIndexTop].trafficClass = 0;
+		it->second.trafficClass = 0;
 		// 6.5
-		tunnels[vIfIndexTop].flowLabel = 0;
+		it->second.flowLabel = 0;
 		// 6.3
 		// The tunnel hop limit default value for hosts is the IPv6 Neighbor
 		// Discovery advertised hop limit [ND-Spec].
 		if ( rt->isRouter() )
-			tunnels[vIfIndexTop].hopLimit = IPv6__INET_DEFAULT_ROUTER_HOPLIMIT;
+			it->second.hopLimit = IPv6__INET_DEFAULT_ROUTER_HOPLIMIT;
 		else
-			tunnels[vIfIndexTop].hopLimit = 255;
+			it->second.hopLimit = 255;
 		// 6.7
 		// TODO perform path MTU on link (interface resolved via exit address)
-		tunnels[vIfIndexTop].tunnelMTU = IPv6_MIN_MTU - 40;
+		it->second.tunnelMTU = IPv6_MIN_MTU - 40;
 
 		EV << "Tunneling: Created tunnel with entry=" << entry << ", exit=" << exit << " and trigger=" << destTrigger << endl;
 	}
 	else if ( tunnelType == T2RH || tunnelType == HA_OPT )
 	{
-		tunnels[vIfIndexTop].tunnelType = tunnelType;
+		it->second.tunnelType = tunnelType;
 
 		if (tunnelType == T2RH)
 			EV << "Tunneling: Created RH2 path with entry=" << entry << ", exit=" << exit << " and trigger=" << destTrigger << endl;
@@ -170,16 +186,58 @@ int IPv6Tunneling::createTunnel(TunnelType tunnelType, const IPv6Address& entry,
 	if ( ev.isGUI() )
 		bubble("Created Tunnel");
 
-	return vIfIndexTop--; // decrement vIfIndex for use with next createTunnel() call
+	return vIfIndex;
+}
+
+
+
+void IPv6Tunneling::TunnelIndex::add(uint32 hash, Tunnels::iterator tunnel)
+{
+	if ( count >= (int)buckets.size() )
+	{
+		// grow: redistribute the items into twice as many buckets
+		std::vector<Bucket> old(buckets.size()*2);
+		old.swap(buckets);
+		for (unsigned int i=0; i<old.size(); i++)
+			for (Bucket::const_iterator it=old[i].begin(); it!=old[i].end(); ++it)
+				buckets[it->hash & (buckets.size()-1)].push_back(*it);
+	}
+
+	Item item;
+	item.hash = hash;
+	item.tunnel = tunnel;
+	buckets[hash & (buckets.size()-1)].push_back(item);
+	count++;
 }
 
 
+void IPv6Tunneling::TunnelIndex::remove(uint32 hash, Tunnels::iterator tunnel)
+{
+	Bucket& bucket = buckets[hash & (buckets.size()-1)];
+	for (Bucket::iterator it=bucket.begin(); it!=bucket.end(); ++it)
+	{
+		if (it->tunnel == tunnel)
+		{
+			*it = bucket.back();
+			bucket.pop_back();
+			count--;
+			return;
+		}
+	}
+	ASSERT(false);
+}
+
 
 int IPv6Tunneling::findTunnel(const IPv6Address& src, const IPv6Address& dest, const IPv6Address& destTrigger) const
 {
-	TI it = find_if( tunnels.begin(), tunnels.end(), bind1st( equalTunnel(), std::make_pair( (int) 0, Tunnel(src, dest, destTrigger) ) ) );
-	if (it != tunnels.end())
-		return it->first;
+	uint32 hash = keyHash(src, dest, destTrigger);
+	const TunnelIndex::Bucket& bucket = keyIndex.getBucket(hash);
+	for (TunnelIndex::Bucket::const_iterator it=bucket.begin(); it!=bucket.end(); ++it)
+	{
+		const Tunnel& tun = it->tunnel->second;
+		if (it->hash == hash && tun.entry == src && tun.exit == dest && tun.destTrigger == destTrigger)
+			return it->tunnel->first;
+	}
 	return 0;
 }
 
@@ -197,13 +255,23 @@ bool IPv6Tunneling::destroyTunnel(const IPv6Address& src, const IPv6Address& des
 		return false;
 	}
 
+	Tunnels::iterator it = tunnels.find(vIfIndex);
+
 	// if we delete a non-split tunnel, then we can
 	// also decrement the appropriate counter
-	if ( tunnels[vIfIndex].tunnelType == NON_SPLIT )
+	if ( it->second.tunnelType == NON_SPLIT )
+	{
 		noOfNonSplitTunnels--;
+		nonSplitVIfIndex = -1;
+	}
 
-	// TODO store vIfIndex for later reuse when creating a new tunnel
-	tunnels.erase(vIfIndex);
+	keyIndex.remove( keyHash(src, dest, destTrigger), it );
+	triggerIndex.remove( destTrigger.hash(), it );
+	exitIndex.remove( dest.hash(), it );
+	tunnels.erase(it);
+
+	// store vIfIndex for later reuse when creating a new tunnel
+	freeVIfIndexes.push_back(vIfIndex);
 
 	// reset the index if we do not have a single tunnel anymore
 	resetVIfIndex();
@@ -217,35 +285,63 @@ bool IPv6Tunneling::destroyTunnel(const IPv6Address& src, const IPv6Address& des
 
 void IPv6Tunneling::destroyTunnel(const IPv6Address& entry, const IPv6Address& exit)
 {
-	for (Tunnels::iterator it=tunnels.begin(); it!=tunnels.end(); )
+	// of the matching tunnels, destroy the one with the lowest vIfIndex
+	const Tunnel *found = NULL;
+	int foundVIfIndex = 0;
+	uint32 hash = exit.hash();
+	const TunnelIndex::Bucket& bucket = exitIndex.getBucket(hash);
+	for (TunnelIndex::Bucket::const_iterator it=bucket.begin(); it!=bucket.end(); ++it)
 	{
-    	if (it->second.entry == entry && it->second.exit == exit)
-        {
-    		destroyTunnel(it->second.entry, it->second.exit, it->second.destTrigger);
-    		break;
-        }
-    	else
-    		++it;
-    }
+		const Tunnel& tun = it->tunnel->second;
+		if ( it->hash == hash && tun.entry == entry && tun.exit == exit && (!found || it->tunnel->first < foundVIfIndex) )
+		{
+			found = &tun;
+			foundVIfIndex = it->tunnel->first;
+		}
+	}
+
+	if (found)
+	{
+		Tunnel tun = *found; // copy, as the tunnel is destroyed
+		destroyTunnel(tun.entry, tun.exit, tun.destTrigger);
+	}
 
 	// reset the index if we do not have a single tunnel anymore
 	resetVIfIndex();
 }
 
 
-void IPv6Tunneling::destroyTunnelForExitAndTrigger(const IPv6Address& exit, const IPv6Address& trigger)
+int IPv6Tunneling::findTunnelForTrigger(const IPv6Address& trigger, const IPv6Address *entry, const IPv6Address *exit) const
 {
-	for (Tunnels::iterator it=tunnels.begin(); it!=tunnels.end(); )
+	// the tunnel with the lowest vIfIndex wins, like in a search over the tunnels map
+	int vIfIndex = 0;
+	uint32 hash = trigger.hash();
+	const TunnelIndex::Bucket& bucket = triggerIndex.getBucket(hash);
+	for (TunnelIndex::Bucket::const_iterator it=bucket.begin(); it!=bucket.end(); ++it)
 	{
-    	if (it->second.exit == exit && it->second.destTrigger == trigger)
-        {
-    		destroyTunnel(it->second.entry, it->second.exit, it->second.destTrigger);
-    		break;
-        }
-    	else
-    		++it;
+		const Tunnel& tun = it->tunnel->second;
+		if ( it->hash == hash && tun.destTrigger == trigger
+			 && (!entry || tun.entry == *entry) && (!exit || tun.exit == *exit)
+			 && (vIfIndex == 0 || it->tunnel->first < vIfIndex) )
+			vIfIndex = it->tunnel->first;
+	}
+	return vIfIndex;
+}
 
-    }
+
+void IPv6Tunneling::destroyTunnelForTrigger(int vIfIndex)
+{
+	if (vIfIndex == 0)
+		return;
+
+	Tunnel tun = tunnels[vIfIndex]; // copy, as the tunnel is destroyed
+	destroyTunnel(tun.entry, tun.exit, tun.destTrigger);
+}
+
+
+void IPv6Tunneling::destroyTunnelForExitAndTrigger(const IPv6Address& exit, const IPv6Address& trigger)
+{
+	destroyTunnelForTrigger( findTunnelForTrigger(trigger, NULL, &exit) );
 
 	// reset the index if we do not have a single tunnel anymore
 	resetVIfIndex();
@@ -254,17 +350,7 @@ void IPv6Tunneling::destroyTunnelForExitAndTrigger(const IPv6Address& exit, cons
 
 void IPv6Tunneling::destroyTunnelForEntryAndTrigger(const IPv6Address& entry, const IPv6Address& trigger)
 {
-	for (Tunnels::iterator it=tunnels.begin(); it!=tunnels.end(); )
-	{
-    	if (it->second.entry == entry && it->second.destTrigger == trigger)
-        {
-    		destroyTunnel(it->second.entry, it->second.exit, it->second.destTrigger);
-    		break;
-        }
-    	else
-    		++it;
-
-    }
+	destroyTunnelForTrigger( findTunnelForTrigger(trigger, &entry, NULL) );
 
 	// reset the index if we do not have a single tunnel anymore
 	resetVIfIndex();
@@ -294,19 +380,11 @@ void IPv6Tunneling::destroyTunnels(const IPv6Address& entry)
 
 void IPv6Tunneling::destroyTunnelFromTrigger(const IPv6Address& trigger)
 {
-	for (Tunnels::iterator it=tunnels.begin(); it!=tunnels.end(); ++it)
-	{
-    	if (it->second.destTrigger == trigger)
-        {
-    		destroyTunnel(it->second.entry, it->second.exit, it->second.destTrigger);
-
-    		// reset the index if we do not have a single tunnel anymore
-    		resetVIfIndex();
-
-    		return; // there can not be more than one tunnel for a trigger
-        }
-    }
+	// there can not be more than one tunnel for a trigger
+	destroyTunnelForTrigger( findTunnelForTrigger(trigger, NULL, NULL) );
 
+	// reset the index if we do not have a single tunnel anymore
+	resetVIfIndex();
 }
 
 
@@ -335,33 +413,33 @@ int IPv6Tunneling::getVIfIndexForDest(const IPv6Address& destAddress, TunnelType
 {
 	int outInterfaceId = -1;
 
-    for (Tunnels::iterator it=tunnels.begin(); it!=tunnels.end(); it++)
-    {
+	// only tunnels triggered by destAddress (and the non-split tunnel) can match;
+	// of the matching ones, the tunnel with the lowest vIfIndex is chosen
+	if (tunnelType == NORMAL || tunnelType == NON_SPLIT || tunnelType == SPLIT )
+		outInterfaceId = nonSplitVIfIndex;
+
+	uint32 hash = destAddress.hash();
+	const TunnelIndex::Bucket& bucket = triggerIndex.getBucket(hash);
+	for (TunnelIndex::Bucket::const_iterator it=bucket.begin(); it!=bucket.end(); ++it)
+	{
+		const Tunnel& tun = it->tunnel->second;
+		if ( it->hash != hash || tun.destTrigger != destAddress )
+			continue;
+		if ( outInterfaceId != -1 && it->tunnel->first > outInterfaceId )
+			continue;
+
     	if (tunnelType == NORMAL || tunnelType == NON_SPLIT || tunnelType == SPLIT )
     	{
-        	// we search here for tunnels which have a destination trigger and
-        	// check whether the trigger is equal to the destination
         	// only "normal" tunnels, both split and non-split, are possible entry points
-        	if ( (it->second.tunnelType == NON_SPLIT) ||
-        		 (it->second.tunnelType == SPLIT && it->second.destTrigger == destAddress)
-        	   )
-            {
-            	outInterfaceId = it->first;
-            	break;
-            }
+        	if ( tun.tunnelType == NON_SPLIT || tun.tunnelType == SPLIT )
+            	outInterfaceId = it->tunnel->first;
     	}
     	else if ( tunnelType == MOBILITY || tunnelType == HA_OPT || tunnelType == T2RH)
     	{
-   	    	if ( it->second.tunnelType != NON_SPLIT &&
-   	    		 it->second.tunnelType != SPLIT &&
-   	    		 it->second.destTrigger == destAddress
-   	    	   )
-   	        {
-   	        	outInterfaceId = it->first;
-   	        	break;
-   	        }
+   	    	if ( tun.tunnelType != NON_SPLIT && tun.tunnelType != SPLIT )
+   	        	outInterfaceId = it->tunnel->first;
     	}
-    }
+	}
 
     return outInterfaceId;
 }
@@ -550,14 +628,15 @@ int IPv6Tunneling::lookupTunnels(const IPv6Address& dest)
 	// we search here for tunnels which have a destination trigger and
 	// check whether the trigger is equal to the destination
 	// only split tunnels or mobility paths are possible entry points
-    for (Tunnels::iterator it=tunnels.begin(); it!=tunnels.end(); it++)
-    {
-    	if ( (it->second.tunnelType != NON_SPLIT) && (it->second.destTrigger == dest) )
-        {
-        	outInterfaceId = it->first;
-        	break;
-        }
-    }
+	uint32 hash = dest.hash();
+	const TunnelIndex::Bucket& bucket = triggerIndex.getBucket(hash);
+	for (TunnelIndex::Bucket::const_iterator it=bucket.begin(); it!=bucket.end(); ++it)
+	{
+		const Tunnel& tun = it->tunnel->second;
+		if ( it->hash == hash && tun.tunnelType != NON_SPLIT && tun.destTrigger == dest
+			 && (outInterfaceId == -1 || it->tunnel->first < outInterfaceId) )
+			outInterfaceId = it->tunnel->first;
+	}
 
     return outInterfaceId;
 }
@@ -565,31 +644,23 @@ int IPv6Tunneling::lookupTunnels(const IPv6Address& dest)
 
 int IPv6Tunneling::doPrefixMatch(const IPv6Address& dest)
 {
-    int outInterfaceId = -1;
-
-    // we'll just stop at the first match, because it is assumed that not
-    // more than a single non-split tunnel is possible
-	for (Tunnels::iterator it=tunnels.begin(); it!=tunnels.end(); it++)
-    {
-		if ( it->second.tunnelType == NON_SPLIT )
-		{
-			outInterfaceId = it->first;
-			break;
-		}
-    }
-
-	return outInterfaceId;
+    // it is assumed that not more than a single non-split tunnel is possible,
+    // so we keep track of that one
+	return nonSplitVIfIndex;
 }
 
 
 bool IPv6Tunneling::isTunnelExit(const IPv6Address& exit)
 {
-    for (Tunnels::iterator it=tunnels.begin(); it!=tunnels.end(); it++)
-    {
+	uint32 hash = exit.hash();
+	const TunnelIndex::Bucket& bucket = exitIndex.getBucket(hash);
+	for (TunnelIndex::Bucket::const_iterator it=bucket.begin(); it!=bucket.end(); ++it)
+	{
+		const Tunnel& tun = it->tunnel->second;
     	// mobility "tunnels" are not relevant for decapsulation
     	// 17.10.07 - same for Home Address Option
-    	if ( it->second.tunnelType != T2RH && it->second.tunnelType != HA_OPT
-    		 && it->second.exit == exit
+    	if ( it->hash == hash && tun.tunnelType != T2RH && tun.tunnelType != HA_OPT
+    		 && tun.exit == exit
     		)
         {
     		return true;
@@ -38,6 +38,7 @@
 #include <functional>
 #include <iterator>
 #include <map>
+#include <vector>
 
 
 
@@ -110,24 +111,57 @@ class INET_API IPv6Tunneling : public cSimpleModule
 		typedef std::map<int, struct Tunnel> Tunnels;
 		typedef Tunnels::const_iterator TI;
 
-		struct equalTunnel : public std::binary_function<Tunnels::value_type, Tunnels::value_type, bool>
+		/**
+		 * Hash index over the tunnels. Each tunnel is filed under a hash of
+		 * some of its addresses; lookups get the bucket for a hash and check
+		 * the tunnels in it.
+		 */
+		class TunnelIndex
 		{
-			bool operator()(const Tunnels::value_type& lhs, const Tunnels::value_type& rhs) const
-			{
-				return (lhs.second.entry == rhs.second.entry) && (lhs.second.exit == rhs.second.exit) &&
-					   (lhs.second.destTrigger == rhs.second.destTrigger);
-			}
+			public:
+				struct Item
+				{
+					uint32 hash;
+					Tunnels::iterator tunnel;
+				};
+				typedef std::vector<Item> Bucket;
+
+			protected:
+				std::vector<Bucket> buckets; // size is a power of 2
+				int count;
+
+			public:
+				TunnelIndex() : buckets(16), count(0) {}
+				void add(uint32 hash, Tunnels::iterator tunnel);
+				void remove(uint32 hash, Tunnels::iterator tunnel);
+				void clear() {buckets.assign(16, Bucket()); count = 0;}
+				const Bucket& getBucket(uint32 hash) const {return buckets[hash & (buckets.size()-1)];}
 		};
 
+		static uint32 keyHash(const IPv6Address& entry, const IPv6Address& exit, const IPv6Address& destTrigger) {
+			return entry.hash() ^ (exit.hash()*0x9e3779b1U) ^ (destTrigger.hash()*0x85ebca6bU);
+		}
+
 		// Tunnels are stored here indexed by vIfIndex
 		Tunnels tunnels;
 
+		// hash indices over tunnels: by (entry, exit, destTrigger), by destTrigger and by exit
+		TunnelIndex keyIndex;
+		TunnelIndex triggerIndex;
+		TunnelIndex exitIndex;
+
 		// The lowest vIfIndex assigned so far. Virtual ifIndexes are assigned downwards.
 		int vIfIndexTop;
 
+		// vIfIndexes of destroyed tunnels, to be reused before going below vIfIndexTop
+		std::vector<int> freeVIfIndexes;
+
 		// number of tunnels which are not split tunnels
 		int noOfNonSplitTunnels;
 
+		// vIfIndex of the non-split tunnel, or -1
+		int nonSplitVIfIndex;
+
 
 	public:
 		IPv6Tunneling();
@@ -242,6 +276,20 @@ class INET_API IPv6Tunneling : public cSimpleModule
 		int findTunnel(const IPv6Address& src, const IPv6Address& dest, const IPv6Address& destTrigger) const;
 
 
+		/**
+		 * Returns the vIfIndex of the tunnel with the given trigger and, if not NULL,
+		 * the given entry and exit point; the lowest one if there are several.
+		 * Returns 0 if there is no such tunnel.
+		 */
+		int findTunnelForTrigger(const IPv6Address& trigger, const IPv6Address *entry, const IPv6Address *exit) const;
+
+
+		/**
+		 * Destroys the tunnel with the given vIfIndex, if it is not 0.
+		 */
+		void destroyTunnelForTrigger(int vIfIndex);
+
+
 		/**
 		 * Encapsulate a datagram with tunnel headers.
 		 *
@@ -278,7 +326,7 @@ class INET_API IPv6Tunneling : public cSimpleModule
 		/**
 		 * Reset the vIfIndex to its starting value if no tunnels exist anymore.
 		 */
-		inline void resetVIfIndex() { if ( tunnels.size() == 0 ) vIfIndexTop = INT_MAX; };
+		inline void resetVIfIndex() { if ( tunnels.size() == 0 ) { vIfIndexTop = INT_MAX; freeVIfIndexes.clear(); } };
 };
 
 #endif
@@ -65,14 +65,9 @@ std::ostream& operator<<(std::ostream& os, const IPv6Route& e)
     return os;
 };
 
-std::ostream& operator<<(std::ostream& os, const RoutingTable6::DestCacheEntry& e)
-{
-    os << "if=" << e.interfaceId << " " << e.nextHopAddr;  //FIXME try printing interface name
-    return os;
-};
-
 RoutingTable6::RoutingTable6()
 {
+    localAddressIndexValid = false;
 }
 
 RoutingTable6::~RoutingTable6()
@@ -95,7 +90,13 @@ void RoutingTable6::initialize(int stage)
         nb->subscribe(this, NF_INTERFACE_IPv6CONFIG_CHANGED);
 
         WATCH_PTRVECTOR(routeList);
-        WATCH_MAP(destCache); // FIXME commented out for now
+
+        destCache.setMaxSize(par("destCacheSize"));
+        numDestCacheHits = numDestCacheMisses = numDestCacheEvictions = 0;
+        WATCH(numDestCacheHits);
+        WATCH(numDestCacheMisses);
+        WATCH(numDestCacheEvictions);
+
         isrouter = par("isRouter");
         WATCH(isrouter);
 
@@ -197,6 +198,11 @@ void RoutingTable6::handleMessage(cMessage *msg)
 
 void RoutingTable6::receiveChangeNotification(int category, const cPolymorphic *details)
 {
+    // interface addresses may have changed (these notifications also
+    // arrive during initialization, when the addresses get assigned)
+    if (category==NF_INTERFACE_CREATED || category==NF_INTERFACE_DELETED || category==NF_INTERFACE_IPv6CONFIG_CHANGED)
+        localAddressIndexValid = false;
+
     if (simulation.getContextType()==CTX_INITIALIZE)
         return;  // ignore notifications during initialize
 
@@ -392,32 +398,81 @@ void RoutingTable6::configureTunnelFromXML(cXMLElement* cfg)
     }
 }
 
-InterfaceEntry *RoutingTable6::getInterfaceByAddress(const IPv6Address& addr)
+void RoutingTable6::rebuildLocalAddressIndex() const
 {
-    Enter_Method("getInterfaceByAddress(%s)=?", addr.str().c_str());
+    int numAddrs = 0;
+    for (int i=0; i<ift->getNumInterfaces(); i++)
+    {
+        IPv6InterfaceData *ipv6Data = ift->getInterface(i)->ipv6Data();
+        if (ipv6Data)
+            numAddrs += ipv6Data->getNumAddresses();
+    }
 
-    if (addr.isUnspecified())
-        return NULL;
-    for (int i=0; i<ift->getNumInterfaces(); ++i)
+    // every address goes in twice (with its solicited-node address);
+    // keep the load factor at 1/2 at most
+    unsigned int size = 16;
+    while (size < (unsigned int)numAddrs*4)
+        size *= 2;
+    localAddressIndex.assign(size, LocalAddress());
+
+    // assigned addresses first, so that they take precedence over solicited-node
+    // ones, and in interface order, so that getInterfaceByAddress() returns the
+    // first interface with the address like a linear search would
+    for (int pass=0; pass<2; pass++)
     {
-        InterfaceEntry *ie = ift->getInterface(i);
-        if (ie->ipv6Data()->hasAddress(addr))
-            return ie;
+        for (int i=0; i<ift->getNumInterfaces(); i++)
+        {
+            InterfaceEntry *ie = ift->getInterface(i);
+            IPv6InterfaceData *ipv6Data = ie->ipv6Data();
+            if (!ipv6Data)
+                continue;
+            for (int j=0; j<ipv6Data->getNumAddresses(); j++)
+            {
+                IPv6Address addr = pass==0 ? ipv6Data->getAddress(j) : ipv6Data->getAddress(j).formSolicitedNodeMulticastAddress();
+                unsigned int k = addr.hash() & (size-1);
+                while (localAddressIndex[k].ie && localAddressIndex[k].address != addr)
+                    k = (k+1) & (size-1);
+                if (localAddressIndex[k].ie)
+                    continue; // already there
+                localAddressIndex[k].address = addr;
+                localAddressIndex[k].ie = ie;
+                localAddressIndex[k].isSolicitedNode = pass==1;
+            }
+        }
     }
+    localAddressIndexValid = true;
+}
+
+const RoutingTable6::LocalAddress *RoutingTable6::findLocalAddress(const IPv6Address& addr) const
+{
+    if (!localAddressIndexValid)
+        rebuildLocalAddressIndex();
+
+    unsigned int mask = localAddressIndex.size()-1;
+    for (unsigned int k = addr.hash() & mask; localAddressIndex[k].ie; k = (k+1) & mask)
+        if (localAddressIndex[k].address == addr)
+            return &localAddressIndex[k];
     return NULL;
 }
 
+InterfaceEntry *RoutingTable6::getInterfaceByAddress(const IPv6Address& addr)
+{
+    Enter_Method_Silent();
+
+    if (addr.isUnspecified())
+        return NULL;
+    const LocalAddress *entry = findLocalAddress(addr);
+    return (entry && !entry->isSolicitedNode) ? entry->ie : NULL;
+}
+
 bool RoutingTable6::isLocalAddress(const IPv6Address& dest) const
 {
-    Enter_Method("isLocalAddress(%s) y/n", dest.str().c_str());
+    Enter_Method_Silent();
 
-    // first, check if we have an interface with this address
-    for (int i=0; i<ift->getNumInterfaces(); i++)
-    {
-        InterfaceEntry *ie = ift->getInterface(i);
-        if (ie->ipv6Data()->hasAddress(dest))
-            return true;
-    }
+    // first, check if we have an interface with this address, or one
+    // whose solicited-node multicast address this is
+    if (findLocalAddress(dest))
+        return true;
 
     // then check for special, preassigned multicast addresses
     // (these addresses occur more rarely than specific interface addresses,
@@ -428,64 +483,57 @@ bool RoutingTable6::isLocalAddress(const IPv6Address& dest) const
     if (isRouter() && (dest==IPv6Address::ALL_ROUTERS_1 || dest==IPv6Address::ALL_ROUTERS_2 || dest==IPv6Address::ALL_ROUTERS_5))
         return true;
 
-    // check for solicited-node multicast address
-    if (dest.matches(IPv6Address::SOLICITED_NODE_PREFIX, 104))
-    {
-        for (int i=0; i<ift->getNumInterfaces(); i++)
-        {
-            InterfaceEntry *ie = ift->getInterface(i);
-            if (ie->ipv6Data()->matchesSolicitedNodeMulticastAddress(dest))
-                return true;
-        }
-    }
     return false;
 }
 
 const IPv6Address& RoutingTable6::lookupDestCache(const IPv6Address& dest, int& outInterfaceId) const
+{
+    bool noRoute;
+    return lookupDestCache(dest, outInterfaceId, noRoute);
+}
+
+const IPv6Address& RoutingTable6::lookupDestCache(const IPv6Address& dest, int& outInterfaceId, bool& outNoRoute) const
 {
     Enter_Method("lookupDestCache(%s)", dest.str().c_str());
 
-    DestCache::const_iterator it = destCache.find(dest);
-    if (it == destCache.end())
+    const IPv6DestCache::Entry *entry = destCache.lookup(dest);
+    if (!entry)
     {
+        numDestCacheMisses++;
         outInterfaceId = -1;
+        outNoRoute = false;
         return IPv6Address::UNSPECIFIED_ADDRESS;
     }
-    outInterfaceId = it->second.interfaceId;
-    return it->second.nextHopAddr;
+    numDestCacheHits++;
+    outInterfaceId = entry->interfaceId;
+    outNoRoute = entry->noRoute;
+    return entry->nextHopAddr;
 }
 
 const IPv6Route *RoutingTable6::doLongestPrefixMatch(const IPv6Address& dest)
 {
-    Enter_Method("doLongestPrefixMatch(%s)", dest.str().c_str());
+    Enter_Method_Silent();
 
-    // we'll just stop at the first match, because the table is sorted
-    // by prefix lengths and metric (see addRoute())
+    // the trie returns the matching route with the longest prefix and
+    // best metric (the same one as the first match in the sorted
+    // routeList would be), skipping expired routes
+    const IPv6Route *route = routeIndex.longestMatch(dest, simTime(), expiredRoutes);
 
-    // bugfix - CB
-    RouteList::iterator it=routeList.begin();
-    while ( it!=routeList.end() )
+    // purge expired on-link prefixes found on the way
+    if (!expiredRoutes.empty())
     {
-    	if ( dest.matches((*it)->getDestPrefix(),(*it)->getPrefixLength()) )
-    {
-    		if (simTime() > (*it)->getExpiryTime() && (*it)->getExpiryTime() != 0)//since 0 represents infinity.
+        for (unsigned int i=0; i<expiredRoutes.size(); i++)
         {
-    			if ( (*it)->getSrc()==IPv6Route::FROM_RA )
-            {
-                EV << "Expired prefix detected!!" << endl;
-    				it = routeList.erase(it);
-    				//RouteList::iterator oldIt = it++;
-    				//removeOnLinkPrefix((*oldIt)->getDestPrefix(), (*oldIt)->getPrefixLength());
-            }
+            EV << "Expired prefix detected!!" << endl;
+            RouteList::iterator it = std::find(routeList.begin(), routeList.end(), expiredRoutes[i]);
+            if (it != routeList.end())
+                eraseRoute(it);
         }
-    		else
-    			return *it;
-    	}
-    	else
-    		++it;
+        expiredRoutes.clear();
+        updateDisplayString();
     }
-    // FIXME todo: if we selected an expired route, throw it out and select again!
-    return NULL;
+
+    return route;
 }
 
 bool RoutingTable6::isPrefixPresent(const IPv6Address& prefix) const
@@ -498,9 +546,16 @@ bool RoutingTable6::isPrefixPresent(const IPv6Address& prefix) const
 
 void RoutingTable6::updateDestCache(const IPv6Address& dest, const IPv6Address& nextHopAddr, int interfaceId)
 {
-    // FIXME this performs 2 lookups -- optimize to do only one
-    destCache[dest].nextHopAddr = nextHopAddr;
-    destCache[dest].interfaceId = interfaceId;
+    if (destCache.update(dest, nextHopAddr, interfaceId))
+        numDestCacheEvictions++;
+
+    updateDisplayString();
+}
+
+void RoutingTable6::updateDestCacheNoRoute(const IPv6Address& dest)
+{
+    if (destCache.updateNoRoute(dest))
+        numDestCacheEvictions++;
 
     updateDisplayString();
 }
@@ -513,21 +568,7 @@ void RoutingTable6::purgeDestCache()
 
 void RoutingTable6::purgeDestCacheEntriesToNeighbour(const IPv6Address& nextHopAddr, int interfaceId)
 {
-    for (DestCache::iterator it=destCache.begin(); it!=destCache.end(); )
-    {
-        if (it->second.interfaceId==interfaceId && it->second.nextHopAddr==nextHopAddr)
-        {
-            // move the iterator past this element before removing it
-            //DestCache::iterator oldIt = it++;
-            //destCache.erase(oldIt);
-            destCache.erase(it++);
-        }
-        else
-        {
-            it++;
-        }
-    }
-
+    destCache.removeEntriesToNeighbour(nextHopAddr, interfaceId);
     updateDisplayString();
 }
 
@@ -614,7 +655,7 @@ void RoutingTable6::removeOnLinkPrefix(const IPv6Address& destPrefix, int prefix
     {
         if ((*it)->getSrc()==IPv6Route::FROM_RA && (*it)->getDestPrefix()==destPrefix && (*it)->getPrefixLength()==prefixLength)
         {
-            routeList.erase(it);
+            eraseRoute(it);
             return; // there can be only one such route, addOrUpdateOnLinkPrefix() guarantees that
         }
     }
@@ -672,11 +713,13 @@ void RoutingTable6::addRoute(IPv6Route *route)
 {
     EV << "// adding route: " << *route << endl; // Added by CB
 
-    routeList.push_back(route);
+    // we keep entries sorted by prefix length and metric in routeList;
+    // longest prefix matching itself is done via routeIndex
+    routeList.insert(std::upper_bound(routeList.begin(), routeList.end(), route, routeLessThan), route);
+    routeIndex.insert(route);
 
-    // we keep entries sorted by prefix length in routeList, so that we can
-    // stop at the first match when doing the longest prefix matching
-    std::sort(routeList.begin(), routeList.end(), routeLessThan);
+    // destinations that were unroutable may be reachable now
+    destCache.removeNoRouteEntries();
 
     updateDisplayString();
 
@@ -690,12 +733,18 @@ void RoutingTable6::removeRoute(IPv6Route *route)
 
     nb->fireChangeNotification(NF_IPv6_ROUTE_DELETED, route); // rather: going to be deleted
 
-    routeList.erase(it);
+    eraseRoute(it);
     delete route;
 
     updateDisplayString();
 }
 
+RoutingTable6::RouteList::iterator RoutingTable6::eraseRoute(RouteList::iterator it)
+{
+    routeIndex.remove(*it);
+    return routeList.erase(it);
+}
+
 int RoutingTable6::getNumRoutes() const
 {
     return routeList.size();
@@ -711,9 +760,9 @@ IPv6Route *RoutingTable6::getRoute(int i)
 
 const IPv6Address& RoutingTable6::getDestinationAddress()
 {
-	DestCache::iterator it;
-	for (it = destCache.begin(); it != destCache.end(); ++it)
-		return it -> first;
+	const IPv6DestCache::Entry *entry = destCache.getMostRecent();
+	if (entry)
+		return entry->dest;
 
 	return IPv6Address::UNSPECIFIED_ADDRESS; // in case we do not find anything - CB
 }
@@ -755,7 +804,7 @@ void RoutingTable6::removeDefaultRoutes(int interfaceID)
 	{
 		// default routes have prefix length 0
         if ( (((*it)->getInterfaceId()) == interfaceID) && ((*it)->getPrefixLength() == 0)  )
-        	it = routeList.erase(it);
+        	it = eraseRoute(it);
         else
         	++it;
 	}
@@ -772,6 +821,7 @@ void RoutingTable6::removeAllRoutes()
         delete routeList[i];
 
 	routeList.clear();
+	routeIndex.clear();
 
 	updateDisplayString();
 }
@@ -785,7 +835,7 @@ void RoutingTable6::removePrefixes(int interfaceID)
 	{
 		// "real" prefixes have a length of larger then 0
         if ( (((*it)->getInterfaceId()) == interfaceID) && ((*it)->getPrefixLength() > 0)  )
-        	it = routeList.erase(it);
+        	it = eraseRoute(it);
         else
         	++it;
 	}
@@ -796,21 +846,7 @@ void RoutingTable6::removePrefixes(int interfaceID)
 
 void RoutingTable6::purgeDestCacheForInterfaceID(int interfaceId)
 {
-    for (DestCache::iterator it=destCache.begin(); it!=destCache.end(); )
-    {
-        if (it->second.interfaceId==interfaceId)
-        {
-            // move the iterator past this element before removing it
-            //DestCache::iterator oldIt = it++;
-            //destCache.erase(oldIt);
-            destCache.erase(it++);
-        }
-        else
-        {
-            ++it;
-        }
-    }
-
+    destCache.removeEntriesForInterface(interfaceId);
     updateDisplayString();
 }
 
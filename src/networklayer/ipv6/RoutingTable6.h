@@ -27,6 +27,8 @@
 //added by zarrar on 12.06.07
 #include "MobilityHeader_m.h"
 #include "IPv6ExtensionHeaders_m.h"
+#include "IPv6RouteTrie.h"
+#include "IPv6DestCache.h"
 
 
 /**
@@ -112,30 +114,52 @@ class INET_API RoutingTable6 : public cSimpleModule, protected INotifiable
     bool ishome_agent; //added by Zarrar Yousaf @ CNI, UniDortmund on 20.02.07
     bool ismobile_node;//added by Zarrar Yousaf @ CNI, UniDortmund on 25.02.07
 
-    // Destination Cache maps dest address to next hop and interfaceId.
-    // NOTE: nextHop might be a link-local address from which interfaceId cannot be deduced
-    struct DestCacheEntry
-    {
-        int interfaceId;
-        IPv6Address nextHopAddr;
-        // more destination specific data may be added here, e.g. path MTU
-    };
-    friend std::ostream& operator<<(std::ostream& os, const DestCacheEntry& e);
-    typedef std::map<IPv6Address,DestCacheEntry> DestCache;
-    DestCache destCache;
+    // Destination Cache maps dest address to next hop and interfaceId,
+    // or records that dest is unroutable. Lookups update its LRU order.
+    mutable IPv6DestCache destCache;
+
+    // destination cache statistics
+    mutable long numDestCacheHits;
+    mutable long numDestCacheMisses;
+    long numDestCacheEvictions;
 
     // RouteList contains local prefixes, and (for routers)
     // static, OSPF, RIP etc routes as well
     typedef std::vector<IPv6Route*> RouteList;
     RouteList routeList;
 
+    // index over routeList for longest prefix matching; every route that
+    // enters or leaves routeList must be added to/removed from it as well
+    IPv6RouteTrie routeIndex;
+    IPv6RouteTrie::RouteVector expiredRoutes; // scratch buffer for doLongestPrefixMatch()
+
     bool mipv6Support; // 4.9.07 - CB
 
+    // Hash index (open addressing) of the addresses assigned to the
+    // interfaces and of their solicited-node multicast addresses, for
+    // isLocalAddress() and getInterfaceByAddress(). It is rebuilt on the
+    // first query after an interface or its IPv6 configuration changed.
+    struct LocalAddress
+    {
+        IPv6Address address;
+        InterfaceEntry *ie;   // NULL for an empty slot
+        bool isSolicitedNode; // solicited-node multicast address of an assigned one
+    };
+    typedef std::vector<LocalAddress> LocalAddressIndex;
+    mutable LocalAddressIndex localAddressIndex;
+    mutable bool localAddressIndexValid;
+
   protected:
     // internal: routes of different type can only be added via well-defined functions
     virtual void addRoute(IPv6Route *route);
     // helper for addRoute()
     static bool routeLessThan(const IPv6Route *a, const IPv6Route *b);
+    // internal: removes the route at the given position from routeList and the index
+    virtual RouteList::iterator eraseRoute(RouteList::iterator it);
+    // internal: rebuilds localAddressIndex from the interface table
+    void rebuildLocalAddressIndex() const;
+    // internal: looks up an address in localAddressIndex, returns NULL if not there
+    const LocalAddress *findLocalAddress(const IPv6Address& addr) const;
     // internal
     virtual void configureInterfaceForIPv6(InterfaceEntry *ie);
     /**
@@ -231,6 +255,14 @@ class INET_API RoutingTable6 : public cSimpleModule, protected INotifiable
      */
     const IPv6Address& lookupDestCache(const IPv6Address& dest, int& outInterfaceId) const;
 
+    /**
+     * Like lookupDestCache(const IPv6Address&, int&), but also reports
+     * (in outNoRoute) if the destination was cached as unroutable, see
+     * updateDestCacheNoRoute(). For such destinations outInterfaceId is -1
+     * as well, so callers that don't care can treat them as cache misses.
+     */
+    const IPv6Address& lookupDestCache(const IPv6Address& dest, int& outInterfaceId, bool& outNoRoute) const;
+
     /**
      * Performs longest prefix match in the routing table and returns
      * the resulting route, or NULL if there was no match.
@@ -251,6 +283,12 @@ class INET_API RoutingTable6 : public cSimpleModule, protected INotifiable
      */
     virtual void updateDestCache(const IPv6Address& dest, const IPv6Address& nextHopAddr, int interfaceId);
 
+    /**
+     * Record in the destination cache that there is no route to the given
+     * destination. Such entries are discarded when a route is added.
+     */
+    virtual void updateDestCacheNoRoute(const IPv6Address& dest);
+
     /**
      * Discard all entries in destination cache where next hop is the given
      * address on the given interface. This is typically called when a router
@@ -67,6 +67,7 @@ void OSPFRouting::initialize(int stage)
 
         // Get routerId
         ospfRouter = new OSPF::Router(rt->getRouterId().getInt(), this);
+        ospfRouter->SetSPFThrottling(par("spfStartDelay").doubleValue(), par("spfHoldTime").doubleValue(), par("spfMaxHoldTime").doubleValue());
 
         // read the OSPF AS configuration
         const char *fileName = par("ospfConfigFile");
@@ -107,7 +107,7 @@ void OSPF::InterfaceState::ChangeState(OSPF::Interface* intf, OSPF::InterfaceSta
     }
 
     if (rebuildRoutingTable) {
-        intf->GetArea()->GetRouter()->RebuildRoutingTable();
+        intf->GetArea()->GetRouter()->ScheduleRoutingTableRebuild();
     }
 }
 
@@ -329,6 +329,6 @@ void OSPF::HelloHandler::ProcessPacket(OSPFPacket* packet, OSPF::Interface* intf
     }
 
     if (rebuildRoutingTable) {
-        router->RebuildRoutingTable();
+        router->ScheduleRoutingTableRebuild();
     }
 }
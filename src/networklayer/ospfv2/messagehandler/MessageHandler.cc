@@ -158,6 +158,12 @@ void OSPF::MessageHandler::HandleTimer(OSPFTimer* timer)
                 router->AgeDatabase();
             }
             break;
+        case SPFDelayTimer:
+            {
+                PrintEvent("Calculating the shortest path trees");
+                router->RebuildRoutingTable();
+            }
+            break;
         default: break;
     }
 }
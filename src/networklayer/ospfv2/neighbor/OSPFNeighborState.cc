@@ -80,6 +80,6 @@ void OSPF::NeighborState::ChangeState(OSPF::Neighbor* neighbor, OSPF::NeighborSt
     }
 
     if (rebuildRoutingTable) {
-        neighbor->GetInterface()->GetArea()->GetRouter()->RebuildRoutingTable();
+        neighbor->GetInterface()->GetArea()->GetRouter()->ScheduleRoutingTableRebuild();
     }
 }
@@ -33,15 +33,29 @@ struct NextHop {
 
 class RoutingInfo
 {
+public:
+    enum SPFState {
+        NotOnTree = 0,
+        Candidate = 1,
+        OnTree    = 2
+    };
+
 private:
     std::vector<NextHop>  nextHops;
     unsigned long         distance;
     OSPFLSA*              parent;
+    // shortest path tree bookkeeping, see OSPF::Area::CalculateShortestPathTree()
+    std::vector<OSPFLSA*> parents;              ///< All parents on equal cost paths, the first one is parent.
+    std::vector<OSPFLSA*> children;
+    SPFState              spfState;
+    long                  spfSequenceNumber;    ///< The LSA instance the shortest path tree was calculated from.
+    bool                  spfMaxAge;
 
 public:
-            RoutingInfo  (void) : distance(0), parent(NULL) {}
+            RoutingInfo  (void) : distance(0), parent(NULL), spfState(NotOnTree), spfSequenceNumber(0), spfMaxAge(true) {}
 
-            RoutingInfo  (const RoutingInfo& routingInfo) : nextHops(routingInfo.nextHops), distance(routingInfo.distance), parent(routingInfo.parent) {}
+            RoutingInfo  (const RoutingInfo& routingInfo) : nextHops(routingInfo.nextHops), distance(routingInfo.distance), parent(routingInfo.parent),
+                                                            spfState(NotOnTree), spfSequenceNumber(0), spfMaxAge(true) {}
 
     virtual ~RoutingInfo(void) {}
 
@@ -53,6 +67,13 @@ public:
     unsigned long   GetDistance         (void) const                { return distance; }
     void            SetParent           (OSPFLSA* p)                { parent = p; }
     OSPFLSA*        GetParent           (void) const                { return parent; }
+
+    std::vector<OSPFLSA*>&  GetParents      (void)                  { return parents; }
+    std::vector<OSPFLSA*>&  GetChildren     (void)                  { return children; }
+    void            SetSPFState         (SPFState state)            { spfState = state; }
+    SPFState        GetSPFState         (void) const                { return spfState; }
+    void            SetSPFInstance      (long sequenceNumber, bool maxAge)          { spfSequenceNumber = sequenceNumber; spfMaxAge = maxAge; }
+    bool            IsSPFInstance       (long sequenceNumber, bool maxAge) const    { return (maxAge == spfMaxAge) && (maxAge || (sequenceNumber == spfSequenceNumber)); }
 };
 
 class LSATrackingInfo
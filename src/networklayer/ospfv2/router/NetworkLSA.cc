@@ -20,12 +20,18 @@
 bool OSPF::NetworkLSA::Update(const OSPFNetworkLSA* lsa)
 {
     bool different = DiffersFrom(lsa);
-    (*this) = (*lsa);
+    bool spfInstance = IsSPFInstance(header_var.getLsSequenceNumber(), header_var.getLsAge() == MAX_AGE);
+    OSPFNetworkLSA::operator=(*lsa);     // keeps the routing info of this LSA
+    SetSource(LSATrackingInfo::Flooded);
     ResetInstallTime();
     if (different) {
         ClearNextHops();
         return true;
     } else {
+        // a refreshed instance doesn't change the shortest path tree
+        if (spfInstance) {
+            SetSPFInstance(header_var.getLsSequenceNumber(), header_var.getLsAge() == MAX_AGE);
+        }
         return false;
     }
 }
@@ -18,6 +18,8 @@
 #include "OSPFArea.h"
 #include "OSPFRouter.h"
 #include <memory.h>
+#include <algorithm>
+#include <set>
 
 OSPF::Area::Area(OSPF::AreaID id) :
     areaID(id),
@@ -25,6 +27,7 @@ OSPF::Area::Area(OSPF::AreaID id) :
     externalRoutingCapability(true),
     stubDefaultCost(1),
     spfTreeRoot(NULL),
+    spfTreeValid(false),
     parentRouter(NULL)
 {
 }
@@ -398,8 +401,9 @@ void OSPF::Area::AgeDatabase(void)
             {
                 if (!selfOriginated || unreachable) {
                     routerLSAsByID.erase(lsa->getHeader().getLinkStateID());
-                    delete lsa;
+                    parentRouter->DeleteLSAAfterRebuild(lsa);
                     routerLSAs[i] = NULL;
+                    spfTreeValid = false;
                     rebuildRoutingTable = true;
                 } else {
                     OSPF::RouterLSA* newLSA              = OriginateRouterLSA();
@@ -494,8 +498,9 @@ void OSPF::Area::AgeDatabase(void)
             {
                 if (!selfOriginated || unreachable) {
                     networkLSAsByID.erase(lsa->getHeader().getLinkStateID());
-                    delete lsa;
+                    parentRouter->DeleteLSAAfterRebuild(lsa);
                     networkLSAs[i] = NULL;
+                    spfTreeValid = false;
                     rebuildRoutingTable = true;
                 } else {
                     OSPF::NetworkLSA* newLSA              = OriginateNetworkLSA(localIntf);
@@ -509,7 +514,11 @@ void OSPF::Area::AgeDatabase(void)
 
                         FloodLSA(lsa);
                     } else {    // no neighbors on the network -> old NetworkLSA must be deleted
-                        delete networkLSAs[i];
+                        networkLSAsByID.erase(lsa->getHeader().getLinkStateID());
+                        parentRouter->DeleteLSAAfterRebuild(lsa);
+                        networkLSAs[i] = NULL;
+                        spfTreeValid = false;
+                        rebuildRoutingTable = true;
                     }
                 }
             }
@@ -586,7 +595,7 @@ void OSPF::Area::AgeDatabase(void)
             {
                 if (!selfOriginated || unreachable) {
                     summaryLSAsByID.erase(lsaKey);
-                    delete lsa;
+                    parentRouter->DeleteLSAAfterRebuild(lsa);
                     summaryLSAs[i] = NULL;
                     rebuildRoutingTable = true;
                 } else {
@@ -602,7 +611,7 @@ void OSPF::Area::AgeDatabase(void)
                         FloodLSA(lsa);
                     } else {
                         summaryLSAsByID.erase(lsaKey);
-                        delete lsa;
+                        parentRouter->DeleteLSAAfterRebuild(lsa);
                         summaryLSAs[i] = NULL;
                         rebuildRoutingTable = true;
                     }
@@ -626,7 +635,7 @@ void OSPF::Area::AgeDatabase(void)
     }
 
     if (rebuildRoutingTable) {
-        parentRouter->RebuildRoutingTable();
+        parentRouter->ScheduleRoutingTableRebuild();
     }
 }
 
@@ -1331,15 +1340,49 @@ OSPF::SummaryLSA* OSPF::Area::OriginateSummaryLSA(const OSPF::SummaryLSA* summar
     return NULL;
 }
 
+/**
+ * Returns the routing information of a vertex of the shortest path tree: a RouterLSA or a NetworkLSA.
+ */
+static OSPF::RoutingInfo* GetVertexRoutingInfo(OSPFLSA* vertex)
+{
+    if (vertex->getHeader().getLsType() == RouterLSAType) {
+        return static_cast<OSPF::RouterLSA*> (vertex);
+    } else {
+        return static_cast<OSPF::NetworkLSA*> (vertex);
+    }
+}
+
+/**
+ * Orders the vertices of the shortest path tree the same way as the candidate list does.
+ */
+static bool IsCloserVertex(OSPFLSA* leftVertex, OSPFLSA* rightVertex)
+{
+    return (OSPF::SPFCandidate(GetVertexRoutingInfo(leftVertex)->GetDistance(), leftVertex) <
+            OSPF::SPFCandidate(GetVertexRoutingInfo(rightVertex)->GetDistance(), rightVertex));
+}
+
+static void ResetVertex(OSPF::RoutingInfo* routingInfo)
+{
+    routingInfo->ClearNextHops();
+    routingInfo->SetDistance(LS_INFINITY);
+    routingInfo->SetParent(NULL);
+    routingInfo->GetParents().clear();
+    routingInfo->GetChildren().clear();
+    routingInfo->SetSPFState(OSPF::RoutingInfo::NotOnTree);
+}
+
+/**
+ * Calculates the shortest path tree of the area and adds the intra-area routes to newRoutingTable.
+ * The tree is kept between calls: if only some router- or network-LSAs changed since the
+ * last calculation, only the parts of the tree depending on them are recalculated.
+ * @sa RFC2328 Section 16.1.
+ */
 void OSPF::Area::CalculateShortestPathTree(std::vector<OSPF::RoutingTableEntry*>& newRoutingTable)
 {
     OSPF::RouterID          routerID = parentRouter->GetRouterID();
-    bool                    finished = false;
-    std::vector<OSPFLSA*>   treeVertices;
-    OSPFLSA*                justAddedVertex;
-    std::vector<OSPFLSA*>   candidateVertices;
-    unsigned long            i, j, k;
-    unsigned long            lsaCount;
+    std::vector<OSPFLSA*>   changedVertices;
+    unsigned long           i;
+    unsigned long           lsaCount;
 
     if (spfTreeRoot == NULL) {
         OSPF::RouterLSA* newLSA = OriginateRouterLSA();
@@ -1349,6 +1392,7 @@ void OSPF::Area::CalculateShortestPathTree(std::vector<OSPF::RoutingTableEntry*>
         OSPF::RouterLSA* routerLSA = FindRouterLSA(routerID);
 
         spfTreeRoot = routerLSA;
+        spfTreeValid = false;
         FloodLSA(newLSA);
         delete newLSA;
     }
@@ -1358,276 +1402,530 @@ void OSPF::Area::CalculateShortestPathTree(std::vector<OSPF::RoutingTableEntry*>
 
     lsaCount = routerLSAs.size();
     for (i = 0; i < lsaCount; i++) {
-        routerLSAs[i]->ClearNextHops();
+        const OSPFLSAHeader& lsaHeader = routerLSAs[i]->getHeader();
+        if (!routerLSAs[i]->IsSPFInstance(lsaHeader.getLsSequenceNumber(), lsaHeader.getLsAge() == MAX_AGE)) {
+            changedVertices.push_back(routerLSAs[i]);
+        }
     }
     lsaCount = networkLSAs.size();
     for (i = 0; i < lsaCount; i++) {
-        networkLSAs[i]->ClearNextHops();
+        const OSPFLSAHeader& lsaHeader = networkLSAs[i]->getHeader();
+        if (!networkLSAs[i]->IsSPFInstance(lsaHeader.getLsSequenceNumber(), lsaHeader.getLsAge() == MAX_AGE)) {
+            changedVertices.push_back(networkLSAs[i]);
+        }
     }
-    spfTreeRoot->SetDistance(0);
-    treeVertices.push_back(spfTreeRoot);
-    justAddedVertex = spfTreeRoot;          // (1)
 
-    do {
-        LSAType vertexType = static_cast<LSAType> (justAddedVertex->getHeader().getLsType());
+    // the next hops of the root's neighbors come from the interfaces, recalculate everything if they changed
+    if (!spfTreeValid || (std::find(changedVertices.begin(), changedVertices.end(), spfTreeRoot) != changedVertices.end())) {
+        CalculateFullShortestPathTree();
+        EV << "Shortest path tree of area " << areaID << " calculated, " << spfTree.size() << " vertices.\n";
+    } else if (!changedVertices.empty()) {
+        CalculateIncrementalShortestPathTree(changedVertices);
+        EV << "Shortest path tree of area " << areaID << " recalculated for " << changedVertices.size() << " changed LSAs.\n";
+    }
 
-        if ((vertexType == RouterLSAType)) {
-            OSPF::RouterLSA* routerVertex = check_and_cast<OSPF::RouterLSA*> (justAddedVertex);
-            if (routerVertex->getV_VirtualLinkEndpoint()) {    // (2)
-                transitCapability = true;
+    unsigned long changedCount = changedVertices.size();
+    for (i = 0; i < changedCount; i++) {
+        const OSPFLSAHeader& lsaHeader = changedVertices[i]->getHeader();
+        GetVertexRoutingInfo(changedVertices[i])->SetSPFInstance(lsaHeader.getLsSequenceNumber(), lsaHeader.getLsAge() == MAX_AGE);
+    }
+    spfTreeValid = true;
+
+    AddShortestPathTreeRoutes(newRoutingTable);
+}
+
+void OSPF::Area::CalculateFullShortestPathTree(void)
+{
+    SPFCandidateQueue candidates;
+    unsigned long     i;
+    unsigned long     lsaCount;
+
+    lsaCount = routerLSAs.size();
+    for (i = 0; i < lsaCount; i++) {
+        ResetVertex(routerLSAs[i]);
+    }
+    lsaCount = networkLSAs.size();
+    for (i = 0; i < lsaCount; i++) {
+        ResetVertex(networkLSAs[i]);
+    }
+    spfTree.clear();
+
+    spfTreeRoot->SetDistance(0);    // (1)
+    AddVertexToTree(spfTreeRoot);
+    AddCandidateVertices(spfTreeRoot, candidates, false);
+    ExtendShortestPathTree(candidates, false);
+}
+
+/**
+ * Removes the changed vertices and everything below them from the tree, then grows the tree
+ * again from the vertices that are left. Vertices which get closer through the changed ones are
+ * moved, together with their subtrees, when they are reached.
+ */
+void OSPF::Area::CalculateIncrementalShortestPathTree(const std::vector<OSPFLSA*>& changedVertices)
+{
+    SPFCandidateQueue     candidates;
+    std::vector<OSPFLSA*> removedVertices;
+    unsigned long         i;
+    unsigned long         lsaCount;
+
+    lsaCount = networkLSAs.size();
+    for (i = 0; i < lsaCount; i++) {
+        unsigned long networkAddress = networkLSAs[i]->getHeader().getLinkStateID() & networkLSAs[i]->getNetworkMask().getInt();
+        spfNetworksByAddress.insert(std::pair<unsigned long, OSPF::NetworkLSA*> (networkAddress, networkLSAs[i]));
+    }
+
+    unsigned long changedCount = changedVertices.size();
+    for (i = 0; i < changedCount; i++) {
+        OSPF::RoutingInfo* routingInfo = GetVertexRoutingInfo(changedVertices[i]);
+        if (routingInfo->GetSPFState() == OSPF::RoutingInfo::OnTree) {
+            RemoveSubtreeFromTree(changedVertices[i], removedVertices);
+        } else {
+            // may have become reachable
+            ResetVertex(routingInfo);
+            removedVertices.push_back(changedVertices[i]);
+        }
+    }
+    ReconnectVertices(removedVertices, candidates);
+    ExtendShortestPathTree(candidates, true);
+
+    spfTree.clear();
+    lsaCount = routerLSAs.size();
+    for (i = 0; i < lsaCount; i++) {
+        if (routerLSAs[i]->GetSPFState() == OSPF::RoutingInfo::OnTree) {
+            spfTree.push_back(routerLSAs[i]);
+        }
+    }
+    lsaCount = networkLSAs.size();
+    for (i = 0; i < lsaCount; i++) {
+        if (networkLSAs[i]->GetSPFState() == OSPF::RoutingInfo::OnTree) {
+            spfTree.push_back(networkLSAs[i]);
+        }
+    }
+    std::sort(spfTree.begin(), spfTree.end(), IsCloserVertex);
+
+    spfNetworksByAddress.clear();
+}
+
+void OSPF::Area::ExtendShortestPathTree(SPFCandidateQueue& candidates, bool incremental)
+{
+    while (!candidates.empty()) {     // (3)
+        SPFCandidate closest = candidates.top();
+
+        candidates.pop();
+
+        OSPF::RoutingInfo* routingInfo = GetVertexRoutingInfo(closest.vertex);
+        if ((routingInfo->GetSPFState() != OSPF::RoutingInfo::Candidate) ||
+            (routingInfo->GetDistance() != closest.distance))
+        {
+            continue;   // superseded by a later entry
+        }
+
+        AddVertexToTree(closest.vertex);
+        AddCandidateVertices(closest.vertex, candidates, incremental);
+    }
+}
+
+/**
+ * Examines the vertices joined to the one just added to the tree.
+ * @sa RFC2328 Section 16.1. (2)
+ */
+void OSPF::Area::AddCandidateVertices(OSPFLSA* vertex, SPFCandidateQueue& candidates, bool incremental)
+{
+    unsigned long i;
+
+    if (vertex->getHeader().getLsType() == RouterLSAType) {
+        OSPF::RouterLSA* routerVertex = static_cast<OSPF::RouterLSA*> (vertex);
+        unsigned int     linkCount    = routerVertex->getLinksArraySize();
+
+        for (i = 0; i < linkCount; i++) {
+            Link&    link     = routerVertex->getLinks(i);
+            LinkType linkType = static_cast<LinkType> (link.getType());
+            OSPFLSA* joiningVertex;
+
+            if (linkType == StubLink) {     // (2) (a)
+                continue;
             }
 
-            unsigned int linkCount = routerVertex->getLinksArraySize();
-            for (i = 0; i < linkCount; i++) {
-                Link&    link     = routerVertex->getLinks(i);
-                LinkType linkType = static_cast<LinkType> (link.getType());
-                OSPFLSA* joiningVertex;
-                LSAType  joiningVertexType;
+            if (linkType == TransitLink) {
+                joiningVertex = FindNetworkLSA(link.getLinkID().getInt());
+            } else {
+                joiningVertex = FindRouterLSA(link.getLinkID().getInt());
+            }
 
-                if (linkType == StubLink) {     // (2) (a)
-                    continue;
-                }
+            if ((joiningVertex == NULL) ||
+                (joiningVertex->getHeader().getLsAge() == MAX_AGE) ||
+                (!HasLink(joiningVertex, vertex)))  // (from, to)     (2) (b)
+            {
+                continue;
+            }
 
-                if (linkType == TransitLink) {
-                    joiningVertex     = FindNetworkLSA(link.getLinkID().getInt());
-                    joiningVertexType = NetworkLSAType;
-                } else {
-                    joiningVertex     = FindRouterLSA(link.getLinkID().getInt());
-                    joiningVertexType = RouterLSAType;
-                }
+            UpdateCandidateVertex(vertex, joiningVertex, routerVertex->GetDistance() + link.getLinkCost(), candidates, incremental);
+        }
+    } else {
+        OSPF::NetworkLSA* networkVertex = static_cast<OSPF::NetworkLSA*> (vertex);
+        unsigned int      routerCount   = networkVertex->getAttachedRoutersArraySize();
+
+        for (i = 0; i < routerCount; i++) {
+            OSPF::RouterLSA* joiningVertex = FindRouterLSA(networkVertex->getAttachedRouters(i).getInt());
+            if ((joiningVertex == NULL) ||
+                (joiningVertex->getHeader().getLsAge() == MAX_AGE) ||
+                (!HasLink(joiningVertex, vertex)))  // (from, to)     (2) (b)
+            {
+                continue;
+            }
 
-                if ((joiningVertex == NULL) ||
-                    (joiningVertex->getHeader().getLsAge() == MAX_AGE) ||
-                    (!HasLink(joiningVertex, justAddedVertex)))  // (from, to)     (2) (b)
-                {
-                    continue;
-                }
+            // link cost from network to router is always 0
+            UpdateCandidateVertex(vertex, joiningVertex, networkVertex->GetDistance(), candidates, incremental);
+        }
+    }
+}
 
-                unsigned int treeSize      = treeVertices.size();
-                bool         alreadyOnTree = false;
+void OSPF::Area::UpdateCandidateVertex(OSPFLSA* parent, OSPFLSA* vertex, unsigned long distance, SPFCandidateQueue& candidates, bool incremental)
+{
+    OSPF::RoutingInfo*     routingInfo = GetVertexRoutingInfo(vertex);
+    std::vector<OSPFLSA*>& parents     = routingInfo->GetParents();
+    bool                   knownParent = (std::find(parents.begin(), parents.end(), parent) != parents.end());
+
+    switch (routingInfo->GetSPFState()) {
+        case OSPF::RoutingInfo::OnTree:     // (2) (c)
+            // after a change the vertices left on the tree may have got closer, or got new equal cost paths
+            if (incremental &&
+                ((distance < routingInfo->GetDistance()) ||
+                 ((distance == routingInfo->GetDistance()) && !knownParent)))
+            {
+                std::vector<OSPFLSA*> removedVertices;
 
-                for (j = 0; j < treeSize; j++) {
-                    if (treeVertices[j] == joiningVertex) {
-                        alreadyOnTree = true;
-                        break;
-                    }
-                }
-                if (alreadyOnTree) {    // (2) (c)
-                    continue;
+                RemoveSubtreeFromTree(vertex, removedVertices);
+                ReconnectVertices(removedVertices, candidates);
+            }
+            break;
+        case OSPF::RoutingInfo::Candidate:  // (2) (d)
+            if (distance > routingInfo->GetDistance()) {
+                break;
+            }
+            if (distance == routingInfo->GetDistance()) {
+                if (!knownParent) {
+                    parents.push_back(parent);
                 }
+                break;
+            }
+            parents.clear();
+            parents.push_back(parent);
+            routingInfo->SetDistance(distance);
+            candidates.push(OSPF::SPFCandidate(distance, vertex));
+            break;
+        default:
+            parents.clear();
+            parents.push_back(parent);
+            routingInfo->SetDistance(distance);
+            routingInfo->SetSPFState(OSPF::RoutingInfo::Candidate);
+            candidates.push(OSPF::SPFCandidate(distance, vertex));
+            break;
+    }
+}
 
-                unsigned long linkStateCost  = routerVertex->GetDistance() + link.getLinkCost();
-                unsigned int  candidateCount = candidateVertices.size();
-                OSPFLSA*      candidate      = NULL;
+/**
+ * Adds a candidate to the tree. Its next hops are calculated from all its parents,
+ * which are already on the tree.
+ */
+void OSPF::Area::AddVertexToTree(OSPFLSA* vertex)
+{
+    OSPF::RoutingInfo*     routingInfo = GetVertexRoutingInfo(vertex);
+    std::vector<OSPFLSA*>& parents     = routingInfo->GetParents();
+    unsigned int           parentCount = parents.size();
+    unsigned int           i, j, k;
 
-                for (j = 0; j < candidateCount; j++) {
-                    if (candidateVertices[j] == joiningVertex) {
-                        candidate = candidateVertices[j];
-                    }
+    if (parentCount > 1) {
+        std::sort(parents.begin(), parents.end(), IsCloserVertex);
+    }
+
+    routingInfo->ClearNextHops();
+    for (i = 0; i < parentCount; i++) {
+        std::vector<OSPF::NextHop>* newNextHops  = CalculateNextHops(vertex, parents[i]); // (destination, parent)
+        unsigned int                nextHopCount = newNextHops->size();
+        for (j = 0; j < nextHopCount; j++) {
+            unsigned int hopCount = routingInfo->GetNextHopCount();
+            for (k = 0; k < hopCount; k++) {
+                if (routingInfo->GetNextHop(k) == (*newNextHops)[j]) {
+                    break;
                 }
-                if (candidate != NULL) {    // (2) (d)
-                    OSPF::RoutingInfo* routingInfo       = check_and_cast<OSPF::RoutingInfo*> (candidate);
-                    unsigned long      candidateDistance = routingInfo->GetDistance();
+            }
+            if (k == hopCount) {
+                routingInfo->AddNextHop((*newNextHops)[j]);
+            }
+        }
+        delete newNextHops;
 
-                    if (linkStateCost > candidateDistance) {
-                        continue;
-                    }
-                    if (linkStateCost < candidateDistance) {
-                        routingInfo->SetDistance(linkStateCost);
-                        routingInfo->ClearNextHops();
-                    }
-                    std::vector<OSPF::NextHop>* newNextHops = CalculateNextHops(joiningVertex, justAddedVertex); // (destination, parent)
-                    unsigned int nextHopCount = newNextHops->size();
-                    for (k = 0; k < nextHopCount; k++) {
-                        routingInfo->AddNextHop((*newNextHops)[k]);
-                    }
-                    delete newNextHops;
-                } else {
-                    if (joiningVertexType == RouterLSAType) {
-                        OSPF::RouterLSA* joiningRouterVertex = check_and_cast<OSPF::RouterLSA*> (joiningVertex);
-                        joiningRouterVertex->SetDistance(linkStateCost);
-                        std::vector<OSPF::NextHop>* newNextHops = CalculateNextHops(joiningVertex, justAddedVertex); // (destination, parent)
-                        unsigned int nextHopCount = newNextHops->size();
-                        for (k = 0; k < nextHopCount; k++) {
-                            joiningRouterVertex->AddNextHop((*newNextHops)[k]);
-                        }
-                        delete newNextHops;
-                        OSPF::RoutingInfo* vertexRoutingInfo = check_and_cast<OSPF::RoutingInfo*> (joiningRouterVertex);
-                        vertexRoutingInfo->SetParent(justAddedVertex);
+        GetVertexRoutingInfo(parents[i])->GetChildren().push_back(vertex);
+    }
 
-                        candidateVertices.push_back(joiningRouterVertex);
-                    } else {
-                        OSPF::NetworkLSA* joiningNetworkVertex = check_and_cast<OSPF::NetworkLSA*> (joiningVertex);
-                        joiningNetworkVertex->SetDistance(linkStateCost);
-                        std::vector<OSPF::NextHop>* newNextHops = CalculateNextHops(joiningVertex, justAddedVertex); // (destination, parent)
-                        unsigned int nextHopCount = newNextHops->size();
-                        for (k = 0; k < nextHopCount; k++) {
-                            joiningNetworkVertex->AddNextHop((*newNextHops)[k]);
-                        }
-                        delete newNextHops;
-                        OSPF::RoutingInfo* vertexRoutingInfo = check_and_cast<OSPF::RoutingInfo*> (joiningNetworkVertex);
-                        vertexRoutingInfo->SetParent(justAddedVertex);
+    routingInfo->SetParent((parentCount > 0) ? parents[0] : NULL);
+    routingInfo->SetSPFState(OSPF::RoutingInfo::OnTree);
+    spfTree.push_back(vertex);
+}
 
-                        candidateVertices.push_back(joiningNetworkVertex);
-                    }
-                }
+/**
+ * Takes vertex and all the vertices reached through it off the tree.
+ */
+void OSPF::Area::RemoveSubtreeFromTree(OSPFLSA* vertex, std::vector<OSPFLSA*>& removedVertices)
+{
+    std::vector<OSPFLSA*> subtree(1, vertex);
+
+    while (!subtree.empty()) {
+        OSPFLSA*           currentVertex = subtree.back();
+        OSPF::RoutingInfo* routingInfo   = GetVertexRoutingInfo(currentVertex);
+
+        subtree.pop_back();
+        if (routingInfo->GetSPFState() != OSPF::RoutingInfo::OnTree) {
+            continue;
+        }
+
+        std::vector<OSPFLSA*>& parents     = routingInfo->GetParents();
+        unsigned int           parentCount = parents.size();
+        for (unsigned int i = 0; i < parentCount; i++) {
+            std::vector<OSPFLSA*>&          siblings = GetVertexRoutingInfo(parents[i])->GetChildren();
+            std::vector<OSPFLSA*>::iterator it       = std::find(siblings.begin(), siblings.end(), currentVertex);
+            if (it != siblings.end()) {
+                siblings.erase(it);
             }
         }
+        std::vector<OSPFLSA*>& children = routingInfo->GetChildren();
+        subtree.insert(subtree.end(), children.begin(), children.end());
 
-        if ((vertexType == NetworkLSAType)) {
-            OSPF::NetworkLSA* networkVertex = check_and_cast<OSPF::NetworkLSA*> (justAddedVertex);
-            unsigned int      routerCount   = networkVertex->getAttachedRoutersArraySize();
+        ResetVertex(routingInfo);
+        removedVertices.push_back(currentVertex);
+    }
+}
 
-            for (i = 0; i < routerCount; i++) {     // (2)
-                OSPF::RouterLSA* joiningVertex = FindRouterLSA(networkVertex->getAttachedRouters(i).getInt());
-                if ((joiningVertex == NULL) ||
-                    (joiningVertex->getHeader().getLsAge() == MAX_AGE) ||
-                    (!HasLink(joiningVertex, justAddedVertex)))  // (from, to)     (2) (b)
-                {
-                    continue;
-                }
+/**
+ * Makes the removed vertices candidates again, by examining the vertices on the tree they
+ * are joined to.
+ */
+void OSPF::Area::ReconnectVertices(const std::vector<OSPFLSA*>& removedVertices, SPFCandidateQueue& candidates)
+{
+    std::vector<OSPFLSA*> treeNeighbors;
+    unsigned long         removedCount = removedVertices.size();
+    unsigned long         i, j;
 
-                unsigned int treeSize      = treeVertices.size();
-                bool         alreadyOnTree = false;
+    for (i = 0; i < removedCount; i++) {
+        OSPFLSA* vertex = removedVertices[i];
 
-                for (j = 0; j < treeSize; j++) {
-                    if (treeVertices[j] == joiningVertex) {
-                        alreadyOnTree = true;
-                        break;
-                    }
-                }
-                if (alreadyOnTree) {    // (2) (c)
-                    continue;
-                }
+        if (vertex->getHeader().getLsAge() == MAX_AGE) {
+            continue;
+        }
+        if (vertex->getHeader().getLsType() == RouterLSAType) {
+            OSPF::RouterLSA* routerVertex = static_cast<OSPF::RouterLSA*> (vertex);
+            unsigned int     linkCount    = routerVertex->getLinksArraySize();
 
-                unsigned long linkStateCost  = networkVertex->GetDistance();   // link cost from network to router is always 0
-                unsigned int  candidateCount = candidateVertices.size();
-                OSPFLSA*      candidate      = NULL;
+            for (j = 0; j < linkCount; j++) {
+                Link&    link     = routerVertex->getLinks(j);
+                LinkType linkType = static_cast<LinkType> (link.getType());
 
-                for (j = 0; j < candidateCount; j++) {
-                    if (candidateVertices[j] == joiningVertex) {
-                        candidate = candidateVertices[j];
+                if (linkType == TransitLink) {
+                    treeNeighbors.push_back(FindNetworkLSA(link.getLinkID().getInt()));
+                } else if (linkType == StubLink) {
+                    // see HasLink(): a network may reach a router having only a stub link to it
+                    std::multimap<unsigned long, OSPF::NetworkLSA*>::iterator networkIt  = spfNetworksByAddress.lower_bound(link.getLinkID().getInt() & link.getLinkData());
+                    std::multimap<unsigned long, OSPF::NetworkLSA*>::iterator networkEnd = spfNetworksByAddress.upper_bound(link.getLinkID().getInt() & link.getLinkData());
+                    for (; networkIt != networkEnd; networkIt++) {
+                        treeNeighbors.push_back(networkIt->second);
                     }
+                } else {
+                    treeNeighbors.push_back(FindRouterLSA(link.getLinkID().getInt()));
                 }
-                if (candidate != NULL) {    // (2) (d)
-                    OSPF::RoutingInfo* routingInfo       = check_and_cast<OSPF::RoutingInfo*> (candidate);
-                    unsigned long      candidateDistance = routingInfo->GetDistance();
+            }
+        } else {
+            OSPF::NetworkLSA* networkVertex = static_cast<OSPF::NetworkLSA*> (vertex);
+            unsigned int      routerCount   = networkVertex->getAttachedRoutersArraySize();
 
-                    if (linkStateCost > candidateDistance) {
-                        continue;
-                    }
-                    if (linkStateCost < candidateDistance) {
-                        routingInfo->SetDistance(linkStateCost);
-                        routingInfo->ClearNextHops();
-                    }
-                    std::vector<OSPF::NextHop>* newNextHops = CalculateNextHops(joiningVertex, justAddedVertex); // (destination, parent)
-                    unsigned int nextHopCount = newNextHops->size();
-                    for (k = 0; k < nextHopCount; k++) {
-                        routingInfo->AddNextHop((*newNextHops)[k]);
-                    }
-                    delete newNextHops;
-                } else {
-                    joiningVertex->SetDistance(linkStateCost);
-                    std::vector<OSPF::NextHop>* newNextHops = CalculateNextHops(joiningVertex, justAddedVertex); // (destination, parent)
-                    unsigned int nextHopCount = newNextHops->size();
-                    for (k = 0; k < nextHopCount; k++) {
-                        joiningVertex->AddNextHop((*newNextHops)[k]);
-                    }
-                    delete newNextHops;
-                    OSPF::RoutingInfo* vertexRoutingInfo = check_and_cast<OSPF::RoutingInfo*> (joiningVertex);
-                    vertexRoutingInfo->SetParent(justAddedVertex);
+            for (j = 0; j < routerCount; j++) {
+                treeNeighbors.push_back(FindRouterLSA(networkVertex->getAttachedRouters(j).getInt()));
+            }
+        }
+    }
 
-                    candidateVertices.push_back(joiningVertex);
-                }
+    std::sort(treeNeighbors.begin(), treeNeighbors.end());
+    treeNeighbors.erase(std::unique(treeNeighbors.begin(), treeNeighbors.end()), treeNeighbors.end());
+
+    unsigned long neighborCount = treeNeighbors.size();
+    for (i = 0; i < neighborCount; i++) {
+        if ((treeNeighbors[i] != NULL) &&
+            (GetVertexRoutingInfo(treeNeighbors[i])->GetSPFState() == OSPF::RoutingInfo::OnTree))
+        {
+            AddCandidateVertices(treeNeighbors[i], candidates, true);
+        }
+    }
+}
+
+/**
+ * Looks up the network routes of a routing table being built, giving the same result as a
+ * scan through the table would: the entry covering the address with the greatest masked
+ * address, the one nearer to the front of the table of two equal ones.
+ */
+class NetworkRouteIndex {
+private:
+    typedef std::pair<unsigned long, unsigned long> RouteKey;     ///< (mask, address & mask)
+
+    const std::vector<OSPF::RoutingTableEntry*>&        routingTable;
+    std::map<RouteKey, std::set<unsigned long> >        routesByKey;    ///< Positions in routingTable.
+    std::map<unsigned long, unsigned long>              maskCounts;
+
+    RouteKey GetKey(unsigned long index) const
+    {
+        unsigned long mask = routingTable[index]->GetAddressMask().getInt();
+        return RouteKey(mask, routingTable[index]->GetDestinationID().getInt() & mask);
+    }
+
+public:
+    NetworkRouteIndex(const std::vector<OSPF::RoutingTableEntry*>& table) : routingTable(table)
+    {
+        unsigned long routeCount = table.size();
+        for (unsigned long i = 0; i < routeCount; i++) {
+            if (table[i]->GetDestinationType() == OSPF::RoutingTableEntry::NetworkDestination) {
+                Add(i);
             }
         }
+    }
 
-        if (candidateVertices.empty()) {  // (3)
-            finished = true;
-        } else {
-            unsigned int  candidateCount = candidateVertices.size();
-            unsigned long minDistance = LS_INFINITY;
-            OSPFLSA*      closestVertex = candidateVertices[0];
+    /**
+     * Registers the network route at position index of the table.
+     */
+    void Add(unsigned long index)
+    {
+        RouteKey key = GetKey(index);
+        routesByKey[key].insert(index);
+        maskCounts[key.first]++;
+    }
 
-            for (i = 0; i < candidateCount; i++) {
-                OSPF::RoutingInfo* routingInfo     = check_and_cast<OSPF::RoutingInfo*> (candidateVertices[i]);
-                unsigned long      currentDistance = routingInfo->GetDistance();
+    /**
+     * Unregisters the network route at position index of the table, before its address or mask is changed.
+     */
+    void Remove(unsigned long index)
+    {
+        RouteKey                                                 key     = GetKey(index);
+        std::map<RouteKey, std::set<unsigned long> >::iterator routeIt = routesByKey.find(key);
 
-                if (currentDistance < minDistance) {
-                    closestVertex = candidateVertices[i];
-                    minDistance = currentDistance;
-                } else {
-                    if (currentDistance == minDistance) {
-                        if ((closestVertex->getHeader().getLsType() == RouterLSAType) &&
-                            (candidateVertices[i]->getHeader().getLsType() == NetworkLSAType))
-                        {
-                            closestVertex = candidateVertices[i];
-                        }
-                    }
-                }
+        if ((routeIt != routesByKey.end()) && (routeIt->second.erase(index) > 0)) {
+            if (routeIt->second.empty()) {
+                routesByKey.erase(routeIt);
             }
+            if (--maskCounts[key.first] == 0) {
+                maskCounts.erase(key.first);
+            }
+        }
+    }
 
-            treeVertices.push_back(closestVertex);
+    /**
+     * Returns the position of the matching route in the table, or -1.
+     */
+    long Find(unsigned long address) const
+    {
+        unsigned long longestMatch = 0;
+        long          found        = -1;
 
-            for (std::vector<OSPFLSA*>::iterator it = candidateVertices.begin(); it != candidateVertices.end(); it++) {
-                if ((*it) == closestVertex) {
-                    candidateVertices.erase(it);
-                    break;
+        for (std::map<unsigned long, unsigned long>::const_iterator maskIt = maskCounts.begin(); maskIt != maskCounts.end(); maskIt++) {
+            unsigned long maskedAddress = address & maskIt->first;
+            if ((maskedAddress == 0) || (maskedAddress < longestMatch)) {
+                continue;
+            }
+
+            std::map<RouteKey, std::set<unsigned long> >::const_iterator routeIt = routesByKey.find(RouteKey(maskIt->first, maskedAddress));
+            if (routeIt != routesByKey.end()) {
+                long index = *(routeIt->second.begin());
+                if ((maskedAddress > longestMatch) || (index < found)) {
+                    longestMatch = maskedAddress;
+                    found        = index;
                 }
             }
+        }
+        return found;
+    }
+};
 
-            if (closestVertex->getHeader().getLsType() == RouterLSAType) {
-                OSPF::RouterLSA* routerLSA = check_and_cast<OSPF::RouterLSA*> (closestVertex);
-                if (routerLSA->getB_AreaBorderRouter() || routerLSA->getE_ASBoundaryRouter()) {
-                    OSPF::RoutingTableEntry*                        entry           = new OSPF::RoutingTableEntry;
-                    OSPF::RouterID                                  destinationID   = routerLSA->getHeader().getLinkStateID();
-                    unsigned int                                    nextHopCount    = routerLSA->GetNextHopCount();
-                    OSPF::RoutingTableEntry::RoutingDestinationType destinationType = OSPF::RoutingTableEntry::NetworkDestination;
-
-                    entry->SetDestinationID(destinationID);
-                    entry->SetLinkStateOrigin(routerLSA);
-                    entry->SetArea(areaID);
-                    entry->SetPathType(OSPF::RoutingTableEntry::IntraArea);
-                    entry->SetCost(routerLSA->GetDistance());
-                    if (routerLSA->getB_AreaBorderRouter()) {
-                        destinationType |= OSPF::RoutingTableEntry::AreaBorderRouterDestination;
-                    }
-                    if (routerLSA->getE_ASBoundaryRouter()) {
-                        destinationType |= OSPF::RoutingTableEntry::ASBoundaryRouterDestination;
-                    }
-                    entry->SetDestinationType(destinationType);
-                    entry->SetOptionalCapabilities(routerLSA->getHeader().getLsOptions());
-                    for (i = 0; i < nextHopCount; i++) {
-                        entry->AddNextHop(routerLSA->GetNextHop(i));
-                    }
+/**
+ * Adds the routes to the routers and networks on the shortest path tree, and to the stub
+ * networks of the routers, to newRoutingTable.
+ * @sa RFC2328 Section 16.1. (4) and (5)
+ */
+void OSPF::Area::AddShortestPathTreeRoutes(std::vector<OSPF::RoutingTableEntry*>& newRoutingTable)
+{
+    NetworkRouteIndex networkRoutes(newRoutingTable);
+    unsigned long     i, j, k;
+    unsigned long     treeSize = spfTree.size();
 
-                    newRoutingTable.push_back(entry);
+    for (j = 0; j < treeSize; j++) {
+        OSPFLSA* closestVertex = spfTree[j];
 
-                    OSPF::Area* backbone;
-                    if (areaID != OSPF::BackboneAreaID) {
-                        backbone = parentRouter->GetArea(OSPF::BackboneAreaID);
-                    } else {
-                        backbone = this;
-                    }
-                    if (backbone != NULL) {
-                        OSPF::Interface* virtualIntf = backbone->FindVirtualLink(destinationID);
-                        if ((virtualIntf != NULL) && (virtualIntf->GetTransitAreaID() == areaID)) {
-                            OSPF::IPv4AddressRange range;
-                            range.address = GetInterface(routerLSA->GetNextHop(0).ifIndex)->GetAddressRange().address;
-                            range.mask    = IPv4AddressFromULong(0xFFFFFFFF);
-                            virtualIntf->SetAddressRange(range);
-                            virtualIntf->SetIfIndex(routerLSA->GetNextHop(0).ifIndex);
-                            virtualIntf->SetOutputCost(routerLSA->GetDistance());
-                            OSPF::Neighbor* virtualNeighbor = virtualIntf->GetNeighbor(0);
-                            if (virtualNeighbor != NULL) {
-                                unsigned int     linkCount   = routerLSA->getLinksArraySize();
-                                OSPF::RouterLSA* toRouterLSA = dynamic_cast<OSPF::RouterLSA*> (justAddedVertex);
-                                if (toRouterLSA != NULL) {
+        if (closestVertex->getHeader().getLsType() == RouterLSAType) {
+            OSPF::RouterLSA* routerLSA = static_cast<OSPF::RouterLSA*> (closestVertex);
+            if (routerLSA->getV_VirtualLinkEndpoint()) {    // (2)
+                transitCapability = true;
+            }
+            if ((routerLSA != spfTreeRoot) && (routerLSA->getB_AreaBorderRouter() || routerLSA->getE_ASBoundaryRouter())) {
+                OSPF::RoutingTableEntry*                        entry           = new OSPF::RoutingTableEntry;
+                OSPF::RouterID                                  destinationID   = routerLSA->getHeader().getLinkStateID();
+                unsigned int                                    nextHopCount    = routerLSA->GetNextHopCount();
+                OSPF::RoutingTableEntry::RoutingDestinationType destinationType = OSPF::RoutingTableEntry::NetworkDestination;
+
+                entry->SetDestinationID(destinationID);
+                entry->SetLinkStateOrigin(routerLSA);
+                entry->SetArea(areaID);
+                entry->SetPathType(OSPF::RoutingTableEntry::IntraArea);
+                entry->SetCost(routerLSA->GetDistance());
+                if (routerLSA->getB_AreaBorderRouter()) {
+                    destinationType |= OSPF::RoutingTableEntry::AreaBorderRouterDestination;
+                }
+                if (routerLSA->getE_ASBoundaryRouter()) {
+                    destinationType |= OSPF::RoutingTableEntry::ASBoundaryRouterDestination;
+                }
+                entry->SetDestinationType(destinationType);
+                entry->SetOptionalCapabilities(routerLSA->getHeader().getLsOptions());
+                for (i = 0; i < nextHopCount; i++) {
+                    entry->AddNextHop(routerLSA->GetNextHop(i));
+                }
+
+                newRoutingTable.push_back(entry);
+
+                OSPF::Area* backbone;
+                if (areaID != OSPF::BackboneAreaID) {
+                    backbone = parentRouter->GetArea(OSPF::BackboneAreaID);
+                } else {
+                    backbone = this;
+                }
+                if (backbone != NULL) {
+                    OSPF::Interface* virtualIntf = backbone->FindVirtualLink(destinationID);
+                    if ((virtualIntf != NULL) && (virtualIntf->GetTransitAreaID() == areaID)) {
+                        OSPF::IPv4AddressRange range;
+                        range.address = GetInterface(routerLSA->GetNextHop(0).ifIndex)->GetAddressRange().address;
+                        range.mask    = IPv4AddressFromULong(0xFFFFFFFF);
+                        virtualIntf->SetAddressRange(range);
+                        virtualIntf->SetIfIndex(routerLSA->GetNextHop(0).ifIndex);
+                        virtualIntf->SetOutputCost(routerLSA->GetDistance());
+                        OSPF::Neighbor* virtualNeighbor = virtualIntf->GetNeighbor(0);
+                        if (virtualNeighbor != NULL) {
+                            unsigned int     linkCount   = routerLSA->getLinksArraySize();
+                            OSPF::RouterLSA* toRouterLSA = dynamic_cast<OSPF::RouterLSA*> (routerLSA->GetParent());
+                            if (toRouterLSA != NULL) {
+                                for (i = 0; i < linkCount; i++) {
+                                    Link& link = routerLSA->getLinks(i);
+
+                                    if ((link.getType() == PointToPointLink) &&
+                                        (link.getLinkID() == toRouterLSA->getHeader().getLinkStateID()) &&
+                                        (virtualIntf->GetState() < OSPF::Interface::WaitingState))
+                                    {
+                                        virtualNeighbor->SetAddress(IPv4AddressFromULong(link.getLinkData()));
+                                        virtualIntf->ProcessEvent(OSPF::Interface::InterfaceUp);
+                                        break;
+                                    }
+                                }
+                            } else {
+                                OSPF::NetworkLSA* toNetworkLSA = dynamic_cast<OSPF::NetworkLSA*> (routerLSA->GetParent());
+                                if (toNetworkLSA != NULL) {
                                     for (i = 0; i < linkCount; i++) {
                                         Link& link = routerLSA->getLinks(i);
 
-                                        if ((link.getType() == PointToPointLink) &&
-                                            (link.getLinkID() == toRouterLSA->getHeader().getLinkStateID()) &&
+                                        if ((link.getType() == TransitLink) &&
+                                            (link.getLinkID() == toNetworkLSA->getHeader().getLinkStateID()) &&
                                             (virtualIntf->GetState() < OSPF::Interface::WaitingState))
                                         {
                                             virtualNeighbor->SetAddress(IPv4AddressFromULong(link.getLinkData()));
@@ -1635,91 +1933,61 @@ void OSPF::Area::CalculateShortestPathTree(std::vector<OSPF::RoutingTableEntry*>
                                             break;
                                         }
                                     }
-                                } else {
-                                    OSPF::NetworkLSA* toNetworkLSA = dynamic_cast<OSPF::NetworkLSA*> (justAddedVertex);
-                                    if (toNetworkLSA != NULL) {
-                                        for (i = 0; i < linkCount; i++) {
-                                            Link& link = routerLSA->getLinks(i);
-
-                                            if ((link.getType() == TransitLink) &&
-                                                (link.getLinkID() == toNetworkLSA->getHeader().getLinkStateID()) &&
-                                                (virtualIntf->GetState() < OSPF::Interface::WaitingState))
-                                            {
-                                                virtualNeighbor->SetAddress(IPv4AddressFromULong(link.getLinkData()));
-                                                virtualIntf->ProcessEvent(OSPF::Interface::InterfaceUp);
-                                                break;
-                                            }
-                                        }
-                                    }
                                 }
                             }
                         }
                     }
                 }
             }
+        }
 
-            if (closestVertex->getHeader().getLsType() == NetworkLSAType) {
-                OSPF::NetworkLSA*        networkLSA    = check_and_cast<OSPF::NetworkLSA*> (closestVertex);
-                unsigned long            destinationID = (networkLSA->getHeader().getLinkStateID() & networkLSA->getNetworkMask().getInt());
-                unsigned int             nextHopCount  = networkLSA->GetNextHopCount();
-                bool                     overWrite     = false;
-                OSPF::RoutingTableEntry* entry         = NULL;
-                unsigned long            routeCount    = newRoutingTable.size();
-                unsigned long            longestMatch  = 0;
-
-                for (i = 0; i < routeCount; i++) {
-                    if (newRoutingTable[i]->GetDestinationType() == OSPF::RoutingTableEntry::NetworkDestination) {
-                        OSPF::RoutingTableEntry* routingEntry = newRoutingTable[i];
-                        unsigned long            entryAddress = routingEntry->GetDestinationID().getInt();
-                        unsigned long            entryMask    = routingEntry->GetAddressMask().getInt();
-
-                        if ((entryAddress & entryMask) == (destinationID & entryMask)) {
-                            if ((destinationID & entryMask) > longestMatch) {
-                                longestMatch = (destinationID & entryMask);
-                                entry        = routingEntry;
-                            }
-                        }
-                    }
-                }
-                if (entry != NULL) {
-                    const OSPFLSA* entryOrigin = entry->GetLinkStateOrigin();
-                    if ((entry->GetCost() != networkLSA->GetDistance()) ||
-                        (entryOrigin->getHeader().getLinkStateID() >= networkLSA->getHeader().getLinkStateID()))
-                    {
-                        overWrite = true;
-                    }
+        if (closestVertex->getHeader().getLsType() == NetworkLSAType) {
+            OSPF::NetworkLSA*        networkLSA    = check_and_cast<OSPF::NetworkLSA*> (closestVertex);
+            unsigned long            destinationID = (networkLSA->getHeader().getLinkStateID() & networkLSA->getNetworkMask().getInt());
+            unsigned int             nextHopCount  = networkLSA->GetNextHopCount();
+            bool                     overWrite     = false;
+            long                     entryIndex    = networkRoutes.Find(destinationID);
+            OSPF::RoutingTableEntry* entry         = (entryIndex >= 0) ? newRoutingTable[entryIndex] : NULL;
+
+            if (entry != NULL) {
+                const OSPFLSA* entryOrigin = entry->GetLinkStateOrigin();
+                if ((entry->GetCost() != networkLSA->GetDistance()) ||
+                    (entryOrigin->getHeader().getLinkStateID() >= networkLSA->getHeader().getLinkStateID()))
+                {
+                    overWrite = true;
                 }
+            }
 
-                if ((entry == NULL) || (overWrite)) {
-                    if (entry == NULL) {
-                        entry = new OSPF::RoutingTableEntry;
-                    }
+            if ((entry == NULL) || (overWrite)) {
+                if (entry == NULL) {
+                    entry = new OSPF::RoutingTableEntry;
+                } else {
+                    networkRoutes.Remove(entryIndex);
+                }
 
-                    entry->SetDestinationID(destinationID);
-                    entry->SetAddressMask(networkLSA->getNetworkMask());
-                    entry->SetLinkStateOrigin(networkLSA);
-                    entry->SetArea(areaID);
-                    entry->SetPathType(OSPF::RoutingTableEntry::IntraArea);
-                    entry->SetCost(networkLSA->GetDistance());
-                    entry->SetDestinationType(OSPF::RoutingTableEntry::NetworkDestination);
-                    entry->SetOptionalCapabilities(networkLSA->getHeader().getLsOptions());
-                    for (i = 0; i < nextHopCount; i++) {
-                        entry->AddNextHop(networkLSA->GetNextHop(i));
-                    }
+                entry->SetDestinationID(destinationID);
+                entry->SetAddressMask(networkLSA->getNetworkMask());
+                entry->SetLinkStateOrigin(networkLSA);
+                entry->SetArea(areaID);
+                entry->SetPathType(OSPF::RoutingTableEntry::IntraArea);
+                entry->SetCost(networkLSA->GetDistance());
+                entry->SetDestinationType(OSPF::RoutingTableEntry::NetworkDestination);
+                entry->SetOptionalCapabilities(networkLSA->getHeader().getLsOptions());
+                for (i = 0; i < nextHopCount; i++) {
+                    entry->AddNextHop(networkLSA->GetNextHop(i));
+                }
 
-                    if (!overWrite) {
-                        newRoutingTable.push_back(entry);
-                    }
+                if (!overWrite) {
+                    entryIndex = newRoutingTable.size();
+                    newRoutingTable.push_back(entry);
                 }
+                networkRoutes.Add(entryIndex);
             }
-
-            justAddedVertex = closestVertex;
         }
-    } while (!finished);
+    }
 
-    unsigned int treeSize      = treeVertices.size();
     for (i = 0; i < treeSize; i++) {
-        OSPF::RouterLSA* routerVertex = dynamic_cast<OSPF::RouterLSA*> (treeVertices[i]);
+        OSPF::RouterLSA* routerVertex = dynamic_cast<OSPF::RouterLSA*> (spfTree[i]);
         if (routerVertex == NULL) {
             continue;
         }
@@ -1733,24 +2001,8 @@ void OSPF::Area::CalculateShortestPathTree(std::vector<OSPF::RoutingTableEntry*>
 
             unsigned long            distance      = routerVertex->GetDistance() + link.getLinkCost();
             unsigned long            destinationID = (link.getLinkID().getInt() & link.getLinkData());
-            OSPF::RoutingTableEntry* entry         = NULL;
-            unsigned long            routeCount    = newRoutingTable.size();
-            unsigned long            longestMatch  = 0;
-
-            for (k = 0; k < routeCount; k++) {
-                if (newRoutingTable[k]->GetDestinationType() == OSPF::RoutingTableEntry::NetworkDestination) {
-                    OSPF::RoutingTableEntry* routingEntry = newRoutingTable[k];
-                    unsigned long            entryAddress = routingEntry->GetDestinationID().getInt();
-                    unsigned long            entryMask    = routingEntry->GetAddressMask().getInt();
-
-                    if ((entryAddress & entryMask) == (destinationID & entryMask)) {
-                        if ((destinationID & entryMask) > longestMatch) {
-                            longestMatch = (destinationID & entryMask);
-                            entry        = routingEntry;
-                        }
-                    }
-                }
-            }
+            long                     entryIndex    = networkRoutes.Find(destinationID);
+            OSPF::RoutingTableEntry* entry         = (entryIndex >= 0) ? newRoutingTable[entryIndex] : NULL;
 
             if (entry != NULL) {
                 Metric entryCost = entry->GetCost();
@@ -1803,6 +2055,7 @@ void OSPF::Area::CalculateShortestPathTree(std::vector<OSPF::RoutingTableEntry*>
                 delete newNextHops;
 
                 newRoutingTable.push_back(entry);
+                networkRoutes.Add(newRoutingTable.size() - 1);
             }
         }
     }
@@ -20,6 +20,7 @@
 
 #include <vector>
 #include <map>
+#include <queue>
 #include "OSPFcommon.h"
 #include "OSPFInterface.h"
 #include "LSA.h"
@@ -29,6 +30,39 @@ namespace OSPF {
 
 class Router;
 
+/**
+ * An entry of the candidate list of the shortest path tree calculation(RFC2328 Section 16.1).
+ * Candidates are taken closest first, networks before routers at the same distance (2) (d),
+ * remaining ties are broken by Link State ID so that the tree is always built in the same order.
+ */
+struct SPFCandidate {
+    unsigned long   distance;
+    bool            isRouter;
+    LinkStateID     linkStateID;
+    OSPFLSA*        vertex;
+
+    SPFCandidate(unsigned long d, OSPFLSA* lsa) :
+        distance(d),
+        isRouter(lsa->getHeader().getLsType() == RouterLSAType),
+        linkStateID(lsa->getHeader().getLinkStateID()),
+        vertex(lsa)
+    {}
+
+    bool operator< (const SPFCandidate& other) const
+    {
+        if (distance != other.distance) {
+            return (distance < other.distance);
+        }
+        if (isRouter != other.isRouter) {
+            return other.isRouter;
+        }
+        return (linkStateID < other.linkStateID);
+    }
+    bool operator> (const SPFCandidate& other) const { return (other < *this); }
+};
+
+typedef std::priority_queue<SPFCandidate, std::vector<SPFCandidate>, std::greater<SPFCandidate> > SPFCandidateQueue;
+
 class Area : public cPolymorphic {
 private:
     AreaID                                                  areaID;
@@ -46,6 +80,9 @@ private:
     bool                                                    externalRoutingCapability;
     Metric                                                  stubDefaultCost;
     RouterLSA*                                              spfTreeRoot;
+    std::vector<OSPFLSA*>                                   spfTree;                ///< The vertices of the shortest path tree, closest first.
+    bool                                                    spfTreeValid;           ///< False if the next calculation has to start from scratch.
+    std::multimap<unsigned long, NetworkLSA*>               spfNetworksByAddress;   ///< Used by incremental calculations to find networks from stub links.
 
     Router*                                                 parentRouter;
 public:
@@ -64,7 +101,7 @@ public:
     bool                GetExternalRoutingCapability    (void) const                                    { return externalRoutingCapability; }
     void                SetStubDefaultCost              (Metric cost)                                   { stubDefaultCost = cost; }
     Metric              GetStubDefaultCost              (void) const                                    { return stubDefaultCost; }
-    void                SetSPFTreeRoot                  (RouterLSA* root)                               { spfTreeRoot = root; }
+    void                SetSPFTreeRoot                  (RouterLSA* root)                               { spfTreeRoot = root; spfTreeValid = false; }
     RouterLSA*          GetSPFTreeRoot                  (void)                                          { return spfTreeRoot; }
     const RouterLSA*    GetSPFTreeRoot                  (void) const                                    { return spfTreeRoot; }
 
@@ -124,6 +161,16 @@ private:
     std::vector<NextHop>*   CalculateNextHops                       (OSPFLSA* destination, OSPFLSA* parent) const;
     std::vector<NextHop>*   CalculateNextHops                       (Link& destination, OSPFLSA* parent) const;
 
+    void                    CalculateFullShortestPathTree           (void);
+    void                    CalculateIncrementalShortestPathTree    (const std::vector<OSPFLSA*>& changedVertices);
+    void                    ExtendShortestPathTree                  (SPFCandidateQueue& candidates, bool incremental);
+    void                    AddCandidateVertices                    (OSPFLSA* vertex, SPFCandidateQueue& candidates, bool incremental);
+    void                    UpdateCandidateVertex                   (OSPFLSA* parent, OSPFLSA* vertex, unsigned long distance, SPFCandidateQueue& candidates, bool incremental);
+    void                    AddVertexToTree                         (OSPFLSA* vertex);
+    void                    RemoveSubtreeFromTree                   (OSPFLSA* vertex, std::vector<OSPFLSA*>& removedVertices);
+    void                    ReconnectVertices                       (const std::vector<OSPFLSA*>& removedVertices, SPFCandidateQueue& candidates);
+    void                    AddShortestPathTreeRoutes               (std::vector<RoutingTableEntry*>& newRoutingTable);
+
     LinkStateID             GetUniqueLinkStateID                    (IPv4AddressRange destination,
                                                                      Metric destinationCost,
                                                                      SummaryLSA*& lsaToReoriginate) const;
@@ -24,6 +24,11 @@
  */
 OSPF::Router::Router(OSPF::RouterID id, cSimpleModule* containingModule) :
     routerID(id),
+    spfStartDelay(0.005),
+    spfHoldTime(0.2),
+    spfMaxHoldTime(5.0),
+    spfCurrentHoldTime(0),
+    lastSPFTime(0),
     rfc1583Compatibility(false)
 {
     messageHandler = new OSPF::MessageHandler(this, containingModule);
@@ -32,12 +37,16 @@ OSPF::Router::Router(OSPF::RouterID id, cSimpleModule* containingModule) :
     ageTimer->setContextPointer(this);
     ageTimer->setName("OSPF::Router::DatabaseAgeTimer");
     messageHandler->StartTimer(ageTimer, 1.0);
+    spfTimer = new OSPFTimer;
+    spfTimer->setTimerKind(SPFDelayTimer);
+    spfTimer->setContextPointer(this);
+    spfTimer->setName("OSPF::Router::SPFDelayTimer");
 }
 
 
 /**
  * Destructor.
- * Clears all LSA lists and kills the Database Age timer.
+ * Clears all LSA lists and kills the Database Age and SPF Delay timers.
  */
 OSPF::Router::~Router(void)
 {
@@ -53,8 +62,14 @@ OSPF::Router::~Router(void)
     for (long k = 0; k < routeCount; k++) {
         delete routingTable[k];
     }
+    long deletedCount = deletedLSAs.size();
+    for (long m = 0; m < deletedCount; m++) {
+        delete deletedLSAs[m];
+    }
     messageHandler->ClearTimer(ageTimer);
     delete ageTimer;
+    messageHandler->ClearTimer(spfTimer);
+    delete spfTimer;
     delete messageHandler;
 }
 
@@ -417,13 +432,13 @@ void OSPF::Router::AgeDatabase(void)
             {
                 if (!selfOriginated || unreachable) {
                     asExternalLSAsByID.erase(lsaKey);
-                    delete lsa;
+                    DeleteLSAAfterRebuild(lsa);
                     asExternalLSAs[i] = NULL;
                     rebuildRoutingTable = true;
                 } else {
                     if (lsa->GetPurgeable()) {
                         asExternalLSAsByID.erase(lsaKey);
-                        delete lsa;
+                        DeleteLSAAfterRebuild(lsa);
                         asExternalLSAs[i] = NULL;
                         rebuildRoutingTable = true;
                     } else {
@@ -458,7 +473,7 @@ void OSPF::Router::AgeDatabase(void)
     messageHandler->StartTimer(ageTimer, 1.0);
 
     if (rebuildRoutingTable) {
-        RebuildRoutingTable();
+        ScheduleRoutingTableRebuild();
     }
 }
 
@@ -813,6 +828,51 @@ OSPF::RoutingTableEntry* OSPF::Router::Lookup(IPAddress destination, std::vector
 }
 
 
+/**
+ * Sets the parameters of ScheduleRoutingTableRebuild().
+ * @param startDelay  [in] The delay of the calculation after the first change.
+ * @param holdTime    [in] The initial minimum time between two calculations.
+ * @param maxHoldTime [in] The upper limit of the minimum time between two calculations.
+ */
+void OSPF::Router::SetSPFThrottling(simtime_t startDelay, simtime_t holdTime, simtime_t maxHoldTime)
+{
+    spfStartDelay      = startDelay;
+    spfHoldTime        = holdTime;
+    spfMaxHoldTime     = (maxHoldTime < holdTime) ? holdTime : maxHoldTime;
+    spfCurrentHoldTime = 0;
+}
+
+
+/**
+ * Schedules RebuildRoutingTable() after a change in the link state database, so that
+ * the changes arriving close to each other are handled by a single calculation.
+ * After a quiet period the calculation starts spfStartDelay after the change. Then the
+ * calculations are at least spfCurrentHoldTime apart, which doubles with every further
+ * calculation up to spfMaxHoldTime, and falls back when the changes stop for twice as long.
+ */
+void OSPF::Router::ScheduleRoutingTableRebuild(void)
+{
+    if (spfTimer->isScheduled()) {
+        return;
+    }
+
+    simtime_t now = simTime();
+
+    if ((spfCurrentHoldTime == 0) || (now - lastSPFTime >= 2 * spfCurrentHoldTime)) {
+        spfCurrentHoldTime = spfHoldTime;
+        messageHandler->StartTimer(spfTimer, spfStartDelay);
+    } else {
+        simtime_t startTime = lastSPFTime + spfCurrentHoldTime;
+
+        if (startTime < now + spfStartDelay) {
+            startTime = now + spfStartDelay;
+        }
+        spfCurrentHoldTime = (2 * spfCurrentHoldTime < spfMaxHoldTime) ? 2 * spfCurrentHoldTime : spfMaxHoldTime;
+        messageHandler->StartTimer(spfTimer, startTime - now);
+    }
+}
+
+
 /**
  * Rebuilds the routing table from scratch(based on the LSA database).
  * @sa RFC2328 Section 16.
@@ -826,6 +886,11 @@ void OSPF::Router::RebuildRoutingTable(void)
 
     EV << "Rebuilding routing table:\n";
 
+    if (spfTimer->isScheduled()) {
+        messageHandler->ClearTimer(spfTimer);
+    }
+    lastSPFTime = simTime();
+
     for (i = 0; i < areaCount; i++) {
         areas[i]->CalculateShortestPathTree(newTable);
         if (areas[i]->GetTransitCapability()) {
@@ -892,6 +957,13 @@ void OSPF::Router::RebuildRoutingTable(void)
         delete(oldTable[i]);
     }
 
+    // no route points to the flushed LSAs any more
+    unsigned long deletedCount = deletedLSAs.size();
+    for (i = 0; i < deletedCount; i++) {
+        delete deletedLSAs[i];
+    }
+    deletedLSAs.clear();
+
     EV << "Routing table was rebuilt.\n"
        << "Results:\n";
 
@@ -1581,7 +1653,7 @@ void OSPF::Router::UpdateExternalRoute(OSPF::IPv4Address networkAddress, const O
     delete asExternalLSA;
 
     if (rebuild) {
-        RebuildRoutingTable();
+        ScheduleRoutingTableRebuild();
     }
 }
 
@@ -43,7 +43,14 @@ private:
     std::vector<ASExternalLSA*>                                        asExternalLSAs;          ///< A list of the ASExternalLSAs advertised by this router.
     std::map<IPv4Address, OSPFASExternalLSAContents, IPv4Address_Less> externalRoutes;          ///< A map of the external route advertised by this router.
     OSPFTimer*                                                         ageTimer;                ///< Database age timer - fires every second.
+    OSPFTimer*                                                         spfTimer;                ///< Delays the routing table calculation after a change, see ScheduleRoutingTableRebuild().
+    simtime_t                                                          spfStartDelay;           ///< Delay of the calculation after the first change.
+    simtime_t                                                          spfHoldTime;             ///< Initial minimum time between two calculations.
+    simtime_t                                                          spfMaxHoldTime;          ///< The minimum time between two calculations doubles up to this during a series of changes.
+    simtime_t                                                          spfCurrentHoldTime;      ///< The current minimum time between two calculations, 0 after a quiet period.
+    simtime_t                                                          lastSPFTime;             ///< The time of the last routing table calculation.
     std::vector<RoutingTableEntry*>                                    routingTable;            ///< The OSPF routing table - contains more information than the one in the IP layer.
+    std::vector<OSPFLSA*>                                              deletedLSAs;             ///< LSAs flushed from the database, which the routing table may still point to until the next rebuild.
     MessageHandler*                                                    messageHandler;          ///< The message dispatcher class.
     bool                                                               rfc1583Compatibility;    ///< Decides whether to handle the preferred routing table entry to an AS boundary router as defined in RFC1583 or not.
 
@@ -55,6 +62,7 @@ public:
     RouterID                 GetRouterID               (void) const               { return routerID; }
     void                     SetRFC1583Compatibility   (bool compatibility)       { rfc1583Compatibility = compatibility; }
     bool                     GetRFC1583Compatibility   (void) const               { return rfc1583Compatibility; }
+    void                     SetSPFThrottling          (simtime_t startDelay, simtime_t holdTime, simtime_t maxHoldTime);
     unsigned long            GetAreaCount              (void) const               { return areas.size(); }
 
     MessageHandler*          GetMessageHandler         (void)                     { return messageHandler; }
@@ -88,6 +96,8 @@ public:
     bool                 IsDestinationUnreachable             (OSPFLSA* lsa) const;
     RoutingTableEntry*   Lookup                               (IPAddress destination, std::vector<RoutingTableEntry*>* table = NULL) const;
     void                 RebuildRoutingTable                  (void);
+    void                 ScheduleRoutingTableRebuild          (void);
+    void                 DeleteLSAAfterRebuild                (OSPFLSA* lsa)             { deletedLSAs.push_back(lsa); }
     IPv4AddressRange     GetContainingAddressRange            (IPv4AddressRange addressRange, bool* advertise = NULL) const;
     void                 UpdateExternalRoute                  (IPv4Address networkAddress, const OSPFASExternalLSAContents& externalRouteContents, int ifIndex);
     void                 RemoveExternalRoute                  (IPv4Address networkAddress);
@@ -166,6 +166,10 @@ void LinkStateRouting::processLINK_STATE_MESSAGE(LinkStateMsg* msg, IPAddress se
         }
     }
 
+    // bandwidth and metric updates from peers aren't announced via NotificationBoard
+    if(forward.size() > 0)
+        tedmod->invalidatePathCache();
+
     if(change)
         tedmod->rebuildRoutingTable();
 
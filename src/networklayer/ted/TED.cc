@@ -14,6 +14,7 @@
 
 #include <omnetpp.h>
 #include <algorithm>
+#include <queue>
 
 #include "TED.h"
 #include "IPControlInfo.h"
@@ -25,6 +26,9 @@
 
 #define LS_INFINITY   1e16
 
+// max number of (bandwidth, priority) combinations kept in the path cache
+#define MAX_CACHED_PATHS   32
+
 Define_Module(TED);
 
 TED::TED()
@@ -47,6 +51,7 @@ void TED::initialize(int stage)
     ift = InterfaceTableAccess().get();
     routerId = rt->getRouterId();
     nb = NotificationBoardAccess().get();
+    nb->subscribe(this, NF_TED_CHANGED);
 
     maxMessageId = 0;
 
@@ -136,6 +141,22 @@ void TED::handleMessage(cMessage * msg)
     ASSERT(false);
 }
 
+void TED::receiveChangeNotification(int category, const cPolymorphic *details)
+{
+    Enter_Method_Silent();
+    printNotificationBanner(category, details);
+
+    ASSERT(category == NF_TED_CHANGED);
+
+    // link state or reserved bandwidth changed, cached paths may be stale
+    invalidatePathCache();
+}
+
+void TED::invalidatePathCache()
+{
+    pathCache.clear();
+}
+
 std::ostream & operator<<(std::ostream & os, const TELinkStateInfo& info)
 {
     os << "advrouter:" << info.advrouter;
@@ -152,43 +173,81 @@ std::ostream & operator<<(std::ostream & os, const TELinkStateInfo& info)
 }
 
 // FIXME should this be called findOrCreateVertex() or something like that?
-int TED::assignIndex(std::vector<vertex_t>& vertices, IPAddress nodeAddr)
+int TED::assignIndex(graph_t& graph, IPAddress nodeAddr)
 {
-    // find node in vertices[] whose IP address is nodeAddr
-    for (unsigned int i = 0 ; i < vertices.size(); i++)
-        if (vertices[i].node == nodeAddr)
-            return i;
+    // find node in graph whose IP address is nodeAddr
+    std::map<IPAddress,int>::iterator it = graph.index.find(nodeAddr);
+    if (it != graph.index.end())
+        return it->second;
 
     // if not found, create
-    vertex_t newVertex;
-    newVertex.node = nodeAddr;
-    newVertex.dist = LS_INFINITY;
-    newVertex.parent = -1;
+    int index = graph.nodes.size();
+    graph.index[nodeAddr] = index;
+    graph.nodes.push_back(nodeAddr);
+    graph.links.push_back(std::vector<int>());
+    return index;
+}
 
-    vertices.push_back(newVertex);
-    return vertices.size() - 1;
+bool TED::indexLinks(graph_t& graph, const TELinkStateInfoVector& topology)
+{
+    // links are never removed from the topology, and an entry's endpoints
+    // don't change once stored, so only entries appended since the last
+    // call have to be added to the index
+    ASSERT(graph.numLinks <= topology.size());
+
+    if (graph.numLinks == topology.size())
+        return false;
+
+    for (unsigned int i = graph.numLinks; i < topology.size(); i++)
+    {
+        int src = assignIndex(graph, topology[i].advrouter);
+        int dest = assignIndex(graph, topology[i].linkid);
+        graph.links[src].push_back(i);
+        graph.peers.push_back(dest);
+    }
+    graph.numLinks = topology.size();
+    return true;
 }
 
 IPAddressVector TED::calculateShortestPath(IPAddressVector dest,
             const TELinkStateInfoVector& topology, double req_bandwidth, int priority)
 {
-    // FIXME comment: what do we do here?
-    std::vector<vertex_t> V = calculateShortestPaths(topology, req_bandwidth, priority);
+    // shortest path tree from this router, over the links that satisfy
+    // the constraints; calculations over ted[] itself are cached
+    const graph_t *graph = &tedGraph;
+    const std::vector<vertex_t> *V;
+
+    graph_t tmpGraph;
+    std::vector<vertex_t> tmp;
+
+    if (&topology == &ted)
+    {
+        V = &calculateShortestPaths(req_bandwidth, priority);
+    }
+    else
+    {
+        indexLinks(tmpGraph, topology);
+        assignIndex(tmpGraph, routerId);
+        tmp = calculateShortestPaths(tmpGraph, topology, req_bandwidth, priority);
+        graph = &tmpGraph;
+        V = &tmp;
+    }
 
+    // pick the closest reachable destination
     double minDist = LS_INFINITY;
     int minIndex = -1;
 
-    // FIXME comment: what do we do in this block?
-    for (unsigned int i = 0; i < V.size(); i++)
+    for (unsigned int i = 0; i < dest.size(); i++)
     {
-        if (V[i].dist >= minDist)
+        std::map<IPAddress,int>::const_iterator it = graph->index.find(dest[i]);
+        if (it == graph->index.end())
             continue;
 
-        if (find(dest.begin(), dest.end(), V[i].node) == dest.end())
+        if ((*V)[it->second].dist >= minDist)
             continue;
 
-        minDist = V[i].dist;
-        minIndex = i;
+        minDist = (*V)[it->second].dist;
+        minIndex = it->second;
     }
 
     IPAddressVector result;
@@ -196,11 +255,12 @@ IPAddressVector TED::calculateShortestPath(IPAddressVector dest,
     if (minIndex < 0)
         return result;
 
-    result.push_back(V[minIndex].node);
-    while (V[minIndex].parent != -1)
+    // walk back to the root
+    result.push_back((*V)[minIndex].node);
+    while ((*V)[minIndex].parent != -1)
     {
-        minIndex = V[minIndex].parent;
-        result.insert(result.begin(), V[minIndex].node);
+        minIndex = (*V)[minIndex].parent;
+        result.insert(result.begin(), (*V)[minIndex].node);
     }
 
     return result;
@@ -210,7 +270,10 @@ void TED::rebuildRoutingTable()
 {
     EV << "rebuilding routing table at " << routerId << endl;
 
-    std::vector<vertex_t> V = calculateShortestPaths(ted, 0.0, 7);
+    // callers modify ted[] right before calling us, not always announcing it first
+    invalidatePathCache();
+
+    const std::vector<vertex_t>& V = calculateShortestPaths(0.0, 7);
 
     // remove all routing entries, except multicast ones (we don't care about them)
     int n = rt->getNumRoutes();
@@ -332,61 +395,87 @@ bool TED::isLocalPeer(IPAddress inetAddr)
     return it != ted.end();
 }
 
-std::vector<TED::vertex_t> TED::calculateShortestPaths(const TELinkStateInfoVector& topology,
-            double req_bandwidth, int priority)
+const std::vector<TED::vertex_t>& TED::calculateShortestPaths(double req_bandwidth, int priority)
 {
-    std::vector<vertex_t> vertices;
-    std::vector<edge_t> edges;
+    // new links change the vertex set, so earlier results can't be reused
+    if (indexLinks(tedGraph, ted))
+        invalidatePathCache();
+    assignIndex(tedGraph, routerId);
 
-    // select edges that have enough bandwidth left, and store them into edges[].
-    // meanwhile, collect vertices in vectices[].
-    for (unsigned int i = 0; i < topology.size(); i++)
-    {
-        if (!topology[i].state)
-            continue;
+    std::pair<double,int> key(req_bandwidth, priority);
 
-        if (topology[i].UnResvBandwidth[priority] < req_bandwidth)
-            continue;
+    PathCache::iterator it = pathCache.find(key);
+    if (it != pathCache.end())
+        return it->second;
+
+    if (pathCache.size() >= MAX_CACHED_PATHS)
+        pathCache.clear();
 
-        edge_t edge;
-        edge.src = assignIndex(vertices, topology[i].advrouter);
-        edge.dest = assignIndex(vertices, topology[i].linkid);
-        edge.metric = topology[i].metric;
-        edges.push_back(edge);
+    std::vector<vertex_t>& V = pathCache[key];
+    V = calculateShortestPaths(tedGraph, ted, req_bandwidth, priority);
+    return V;
+}
+
+std::vector<TED::vertex_t> TED::calculateShortestPaths(const graph_t& graph,
+            const TELinkStateInfoVector& topology, double req_bandwidth, int priority)
+{
+    ASSERT(graph.numLinks == topology.size());
+
+    std::vector<vertex_t> vertices(graph.nodes.size());
+    for (unsigned int i = 0; i < vertices.size(); i++)
+    {
+        vertices[i].node = graph.nodes[i];
+        vertices[i].parent = -1;
+        vertices[i].dist = LS_INFINITY;
     }
 
-    IPAddress srcAddr = routerId;
+    std::map<IPAddress,int>::const_iterator root = graph.index.find(routerId);
+    ASSERT(root != graph.index.end());
 
-    int srcIndex = assignIndex(vertices, srcAddr);
+    int srcIndex = root->second;
     vertices[srcIndex].dist = 0.0;
 
-    // FIXME comment: Dijkstra? just guessing...
-    for (unsigned int i = 1; i < vertices.size(); i++)
+    // Dijkstra, candidates are kept in a heap ordered by distance;
+    // a vertex may be pushed several times, only its first pop counts
+    typedef std::pair<double,int> candidate_t;
+    std::priority_queue<candidate_t, std::vector<candidate_t>, std::greater<candidate_t> > candidates;
+    std::vector<bool> done(vertices.size(), false);
+
+    candidates.push(candidate_t(0.0, srcIndex));
+
+    while (!candidates.empty())
     {
-        bool mod = false;
+        int src = candidates.top().second;
+        candidates.pop();
+
+        if (done[src])
+            continue;
+        done[src] = true;
 
-        for (unsigned int j = 0; j < edges.size(); j++)
+        const std::vector<int>& links = graph.links[src];
+        for (unsigned int i = 0; i < links.size(); i++)
         {
-            int src = edges[j].src;
-            int dest = edges[j].dest;
+            const TELinkStateInfo& link = topology[links[i]];
+
+            // follow only links that are up and have enough bandwidth left
+            if (!link.state)
+                continue;
+
+            if (link.UnResvBandwidth[priority] < req_bandwidth)
+                continue;
+
+            int dest = graph.peers[links[i]];
 
-            ASSERT(src >= 0);
-            ASSERT(dest >= 0);
-            ASSERT(src < (int)vertices.size());
-            ASSERT(dest < (int)vertices.size());
             ASSERT(src != dest);
 
-            if (vertices[src].dist + edges[j].metric >= vertices[dest].dist)
+            if (vertices[src].dist + link.metric >= vertices[dest].dist)
                 continue;
 
-            vertices[dest].dist = vertices[src].dist + edges[j].metric;
+            vertices[dest].dist = vertices[src].dist + link.metric;
             vertices[dest].parent = src;
 
-            mod = true;
+            candidates.push(candidate_t(vertices[dest].dist, dest));
         }
-
-        if (!mod)
-            break;
     }
 
     return vertices;
@@ -16,8 +16,10 @@
 #define __INET_TED_H
 
 #include <omnetpp.h>
+#include <map>
 #include "TED_m.h"
 #include "IntServ.h"
+#include "INotifiable.h"
 
 class IRoutingTable;
 class IInterfaceTable;
@@ -31,7 +33,7 @@ class NotificationBoard;
  *
  * See NED file for more info.
  */
-class TED : public cSimpleModule
+class TED : public cSimpleModule, public INotifiable
 {
   public:
     /**
@@ -47,13 +49,19 @@ class TED : public cSimpleModule
 
     /**
      * Only used internally, during shortest path calculation:
-     * edge in the graph we build from links in TELinkStateInfoVector.
+     * adjacency index over the links in a TELinkStateInfoVector. Links
+     * are grouped by advertising router, so that the calculation only
+     * looks at the links leaving the vertex being expanded.
      */
-    struct edge_t
+    struct graph_t
     {
-        int src;       // index into the vertex_t[] vector
-        int dest;      // index into the vertex_t[] vector
-        double metric; // link cost
+        std::map<IPAddress,int> index;        // node address -> index into nodes[]
+        std::vector<IPAddress> nodes;         // vertex addresses
+        std::vector<std::vector<int> > links; // per vertex: indices of the links it advertises
+        std::vector<int> peers;               // per link: index of the vertex it leads to
+        unsigned int numLinks;                // number of topology entries indexed so far
+
+        graph_t() : numLinks(0) {}
     };
 
     /**
@@ -70,8 +78,8 @@ class TED : public cSimpleModule
     virtual int numInitStages() const  {return 5;}
     virtual void handleMessage(cMessage *msg);
 
-    virtual IPAddressVector calculateShortestPath(IPAddressVector dest,
-        const TELinkStateInfoVector& topology, double req_bandwidth, int priority);
+    // INotifiable method
+    virtual void receiveChangeNotification(int category, const cPolymorphic *details);
 
   public:
     /** @name Public interface to the Traffic Engineering Database */
@@ -87,6 +95,22 @@ class TED : public cSimpleModule
     virtual IPAddressVector getLocalAddress();
 
     virtual void rebuildRoutingTable();
+
+    /**
+     * Constrained shortest path first: returns the path from this router
+     * to the closest of the dest routers, using only links that are up and
+     * have at least req_bandwidth unreserved at the given priority.
+     * Returns an empty vector if none of them is reachable.
+     */
+    virtual IPAddressVector calculateShortestPath(IPAddressVector dest,
+        const TELinkStateInfoVector& topology, double req_bandwidth, int priority);
+
+    /**
+     * Drops the cached path calculations. Must be called after modifying
+     * ted[] unless the change is announced with NF_TED_CHANGED or followed
+     * by rebuildRoutingTable().
+     */
+    virtual void invalidatePathCache();
     //@}
 
   protected:
@@ -100,10 +124,18 @@ class TED : public cSimpleModule
   protected:
     int maxMessageId;
 
-    virtual int assignIndex(std::vector<vertex_t>& vertices, IPAddress nodeAddr);
+    // cached shortest path trees over ted[], keyed by (req_bandwidth, priority)
+    typedef std::map<std::pair<double,int>, std::vector<vertex_t> > PathCache;
 
-    std::vector<vertex_t> calculateShortestPaths(const TELinkStateInfoVector& topology,
-        double req_bandwidth, int priority);
+    graph_t tedGraph;     // adjacency index over ted[], extended as links get appended
+    PathCache pathCache;
+
+    virtual int assignIndex(graph_t& graph, IPAddress nodeAddr);
+    virtual bool indexLinks(graph_t& graph, const TELinkStateInfoVector& topology);
+
+    const std::vector<vertex_t>& calculateShortestPaths(double req_bandwidth, int priority);
+    std::vector<vertex_t> calculateShortestPaths(const graph_t& graph,
+        const TELinkStateInfoVector& topology, double req_bandwidth, int priority);
 
   public: //FIXME
     virtual bool checkLinkValidity(TELinkStateInfo link, TELinkStateInfo *&match);
@@ -29,15 +29,31 @@
 
 Define_Module(BindingCache);
 
+// initial number of slots of the BC hash table; must be a power of two
+#define BC_INITIAL_CAPACITY  16
+
 std::ostream& operator<<(std::ostream& os, const BindingCache::BindingCacheEntry& bce)
 {
     os << "CoA of MN:" << bce.careOfAddress << " BU Lifetime: " << bce.bindingLifetime <<" Home Registeration: "<<bce.isHomeRegisteration <<" BU_Sequence#: "<<bce.sequenceNumber<<"\n";
     return os;
 }
 
+std::ostream& operator<<(std::ostream& os, const BindingCache::BindingCacheView& view)
+{
+    const BindingCache::BindingCache6& table = view.owner->bindingCache;
+    os << view.owner->numUsed << " entries\n";
+    for (unsigned int i=0; i<table.size(); i++)
+        if (table[i].slotState == BindingCache::SLOT_USED)
+            os << "HoA " << table[i].homeAddress << ": " << table[i];
+    return os;
+}
+
 
 BindingCache::BindingCache()
 {
+	numUsed = numDeleted = 0;
+	bindingCacheView.owner = this;
+	rehash(BC_INITIAL_CAPACITY);
 }
 
 
@@ -52,7 +68,7 @@ void BindingCache::initialize(int stage)
 {
     if (stage==1)
     {
-    	WATCH_MAP(bindingCache); //added by Zarrar Yousaf
+    	WATCH(bindingCacheView); //added by Zarrar Yousaf
     }
 }
 
@@ -63,15 +79,98 @@ void BindingCache::handleMessage(cMessage *msg)
 }
 
 
+const BindingCache::BindingCacheEntry *BindingCache::lookup(const IPv6Address& HoA) const
+{
+	unsigned int mask = bindingCache.size()-1;
+
+	for (unsigned int i = HoA.hash() & mask; ; i = (i+1) & mask)
+	{
+		const BindingCacheEntry& slot = bindingCache[i];
+
+		if (slot.slotState == SLOT_EMPTY)
+			return NULL; // end of probe sequence
+		if (slot.slotState == SLOT_USED && slot.homeAddress == HoA)
+			return &slot;
+	}
+}
+
+
+BindingCache::BindingCacheEntry *BindingCache::lookupOrInsert(const IPv6Address& HoA)
+{
+	// keep the load factor (including tombstones) below 3/4, so that
+	// probe sequences stay short and an empty slot always exists
+	if ((numUsed+numDeleted+1)*4 > bindingCache.size()*3)
+		rehash(numUsed*4 >= bindingCache.size() ? bindingCache.size()*2 : bindingCache.size());
+
+	unsigned int mask = bindingCache.size()-1;
+	BindingCacheEntry *tombstone = NULL;
+
+	for (unsigned int i = HoA.hash() & mask; ; i = (i+1) & mask)
+	{
+		BindingCacheEntry& slot = bindingCache[i];
+
+		if (slot.slotState == SLOT_USED)
+		{
+			if (slot.homeAddress == HoA)
+				return &slot;
+		}
+		else if (slot.slotState == SLOT_DELETED)
+		{
+			if (tombstone == NULL)
+				tombstone = &slot;
+		}
+		else
+		{
+			// HoA is not in the cache: reuse the first tombstone on the
+			// probe path if there was one, otherwise this empty slot
+			BindingCacheEntry *entry = &slot;
+			if (tombstone != NULL)
+			{
+				entry = tombstone;
+				numDeleted--;
+			}
+			*entry = BindingCacheEntry();
+			entry->homeAddress = HoA;
+			entry->slotState = SLOT_USED;
+			numUsed++;
+			return entry;
+		}
+	}
+}
+
+
+void BindingCache::rehash(unsigned int newCapacity)
+{
+	BindingCache6 oldTable;
+	oldTable.swap(bindingCache);
+
+	BindingCacheEntry emptySlot = BindingCacheEntry();
+	emptySlot.slotState = SLOT_EMPTY;
+	bindingCache.assign(newCapacity, emptySlot);
+
+	unsigned int mask = newCapacity-1;
+	for (BindingCache6::const_iterator it = oldTable.begin(); it != oldTable.end(); ++it)
+	{
+		if (it->slotState != SLOT_USED)
+			continue;
+
+		unsigned int i = it->homeAddress.hash() & mask;
+		while (bindingCache[i].slotState == SLOT_USED)
+			i = (i+1) & mask;
+		bindingCache[i] = *it;
+	}
+	numDeleted = 0;
+}
 
 
 void BindingCache::addOrUpdateBC(const IPv6Address& hoa, const IPv6Address& coa, const uint lifetime, const uint seq, bool homeReg)
 {
 	EV<<"\n++++++++++++++++++++Binding Cache Being Updated in Routing Table6 ++++++++++++++\n";
-	bindingCache[hoa].careOfAddress = coa;
-	bindingCache[hoa].bindingLifetime = lifetime;
-	bindingCache[hoa].sequenceNumber = seq;
-	bindingCache[hoa].isHomeRegisteration = homeReg;
+	BindingCacheEntry *entry = lookupOrInsert(hoa);
+	entry->careOfAddress = coa;
+	entry->bindingLifetime = lifetime;
+	entry->sequenceNumber = seq;
+	entry->isHomeRegisteration = homeReg;
 }
 
 
@@ -85,60 +184,64 @@ uint BindingCache::readBCSequenceNumber(const IPv6Address& HoA)
 	// update 10.09.07 - CB
 	// the code from above creates a new (empty) entry if
 	// the provided HoA does not yet exist.
-	BindingCache6::iterator pos = bindingCache.find(HoA);
+	const BindingCacheEntry *entry = lookup(HoA);
 
-	if ( pos == bindingCache.end() )
+	if ( entry == NULL )
 		return 0; // HoA not yet registered
 	else
-		return pos->second.sequenceNumber;
+		return entry->sequenceNumber;
 }
 
 
 bool BindingCache::isInBindingCache(const IPv6Address& HoA, IPv6Address& CoA)
 {
-	BindingCache6::iterator pos = bindingCache.find(HoA);
+	const BindingCacheEntry *entry = lookup(HoA);
 
-	if ( pos == bindingCache.end() )
+	if ( entry == NULL )
 		return false; // if HoA is not registered then there's obviously no valid entry in the BC
 
-	return (pos->second.careOfAddress == CoA); // if CoA corresponds to HoA, everything is fine
+	return (entry->careOfAddress == CoA); // if CoA corresponds to HoA, everything is fine
 }
 
 
 bool BindingCache::isInBindingCache(const IPv6Address& HoA)
 {
-	return bindingCache.find(HoA) != bindingCache.end();
+	return lookup(HoA) != NULL;
 }
 
 
 void BindingCache::deleteEntry(IPv6Address& HoA)
 {
-	BindingCache6::iterator pos = bindingCache.find(HoA);
-
-	if ( pos != bindingCache.end() ) // update 11.9.07 - CB
-		bindingCache.erase(pos);
+	BindingCacheEntry *entry = const_cast<BindingCacheEntry *>(lookup(HoA));
+
+	if ( entry != NULL ) // update 11.9.07 - CB
+	{
+		entry->slotState = SLOT_DELETED;
+		numUsed--;
+		numDeleted++;
+	}
 }
 
 
 bool BindingCache::getHomeRegistration(const IPv6Address& HoA)
 {
-	BindingCache6::iterator pos = bindingCache.find( HoA );
+	const BindingCacheEntry *entry = lookup(HoA);
 
-	if ( pos == bindingCache.end() )
+	if ( entry == NULL )
 		return false; // HoA not yet registered; should not occur anyway
 	else
-		return pos->second.isHomeRegisteration;
+		return entry->isHomeRegisteration;
 }
 
 
 uint BindingCache::getLifetime(const IPv6Address& HoA)
 {
-	BindingCache6::iterator pos = bindingCache.find( HoA );
+	const BindingCacheEntry *entry = lookup(HoA);
 
-	if ( pos == bindingCache.end() )
+	if ( entry == NULL )
 		return 0; // HoA not yet registered; should not occur anyway
 	else
-		return pos->second.bindingLifetime;
+		return entry->bindingLifetime;
 }
 
 
@@ -47,7 +47,8 @@ class INET_API BindingCache : public cSimpleModule
 		  /*o  The home address of the mobile node for which this is the Binding
 			  Cache entry.  This field is used as the key for searching the
       		  Binding Cache for the destination address of a packet being sent.*/
-		  // this is stored as the key to the entry
+		  // this is stored inline as the key of the hash table slot
+		  IPv6Address homeAddress;
 		  /*o  The care-of address for the mobile node indicated by the home
       		   address field in this Binding Cache entry.*/
 		  IPv6Address careOfAddress;
@@ -56,15 +57,16 @@ class INET_API BindingCache : public cSimpleModule
       		   Lifetime field in the Binding Update that created or last modified
       		   this Binding Cache entry.*/
    		  uint bindingLifetime;
-		  /*o  A flag indicating whether or not this Binding Cache entry is a
-      		   home registration entry (applicable only on nodes which support
-      		   home agent functionality).*/ 
-   		  bool isHomeRegisteration; 	//if FALSE, it is Correspondent Registeration
    		  /*o  The maximum value of the Sequence Number field received in
 			   previous Binding Updates for this home address.  The Sequence
 			   Number field is 16 bits long.  Sequence Number values MUST be
-			   compared modulo 2**16 as explained in Section 9.5.1.*/	  
+			   compared modulo 2**16 as explained in Section 9.5.1.*/
    		  uint sequenceNumber; 	//Sequence number of BU message sent
+		  /*o  A flag indicating whether or not this Binding Cache entry is a
+      		   home registration entry (applicable only on nodes which support
+      		   home agent functionality).*/
+   		  bool isHomeRegisteration; 	//if FALSE, it is Correspondent Registeration
+   		  unsigned char slotState; // SLOT_EMPTY, SLOT_USED or SLOT_DELETED
    		  /*o  Usage information for this Binding Cache entry.  This is needed to
       		   implement the cache replacement policy in use in the Binding
       		   Cache.  Recent use of a cache entry also serves as an indication
@@ -72,9 +74,30 @@ class INET_API BindingCache : public cSimpleModule
       		   this entry nears expiration.*/
    		  // omitted
 	  };
-	  typedef std::map<IPv6Address,BindingCacheEntry> BindingCache6; //The IPv6 Address KEY of this map is the HomeAddress of the MN
+
+	  enum SlotState { SLOT_EMPTY = 0, SLOT_USED, SLOT_DELETED };
+
+	  /*
+	   * The Binding Cache is an open-addressing hash table (linear probing)
+	   * keyed by the home address of the MN. Home agents may serve a very
+	   * large number of MNs, and the BC is consulted for every Binding Update,
+	   * so lookups should not depend on the number of registered bindings.
+	   * The slot array always has a power of two size; deleted slots are
+	   * marked as tombstones and dropped on the next rehash.
+	   */
+	  typedef std::vector<BindingCacheEntry> BindingCache6;
 	  BindingCache6 bindingCache;
-	  
+	  unsigned int numUsed;    // slots holding a binding
+	  unsigned int numDeleted; // tombstones
+
+	  // needed by the WATCH() in initialize()
+	  struct BindingCacheView
+	  {
+		  const BindingCache *owner;
+	  };
+	  BindingCacheView bindingCacheView;
+
+	  friend std::ostream& operator<<(std::ostream& os, const BindingCacheView& view);
 	  friend std::ostream& operator<<(std::ostream& os, const BindingCacheEntry& bce);
 
   public:
@@ -90,6 +113,23 @@ class INET_API BindingCache : public cSimpleModule
 	   */
 	  virtual void handleMessage(cMessage *);
 
+	  /**
+	   * Returns the slot holding the binding for the given HoA, or NULL.
+	   */
+	  const BindingCacheEntry *lookup(const IPv6Address& HoA) const;
+
+	  /**
+	   * Returns the slot for the given HoA, claiming a free one if the
+	   * HoA is not yet in the cache.
+	   */
+	  BindingCacheEntry *lookupOrInsert(const IPv6Address& HoA);
+
+	  /**
+	   * Reallocates the slot array with the given number of slots
+	   * (power of two) and reinserts all live entries.
+	   */
+	  void rehash(unsigned int newCapacity);
+
   public:
 	  /**
 	   * Sets Binding Cache Entry (BCE) with provided values. If BCE does not yet exist, a new one will be created.
@@ -129,6 +169,11 @@ class INET_API BindingCache : public cSimpleModule
 	   */
 	  uint getLifetime(const IPv6Address& HoA); // 10.9.07 - CB
 
+	  /**
+	   * Returns the number of bindings currently stored in the BC.
+	   */
+	  unsigned int getNumEntries() const {return numUsed;}
+
 
 	/**
 	 * Generates a home token from the provided parameters.
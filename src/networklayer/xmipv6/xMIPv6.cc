@@ -22,6 +22,7 @@
 
 #include "xMIPv6.h"
 #include <algorithm>
+#include "Ieee80211Primitives_m.h"
 
 #define MK_SEND_PERIODIC_BU			1
 // 18.09.07 - CB
@@ -35,6 +36,17 @@
 #define MAX_TOKEN_LIFETIME			500		//210  // maximum valid lifetime for the tokens used in RR
 #define MAX_RR_BINDING_LIFETIME		4000	//420  // maximum valid lifetime of a binding for CNs
 #define TEST_INIT_RETRANS_FACTOR	8	 	// HoTI and CoTI will be retransmitted every MAX_RR_BINDING_LIFETIME * TEST_INIT_RETRANS_FACTOR seconds
+// FMIPv6 (RFC 5568)
+#define MK_SEND_FHO_MSG				12		// RtSolPr, FBU or HI (re)transmission
+#define MK_FHO_TUNNEL_EXPIRY		24
+#define FHO_RETRANS_TIMEOUT			1		// seconds between retransmissions of RtSolPr, FBU and HI
+#define FHO_RETRIES					3		// number of transmissions of RtSolPr, FBU and HI
+#define FHO_POLL_INTERVAL			0.1		// retry interval while there is no default router (RtSolPr) or the source is tentative
+#define FHO_MAX_DEFERRALS			30		// give up after deferring the transmission this often
+#define FHO_LIFETIME				20		// lifetime of the PAR's tunnel in seconds, until the HA binding takes over
+#define FHO_BUFFER_TIME				3		// seconds that the NAR buffers packets for a NCoA after a HI
+#define HACK_ACCEPTED				0		// 6.2.2 Handover Accepted
+#define HACK_NOT_ACCEPTED			128		// 6.2.2 Handover Not Accepted, reason unspecified
 
 
 // sizes of mobility messages and headers in bytes
@@ -50,6 +62,15 @@
 #define	SIZE_COT				18	// 6.1.6 CoT = 144 bit
 #define	SIZE_BE					18	// 6.1.9 BE message = 144 bit
 #define	SIZE_BRR				2	// 6.1.2 BRR reserved = 16 bit
+// RFC 5568
+#define SIZE_RTSOLPR			10	// 6.1.1 identifier + new AP link-layer address option
+#define SIZE_PRRTADV			2	// 6.1.2 code + identifier
+#define SIZE_PRRTADV_NEIGHBOUR	64	// 6.1.2 per AP: AP-ID, NAR link-layer address, NAR prefix and IP address options
+#define SIZE_FBU				6	// 6.3.1 same as BU
+#define SIZE_ALT_COA_OPTION		18	// 6.3.1 Alternate CoA option carrying the NCoA
+#define SIZE_FBACK				6	// 6.3.2 same as BAck
+#define SIZE_HI					52	// 6.2.1 HI with PCoA and NCoA options
+#define SIZE_HACK				4	// 6.2.2 status + identifier
 
 
 Define_Module(xMIPv6);
@@ -75,6 +96,8 @@ xMIPv6::~xMIPv6()
 
 		cancelTimerIfEntry(key.dest, key.interfaceID, key.type);
 	}
+
+	cancelAndDelete(timerWheelTick);
 }
 
 
@@ -86,6 +109,14 @@ void xMIPv6::initialize(int stage)
 
 		nb = NotificationBoardAccess().get();
 
+		timerWheel.setResolution(par("timerWheelResolution"));
+		timerWheelTick = new cMessage("timerWheelTick");
+
+		fastHandoverMode = FHO_NONE;
+		fbackReceived = false;
+		fhoSequence = 0;
+		numFastHandoversAccepted = 0;
+
 		// statistic collection
 		/*statVectorBUtoHA.setName("BU to HA");
 		statVectorBUtoCN.setName("BU to CN");
@@ -137,50 +168,48 @@ void xMIPv6::initialize(int stage)
 			bul = NULL;
 		}
 
+        // FMIPv6
+        if ( rt6->isMobileNode() )
+        {
+        	std::string mode = par("fastHandover").stdstringValue();
+        	if ( mode == "predictive" )
+        		fastHandoverMode = FHO_PREDICTIVE;
+        	else if ( mode == "reactive" )
+        		fastHandoverMode = FHO_REACTIVE;
+        	else if ( mode != "" )
+        		error("Invalid value '%s' for parameter fastHandover", mode.c_str());
+
+        	if ( fastHandoverMode != FHO_NONE )
+        	{
+        		nb->subscribe(this, NF_L2_BEACON_LOST);
+        		nb->subscribe(this, NF_MIH_LINK_DOWN);
+        		nb->subscribe(this, NF_L2_ASSOCIATED);
+        	}
+        }
+        else
+        	parseFastHandoverNeighbours(par("fastHandoverNeighbours"));
+
         WATCH_VECTOR(cnList);
         WATCH_MAP(interfaceCoAList);
+        WATCH(parAddress);
+        WATCH(currentAccessPoint);
+        WATCH(numFastHandoversAccepted);
      }
 }
 
 
+void xMIPv6::finish()
+{
+	if ( !rt6->isMobileNode() && !neighbourRouterConfigs.empty() )
+		recordScalar("fast handovers accepted", numFastHandoversAccepted);
+}
+
+
 void xMIPv6::handleMessage(cMessage *msg)
 {
-    if ( msg->isSelfMessage() )
+    if ( msg == timerWheelTick )
     {
-        EV << "Self message received!\n";
-
-        if (msg->getKind()==MK_SEND_PERIODIC_BU)
-        {
-            EV << "Periodic BU Timeout Message Received\n";
-            sendPeriodicBU(msg);
-        }
-        else if (msg->getKind()==MK_SEND_PERIODIC_BR)
-        {
-            EV << "Periodic BRR Timeout Message Received\n";
-            sendPeriodicBRR(msg);
-        }
-        else if (msg->getKind()==MK_SEND_TEST_INIT) // 28.08.07 - CB
-        {
-        	EV << "HoTI/CoTI Timeout Message Received\n";
-        	sendTestInit(msg);
-        }
-        else if (msg->getKind()==MK_BUL_EXPIRY) // 12.06.08 - CB
-        {
-        	EV << "BUL Expiry Timeout Message Received\n";
-        	handleBULExpiry(msg);
-        }
-        else if (msg->getKind()==MK_BC_EXPIRY) // 12.06.08 - CB
-        {
-        	EV << "BUL Expiry Timeout Message Received\n";
-        	handleBCExpiry(msg);
-        }
-        else if ( msg->getKind() == MK_TOKEN_EXPIRY ) // 11.07.08 - CB
-        {
-        	EV << "RR token expired" << endl;
-        	handleTokenExpiry(msg);
-        }
-        else
-            error("Unrecognized Timer");//stops sim w/ error msg.
+        handleTimerWheelTick();
     }
     // Zarrar Yousaf @ CNI Dortmund Uni on 29.05.07
     // if its a MIPv6 related mobility message
@@ -209,6 +238,113 @@ void xMIPv6::handleMessage(cMessage *msg)
 }
 
 
+void xMIPv6::handleTimer(cMessage *msg)
+{
+    EV << "Timer expired: " << msg->getName() << "\n";
+
+    if (msg->getKind()==MK_SEND_PERIODIC_BU)
+    {
+        EV << "Periodic BU Timeout Message Received\n";
+        sendPeriodicBU(msg);
+    }
+    else if (msg->getKind()==MK_SEND_PERIODIC_BR)
+    {
+        EV << "Periodic BRR Timeout Message Received\n";
+        sendPeriodicBRR(msg);
+    }
+    else if (msg->getKind()==MK_SEND_TEST_INIT) // 28.08.07 - CB
+    {
+    	EV << "HoTI/CoTI Timeout Message Received\n";
+    	sendTestInit(msg);
+    }
+    else if (msg->getKind()==MK_BUL_EXPIRY) // 12.06.08 - CB
+    {
+    	EV << "BUL Expiry Timeout Message Received\n";
+    	handleBULExpiry(msg);
+    }
+    else if (msg->getKind()==MK_BC_EXPIRY) // 12.06.08 - CB
+    {
+    	EV << "BUL Expiry Timeout Message Received\n";
+    	handleBCExpiry(msg);
+    }
+    else if ( msg->getKind() == MK_TOKEN_EXPIRY ) // 11.07.08 - CB
+    {
+    	EV << "RR token expired" << endl;
+    	handleTokenExpiry(msg);
+    }
+    else if ( msg->getKind() == MK_SEND_FHO_MSG )
+    {
+    	EV << "RtSolPr/FBU/HI Timeout Message Received" << endl;
+    	sendFastHandoverMessage(msg);
+    }
+    else if ( msg->getKind() == MK_FHO_TUNNEL_EXPIRY )
+    {
+    	EV << "Fast handover tunnel expired" << endl;
+    	handleFastHandoverTunnelExpiry(msg);
+    }
+    else
+        error("Unrecognized Timer");//stops sim w/ error msg.
+}
+
+
+void xMIPv6::handleTimerWheelTick()
+{
+	timerWheel.advance(simTime());
+
+	// fire all timers that are due in this slot; pop them one by one,
+	// since a handler may cancel (and delete) other due entries
+	TimerWheel::Timer* t;
+	while ( (t = timerWheel.popExpired()) != NULL )
+	{
+		TimerIfEntry* entry = (TimerIfEntry*) t;
+		ASSERT(entry->timer != NULL);
+		handleTimer(entry->timer);
+	}
+
+	rescheduleTimerWheelTick();
+}
+
+
+void xMIPv6::scheduleTimer(TimerIfEntry* entry, simtime_t expiryTime)
+{
+	// zero-delay timers (e.g. the first BU) must not be delayed to the
+	// next tick, so they bypass the rounding to timerWheelResolution
+	if ( expiryTime <= simTime() )
+		timerWheel.scheduleExpired(entry);
+	else
+		timerWheel.schedule(entry, expiryTime);
+
+	// the tick only needs to be moved if the new timer expires before it;
+	// this keeps scheduling O(1)
+	simtime_t wakeupTime = entry->getExpiryTime();
+	if ( wakeupTime < simTime() )
+		wakeupTime = simTime();
+
+	if ( timerWheelTick->isScheduled() )
+	{
+		if ( timerWheelTick->getArrivalTime() <= wakeupTime )
+			return;
+		cancelEvent(timerWheelTick);
+	}
+	scheduleAt(wakeupTime, timerWheelTick);
+}
+
+
+void xMIPv6::rescheduleTimerWheelTick()
+{
+	// cancelled timers are not tracked here: if the earliest timer was
+	// cancelled, the tick simply arrives, finds nothing due and moves on
+	cancelEvent(timerWheelTick);
+
+	simtime_t wakeupTime = timerWheel.getNextWakeupTime();
+	if ( wakeupTime == MAXTIME )
+		return;
+	if ( wakeupTime < simTime() )
+		wakeupTime = simTime();
+	scheduleAt(wakeupTime, timerWheelTick);
+}
+
+
 void xMIPv6::processMobilityMessage(MobilityHeader* mipv6Msg, IPv6ControlInfo* ctrlInfo)
 {
 	EV <<"Processing of MIPv6 related mobility message" << endl;
@@ -253,6 +389,37 @@ void xMIPv6::processMobilityMessage(MobilityHeader* mipv6Msg, IPv6ControlInfo* c
 		EV <<"Message recognised as Binding Refresh Request" << endl;
 		processBRRMessage( (BindingRefreshRequest*) mipv6Msg, ctrlInfo );
 	}
+	// FMIPv6
+	else if ( dynamic_cast<RouterSolicitationForProxyAdv*>(mipv6Msg) )
+	{
+		EV <<"Message recognised as Router Solicitation for Proxy Advertisement (RtSolPr)" << endl;
+		processRtSolPrMessage( (RouterSolicitationForProxyAdv*) mipv6Msg, ctrlInfo );
+	}
+	else if ( dynamic_cast<ProxyRouterAdvertisement*>(mipv6Msg) )
+	{
+		EV <<"Message recognised as Proxy Router Advertisement (PrRtAdv)" << endl;
+		processPrRtAdvMessage( (ProxyRouterAdvertisement*) mipv6Msg, ctrlInfo );
+	}
+	else if ( dynamic_cast<FastBindingUpdate*>(mipv6Msg) )
+	{
+		EV <<"Message recognised as Fast Binding Update (FBU)" << endl;
+		processFBUMessage( (FastBindingUpdate*) mipv6Msg, ctrlInfo );
+	}
+	else if ( dynamic_cast<FastBindingAcknowledgement*>(mipv6Msg) )
+	{
+		EV <<"Message recognised as Fast Binding Acknowledgement (FBack)" << endl;
+		processFBackMessage( (FastBindingAcknowledgement*) mipv6Msg, ctrlInfo );
+	}
+	else if ( dynamic_cast<HandoverInitiate*>(mipv6Msg) )
+	{
+		EV <<"Message recognised as Handover Initiate (HI)" << endl;
+		processHIMessage( (HandoverInitiate*) mipv6Msg, ctrlInfo );
+	}
+	else if ( dynamic_cast<HandoverAcknowledge*>(mipv6Msg) )
+	{
+		EV <<"Message recognised as Handover Acknowledge (HAck)" << endl;
+		processHAckMessage( (HandoverAcknowledge*) mipv6Msg, ctrlInfo );
+	}
 	else
 	{
 		EV <<"Unrecognised mobility message... Dropping" << endl;
@@ -436,7 +603,7 @@ void xMIPv6::createBUTimer(const IPv6Address& buDest, InterfaceEntry* ie, const
 
 	// send BU now, 14.9.07 - CB
 	//scheduleAt(buIfEntry->initScheduledBUTime, buTriggerMsg); //Scheduling a message which will trigger a BU towards buIfEntry->dest
-	scheduleAt(simTime(), buTriggerMsg); //Scheduling a message which will trigger a BU towards buIfEntry->dest
+	scheduleTimer(buIfEntry, simTime()); //Scheduling a message which will trigger a BU towards buIfEntry->dest
 }
 
 
@@ -505,7 +672,7 @@ void xMIPv6::sendPeriodicBU(cMessage *msg)
 	}
 	EV << "Present Sent Time: " << buIfEntry->presentSentTimeBU <<", Present TimeOut: " << buIfEntry->ackTimeout << endl;
 	EV << "Next Sent Time: " << buIfEntry->nextScheduledTime << endl;//<<" Next TimeOut: "<<buIfEntry->nextBindAckTimeout<<endl;
-	scheduleAt(buIfEntry->nextScheduledTime, msg);
+	scheduleTimer(buIfEntry, buIfEntry->nextScheduledTime);
 }
 
 
@@ -1293,6 +1460,9 @@ void xMIPv6::processBAMessage(BindingAcknowledgement* ba, IPv6ControlInfo* ctrlI
 					tunneling->createTunnel( IPv6Tunneling::NORMAL, entry->careOfAddress, entry->destAddress ); // update 10.06.08 - CB
 					//bubble("Established tunnel to home agent.");
 
+					// the HA now forwards to the NCoA: the PAR is not needed anymore
+					finishFastHandover(ie, entry->careOfAddress);
+
 					/**11.5.1
 					 	After updating its home registration, the mobile
    						node then updates associated mobility bindings in correspondent nodes
@@ -1610,7 +1780,7 @@ void xMIPv6::createTestInitTimer(MobilityHeader* testInit, const IPv6Address& de
 
 	// scheduling a message which will trigger the Test Init for sendTime seconds
 	// if not called with a parameter for sendTime, the message will be scheduled for NOW
-	scheduleAt(simTime()+sendTime, testInitTriggerMsg);
+	scheduleTimer(tiIfEntry, simTime()+sendTime);
 }
 
 
@@ -1695,7 +1865,7 @@ void xMIPv6::sendTestInit(cMessage* msg)
 		tiIfEntry->ackTimeout = ie->ipv6Data()->_maxBindAckTimeout();
 
 	msg->setContextPointer(tiIfEntry);
-	scheduleAt(tiIfEntry->nextScheduledTime, msg);
+	scheduleTimer(tiIfEntry, tiIfEntry->nextScheduledTime);
 
 	EV << "Scheduled next HoTI/CoTI for time=" << tiIfEntry->nextScheduledTime
 	   << " with timeout=" << tiIfEntry->ackTimeout << " for dest="
@@ -1788,15 +1958,14 @@ void xMIPv6::resetBUIfEntry(const IPv6Address& dest, int interfaceID, simtime_t
 	TimerIfEntry* entry = (pos->second);
 	ASSERT(entry);
 
-	// first we cancel the current retransmission timer
-	cancelEvent(entry->timer);
-	// then we reset the timeout value to the initial value
+	// first we reset the timeout value to the initial value
 	entry->ackTimeout = entry->ifEntry->ipv6Data()->_initialBindAckTimeout();
 	// and then we reschedule again for BU expiry time
-	// (with correct offset for scheduling)
+	// (with correct offset for scheduling); this also
+	// cancels the current retransmission timer
 	entry->nextScheduledTime = retransmissionTime;
 
-	scheduleAt(entry->nextScheduledTime, entry->timer);
+	scheduleTimer(entry, entry->nextScheduledTime);
 
 	EV << "Updated BUTransmitIfEntry and corresponding timer.\n";
 }
@@ -2344,8 +2513,11 @@ bool xMIPv6::cancelTimerIfEntry(const IPv6Address& dest, int interfaceID, int ms
 
 	if ( dynamic_cast<TestInitTransmitIfEntry*>(entry) )
 		delete ((TestInitTransmitIfEntry*) entry)->testInitMsg;
+	else if ( dynamic_cast<FastHandoverTransmitIfEntry*>(entry) )
+		delete ((FastHandoverTransmitIfEntry*) entry)->fhoMsg;
 
-	cancelAndDelete(entry->timer); // cancels the retransmission timer
+	timerWheel.cancel(entry); // cancels the retransmission timer
+	delete entry->timer;
 	entry->timer = NULL;
 
 	transmitIfList.erase(key); // remove entry from list
@@ -2416,9 +2588,26 @@ xMIPv6::TimerIfEntry* xMIPv6::getTimerIfEntry(Key& key, int timerType)
 
 			ifEntry = tokenExpIfEntry;
 		}
+		else if ( dynamic_cast<FastHandoverTransmitIfEntry*>(pos->second) )
+		{
+			FastHandoverTransmitIfEntry* fhoIfEntry = (FastHandoverTransmitIfEntry*) pos->second;
+			cancelAndDelete(fhoIfEntry->timer); // delete the corresponding timer
+			delete fhoIfEntry->fhoMsg; // the new message replaces it
+			fhoIfEntry->fhoMsg = NULL;
+
+			ifEntry = fhoIfEntry;
+		}
+		else if ( dynamic_cast<FastHandoverTunnelExpiryIfEntry*>(pos->second) )
+		{
+			FastHandoverTunnelExpiryIfEntry* tunnelExpIfEntry = (FastHandoverTunnelExpiryIfEntry*) pos->second;
+			cancelAndDelete(tunnelExpIfEntry->timer); // delete the corresponding timer
+
+			ifEntry = tunnelExpIfEntry;
+		}
 		else
 			opp_error("Expected a subclass of TimerIfEntry!");
 
+		timerWheel.cancel(ifEntry);
 		ifEntry->timer = NULL;
 	}
 	else
@@ -2441,6 +2630,13 @@ xMIPv6::TimerIfEntry* xMIPv6::getTimerIfEntry(Key& key, int timerType)
 			case EXPIRY_TYPE_TOKEN:
 				ifEntry = new TokenExpiryIfEntry();
 				break;
+			case TRANSMIT_TYPE_FHO:
+				ifEntry = new FastHandoverTransmitIfEntry();
+				((FastHandoverTransmitIfEntry*) ifEntry)->fhoMsg = NULL;
+				break;
+			case EXPIRY_TYPE_FHO_TUNNEL:
+				ifEntry = new FastHandoverTunnelExpiryIfEntry();
+				break;
 			default:
 				opp_error("Expected a valid TimerIfEntry type!");
 				break;
@@ -2518,7 +2714,8 @@ void xMIPv6::cancelEntries(int interfaceId, IPv6Address& CoA)
 	// ...and then for the CNs
 	for (TransmitIfList::iterator it=transmitIfList.begin(); it!=transmitIfList.end(); )
 	{
-		if ( (*it).first.interfaceID == interfaceId )
+		// the RtSolPr and FBU of a fast handover belong to the new link already
+		if ( (*it).first.interfaceID == interfaceId && (*it).first.type != KEY_RTSOLPR && (*it).first.type != KEY_FBU )
 		{
 			TransmitIfList::iterator oldIt = it++;
 
@@ -2572,7 +2769,8 @@ void xMIPv6::createBRRTimer(const IPv6Address& brDest, InterfaceEntry* ie, const
 		if (dynamic_cast<BRTransmitIfEntry*>(pos->second) )
 		{
 			brIfEntry = (BRTransmitIfEntry*) pos->second;
-			cancelAndDelete(brIfEntry->timer); // delete the corresponding timer
+			timerWheel.cancel(brIfEntry);
+			delete brIfEntry->timer; // delete the corresponding timer
 		}
 		else
 			opp_error("Expected BRTransmitIfEntry* !");
@@ -2594,7 +2792,7 @@ void xMIPv6::createBRRTimer(const IPv6Address& brDest, InterfaceEntry* ie, const
 	brTriggerMsg->setContextPointer(brIfEntry); // attaching the brIfEntry info corresponding to a particular address ith message
 
 	// Scheduling a message which will trigger a BRR towards brIfEntry->dest
-	scheduleAt(simTime()+scheduledTime, brTriggerMsg);
+	scheduleTimer(brIfEntry, simTime()+scheduledTime);
 	EV<<"\n++++++++++BRR TIMER CREATED FOR SIM TIME: "<<simTime()+scheduledTime<<" seconds+++++++++++++++++ \n";
 }
 
@@ -2618,7 +2816,7 @@ void xMIPv6::sendPeriodicBRR(cMessage *msg)
 		createAndSendBRRMessage(brDest, ie);
 
 		// retransmit the Binding Refresh Message
-		scheduleAt(simTime() + BRR_TIMEOUT_THRESHOLD, msg);
+		scheduleTimer(brIfEntry, simTime() + BRR_TIMEOUT_THRESHOLD);
 	}
 	else
 	{
@@ -2699,7 +2897,7 @@ void xMIPv6::createBULEntryExpiryTimer(BindingUpdateList::BindingUpdateListEntry
 
 	/*BULExpiryIfEntry* bulExpIfEntry = createBULEntryExpiryTimer(key, HA, HoA, CoA, ie);*/
 
-	scheduleAt(scheduledTime, bulExpiryMsg);
+	scheduleTimer(bulExpIfEntry, scheduledTime);
 	EV << "Scheduled BUL expiry (" << entry->bindingExpiry << "s) for time " << scheduledTime << "s" << endl;
 	// WAS SCHEDULED FOR EXPIRY, NOT 2 SECONDS BEFORE!?!?!?
 }
@@ -2805,7 +3003,7 @@ void xMIPv6::createBCEntryExpiryTimer(IPv6Address& HoA, InterfaceEntry* ie, simt
 
 	bcExpiryMsg->setContextPointer(bcExpIfEntry); // information in the bulExpIfEntry is required for handler when message fires
 
-	scheduleAt(scheduledTime, bcExpiryMsg);
+	scheduleTimer(bcExpIfEntry, scheduledTime);
 	EV << "Scheduled BC expiry for time " << scheduledTime << "s" << endl;
 }
 
@@ -2856,7 +3054,7 @@ void xMIPv6::createTokenEntryExpiryTimer(IPv6Address& cnAddr, InterfaceEntry* ie
 
 	tokenExpiryMsg->setContextPointer(tokenExpIfEntry);
 
-	scheduleAt(scheduledTime, tokenExpiryMsg);
+	scheduleTimer(tokenExpIfEntry, scheduledTime);
 	EV << "Scheduled token expiry for time " << scheduledTime << "s" << endl;
 }
 
@@ -2895,3 +3093,645 @@ void xMIPv6::handleTokenExpiry(cMessage* msg)
 	//delete msg;
 }
 
+
+//
+// FMIPv6 (RFC 5568)
+//
+
+void xMIPv6::receiveChangeNotification(int category, const cPolymorphic *details)
+{
+	Enter_Method_Silent();
+	printNotificationBanner(category, details);
+
+	InterfaceEntry* ie = getFastHandoverInterface();
+	if ( ie == NULL )
+		return;
+
+	if ( category == NF_L2_BEACON_LOST || category == NF_MIH_LINK_DOWN )
+		handleLinkGoingDown(ie);
+	else if ( category == NF_L2_ASSOCIATED )
+	{
+		const Ieee80211Prim_BSSDescription* bssDesc = check_and_cast<const Ieee80211Prim_BSSDescription*>(details);
+		handleLinkUp(ie, bssDesc->getBSSID());
+	}
+}
+
+
+void xMIPv6::parseFastHandoverNeighbours(const char* neighbours)
+{
+	// entries are of the form accesspoint=router/interface, e.g. "10:AA:00:00:A1:01=R_1/eth1"
+	cStringTokenizer tokenizer(neighbours);
+	const char* token;
+
+	while ( (token = tokenizer.nextToken()) != NULL )
+	{
+		std::string entry(token);
+		std::string::size_type eqPos = entry.find('=');
+		std::string::size_type slashPos = entry.rfind('/');
+
+		if ( eqPos == std::string::npos || slashPos == std::string::npos || slashPos < eqPos )
+			error("Invalid entry '%s' in fastHandoverNeighbours, expected accesspoint=router/interface", token);
+
+		NeighbourRouterConfig config;
+		config.accessPoint.setAddress( entry.substr(0, eqPos).c_str() );
+		config.routerPath = entry.substr(eqPos+1, slashPos-eqPos-1);
+		config.interfaceName = entry.substr(slashPos+1);
+		neighbourRouterConfigs.push_back(config);
+	}
+}
+
+
+bool xMIPv6::resolveNeighbourRouter(const NeighbourRouterConfig& config, NeighbourRouterInfo& info, IPv6Address& globalAddr)
+{
+	// the routers are only looked up at this point, as their addresses
+	// are not yet configured when this module is initialized
+	cModule* router = simulation.getModuleByPath( config.routerPath.c_str() );
+	if ( router == NULL )
+		error("fastHandoverNeighbours: module '%s' not found", config.routerPath.c_str());
+
+	InterfaceEntry* nie = IPAddressResolver().interfaceTableOf(router)->getInterfaceByName( config.interfaceName.c_str() );
+	if ( nie == NULL || nie->ipv6Data() == NULL )
+		error("fastHandoverNeighbours: no IPv6 interface '%s' in '%s'", config.interfaceName.c_str(), config.routerPath.c_str());
+
+	if ( nie->ipv6Data()->getNumAdvPrefixes() == 0 )
+		return false;
+
+	// the same information as in the RA of that router
+	const IPv6InterfaceData::AdvPrefix& advPrefix = nie->ipv6Data()->getAdvPrefix(0);
+	info.accessPoint = config.accessPoint;
+	info.routerAddress = nie->ipv6Data()->getLinkLocalAddress();
+	info.routerLinkLayerAddress = nie->getMacAddress();
+	info.prefix = advPrefix.prefix;
+	info.prefixLength = advPrefix.prefixLength;
+	info.validLifetime = SIMTIME_DBL(advPrefix.advValidLifetime);
+	info.preferredLifetime = SIMTIME_DBL(advPrefix.advPreferredLifetime);
+	info.routerLifetime = SIMTIME_DBL(nie->ipv6Data()->getAdvDefaultLifetime());
+
+	globalAddr = nie->ipv6Data()->getPreferredAddress();
+	return !globalAddr.isUnspecified();
+}
+
+
+InterfaceEntry* xMIPv6::getFastHandoverInterface()
+{
+	for (int i=0; i < ift->getNumInterfaces(); i++)
+	{
+		InterfaceEntry* ie = ift->getInterface(i);
+		if ( !ie->isLoopback() && ie->ipv6Data() != NULL )
+			return ie;
+	}
+
+	return NULL;
+}
+
+
+void xMIPv6::createFastHandoverTimer(MobilityHeader* msg, int keyType, const IPv6Address& dest, const IPv6Address& src,
+		InterfaceEntry* ie, uint retries, simtime_t sendTime)
+{
+	cMessage* fhoMsg = new cMessage("sendFastHandoverMessage", MK_SEND_FHO_MSG);
+
+	IPv6Address keyAddr = dest;
+	if ( keyType == KEY_HANDOVER_INIT )
+		keyAddr = check_and_cast<HandoverInitiate*>(msg)->getNewCareOfAddress();
+
+	Key key(keyAddr, ie->getInterfaceId(), keyType);
+	FastHandoverTransmitIfEntry* fhoIfEntry = (FastHandoverTransmitIfEntry*) getTimerIfEntry(key, TRANSMIT_TYPE_FHO);
+
+	fhoIfEntry->dest = dest;
+	fhoIfEntry->src = src;
+	fhoIfEntry->keyAddr = keyAddr;
+	fhoIfEntry->ifEntry = ie;
+	fhoIfEntry->fhoMsg = msg;
+	fhoIfEntry->retries = retries;
+	fhoIfEntry->deferrals = 0;
+	fhoIfEntry->keyType = keyType;
+	fhoIfEntry->timer = fhoMsg;
+
+	fhoMsg->setContextPointer(fhoIfEntry);
+	scheduleTimer(fhoIfEntry, simTime() + sendTime);
+}
+
+
+void xMIPv6::sendFastHandoverMessage(cMessage* msg)
+{
+	FastHandoverTransmitIfEntry* fhoIfEntry = (FastHandoverTransmitIfEntry*) msg->getContextPointer();
+	InterfaceEntry* ie = fhoIfEntry->ifEntry;
+	IPv6Address dest = fhoIfEntry->dest;
+
+	if ( dest.isUnspecified() )
+	{
+		// RtSolPr: goes to the current default router, i.e. the access router
+		for (int i=0; i < rt6->getNumRoutes(); i++)
+		{
+			const IPv6Route* route = rt6->getRoute(i);
+			if ( route->getPrefixLength() == 0 && route->getInterfaceId() == ie->getInterfaceId() )
+			{
+				dest = route->getNextHop();
+				break;
+			}
+		}
+	}
+
+	if ( dest.isUnspecified() || ie->ipv6Data()->isTentativeAddress(fhoIfEntry->src) )
+	{
+		if ( ++fhoIfEntry->deferrals > FHO_MAX_DEFERRALS )
+		{
+			EV << "Still no access router or source address still tentative, giving up on " << fhoIfEntry->fhoMsg->getName() << endl;
+			cancelTimerIfEntry(fhoIfEntry->keyAddr, ie->getInterfaceId(), fhoIfEntry->keyType);
+			return;
+		}
+
+		EV << "No access router yet or source address still tentative, deferring " << fhoIfEntry->fhoMsg->getName() << endl;
+		scheduleTimer(fhoIfEntry, simTime() + FHO_POLL_INTERVAL);
+		return;
+	}
+
+	// link-local destinations need the interface, everything else is routed
+	int interfaceId = dest.isLinkLocal() ? ie->getInterfaceId() : -1;
+	sendMobilityMessageToIPv6Module(fhoIfEntry->fhoMsg->dup(), dest, fhoIfEntry->src, interfaceId);
+
+	if ( --fhoIfEntry->retries > 0 )
+		scheduleTimer(fhoIfEntry, simTime() + FHO_RETRANS_TIMEOUT);
+	else
+		// we've tried often enough - remove the timer
+		cancelTimerIfEntry(fhoIfEntry->keyAddr, ie->getInterfaceId(), fhoIfEntry->keyType);
+}
+
+
+void xMIPv6::handleLinkGoingDown(InterfaceEntry* ie)
+{
+	/*RFC 5568, 3.1
+	  When the MN has information about the next point of attachment to
+	  which the MN will move (e.g., via the AP-ID obtained from PrRtAdv),
+	  it sends an FBU to the PAR from the previous link.*/
+	if ( fastHandoverMode != FHO_PREDICTIVE || parAddress.isUnspecified() || !predictedCoA.isUnspecified() )
+		return;
+
+	// without a scan result we simply take the first neighbouring
+	// access point that does not lead back to the home link
+	const IPv6Address& HoA = ie->ipv6Data()->getMNHomeAddress();
+	for (NeighbourRouterList::iterator it = neighbourRouters.begin(); it != neighbourRouters.end(); ++it)
+	{
+		const NeighbourRouterInfo& info = it->second;
+		if ( it->first == currentAccessPoint || (!HoA.isUnspecified() && HoA.matches(info.prefix, info.prefixLength)) )
+			continue;
+
+		IPv6Address PCoA = getCurrentCareOfAddress(ie);
+		predictedCoA = formNewCareOfAddress(ie, info);
+		fbackReceived = false;
+
+		EV << "Link going down: sending predictive FBU to " << parAddress << " for NCoA " << predictedCoA << endl;
+		FastBindingUpdate* fbu = createFBUMessage(PCoA, predictedCoA);
+		// the link is about to go down: retransmissions would be lost anyway
+		createFastHandoverTimer(fbu, KEY_FBU, parAddress, PCoA, ie, 1);
+		return;
+	}
+}
+
+
+void xMIPv6::handleLinkUp(InterfaceEntry* ie, const MACAddress& accessPoint)
+{
+	if ( accessPoint == currentAccessPoint )
+		return;
+
+	currentAccessPoint = accessPoint;
+
+	const IPv6Address& HoA = ie->ipv6Data()->getMNHomeAddress();
+	NeighbourRouterList::iterator it = neighbourRouters.find(accessPoint);
+
+	// home registrations are left to the normal MIPv6 procedure
+	if ( it != neighbourRouters.end() && !HoA.isUnspecified() && !HoA.matches(it->second.prefix, it->second.prefixLength) )
+	{
+		const NeighbourRouterInfo& info = it->second;
+		IPv6Address PCoA = getCurrentCareOfAddress(ie);
+		IPv6Address NCoA = formNewCareOfAddress(ie, info);
+
+		EV << "Fast handover to " << info.routerAddress << ", PCoA=" << PCoA << ", NCoA=" << NCoA << endl;
+
+		// an earlier fast handover that has not been completed by the HA yet
+		if ( !previousAR.isUnspecified() )
+		{
+			tunneling->destroyTunnel(PCoA, previousAR, previousCoA);
+			if ( previousCoA != HoA && ie->ipv6Data()->hasAddress(previousCoA) )
+				ie->ipv6Data()->removeAddress(previousCoA);
+		}
+
+		/*RFC 5568, 5.2
+		  The MN uses the NCoA as soon as it attaches to the NAR, without
+		  waiting for a RA.*/
+		ipv6nd->attachToNewAccessRouter(ie, info.routerAddress, info.routerLinkLayerAddress, info.routerLifetime,
+				info.prefix, info.prefixLength, NCoA, info.validLifetime, info.preferredLifetime);
+
+		// the PCoA is not valid on this link: deprecate it so that the NCoA is chosen as CoA
+		if ( PCoA != HoA )
+			ie->ipv6Data()->updateMatchingAddressExpiryTimes(PCoA, 128, simTime(), simTime());
+
+		// accept packets tunneled by the PAR
+		tunneling->createTunnel(IPv6Tunneling::NORMAL, NCoA, parAddress, PCoA);
+		previousCoA = PCoA;
+		previousAR = parAddress;
+
+		/*RFC 5568, 3.2
+		  If the MN did not receive the FBack on the previous link, it sends
+		  the FBU from the new link (reactive mode).*/
+		if ( !fbackReceived || predictedCoA != NCoA )
+		{
+			EV << "Sending reactive FBU to " << parAddress << " from the new link" << endl;
+			FastBindingUpdate* fbu = createFBUMessage(PCoA, NCoA);
+			createFastHandoverTimer(fbu, KEY_FBU, parAddress, NCoA, ie, FHO_RETRIES);
+		}
+
+		// and register the NCoA with the HA (and the CNs)
+		initiateMIPv6Protocol(ie, NCoA);
+	}
+
+	// the neighbour information refers to the previous access router
+	neighbourRouters.clear();
+	parAddress = IPv6Address::UNSPECIFIED_ADDRESS;
+	predictedCoA = IPv6Address::UNSPECIFIED_ADDRESS;
+	fbackReceived = false;
+
+	/*RFC 5568, 3.1
+	  The MN sends a RtSolPr to its access router to resolve one or more
+	  Access Point Identifiers to subnet-specific information.*/
+	RouterSolicitationForProxyAdv* rtSolPr = new RouterSolicitationForProxyAdv("RtSolPr");
+	rtSolPr->setMobilityHeaderType(ROUTER_SOLICITATION_FOR_PROXY_ADV);
+	rtSolPr->setSequence(fhoSequence++);
+	rtSolPr->setByteLength(SIZE_MOBILITY_HEADER + SIZE_RTSOLPR);
+	createFastHandoverTimer(rtSolPr, KEY_RTSOLPR, IPv6Address::UNSPECIFIED_ADDRESS,
+			ie->ipv6Data()->getLinkLocalAddress(), ie, FHO_RETRIES);
+}
+
+
+IPv6Address xMIPv6::formNewCareOfAddress(InterfaceEntry* ie, const NeighbourRouterInfo& info)
+{
+	// stateless autoconfiguration, as in IPv6NeighbourDiscovery::processRAPrefixInfoForAddrAutoConf()
+	IPv6Address NCoA = ie->ipv6Data()->getLinkLocalAddress();
+	NCoA.setPrefix(info.prefix, info.prefixLength);
+	return NCoA;
+}
+
+
+IPv6Address xMIPv6::getCurrentCareOfAddress(InterfaceEntry* ie)
+{
+	IPv6Address CoA = ie->ipv6Data()->getGlobalAddress(IPv6InterfaceData::CoA);
+
+	if ( CoA.isUnspecified() )
+		CoA = ie->ipv6Data()->getMNHomeAddress(); // at home
+
+	return CoA;
+}
+
+
+FastBindingUpdate* xMIPv6::createFBUMessage(const IPv6Address& PCoA, const IPv6Address& NCoA)
+{
+	FastBindingUpdate* fbu = new FastBindingUpdate("Fast Binding Update");
+
+	/*RFC 5568, 6.3.1
+	  The FBU uses the same format as the BU; the NCoA is carried in an
+	  Alternate Care-of Address option.*/
+	fbu->setMobilityHeaderType(FAST_BINDING_UPDATE);
+	fbu->setSequence(fhoSequence++);
+	fbu->setLifetime(FHO_LIFETIME / 4); /* 6.1.7 One time unit is 4 seconds. */
+	fbu->setAckFlag(true);
+	fbu->setPreviousCareOfAddress(PCoA);
+	fbu->setNewCareOfAddress(NCoA);
+	fbu->setByteLength(SIZE_MOBILITY_HEADER + SIZE_FBU + SIZE_ALT_COA_OPTION);
+
+	return fbu;
+}
+
+
+void xMIPv6::processRtSolPrMessage(RouterSolicitationForProxyAdv* rtSolPr, IPv6ControlInfo* ctrlInfo)
+{
+	if ( rt6->isMobileNode() || !rt6->isRouter() )
+	{
+		EV << "Not an access router, dropping RtSolPr" << endl;
+		delete rtSolPr;
+		delete ctrlInfo;
+		return;
+	}
+
+	InterfaceEntry* ie = ift->getInterfaceById( ctrlInfo->getInterfaceId() );
+
+	/*RFC 5568, 6.1.2
+	  The access router sends a PrRtAdv with the [AP-ID, AR-Info] tuples
+	  of the neighbouring access points, as the response to a RtSolPr.*/
+	std::vector<NeighbourRouterInfo> neighbours;
+	for (NeighbourRouterConfigList::iterator it = neighbourRouterConfigs.begin(); it != neighbourRouterConfigs.end(); ++it)
+	{
+		if ( !rtSolPr->getNewAccessPoint().isUnspecified() && rtSolPr->getNewAccessPoint() != it->accessPoint )
+			continue;
+
+		NeighbourRouterInfo info;
+		IPv6Address narAddr;
+		if ( resolveNeighbourRouter(*it, info, narAddr) )
+			neighbours.push_back(info);
+	}
+
+	ProxyRouterAdvertisement* prRtAdv = new ProxyRouterAdvertisement("PrRtAdv");
+	prRtAdv->setMobilityHeaderType(PROXY_ROUTER_ADVERTISEMENT);
+	prRtAdv->setSequence(rtSolPr->getSequence());
+	prRtAdv->setNeighbourRoutersArraySize(neighbours.size());
+	for (unsigned int i=0; i < neighbours.size(); i++)
+		prRtAdv->setNeighbourRouters(i, neighbours[i]);
+	prRtAdv->setByteLength(SIZE_MOBILITY_HEADER + SIZE_PRRTADV + neighbours.size() * SIZE_PRRTADV_NEIGHBOUR);
+
+	// sent from our global address, which the MN then uses as the PAR address
+	EV << "Sending PrRtAdv with " << neighbours.size() << " neighbouring access routers" << endl;
+	sendMobilityMessageToIPv6Module(prRtAdv, ctrlInfo->getSrcAddr(), ie->ipv6Data()->getPreferredAddress(), ie->getInterfaceId());
+
+	delete rtSolPr;
+	delete ctrlInfo;
+}
+
+
+void xMIPv6::processPrRtAdvMessage(ProxyRouterAdvertisement* prRtAdv, IPv6ControlInfo* ctrlInfo)
+{
+	if ( !rt6->isMobileNode() || fastHandoverMode == FHO_NONE )
+	{
+		EV << "Fast handovers not enabled, dropping PrRtAdv" << endl;
+		delete prRtAdv;
+		delete ctrlInfo;
+		return;
+	}
+
+	cancelTimerIfEntry(IPv6Address::UNSPECIFIED_ADDRESS, ctrlInfo->getInterfaceId(), KEY_RTSOLPR);
+
+	parAddress = ctrlInfo->getSrcAddr();
+	neighbourRouters.clear();
+	for (unsigned int i=0; i < prRtAdv->getNeighbourRoutersArraySize(); i++)
+	{
+		const NeighbourRouterInfo& info = prRtAdv->getNeighbourRouters(i);
+		neighbourRouters[info.accessPoint] = info;
+	}
+
+	EV << "Learned " << neighbourRouters.size() << " neighbouring access routers from " << parAddress << endl;
+
+	delete prRtAdv;
+	delete ctrlInfo;
+}
+
+
+void xMIPv6::processFBUMessage(FastBindingUpdate* fbu, IPv6ControlInfo* ctrlInfo)
+{
+	if ( rt6->isMobileNode() || !rt6->isRouter() )
+	{
+		EV << "Not an access router, dropping FBU" << endl;
+		delete fbu;
+		delete ctrlInfo;
+		return;
+	}
+
+	const IPv6Address& NCoA = fbu->getNewCareOfAddress();
+	bool known = fastHandovers.find(NCoA) != fastHandovers.end();
+
+	FastHandoverInfo& fho = fastHandovers[NCoA];
+	fho.parAddr = ctrlInfo->getDestAddr();
+	fho.PCoA = fbu->getPreviousCareOfAddress();
+	fho.NCoA = NCoA;
+	fho.fbuSource = ctrlInfo->getSrcAddr();
+	fho.sequence = fbu->getSequence();
+	fho.lifetime = fbu->getLifetime() * 4; /* 6.1.7 One time unit is 4 seconds. */
+	fho.interfaceId = ctrlInfo->getInterfaceId();
+	if ( !known )
+		fho.tunnelCreated = false;
+
+	// the NAR is the neighbouring access router that owns the prefix of the NCoA
+	bool found = false;
+	IPv6Address narAddr;
+	for (NeighbourRouterConfigList::iterator it = neighbourRouterConfigs.begin(); it != neighbourRouterConfigs.end() && !found; ++it)
+	{
+		NeighbourRouterInfo info;
+		found = resolveNeighbourRouter(*it, info, narAddr) && NCoA.matches(info.prefix, info.prefixLength);
+	}
+
+	if ( !found )
+	{
+		EV << "NCoA " << NCoA << " does not belong to a neighbouring access router, rejecting FBU" << endl;
+		completeFastHandover(fho, REASON_UNSPECIFIED);
+		fastHandovers.erase(NCoA);
+	}
+	else if ( fho.fbuSource == NCoA || fho.tunnelCreated )
+	{
+		/*RFC 5568, 3.2
+		  In reactive mode the MN is already on the new link: the PAR
+		  starts forwarding right away. (Same for a retransmitted FBU.)*/
+		completeFastHandover(fho, BINDING_UPDATE_ACCEPTED);
+	}
+	else
+	{
+		/*RFC 5568, 3.1
+		  The PAR and NAR exchange HI and HAck messages, so that the NAR
+		  can buffer packets for the NCoA until the MN arrives.*/
+		fho.narAddr = narAddr;
+		if ( !known )
+			fho.hiSequence = fhoSequence++ % 65536;
+
+		HandoverInitiate* hi = new HandoverInitiate("Handover Initiate");
+		hi->setMobilityHeaderType(HANDOVER_INITIATE);
+		hi->setSequence(fho.hiSequence);
+		hi->setPreviousCareOfAddress(fho.PCoA);
+		hi->setNewCareOfAddress(NCoA);
+		hi->setBufferFlag(true);
+		hi->setByteLength(SIZE_MOBILITY_HEADER + SIZE_HI);
+
+		EV << "Sending HI to NAR " << narAddr << endl;
+		createFastHandoverTimer(hi, KEY_HANDOVER_INIT, narAddr, IPv6Address::UNSPECIFIED_ADDRESS,
+				ift->getInterfaceById(fho.interfaceId), FHO_RETRIES);
+	}
+
+	delete fbu;
+	delete ctrlInfo;
+}
+
+
+void xMIPv6::processFBackMessage(FastBindingAcknowledgement* fback, IPv6ControlInfo* ctrlInfo)
+{
+	if ( !rt6->isMobileNode() || fastHandoverMode == FHO_NONE )
+	{
+		delete fback;
+		delete ctrlInfo;
+		return;
+	}
+
+	cancelTimerIfEntry(ctrlInfo->getSrcAddr(), ctrlInfo->getInterfaceId(), KEY_FBU);
+
+	if ( fback->getStatus() < 128 )
+	{
+		EV << "FBU accepted by " << ctrlInfo->getSrcAddr() << endl;
+
+		// still on the previous link: no need to repeat the FBU from the new link
+		if ( !predictedCoA.isUnspecified() )
+			fbackReceived = true;
+	}
+	else
+		EV << "FBU rejected by " << ctrlInfo->getSrcAddr() << ", falling back to normal MIPv6 handover" << endl;
+
+	delete fback;
+	delete ctrlInfo;
+}
+
+
+void xMIPv6::processHIMessage(HandoverInitiate* hi, IPv6ControlInfo* ctrlInfo)
+{
+	const IPv6Address& NCoA = hi->getNewCareOfAddress();
+	int status = HACK_NOT_ACCEPTED;
+
+	// the NCoA has to be formed from a prefix that we advertise
+	for (int i=0; i < ift->getNumInterfaces() && status != HACK_ACCEPTED; i++)
+	{
+		InterfaceEntry* ie = ift->getInterface(i);
+		if ( ie->ipv6Data() == NULL )
+			continue;
+
+		for (int j=0; j < ie->ipv6Data()->getNumAdvPrefixes(); j++)
+		{
+			const IPv6InterfaceData::AdvPrefix& advPrefix = ie->ipv6Data()->getAdvPrefix(j);
+			if ( NCoA.matches(advPrefix.prefix, advPrefix.prefixLength) )
+			{
+				/*RFC 5568, 6.2.1
+				  U flag: buffer packets for this MN.*/
+				if ( hi->getBufferFlag() )
+					ipv6nd->bufferPacketsForNeighbour(NCoA, ie, FHO_BUFFER_TIME);
+
+				status = HACK_ACCEPTED;
+				break;
+			}
+		}
+	}
+
+	HandoverAcknowledge* hack = new HandoverAcknowledge("Handover Acknowledge");
+	hack->setMobilityHeaderType(HANDOVER_ACKNOWLEDGE);
+	hack->setStatus(status);
+	hack->setSequence(hi->getSequence());
+	hack->setByteLength(SIZE_MOBILITY_HEADER + SIZE_HACK);
+
+	EV << "Sending HAck with status " << status << " to " << ctrlInfo->getSrcAddr() << endl;
+	sendMobilityMessageToIPv6Module(hack, ctrlInfo->getSrcAddr(), ctrlInfo->getDestAddr());
+
+	delete hi;
+	delete ctrlInfo;
+}
+
+
+void xMIPv6::processHAckMessage(HandoverAcknowledge* hack, IPv6ControlInfo* ctrlInfo)
+{
+	const IPv6Address& narAddr = ctrlInfo->getSrcAddr();
+
+	FastHandoverList::iterator it;
+	for (it = fastHandovers.begin(); it != fastHandovers.end(); ++it)
+	{
+		if ( it->second.narAddr == narAddr && it->second.hiSequence == hack->getSequence() && !it->second.tunnelCreated )
+			break;
+	}
+
+	if ( it == fastHandovers.end() )
+	{
+		EV << "No pending HI for this HAck, dropping it" << endl;
+		delete hack;
+		delete ctrlInfo;
+		return;
+	}
+
+	FastHandoverInfo& fho = it->second;
+	cancelTimerIfEntry(fho.NCoA, fho.interfaceId, KEY_HANDOVER_INIT);
+
+	if ( hack->getStatus() < 128 )
+		completeFastHandover(fho, BINDING_UPDATE_ACCEPTED);
+	else
+	{
+		completeFastHandover(fho, REASON_UNSPECIFIED);
+		fastHandovers.erase(it);
+	}
+
+	delete hack;
+	delete ctrlInfo;
+}
+
+
+void xMIPv6::completeFastHandover(FastHandoverInfo& fho, int status)
+{
+	if ( status < 128 )
+	{
+		/*RFC 5568, 3.1
+		  The PAR tunnels packets destined to the PCoA to the NCoA.*/
+		if ( !fho.tunnelCreated )
+		{
+			tunneling->createTunnel(IPv6Tunneling::NORMAL, fho.parAddr, fho.NCoA, fho.PCoA);
+			fho.tunnelCreated = true;
+			numFastHandoversAccepted++;
+		}
+
+		// (re)start the expiry timer of the tunnel
+		cMessage* tunnelExpiryMsg = new cMessage("fastHandoverTunnelExpiry", MK_FHO_TUNNEL_EXPIRY);
+
+		Key key(fho.NCoA, fho.interfaceId, KEY_FHO_TUNNEL_EXP);
+		FastHandoverTunnelExpiryIfEntry* tunnelExpIfEntry = (FastHandoverTunnelExpiryIfEntry*) getTimerIfEntry(key, EXPIRY_TYPE_FHO_TUNNEL);
+
+		tunnelExpIfEntry->dest = fho.parAddr;
+		tunnelExpIfEntry->PCoA = fho.PCoA;
+		tunnelExpIfEntry->NCoA = fho.NCoA;
+		tunnelExpIfEntry->ifEntry = ift->getInterfaceById(fho.interfaceId);
+		tunnelExpIfEntry->timer = tunnelExpiryMsg;
+
+		tunnelExpiryMsg->setContextPointer(tunnelExpIfEntry);
+		scheduleTimer(tunnelExpIfEntry, simTime() + fho.lifetime);
+	}
+
+	FastBindingAcknowledgement* fback = new FastBindingAcknowledgement("Fast Binding Acknowledgement");
+	fback->setMobilityHeaderType(FAST_BINDING_ACKNOWLEDGEMENT);
+	fback->setStatus(status);
+	fback->setSequence(fho.sequence);
+	fback->setLifetime(status < 128 ? fho.lifetime / 4 : 0);
+	fback->setByteLength(SIZE_MOBILITY_HEADER + SIZE_FBACK);
+
+	/*RFC 5568, 6.3.2
+	  In predictive mode, the FBack is sent to the NCoA as well as on the
+	  previous link; in reactive mode, only to the NCoA.*/
+	if ( status >= 128 )
+		sendMobilityMessageToIPv6Module(fback, fho.fbuSource, fho.parAddr);
+	else
+	{
+		if ( fho.fbuSource != fho.NCoA )
+			sendMobilityMessageToIPv6Module(fback->dup(), fho.fbuSource, fho.parAddr);
+		sendMobilityMessageToIPv6Module(fback, fho.NCoA, fho.parAddr);
+	}
+}
+
+
+void xMIPv6::handleFastHandoverTunnelExpiry(cMessage* msg)
+{
+	FastHandoverTunnelExpiryIfEntry* tunnelExpIfEntry = (FastHandoverTunnelExpiryIfEntry*) msg->getContextPointer();
+	IPv6Address parAddr = tunnelExpIfEntry->dest;
+	IPv6Address PCoA = tunnelExpIfEntry->PCoA;
+	IPv6Address NCoA = tunnelExpIfEntry->NCoA;
+
+	// if we are the HA of the MN and it has registered the NCoA, the
+	// tunnel has been replaced by the one for the binding cache entry
+	if ( rt6->isHomeAgent() && bc->isInBindingCache(PCoA, NCoA) )
+		EV << "Tunnel to " << NCoA << " now belongs to the home registration" << endl;
+	else
+		tunneling->destroyTunnel(parAddr, NCoA, PCoA);
+
+	fastHandovers.erase(NCoA);
+	cancelTimerIfEntry(NCoA, tunnelExpIfEntry->ifEntry->getInterfaceId(), KEY_FHO_TUNNEL_EXP);
+	// deletion of the message already takes place in the cancelTimerIfEntry(.., KEY_FHO_TUNNEL_EXP);
+}
+
+
+void xMIPv6::finishFastHandover(InterfaceEntry* ie, const IPv6Address& CoA)
+{
+	if ( previousAR.isUnspecified() || CoA == previousCoA )
+		return;
+
+	EV << "Home registration of " << CoA << " complete, releasing PCoA " << previousCoA << endl;
+
+	tunneling->destroyTunnel(CoA, previousAR, previousCoA);
+
+	if ( previousCoA != ie->ipv6Data()->getMNHomeAddress() && ie->ipv6Data()->hasAddress(previousCoA) )
+		ie->ipv6Data()->removeAddress(previousCoA);
+
+	previousCoA = IPv6Address::UNSPECIFIED_ADDRESS;
+	previousAR = IPv6Address::UNSPECIFIED_ADDRESS;
+}
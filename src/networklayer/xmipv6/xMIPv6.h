@@ -27,6 +27,7 @@
 #include <string.h>
 #include <vector>
 #include <set>
+#include <map>
 #include <omnetpp.h>
 #include "IPv6Address.h"
 #include "IPv6Datagram.h"
@@ -54,6 +55,7 @@
 #include "IPv6TunnelingAccess.h"
 // 14.01.08 - CB
 #include "NotificationBoard.h"
+#include "TimerWheel.h"
 
 // 13.9.07
 // Keys for timer list (=message type)
@@ -65,6 +67,11 @@
 #define KEY_BC_EXP		5 // BC entry expiry // 17.06.08 - CB
 #define KEY_HTOKEN_EXP	6 // home token expiry // 10.07.08 - CB
 #define KEY_CTOKEN_EXP	7 // care-of token expiry // 10.07.08 - CB
+// FMIPv6 (RFC 5568)
+#define KEY_RTSOLPR		8 // Router Solicitation for Proxy Advertisement
+#define KEY_FBU			9 // Fast Binding Update
+#define KEY_HANDOVER_INIT	10 // Handover Initiate (not KEY_HI, that is the HoTI)
+#define KEY_FHO_TUNNEL_EXP	11 // expiry of the PAR's tunnel to the NCoA
 
 
 // 21.9.07
@@ -75,13 +82,22 @@
 #define EXPIRY_TYPE_BC		62 // BCExpiryIfEntry
 // 10.07.08 - CB
 #define EXPIRY_TYPE_TOKEN	63 // {Home, CareOf}TokenExpiryIfEntry
+// FMIPv6 (RFC 5568)
+#define TRANSMIT_TYPE_FHO	53 // FastHandoverTransmitIfEntry
+#define EXPIRY_TYPE_FHO_TUNNEL	64 // FastHandoverTunnelExpiryIfEntry
 
 /**
  * Implements RFC 3775 Mobility Support in IPv6.
+ *
+ * Fast handovers (RFC 5568) are supported as well, see the fastHandover
+ * and fastHandoverNeighbours parameters in the NED file. The mobile node
+ * side is driven by the NF_L2_BEACON_LOST, NF_MIH_LINK_DOWN and
+ * NF_L2_ASSOCIATED notifications of the link layer.
  */
-class INET_API xMIPv6 : public cSimpleModule
+class INET_API xMIPv6 : public cSimpleModule, public INotifiable
 {
   public:
+	  xMIPv6() {timerWheelTick = NULL;}
 	  virtual ~xMIPv6();
 
   protected:
@@ -110,11 +126,12 @@ class INET_API xMIPv6 : public cSimpleModule
 
 	/**
 	 * The base class for all other timers that are used for retransmissions.
+	 * Timers are not put into the FES individually, but kept in the timerWheel.
 	 */
-	class TimerIfEntry
+	class TimerIfEntry : public TimerWheel::Timer
 	{
 	public:
-		cMessage* timer; // pointer to the scheduled timer message
+		cMessage* timer; // the timer message; handed to the handler when the entry expires in the timerWheel
 		virtual ~TimerIfEntry() {}; // to make it a polymorphic base class
 
 		IPv6Address dest; // the address (HA or CN(s) for which the message is sent
@@ -141,6 +158,14 @@ class INET_API xMIPv6 : public cSimpleModule
 	typedef std::map<Key,TimerIfEntry*> TransmitIfList;
 	TransmitIfList transmitIfList;
 
+	/**
+	 * All BU, HoTI/CoTI, BRR and expiry timers of the TimerIfEntries are
+	 * multiplexed onto a single self-message (timerWheelTick), which is
+	 * always scheduled for the next wakeup time of the wheel.
+	 */
+	TimerWheel timerWheel;
+	cMessage* timerWheelTick;
+
 	/** holds the tuples of currently available {InterfaceID, CoA} pairs */
 	typedef std::map<int,IPv6Address> InterfaceCoAList;
 	InterfaceCoAList interfaceCoAList;
@@ -196,12 +221,106 @@ class INET_API xMIPv6 : public cSimpleModule
 		int tokenType; // KEY_XX indicates whether it is a care-of token, etc.
 	};
 
+	// FMIPv6 (RFC 5568)
+	class FastHandoverTransmitIfEntry : public TimerIfEntry
+	{
+	public:
+		MobilityHeader* fhoMsg; // the RtSolPr, FBU or HI to be (re)transmitted
+		IPv6Address src; // source address of the message
+		IPv6Address keyAddr; // address under which the entry is stored: dest, or the NCoA for a HI
+		uint retries; // number of transmissions left
+		uint deferrals; // number of times the transmission was deferred
+		int keyType; // KEY_XX under which the entry is stored
+	};
+
+	class FastHandoverTunnelExpiryIfEntry : public TimerIfEntry
+	{
+	public:
+		IPv6Address PCoA, NCoA; // trigger and exit of the tunnel; dest is its entry
+	};
+
+	/** Fast handover mode of a MN */
+	enum FastHandoverMode
+	{
+		FHO_NONE,
+		FHO_PREDICTIVE,
+		FHO_REACTIVE
+	};
+	FastHandoverMode fastHandoverMode;
+
+	/** MN: access routers behind the neighbouring access points, from the last PrRtAdv */
+	typedef std::map<MACAddress,NeighbourRouterInfo> NeighbourRouterList;
+	NeighbourRouterList neighbourRouters;
+	IPv6Address parAddress; // sender of the last PrRtAdv, i.e. the current access router
+	MACAddress currentAccessPoint;
+	IPv6Address predictedCoA; // NCoA of the FBU sent from the previous link
+	bool fbackReceived; // the FBack for predictedCoA arrived on the previous link
+	IPv6Address previousCoA; // PCoA of the last fast handover, until the HA accepts the NCoA
+	IPv6Address previousAR; // PAR of the last fast handover
+	uint fhoSequence; // MN: sequence number of the next RtSolPr/FBU; AR: of the next HI
+
+	/** access router: neighbouring access points and the routers behind them */
+	struct NeighbourRouterConfig
+	{
+		MACAddress accessPoint;
+		std::string routerPath; // module path of the access router
+		std::string interfaceName; // its interface that connects to the access point
+	};
+	typedef std::vector<NeighbourRouterConfig> NeighbourRouterConfigList;
+	NeighbourRouterConfigList neighbourRouterConfigs;
+
+	/** PAR: fast handovers in progress, keyed by NCoA */
+	struct FastHandoverInfo
+	{
+		IPv6Address parAddr; // our address the FBU was sent to: entry of the tunnel
+		IPv6Address PCoA;
+		IPv6Address NCoA;
+		IPv6Address fbuSource; // where the FBU came from (PCoA or NCoA)
+		IPv6Address narAddr; // NAR that the HI was sent to
+		uint sequence; // sequence number of the FBU
+		uint hiSequence; // sequence number of the HI, which the HAck echoes
+		uint lifetime; // lifetime of the FBU in seconds
+		int interfaceId; // interface on which the FBU was received
+		bool tunnelCreated;
+	};
+	typedef std::map<IPv6Address,FastHandoverInfo> FastHandoverList;
+	FastHandoverList fastHandovers;
+	long numFastHandoversAccepted; // PAR: tunnels set up for a NCoA
+
 
   protected:
 	/************************Miscellaneous Stuff***************************/
 	virtual int numInitStages() const {return 4;}
 	virtual void initialize(int stage);
 	virtual void handleMessage(cMessage *msg);
+	virtual void finish();
+
+	/**
+	 * Called by the NotificationBoard whenever a change of a category
+	 * occurs to which this client has subscribed.
+	 */
+	virtual void receiveChangeNotification(int category, const cPolymorphic *details);
+
+	/**
+	 * Dispatches an expired timer message to its handler.
+	 */
+	virtual void handleTimer(cMessage *msg);
+
+	/**
+	 * Fires all TimerIfEntries that are due, then reschedules the tick.
+	 */
+	void handleTimerWheelTick();
+
+	/**
+	 * Schedules (or reschedules) the timer of the provided entry to expire
+	 * at the given time. Replaces scheduleAt() on entry->timer.
+	 */
+	void scheduleTimer(TimerIfEntry* entry, simtime_t expiryTime);
+
+	/**
+	 * Schedules timerWheelTick for the next wakeup time of the timerWheel.
+	 */
+	void rescheduleTimerWheelTick();
 
 	//================MIPv6 Related Functions=================================================
 	/**
@@ -555,6 +674,119 @@ private:
 	 */
 	void handleTokenExpiry(cMessage* msg);
 
+//
+// FMIPv6 (RFC 5568) related functions
+//
+  protected:
+	/**
+	 * Parses the fastHandoverNeighbours parameter.
+	 */
+	void parseFastHandoverNeighbours(const char* neighbours);
+
+	/**
+	 * Fills in the information about the access router behind a neighbouring access
+	 * point from the interface table of that router, and returns its global address
+	 * on that link. Returns false if the router or the interface does not exist.
+	 */
+	bool resolveNeighbourRouter(const NeighbourRouterConfig& config, NeighbourRouterInfo& info, IPv6Address& globalAddr);
+
+	/**
+	 * Returns the interface of the MN that fast handovers are performed with.
+	 * (A MN with a single wireless interface is assumed.)
+	 */
+	InterfaceEntry* getFastHandoverInterface();
+
+	/**
+	 * Creates and schedules a (re)transmission timer for a RtSolPr, FBU or HI message.
+	 * If dest is unspecified, the message is sent to the current default router, and
+	 * transmission is deferred until there is one. The timer is stored under dest,
+	 * except for a HI: a NAR may receive HIs for several MNs at the same time, so
+	 * that one is stored under the NCoA it announces.
+	 */
+	void createFastHandoverTimer(MobilityHeader* msg, int keyType, const IPv6Address& dest, const IPv6Address& src,
+			InterfaceEntry* ie, uint retries, simtime_t sendTime = 0);
+
+	/**
+	 * Handles a fired FastHandoverTransmitIfEntry: sends the message and reschedules
+	 * the timer if there are retransmissions left.
+	 */
+	void sendFastHandoverMessage(cMessage* msg);
+
+	/**
+	 * MN: the link to the current access point is going down. In predictive mode, an
+	 * FBU is sent to the PAR for the first neighbouring access router that is known.
+	 */
+	void handleLinkGoingDown(InterfaceEntry* ie);
+
+	/**
+	 * MN: associated with a new access point. If the access router behind it is known
+	 * from the last PrRtAdv, the NCoA is configured right away and the fast handover
+	 * is completed from the new link; in any case, a RtSolPr is sent on the new link.
+	 */
+	void handleLinkUp(InterfaceEntry* ie, const MACAddress& accessPoint);
+
+	/**
+	 * Forms the NCoA for the given neighbouring access router.
+	 */
+	IPv6Address formNewCareOfAddress(InterfaceEntry* ie, const NeighbourRouterInfo& info);
+
+	/**
+	 * Returns the current CoA of the MN, or its HoA if it is at home.
+	 */
+	IPv6Address getCurrentCareOfAddress(InterfaceEntry* ie);
+
+	/**
+	 * Creates a FBU for the given PCoA/NCoA pair.
+	 */
+	FastBindingUpdate* createFBUMessage(const IPv6Address& PCoA, const IPv6Address& NCoA);
+
+	/**
+	 * Processes a RtSolPr (access router): answers with a PrRtAdv.
+	 */
+	void processRtSolPrMessage(RouterSolicitationForProxyAdv* rtSolPr, IPv6ControlInfo* ctrlInfo);
+
+	/**
+	 * Processes a PrRtAdv (MN): caches the neighbouring access routers.
+	 */
+	void processPrRtAdvMessage(ProxyRouterAdvertisement* prRtAdv, IPv6ControlInfo* ctrlInfo);
+
+	/**
+	 * Processes a FBU (PAR): sends a HI to the NAR if the FBU came from the previous
+	 * link, otherwise establishes the tunnel to the NCoA and sends the FBack right away.
+	 */
+	void processFBUMessage(FastBindingUpdate* fbu, IPv6ControlInfo* ctrlInfo);
+
+	/**
+	 * Processes a FBack (MN).
+	 */
+	void processFBackMessage(FastBindingAcknowledgement* fback, IPv6ControlInfo* ctrlInfo);
+
+	/**
+	 * Processes a HI (NAR): buffers packets for the NCoA and answers with a HAck.
+	 */
+	void processHIMessage(HandoverInitiate* hi, IPv6ControlInfo* ctrlInfo);
+
+	/**
+	 * Processes a HAck (PAR): establishes the tunnel to the NCoA and sends the FBack.
+	 */
+	void processHAckMessage(HandoverAcknowledge* hack, IPv6ControlInfo* ctrlInfo);
+
+	/**
+	 * PAR: creates the tunnel to the NCoA, starts its expiry timer and sends the FBack.
+	 */
+	void completeFastHandover(FastHandoverInfo& fho, int status);
+
+	/**
+	 * PAR: destroys the tunnel to the NCoA, unless it has become the tunnel of a
+	 * home registration in the meantime (PAR is the HA of the MN).
+	 */
+	void handleFastHandoverTunnelExpiry(cMessage* msg);
+
+	/**
+	 * MN: called when the HA has accepted the NCoA; releases the PCoA and the tunnel
+	 * from the PAR.
+	 */
+	void finishFastHandover(InterfaceEntry* ie, const IPv6Address& CoA);
 };
 
 #endif //__XMIPV6_H__
@@ -34,13 +34,6 @@ bool TCP::logverbose;
 #define EPHEMERAL_PORTRANGE_START 1024
 #define EPHEMERAL_PORTRANGE_END   5000
 
-static std::ostream& operator<<(std::ostream& os, const TCP::SockPair& sp)
-{
-    os << "loc=" << IPvXAddress(sp.localAddr) << ":" << sp.localPort << " "
-       << "rem=" << IPvXAddress(sp.remoteAddr) << ":" << sp.remotePort;
-    return os;
-}
-
 static std::ostream& operator<<(std::ostream& os, const TCP::AppConnKey& app)
 {
     os << "connId=" << app.connId << " appGateIndex=" << app.appGateIndex;
@@ -49,7 +42,10 @@ static std::ostream& operator<<(std::ostream& os, const TCP::AppConnKey& app)
 
 static std::ostream& operator<<(std::ostream& os, const TCPConnection& conn)
 {
-    os << "connId=" << conn.connId << " " << TCPConnection::stateName(conn.getFsmState())
+    os << "connId=" << conn.connId << " "
+       << "loc=" << conn.localAddr << ":" << conn.localPort << " "
+       << "rem=" << conn.remoteAddr << ":" << conn.remotePort << " "
+       << TCPConnection::stateName(conn.getFsmState())
        << " state={" << const_cast<TCPConnection&>(conn).getState()->info() << "}";
     return os;
 }
@@ -60,11 +56,16 @@ void TCP::initialize()
     lastEphemeralPort = EPHEMERAL_PORTRANGE_START;
     WATCH(lastEphemeralPort);
 
-    WATCH_PTRMAP(tcpConnMap);
     WATCH_PTRMAP(tcpAppConnMap);
 
     recordStatistics = par("recordStats");
 
+    double timerWheelResolution = par("timerWheelResolution");
+    useTimerWheel = timerWheelResolution > 0;
+    if (useTimerWheel)
+        timerWheel.setResolution(timerWheelResolution);
+    timerWheelTick = new cMessage("timerWheelTick");
+
     cModule *netw = simulation.getSystemModule();
     testing = netw->hasPar("testing") && netw->par("testing").boolValue();
     logverbose = !testing && netw->hasPar("logverbose") && netw->par("logverbose").boolValue();
@@ -78,16 +79,18 @@ TCP::~TCP()
         delete (*i).second;
         tcpAppConnMap.erase(i);
     }
+    cancelAndDelete(timerWheelTick);
 }
 
 void TCP::handleMessage(cMessage *msg)
 {
-    if (msg->isSelfMessage())
+    if (msg==timerWheelTick)
     {
-        TCPConnection *conn = (TCPConnection *) msg->getContextPointer();
-        bool ret = conn->processTimer(msg);
-        if (!ret)
-            removeConnection(conn);
+        handleTimerWheelTick();
+    }
+    else if (msg->isSelfMessage())
+    {
+        processConnectionTimer(msg);
     }
     else if (msg->arrivedOn("ipIn") || msg->arrivedOn("ipv6In"))
     {
@@ -166,6 +169,80 @@ void TCP::handleMessage(cMessage *msg)
         updateDisplayString();
 }
 
+void TCP::processConnectionTimer(cMessage *timer)
+{
+    TCPConnection *conn = (TCPConnection *) timer->getContextPointer();
+    bool ret = conn->processTimer(timer);
+    if (!ret)
+        removeConnection(conn);
+}
+
+void TCP::handleTimerWheelTick()
+{
+    timerWheel.advance(simTime());
+
+    // fire due timers one by one: processing a timer may cancel other due
+    // ones, or delete them together with their connection
+    TimerWheel::Timer *t;
+    while ((t = timerWheel.popExpired()) != NULL)
+        processConnectionTimer(static_cast<TCPTimer *>(t));
+
+    rescheduleTimerWheelTick();
+}
+
+void TCP::rescheduleTimerWheelTick()
+{
+    cancelEvent(timerWheelTick);
+
+    simtime_t wakeupTime = timerWheel.getNextWakeupTime();
+    if (wakeupTime == MAXTIME)
+        return;
+    if (wakeupTime < simTime())
+        wakeupTime = simTime();
+    scheduleAt(wakeupTime, timerWheelTick);
+}
+
+void TCP::scheduleTimer(cMessage *timer, simtime_t expiryTime)
+{
+    TCPTimer *t = useTimerWheel ? dynamic_cast<TCPTimer *>(timer) : NULL;
+    if (!t)
+    {
+        scheduleAt(expiryTime, timer);
+        return;
+    }
+
+    timerWheel.schedule(t, expiryTime);
+
+    // the tick only needs to be moved if the new timer expires before it,
+    // which is rare: restarted timers (REXMIT, DELAYEDACK) tend to move later
+    simtime_t wakeupTime = t->getExpiryTime();
+    if (wakeupTime < simTime())
+        wakeupTime = simTime();
+    if (timerWheelTick->isScheduled())
+    {
+        if (timerWheelTick->getArrivalTime() <= wakeupTime)
+            return;
+        cancelEvent(timerWheelTick);
+    }
+    scheduleAt(wakeupTime, timerWheelTick);
+}
+
+cMessage *TCP::cancelTimer(cMessage *timer)
+{
+    TCPTimer *t = useTimerWheel ? dynamic_cast<TCPTimer *>(timer) : NULL;
+    if (t)
+        timerWheel.cancel(t);
+    else
+        cancelEvent(timer);
+    return timer;
+}
+
+bool TCP::isTimerScheduled(cMessage *timer) const
+{
+    TCPTimer *t = useTimerWheel ? dynamic_cast<TCPTimer *>(timer) : NULL;
+    return t ? static_cast<TimerWheel::Timer *>(t)->isScheduled() : timer->isScheduled();
+}
+
 TCPConnection *TCP::createConnection(int appGateIndex, int connId)
 {
     return new TCPConnection(this, appGateIndex, connId);
@@ -233,6 +310,78 @@ void TCP::updateDisplayString()
     getDisplayString().setTagArg("t",0,buf2);
 }
 
+TCP::SockPairMap::SockPairMap()
+{
+    slots.resize(16);
+    for (unsigned int i=0; i<slots.size(); i++)
+        slots[i].conn = NULL;
+    count = 0;
+}
+
+int TCP::SockPairMap::findSlot(const SockPair& key) const
+{
+    // returns the slot of the key, or the free slot where it would go
+    int mask = slots.size() - 1;
+    int i = key.hash() & mask;
+    while (slots[i].conn && !(slots[i].key == key))
+        i = (i+1) & mask;
+    return i;
+}
+
+void TCP::SockPairMap::grow()
+{
+    std::vector<Slot> old;
+    old.swap(slots);
+    slots.resize(old.size()*2);
+    for (unsigned int i=0; i<slots.size(); i++)
+        slots[i].conn = NULL;
+    for (unsigned int i=0; i<old.size(); i++)
+        if (old[i].conn)
+            slots[findSlot(old[i].key)] = old[i];
+}
+
+bool TCP::SockPairMap::insert(const SockPair& key, TCPConnection *conn)
+{
+    if (2*(count+1) > (int)slots.size())
+        grow();
+    int i = findSlot(key);
+    if (slots[i].conn)
+        return false;
+    slots[i].key = key;
+    slots[i].conn = conn;
+    count++;
+    return true;
+}
+
+bool TCP::SockPairMap::erase(const SockPair& key)
+{
+    int i = findSlot(key);
+    if (!slots[i].conn)
+        return false;
+    slots[i].conn = NULL;
+    count--;
+
+    // move back entries of the probe sequence that would no longer be found
+    int mask = slots.size() - 1;
+    for (int j = (i+1) & mask; slots[j].conn; j = (j+1) & mask)
+    {
+        int home = slots[j].key.hash() & mask;
+        // can the entry at j move to the hole at i? (i.e. is i cyclically in [home,j))
+        if ((j > i && (home <= i || home > j)) || (j < i && home <= i && home > j))
+        {
+            slots[i] = slots[j];
+            slots[j].conn = NULL;
+            i = j;
+        }
+    }
+    return true;
+}
+
+TCP::SockPairMap& TCP::getSockPairMap(const SockPair& key)
+{
+    return (key.remoteAddr.isUnspecified() && key.remotePort==-1) ? tcpListenerMap : tcpConnMap;
+}
+
 TCPConnection *TCP::findConnForSegment(TCPSegment *tcpseg, IPvXAddress srcAddr, IPvXAddress destAddr)
 {
     SockPair key;
@@ -240,33 +389,32 @@ TCPConnection *TCP::findConnForSegment(TCPSegment *tcpseg, IPvXAddress srcAddr,
     key.remoteAddr = srcAddr;
     key.localPort = tcpseg->getDestPort();
     key.remotePort = tcpseg->getSrcPort();
-    SockPair save = key;
+    TCPConnection *conn;
 
     // try with fully qualified SockPair
-    TcpConnMap::iterator i;
-    i = tcpConnMap.find(key);
-    if (i!=tcpConnMap.end())
-        return i->second;
+    if ((conn = tcpConnMap.find(key)) != NULL)
+        return conn;
 
     // try with localAddr missing (only localPort specified in passive/active open)
     key.localAddr = IPvXAddress();
-    i = tcpConnMap.find(key);
-    if (i!=tcpConnMap.end())
-        return i->second;
+    if ((conn = tcpConnMap.find(key)) != NULL)
+        return conn;
+
+    // no listeners, no need to look further (e.g. client-only hosts)
+    if (tcpListenerMap.size() == 0)
+        return NULL;
 
     // try fully qualified local socket + blank remote socket (for incoming SYN)
-    key = save;
+    key.localAddr = destAddr;
     key.remoteAddr = IPvXAddress();
     key.remotePort = -1;
-    i = tcpConnMap.find(key);
-    if (i!=tcpConnMap.end())
-        return i->second;
+    if ((conn = tcpListenerMap.find(key)) != NULL)
+        return conn;
 
     // try with blank remote socket, and localAddr missing (for incoming SYN)
     key.localAddr = IPvXAddress();
-    i = tcpConnMap.find(key);
-    if (i!=tcpConnMap.end())
-        return i->second;
+    if ((conn = tcpListenerMap.find(key)) != NULL)
+        return conn;
 
     // given up
     return NULL;
@@ -311,9 +459,8 @@ void TCP::addSockPair(TCPConnection *conn, IPvXAddress localAddr, IPvXAddress re
     key.localPort = conn->localPort = localPort;
     key.remotePort = conn->remotePort = remotePort;
 
-    // make sure connection is unique
-    TcpConnMap::iterator it = tcpConnMap.find(key);
-    if (it!=tcpConnMap.end())
+    // make sure connection is unique, and insert it into tcpConnMap or tcpListenerMap
+    if (!getSockPairMap(key).insert(key, conn))
     {
         // throw "address already in use" error
         if (remoteAddr.isUnspecified() && remotePort==-1)
@@ -324,9 +471,6 @@ void TCP::addSockPair(TCPConnection *conn, IPvXAddress localAddr, IPvXAddress re
                   localAddr.str().c_str(), localPort, remoteAddr.str().c_str(), remotePort);
     }
 
-    // then insert it into tcpConnMap
-    tcpConnMap[key] = conn;
-
     // mark port as used
     if (localPort>=EPHEMERAL_PORTRANGE_START && localPort<EPHEMERAL_PORTRANGE_END)
         usedEphemeralPorts.insert(localPort);
@@ -340,18 +484,17 @@ void TCP::updateSockPair(TCPConnection *conn, IPvXAddress localAddr, IPvXAddress
     key.remoteAddr = conn->remoteAddr;
     key.localPort = conn->localPort;
     key.remotePort = conn->remotePort;
-    TcpConnMap::iterator it = tcpConnMap.find(key);
-    ASSERT(it!=tcpConnMap.end() && it->second==conn);
+    ASSERT(getSockPairMap(key).find(key)==conn);
 
-    // ...and remove from the old place in tcpConnMap
-    tcpConnMap.erase(it);
+    // ...and remove from the old place in tcpConnMap/tcpListenerMap
+    getSockPairMap(key).erase(key);
 
-    // then update addresses/ports, and re-insert it with new key into tcpConnMap
+    // then update addresses/ports, and re-insert it with new key
     key.localAddr = conn->localAddr = localAddr;
     key.remoteAddr = conn->remoteAddr = remoteAddr;
     ASSERT(conn->localPort == localPort);
     key.remotePort = conn->remotePort = remotePort;
-    tcpConnMap[key] = conn;
+    getSockPairMap(key).insert(key, conn);
 
     // localPort doesn't change (see ASSERT above), so there's no need to update usedEphemeralPorts[].
 }
@@ -390,7 +533,7 @@ void TCP::removeConnection(TCPConnection *conn)
     key2.remoteAddr = conn->remoteAddr;
     key2.localPort = conn->localPort;
     key2.remotePort = conn->remotePort;
-    tcpConnMap.erase(key2);
+    getSockPairMap(key2).erase(key2);
 
     // IMPORTANT: usedEphemeralPorts.erase(conn->localPort) is NOT GOOD because it
     // deletes ALL occurrences of the port from the multiset.
@@ -403,5 +546,5 @@ void TCP::removeConnection(TCPConnection *conn)
 
 void TCP::finish()
 {
-    tcpEV << getFullPath() << ": finishing with " << tcpConnMap.size() << " connections open.\n";
+    tcpEV << getFullPath() << ": finishing with " << (tcpConnMap.size() + tcpListenerMap.size()) << " connections open.\n";
 }
@@ -20,8 +20,10 @@
 
 #include <map>
 #include <set>
+#include <vector>
 #include <omnetpp.h>
 #include "IPvXAddress.h"
+#include "TimerWheel.h"
 
 
 class TCPConnection;
@@ -37,6 +39,21 @@ class TCPSegment;
 #define testingEV (ev.disable_tracing||!TCP::testing)?ev:ev
 
 
+/**
+ * Timer message of TCPConnection and TCPAlgorithm. It can be scheduled
+ * either as a normal self-message, or in the timer wheel of the TCP
+ * module (see TCP::scheduleTimer()); the context pointer of the message
+ * must point to the connection.
+ *
+ * Note: whether the timer is scheduled must be asked via
+ * TCP::isTimerScheduled(), as cMessage::isScheduled() doesn't know
+ * about the timer wheel.
+ */
+class INET_API TCPTimer : public cMessage, public TimerWheel::Timer
+{
+  public:
+    TCPTimer(const char *name=NULL) : cMessage(name) {}
+};
 
 
 
@@ -127,18 +144,71 @@ class INET_API TCP : public cSimpleModule
             else
                 return localPort<b.localPort;
         }
+
+        // note: unlike IPvXAddress::operator==, this also compares address families
+        inline bool operator==(const SockPair& b) const
+        {
+            return localPort==b.localPort && remotePort==b.remotePort &&
+                   localAddr.isIPv6()==b.localAddr.isIPv6() && localAddr==b.localAddr &&
+                   remoteAddr.isIPv6()==b.remoteAddr.isIPv6() && remoteAddr==b.remoteAddr;
+        }
+
+        inline uint32 hash() const
+        {
+            uint32 h = localAddr.hash() ^ (remoteAddr.hash()*0x9e3779b1U);
+            h ^= ((uint32)(unsigned short)localPort << 16) | (unsigned short)remotePort;
+            h *= 0x9e3779b1U;
+            return h ^ (h>>16);
+        }
+    };
+
+    /**
+     * Hash table of connections, keyed by socket pair. Open addressing with
+     * linear probing; the load factor is kept at or below 1/2.
+     */
+    class SockPairMap
+    {
+      protected:
+        struct Slot
+        {
+            SockPair key;
+            TCPConnection *conn;  // NULL for free slots
+        };
+        std::vector<Slot> slots;  // size is a power of 2
+        int count;
+
+        int findSlot(const SockPair& key) const;
+        void grow();
+
+      public:
+        SockPairMap();
+        TCPConnection *find(const SockPair& key) const  {int i = findSlot(key); return slots[i].conn;}
+        bool insert(const SockPair& key, TCPConnection *conn);  // returns false if key is already there
+        bool erase(const SockPair& key);  // returns false if key was not found
+        int size() const  {return count;}
     };
 
   protected:
     typedef std::map<AppConnKey,TCPConnection*> TcpAppConnMap;
-    typedef std::map<SockPair,TCPConnection*> TcpConnMap;
 
     TcpAppConnMap tcpAppConnMap;
-    TcpConnMap tcpConnMap;
+
+    // connections by socket pair: listening ones (remote address and port
+    // unspecified) are kept separately from the others, so that segments of
+    // established connections and incoming SYNs are both found with few probes
+    SockPairMap tcpConnMap;
+    SockPairMap tcpListenerMap;
 
     short lastEphemeralPort;
     std::multiset<short> usedEphemeralPorts;
 
+    // If timerWheelResolution>0, TCPTimers of all connections are kept in
+    // timerWheel, and multiplexed onto a single self-message, timerWheelTick.
+    // Cancelling a timer doesn't move the tick: it will just find nothing due.
+    bool useTimerWheel;
+    TimerWheel timerWheel;
+    cMessage *timerWheelTick;
+
   protected:
     /** Factory method; may be overriden for customizing TCP */
     virtual TCPConnection *createConnection(int appGateIndex, int connId);
@@ -146,9 +216,13 @@ class INET_API TCP : public cSimpleModule
     // utility methods
     virtual TCPConnection *findConnForSegment(TCPSegment *tcpseg, IPvXAddress srcAddr, IPvXAddress destAddr);
     virtual TCPConnection *findConnForApp(int appGateIndex, int connId);
+    virtual SockPairMap& getSockPairMap(const SockPair& key);
     virtual void segmentArrivalWhileClosed(TCPSegment *tcpseg, IPvXAddress src, IPvXAddress dest);
     virtual void removeConnection(TCPConnection *conn);
     virtual void updateDisplayString();
+    virtual void processConnectionTimer(cMessage *timer);
+    virtual void handleTimerWheelTick();
+    virtual void rescheduleTimerWheelTick();
 
   public:
     static bool testing;    // switches between tcpEV and testingEV
@@ -157,7 +231,7 @@ class INET_API TCP : public cSimpleModule
     bool recordStatistics;  // output vectors on/off
 
   public:
-    TCP() {}
+    TCP() {useTimerWheel = false; timerWheelTick = NULL;}
     virtual ~TCP();
 
   protected:
@@ -188,6 +262,22 @@ class INET_API TCP : public cSimpleModule
      * To be called from TCPConnection: reserves an ephemeral port for the connection.
      */
     virtual short getEphemeralPort();
+
+    /**
+     * Schedules a connection timer. TCPTimers go into the timer wheel if
+     * it is enabled; other timer messages are scheduled with scheduleAt().
+     */
+    virtual void scheduleTimer(cMessage *timer, simtime_t expiryTime);
+
+    /**
+     * Cancels a timer scheduled with scheduleTimer(), and returns it.
+     */
+    virtual cMessage *cancelTimer(cMessage *timer);
+
+    /**
+     * Returns true if the timer is scheduled (by scheduleTimer()).
+     */
+    virtual bool isTimerScheduled(cMessage *timer) const;
 };
 
 #endif
@@ -160,6 +160,13 @@ class INET_API TCPAlgorithm : public cPolymorphic
      */
     virtual void dataSent(uint32 fromseq) = 0;
 
+    /**
+     * Called before receivedDataAck() if the ACK carried an echoed timestamp
+     * (Timestamps option, RFC 1323). The RTT can be measured on every such
+     * ACK, see TCPConnection::convertTSToSimtime().
+     */
+    virtual void rttMeasurementCompleteUsingTS(uint32 echoedTS) = 0;
+
 };
 
 #endif
@@ -22,14 +22,15 @@
 #include "INETDefs.h"
 #include "IPvXAddress.h"
 #include "TCP.h"
+#include "TCPSegment.h"
 
 
-class TCPSegment;
 class TCPCommand;
 class TCPOpenCommand;
 class TCPSendQueue;
 class TCPReceiveQueue;
 class TCPAlgorithm;
+class TCPSackScoreboard;
 
 
 //
@@ -124,6 +125,16 @@ inline bool seqLess(uint32 a, uint32 b) {return a!=b && b-a<(1UL<<31);}
 inline bool seqLE(uint32 a, uint32 b) {return b-a<(1UL<<31);}
 inline bool seqGreater(uint32 a, uint32 b) {return a!=b && a-b<(1UL<<31);}
 inline bool seqGE(uint32 a, uint32 b) {return a-b<(1UL<<31);}
+
+/**
+ * Function object for seqLess(), to order sequence numbers in STL
+ * containers. Only valid if all keys are within 2^31 of each other,
+ * e.g. inside the receive window.
+ */
+struct SeqLess
+{
+    bool operator()(uint32 a, uint32 b) const {return seqLess(a,b);}
+};
 //@}
 
 
@@ -157,7 +168,7 @@ class INET_API TCPStateVariables : public cPolymorphic
     uint32 snd_nxt;      // send next (drops back on retransmission)
     uint32 snd_max;      // max seq number sent (needed because snd_nxt is re-set on retransmission)
 
-    uint snd_wnd;        // send window
+    uint snd_wnd;        // send window (already scaled, see snd_wnd_scale)
     uint32 snd_up;       // send urgent pointer
     uint32 snd_wl1;      // segment sequence number used for last window update
     uint32 snd_wl2;      // segment ack. number used for last window update
@@ -173,6 +184,23 @@ class INET_API TCPStateVariables : public cPolymorphic
     // belong to TCPAlgorithm, but it's a lot easier to manage here)
     short dupacks;
 
+    // Window Scale option (RFC 1323)
+    bool ws_support;     // whether we send Window Scale in SYN (windowScalingSupport NED parameter)
+    bool ws_enabled;     // whether window scaling is used, i.e. both sides sent Window Scale
+    uint snd_wnd_scale;  // shift count to apply to the window of incoming segments
+    uint rcv_wnd_scale;  // shift count to apply to rcv_wnd in outgoing segments
+
+    // Timestamps option (RFC 1323)
+    bool ts_support;     // whether we send Timestamps in SYN (timestampSupport NED parameter)
+    bool ts_enabled;     // whether timestamps are used, i.e. both sides sent Timestamps
+    uint32 ts_recent;    // TS.Recent: timestamp to be echoed in the next segment sent
+    uint32 last_ack_sent; // Last.ACK.sent: ackNo in the last segment sent
+
+    // SACK (RFC 2018)
+    bool sack_support;   // whether we send SACK-Permitted in SYN (sackSupport NED parameter)
+    bool sack_enabled;   // whether SACK is used, i.e. both sides sent SACK-Permitted
+    std::vector<TCPSackBlock> sack_blocks; // blocks to report in the SACK option, most recent first
+
     // SYN, SYN+ACK retransmission variables (handled separately
     // because normal rexmit belongs to TCPAlgorithm)
     int syn_rexmit_count;   // number of SYN/SYN+ACK retransmissions (=1 after first rexmit)
@@ -274,6 +302,9 @@ class INET_API TCPConnection
     // TCP behavior in data transfer state
     TCPAlgorithm *tcpAlgorithm;
 
+    // data SACKed by the peer, for SACK-based loss recovery in tcpAlgorithm
+    TCPSackScoreboard *sackScoreboard;
+
     // timers
     cMessage *the2MSLTimer;
     cMessage *connEstabTimer;
@@ -351,6 +382,33 @@ class INET_API TCPConnection
     /** Utility: check if segment is acceptable (all bytes are in receive window) */
     virtual bool isSegmentAcceptable(TCPSegment *tcpseg);
 
+    /**
+     * Utility: update the SACK blocks to be sent, after data starting at
+     * seq have been inserted into the receive queue (RFC 2018 section 4)
+     */
+    virtual void updateSackBlocks(uint32 seq);
+
+    /**
+     * Utility: process the options of the SYN or SYN+ACK received, i.e.
+     * decide which of the options we support will be used on the connection
+     */
+    virtual void processSynOptions(TCPSegment *tcpseg);
+
+    /** Utility: returns the window field of outgoing (non-SYN) segments, i.e. rcv_wnd scaled down */
+    virtual ulong getScaledRcvWnd();
+
+    /** Utility: add the Timestamps option to an outgoing segment, if timestamps are used */
+    virtual void addTimestampOption(TCPSegment *tcpseg);
+
+    /** Utility: update TS.Recent from an incoming segment (RFC 1323 section 3.4) */
+    virtual void processTimestampOption(TCPSegment *tcpseg);
+
+    /** Utility: add the SACK option to an outgoing segment, if there are blocks to report */
+    virtual void addSackOption(TCPSegment *tcpseg);
+
+    /** Utility: record the blocks of an incoming SACK option in the scoreboard */
+    virtual void processSackOption(TCPSegment *tcpseg);
+
     /** Utility: send SYN */
     virtual void sendSyn();
 
@@ -377,6 +435,12 @@ class INET_API TCPConnection
     /** Utility: retransmit all from snd_una to snd_max */
     virtual void retransmitData();
 
+    /**
+     * Utility: retransmit one segment of 'bytes' bytes from seq, for
+     * SACK-based loss recovery. snd_nxt will point after the segment.
+     */
+    virtual void retransmitSegment(uint32 seq, ulong bytes);
+
     /** Utility: sends RST */
     virtual void sendRst(uint32 seqNo);
     /** Utility: sends RST; does not use connection state */
@@ -410,11 +474,14 @@ class INET_API TCPConnection
 
     /** Utility: start a timer */
     void scheduleTimeout(cMessage *msg, simtime_t timeout)
-        {tcpMain->scheduleAt(simTime()+timeout, msg);}
+        {tcpMain->scheduleTimer(msg, simTime()+timeout);}
+
+    /** Utility: returns true if the timer is running */
+    bool isTimerScheduled(cMessage *msg)  {return tcpMain->isTimerScheduled(msg);}
 
   protected:
     /** Utility: cancel a timer */
-    cMessage *cancelEvent(cMessage *msg)  {return tcpMain->cancelEvent(msg);}
+    cMessage *cancelEvent(cMessage *msg)  {return tcpMain->cancelTimer(msg);}
 
     /** Utility: send IP packet */
     static void sendToIP(TCPSegment *tcpseg, IPvXAddress src, IPvXAddress dest);
@@ -439,6 +506,10 @@ class INET_API TCPConnection
     static const char *eventName(int event);
     /** Utility: returns name of TCP_I_xxx constants */
     static const char *indicationName(int code);
+    /** Utility: converts simulation time to the value of the Timestamps option clock (milliseconds) */
+    static uint32 convertSimtimeToTS(simtime_t t);
+    /** Utility: converts a timestamp to simulation time, assuming it's not older than 2^31 ms */
+    static simtime_t convertTSToSimtime(uint32 ts);
 
   public:
     /**
@@ -472,6 +543,7 @@ class INET_API TCPConnection
     TCPSendQueue *getSendQueue() {return sendQueue;}
     TCPReceiveQueue *getReceiveQueue() {return receiveQueue;}
     TCPAlgorithm *getTcpAlgorithm() {return tcpAlgorithm;}
+    TCPSackScoreboard *getSackScoreboard() {return sackScoreboard;}
     TCP *getTcpMain() {return tcpMain;}
     //@}
 
@@ -25,6 +25,7 @@
 #include "TCPSendQueue.h"
 #include "TCPReceiveQueue.h"
 #include "TCPAlgorithm.h"
+#include "TCPSackScoreboard.h"
 
 
 TCPStateVariables::TCPStateVariables()
@@ -48,6 +49,19 @@ TCPStateVariables::TCPStateVariables()
 
     dupacks = 0;
 
+    ws_support = false; // will be set from configureStateVariables()
+    ws_enabled = false;
+    snd_wnd_scale = 0;
+    rcv_wnd_scale = 0;
+
+    ts_support = false; // will be set from configureStateVariables()
+    ts_enabled = false;
+    ts_recent = 0;
+    last_ack_sent = 0;
+
+    sack_support = false; // will be set from configureStateVariables()
+    sack_enabled = false;
+
     syn_rexmit_count = 0;
     syn_rexmit_timeout = 0;
 
@@ -89,6 +103,12 @@ std::string TCPStateVariables::detailedInfo() const
     out << "rcv_up = " << rcv_up << "\n";
     out << "irs = " << irs << "\n";
     out << "fin_ack_rcvd = " << fin_ack_rcvd << "\n";
+    out << "ws_enabled = " << ws_enabled << "\n";
+    out << "snd_wnd_scale = " << snd_wnd_scale << "\n";
+    out << "rcv_wnd_scale = " << rcv_wnd_scale << "\n";
+    out << "ts_enabled = " << ts_enabled << "\n";
+    out << "ts_recent = " << ts_recent << "\n";
+    out << "sack_enabled = " << sack_enabled << "\n";
     return out.str();
 }
 
@@ -99,6 +119,7 @@ TCPConnection::TCPConnection()
     sendQueue = NULL;
     receiveQueue = NULL;
     tcpAlgorithm = NULL;
+    sackScoreboard = NULL;
     state = NULL;
     the2MSLTimer = connEstabTimer = finWait2Timer = synRexmitTimer = NULL;
     sndWndVector = sndNxtVector = sndAckVector = rcvSeqVector = rcvAckVector = unackedVector = NULL;
@@ -126,12 +147,13 @@ TCPConnection::TCPConnection(TCP *_mod, int _appGateIndex, int _connId)
     sendQueue = NULL;
     receiveQueue = NULL;
     tcpAlgorithm = NULL;
+    sackScoreboard = NULL;
     state = NULL;
 
-    the2MSLTimer = new cMessage("2MSL");
-    connEstabTimer = new cMessage("CONN-ESTAB");
-    finWait2Timer = new cMessage("FIN-WAIT-2");
-    synRexmitTimer = new cMessage("SYN-REXMIT");
+    the2MSLTimer = new TCPTimer("2MSL");
+    connEstabTimer = new TCPTimer("CONN-ESTAB");
+    finWait2Timer = new TCPTimer("FIN-WAIT-2");
+    synRexmitTimer = new TCPTimer("SYN-REXMIT");
 
     the2MSLTimer->setContextPointer(this);
     connEstabTimer->setContextPointer(this);
@@ -162,6 +184,7 @@ TCPConnection::~TCPConnection()
     delete sendQueue;
     delete receiveQueue;
     delete tcpAlgorithm;
+    delete sackScoreboard;
     delete state;
 
     if (the2MSLTimer)   delete cancelEvent(the2MSLTimer);
@@ -24,6 +24,7 @@
 #include "TCPSendQueue.h"
 #include "TCPReceiveQueue.h"
 #include "TCPAlgorithm.h"
+#include "TCPSackScoreboard.h"
 
 bool TCPConnection::tryFastRoute(TCPSegment *tcpseg)
 {
@@ -136,6 +137,10 @@ TCPEventCode TCPConnection::processSegment1stThru8th(TCPSegment *tcpseg)
         return TCP_E_IGNORE;
     }
 
+    // RFC 1323: remember the timestamp to be echoed
+    if (state->ts_enabled && tcpseg->getTimestampOption())
+        processTimestampOption(tcpseg);
+
     //
     // RFC 793: second check the RST bit,
     //
@@ -382,6 +387,7 @@ TCPEventCode TCPConnection::processSegment1stThru8th(TCPSegment *tcpseg)
     // RFC 793: seventh, process the segment text,
     //
     uint32 old_rcv_nxt = state->rcv_nxt; // if rcv_nxt changes, we need to send/schedule an ACK
+    bool fin_processed = false; // whether we've got to the peer's FIN with this segment
     if (fsm.getState()==TCP_S_SYN_RCVD || fsm.getState()==TCP_S_ESTABLISHED || fsm.getState()==TCP_S_FIN_WAIT_1 || fsm.getState()==TCP_S_FIN_WAIT_2)
     {
         //"
@@ -421,6 +427,9 @@ TCPEventCode TCPConnection::processSegment1stThru8th(TCPSegment *tcpseg)
             uint32 old_rcv_nxt = state->rcv_nxt;
             state->rcv_nxt = receiveQueue->insertBytesFromSegment(tcpseg);
 
+            if (state->sack_enabled)
+                updateSackBlocks(tcpseg->getSequenceNo());
+
             // out-of-order segment?
             if (old_rcv_nxt==state->rcv_nxt)
             {
@@ -456,6 +465,7 @@ TCPEventCode TCPConnection::processSegment1stThru8th(TCPSegment *tcpseg)
                     tcpEV << "All segments arrived up to the FIN segment, advancing rcv_nxt over the FIN\n";
                     state->rcv_nxt = state->rcv_fin_seq+1;
                     sendIndicationToApp(TCP_I_PEER_CLOSED);
+                    fin_processed = true;
                 }
             }
         }
@@ -485,6 +495,12 @@ TCPEventCode TCPConnection::processSegment1stThru8th(TCPSegment *tcpseg)
             tcpEV << "FIN arrived, advancing rcv_nxt over the FIN\n";
             state->rcv_nxt++;
             sendIndicationToApp(TCP_I_PEER_CLOSED);
+            fin_processed = true;
+        }
+        else if (seqLess(fin_seq, state->rcv_nxt))
+        {
+            // retransmission of a FIN we've already processed
+            fin_processed = true;
         }
         else
         {
@@ -495,9 +511,14 @@ TCPEventCode TCPConnection::processSegment1stThru8th(TCPSegment *tcpseg)
         }
 
         // TBD do PUSH stuff
+    }
 
+    if (fin_processed)
+    {
         // state transitions will be done in the state machine, here we just set
-        // the proper event code (TCP_E_RCV_FIN or TCP_E_RCV_FIN_ACK)
+        // the proper event code (TCP_E_RCV_FIN or TCP_E_RCV_FIN_ACK). Note that
+        // a FIN above sequence doesn't close the connection yet: we're staying
+        // in a state where the missing data can still be received.
         event = TCP_E_RCV_FIN;
         switch (fsm.getState())
         {
@@ -657,9 +678,12 @@ TCPEventCode TCPConnection::processSegmentInListen(TCPSegment *tcpseg, IPvXAddre
         state->snd_wl2 = state->iss;
         if (sndWndVector) sndWndVector->record(state->snd_wnd);
 
+        // decide about window scaling, timestamps and SACK
+        processSynOptions(tcpseg);
+
         sendSynAck();
         startSynRexmitTimer();
-        if (!connEstabTimer->isScheduled())
+        if (!isTimerScheduled(connEstabTimer))
             scheduleTimeout(connEstabTimer, TCP_TIMEOUT_CONN_ESTAB);
 
         //"
@@ -764,6 +788,9 @@ TCPEventCode TCPConnection::processSegmentInSynSent(TCPSegment *tcpseg, IPvXAddr
         state->irs = tcpseg->getSequenceNo();
         receiveQueue->init(state->rcv_nxt);
 
+        // decide about window scaling, timestamps and SACK
+        processSynOptions(tcpseg);
+
         if (tcpseg->getAckBit())
         {
             state->snd_una = tcpseg->getAckNo();
@@ -912,6 +939,12 @@ bool TCPConnection::processAckInEstabEtc(TCPSegment *tcpseg)
     //"
     // Note: should use SND.MAX instead of SND.NXT in above checks
     //
+    // The SACK option is processed first, so that tcpAlgorithm sees
+    // the updated scoreboard (RFC 6675).
+    //
+    if (state->sack_enabled && tcpseg->getSackBlockArraySize()>0)
+        processSackOption(tcpseg);
+
     if (seqGE(state->snd_una, tcpseg->getAckNo()))
     {
         //
@@ -970,18 +1003,24 @@ bool TCPConnection::processAckInEstabEtc(TCPSegment *tcpseg)
 
         // acked data no longer needed in send queue
         sendQueue->discardUpTo(discardUpToSeq);
+        sackScoreboard->discardUpTo(state->snd_una);
 
         if (seqLess(state->snd_wl1, tcpseg->getSequenceNo()) ||
             (state->snd_wl1==tcpseg->getSequenceNo() && seqLE(state->snd_wl2, tcpseg->getAckNo())))
         {
-            // send window should be updated
-            tcpEV << "Updating send window from segment: new wnd=" << tcpseg->getWindow() << "\n";
-            state->snd_wnd = tcpseg->getWindow();
+            // send window should be updated (RFC 1323: the window field
+            // of non-SYN segments is scaled)
+            state->snd_wnd = tcpseg->getWindow() << state->snd_wnd_scale;
+            tcpEV << "Updating send window from segment: new wnd=" << state->snd_wnd << "\n";
             state->snd_wl1 = tcpseg->getSequenceNo();
             state->snd_wl2 = tcpseg->getAckNo();
             if (sndWndVector) sndWndVector->record(state->snd_wnd);
         }
 
+        // RFC 1323: with timestamps, every ACK of new data is an RTT sample
+        if (state->ts_enabled && tcpseg->getTimestampOption() && tcpseg->getTsEcr()!=0)
+            tcpAlgorithm->rttMeasurementCompleteUsingTS(tcpseg->getTsEcr());
+
         // notify
         tcpAlgorithm->receivedDataAck(old_snd_una);
 
@@ -1000,6 +1039,27 @@ bool TCPConnection::processAckInEstabEtc(TCPSegment *tcpseg)
     return true;
 }
 
+void TCPConnection::processSackOption(TCPSegment *tcpseg)
+{
+    // blocks must report data above the cumulative ACK that we really sent;
+    // others (e.g. D-SACK blocks, RFC 2883) are ignored
+    uint32 ackNo = tcpseg->getAckNo();
+    if (seqGreater(ackNo, state->snd_max))
+        return;
+    if (seqLess(ackNo, state->snd_una))
+        ackNo = state->snd_una;
+
+    for (unsigned int i=0; i<tcpseg->getSackBlockArraySize(); i++)
+    {
+        const TCPSackBlock& block = tcpseg->getSackBlock(i);
+        if (seqLess(ackNo, block.start) && seqLess(block.start, block.end) && seqLE(block.end, state->snd_max))
+            sackScoreboard->addBlock(block.start, block.end);
+        else
+            tcpEV << "Ignoring invalid SACK block " << block.start << ":" << block.end << "\n";
+    }
+    tcpEV2 << "SACK scoreboard: " << sackScoreboard->info() << "\n";
+}
+
 //----
 
 void TCPConnection::process_TIMEOUT_CONN_ESTAB()
@@ -1063,7 +1123,7 @@ void TCPConnection::startSynRexmitTimer()
     state->syn_rexmit_count = 0;
     state->syn_rexmit_timeout = TCP_TIMEOUT_SYN_REXMIT;
 
-    if (synRexmitTimer->isScheduled())
+    if (isTimerScheduled(synRexmitTimer))
         cancelEvent(synRexmitTimer);
     scheduleTimeout(synRexmitTimer, state->syn_rexmit_timeout);
 }
@@ -27,6 +27,7 @@
 #include "TCPSendQueue.h"
 #include "TCPReceiveQueue.h"
 #include "TCPAlgorithm.h"
+#include "TCPSackScoreboard.h"
 
 
 //
@@ -130,7 +131,13 @@ void TCPConnection::printSegmentBrief(TCPSegment *tcpseg)
         tcpEV << "(" << tcpseg->getPayloadLength() << ") ";
     }
     if (tcpseg->getAckBit())  tcpEV << "ack " << tcpseg->getAckNo() << " ";
-    tcpEV << "win " << tcpseg->getWindow() << "\n";
+    tcpEV << "win " << tcpseg->getWindow();
+    if (tcpseg->getWindowScaleOption())  tcpEV << " wscale " << tcpseg->getWindowScale();
+    if (tcpseg->getTimestampOption())  tcpEV << " TS val " << tcpseg->getTsVal() << " ecr " << tcpseg->getTsEcr();
+    if (tcpseg->getSackPermitted())  tcpEV << " sackOK";
+    for (unsigned int i=0; i<tcpseg->getSackBlockArraySize(); i++)
+        tcpEV << " sack " << tcpseg->getSackBlock(i).start << ":" << tcpseg->getSackBlock(i).end;
+    tcpEV << "\n";
     if (tcpseg->getUrgBit())  tcpEV << "urg " << tcpseg->getUrgentPointer() << " ";
 }
 
@@ -151,6 +158,8 @@ TCPConnection *TCPConnection::cloneListeningConnection()
     conn->tcpAlgorithm = check_and_cast<TCPAlgorithm *>(createOne(tcpAlgorithmClass));
     conn->tcpAlgorithm->setConnection(conn);
 
+    conn->sackScoreboard = new TCPSackScoreboard();
+
     conn->state = conn->tcpAlgorithm->getStateVariables();
     configureStateVariables();
     conn->tcpAlgorithm->initialize();
@@ -175,8 +184,11 @@ void TCPConnection::sendToIP(TCPSegment *tcpseg)
     // final touches on the segment before sending
     tcpseg->setSrcPort(localPort);
     tcpseg->setDestPort(remotePort);
-    tcpseg->setByteLength(TCP_HEADER_OCTETS+tcpseg->getPayloadLength());
-    // TBD account for Options (once they get implemented)
+    tcpseg->setByteLength(TCP_HEADER_OCTETS+tcpseg->getOptionsLength()+tcpseg->getPayloadLength());
+
+    // remember Last.ACK.sent for timestamps (RFC 1323)
+    if (tcpseg->getAckBit())
+        state->last_ack_sent = tcpseg->getAckNo();
 
     tcpEV << "Sending: ";
     printSegmentBrief(tcpseg);
@@ -301,6 +313,8 @@ void TCPConnection::initConnection(TCPOpenCommand *openCmd)
     tcpAlgorithm = check_and_cast<TCPAlgorithm *>(createOne(tcpAlgorithmClass));
     tcpAlgorithm->setConnection(this);
 
+    sackScoreboard = new TCPSackScoreboard();
+
     // create state block
     state = tcpAlgorithm->getStateVariables();
     configureStateVariables();
@@ -311,6 +325,18 @@ void TCPConnection::configureStateVariables()
 {
     state->snd_mss = tcpMain->par("mss").longValue(); // TODO: mss=-1 should mean autodetect
     state->rcv_wnd = tcpMain->par("advertisedWindow").longValue();
+    state->ws_support = tcpMain->par("windowScalingSupport");
+    state->ts_support = tcpMain->par("timestampSupport");
+    state->sack_support = tcpMain->par("sackSupport");
+
+    // windows above TCP_MAX_WIN can only be advertised with window scaling:
+    // choose the smallest shift count that makes rcv_wnd fit (RFC 1323)
+    if (state->rcv_wnd > ((uint32)TCP_MAX_WIN << (state->ws_support ? TCP_MAX_WIN_SCALE : 0)))
+        opp_error("advertisedWindow=%u is too large%s", state->rcv_wnd,
+                  state->ws_support ? "" : " without window scaling (see windowScalingSupport)");
+    state->rcv_wnd_scale = 0;
+    while ((state->rcv_wnd >> state->rcv_wnd_scale) > TCP_MAX_WIN)
+        state->rcv_wnd_scale++;
 }
 
 void TCPConnection::selectInitialSeqNum()
@@ -331,6 +357,113 @@ bool TCPConnection::isSegmentAcceptable(TCPSegment *tcpseg)
            seqLE(tcpseg->getSequenceNo()+tcpseg->getPayloadLength(),state->rcv_nxt+state->rcv_wnd);
 }
 
+void TCPConnection::processSynOptions(TCPSegment *tcpseg)
+{
+    // Window Scale (RFC 1323): windows are scaled in both directions if
+    // both SYNs carried the option; otherwise we're limited to TCP_MAX_WIN
+    state->ws_enabled = state->ws_support && tcpseg->getWindowScaleOption();
+    if (state->ws_enabled)
+    {
+        state->snd_wnd_scale = std::min((uint)tcpseg->getWindowScale(), (uint)TCP_MAX_WIN_SCALE);
+    }
+    else
+    {
+        state->snd_wnd_scale = state->rcv_wnd_scale = 0;
+        if (state->rcv_wnd > TCP_MAX_WIN)
+            state->rcv_wnd = TCP_MAX_WIN;
+    }
+
+    // Timestamps (RFC 1323): used if both SYNs carried the option
+    state->ts_enabled = state->ts_support && tcpseg->getTimestampOption();
+    if (state->ts_enabled)
+        state->ts_recent = tcpseg->getTsVal();
+
+    // SACK is used if we both send SACK-Permitted (RFC 2018)
+    state->sack_enabled = state->sack_support && tcpseg->getSackPermitted();
+}
+
+ulong TCPConnection::getScaledRcvWnd()
+{
+    return state->rcv_wnd >> state->rcv_wnd_scale;
+}
+
+void TCPConnection::addTimestampOption(TCPSegment *tcpseg)
+{
+    if (!state->ts_enabled)
+        return;
+
+    tcpseg->setTimestampOption(true);
+    tcpseg->setTsVal(convertSimtimeToTS(simTime()));
+    tcpseg->setTsEcr(state->ts_recent);
+}
+
+void TCPConnection::processTimestampOption(TCPSegment *tcpseg)
+{
+    // RFC 1323 section 3.4: echo the timestamp of the earliest segment not
+    // acked yet (i.e. don't update TS.Recent from segments above Last.ACK.sent,
+    // which may have been delayed ACKs or out-of-order). The tsVal check is
+    // from RFC 7323: don't let an old duplicate move TS.Recent backwards.
+    if (seqLE(tcpseg->getSequenceNo(), state->last_ack_sent) && seqGE(tcpseg->getTsVal(), state->ts_recent))
+        state->ts_recent = tcpseg->getTsVal();
+}
+
+uint32 TCPConnection::convertSimtimeToTS(simtime_t t)
+{
+    return (uint32)(int64)floor(SIMTIME_DBL(t)*1000);
+}
+
+simtime_t TCPConnection::convertTSToSimtime(uint32 ts)
+{
+    // count back from the current time, so that wraparound doesn't matter
+    int32 age = (int32)(convertSimtimeToTS(simTime()) - ts);
+    return simTime() - age/1000.0;
+}
+
+void TCPConnection::updateSackBlocks(uint32 seq)
+{
+    // RFC 2018: the first block must contain the most recently received
+    // segment, the others repeat the most recently reported blocks.
+    // Blocks that got cumulatively acked or merged into the first one are dropped.
+    std::vector<TCPSackBlock>& blocks = state->sack_blocks;
+    TCPSackBlock first;
+    bool isFirst = receiveQueue->getOutOfOrderBlock(seq, first.start, first.end);
+
+    unsigned int n = 0;
+    for (unsigned int i=0; i<blocks.size(); i++)
+    {
+        if (seqLE(blocks[i].end, state->rcv_nxt))
+            continue;
+        if (isFirst && seqLE(first.start, blocks[i].start) && seqLE(blocks[i].end, first.end))
+            continue;
+        blocks[n++] = blocks[i];
+    }
+    blocks.resize(n);
+
+    if (isFirst)
+        blocks.insert(blocks.begin(), first);
+
+    // no more blocks fit into the options (Timestamps takes 12 octets)
+    const unsigned int maxBlocks = (TCP_MAX_OPTIONS_OCTETS-(state->ts_enabled ? 12 : 0)-4)/8;
+    if (blocks.size() > maxBlocks)
+        blocks.resize(maxBlocks);
+}
+
+void TCPConnection::addSackOption(TCPSegment *tcpseg)
+{
+    if (!state->sack_enabled || state->sack_blocks.empty())
+        return;
+
+    // as many blocks as fit next to the other options
+    unsigned int optionsLength = tcpseg->getOptionsLength();
+    unsigned int n = optionsLength+4+8 > TCP_MAX_OPTIONS_OCTETS ? 0 : (TCP_MAX_OPTIONS_OCTETS-optionsLength-4)/8;
+    if (n > state->sack_blocks.size())
+        n = state->sack_blocks.size();
+
+    tcpseg->setSackBlockArraySize(n);
+    for (unsigned int i=0; i<n; i++)
+        tcpseg->setSackBlock(i, state->sack_blocks[i]);
+}
+
 void TCPConnection::sendSyn()
 {
     if (remoteAddr.isUnspecified() || remotePort==-1)
@@ -342,7 +475,12 @@ void TCPConnection::sendSyn()
     TCPSegment *tcpseg = createTCPSegment("SYN");
     tcpseg->setSequenceNo(state->iss);
     tcpseg->setSynBit(true);
-    tcpseg->setWindow(state->rcv_wnd);
+    tcpseg->setWindow(std::min(state->rcv_wnd, (uint32)TCP_MAX_WIN)); // never scaled in SYNs
+    tcpseg->setWindowScaleOption(state->ws_support);
+    tcpseg->setWindowScale(state->rcv_wnd_scale);
+    tcpseg->setTimestampOption(state->ts_support);
+    tcpseg->setTsVal(convertSimtimeToTS(simTime()));
+    tcpseg->setSackPermitted(state->sack_support);
 
     state->snd_max = state->snd_nxt = state->iss+1;
 
@@ -358,7 +496,11 @@ void TCPConnection::sendSynAck()
     tcpseg->setAckNo(state->rcv_nxt);
     tcpseg->setSynBit(true);
     tcpseg->setAckBit(true);
-    tcpseg->setWindow(state->rcv_wnd);
+    tcpseg->setWindow(std::min(state->rcv_wnd, (uint32)TCP_MAX_WIN)); // never scaled in SYNs
+    tcpseg->setWindowScaleOption(state->ws_enabled); // options only if the SYN had them
+    tcpseg->setWindowScale(state->rcv_wnd_scale);
+    addTimestampOption(tcpseg);
+    tcpseg->setSackPermitted(state->sack_enabled);
 
     state->snd_max = state->snd_nxt = state->iss+1;
 
@@ -408,7 +550,9 @@ void TCPConnection::sendAck()
     tcpseg->setAckBit(true);
     tcpseg->setSequenceNo(state->snd_nxt);
     tcpseg->setAckNo(state->rcv_nxt);
-    tcpseg->setWindow(state->rcv_wnd);
+    tcpseg->setWindow(getScaledRcvWnd());
+    addTimestampOption(tcpseg);
+    addSackOption(tcpseg);
 
     // send it
     sendToIP(tcpseg);
@@ -427,7 +571,9 @@ void TCPConnection::sendFin()
     tcpseg->setAckBit(true);
     tcpseg->setAckNo(state->rcv_nxt);
     tcpseg->setSequenceNo(state->snd_nxt);
-    tcpseg->setWindow(state->rcv_wnd);
+    tcpseg->setWindow(getScaledRcvWnd());
+    addTimestampOption(tcpseg);
+    addSackOption(tcpseg);
 
     // send it
     sendToIP(tcpseg);
@@ -442,7 +588,9 @@ void TCPConnection::sendSegment(int bytes)
     TCPSegment *tcpseg = sendQueue->createSegmentWithBytes(state->snd_nxt, bytes);
     tcpseg->setAckNo(state->rcv_nxt);
     tcpseg->setAckBit(true);
-    tcpseg->setWindow(state->rcv_wnd);
+    tcpseg->setWindow(getScaledRcvWnd());
+    addTimestampOption(tcpseg);
+    addSackOption(tcpseg);
     // TBD when to set PSH bit?
     // TBD set URG bit if needed
     ASSERT(bytes==tcpseg->getPayloadLength());
@@ -609,3 +757,18 @@ void TCPConnection::retransmitData()
 }
 
 
+
+void TCPConnection::retransmitSegment(uint32 seq, ulong bytes)
+{
+    state->snd_nxt = seq;
+
+    // the FIN takes up a sequence number but no data: if there's only the
+    // FIN left, sendSegment() will send it in an empty segment
+    bytes = std::min(bytes, sendQueue->getBytesAvailable(seq));
+    ASSERT(bytes!=0 || (state->send_fin && seq==state->snd_fin_seq));
+
+    sendSegment(bytes);
+
+    // notify
+    tcpAlgorithm->ackSent();
+}
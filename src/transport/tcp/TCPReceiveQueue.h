@@ -86,6 +86,15 @@ class INET_API TCPReceiveQueue : public cPolymorphic
      */
     virtual cPacket *extractBytesUpTo(uint32 seq) = 0;
 
+    /**
+     * Should return in start and end the contiguous block of data which
+     * contains seq and is stored above rcv_nxt (i.e. arrived out of order),
+     * or return false if seq is not in such a block. Used for generating
+     * SACK blocks (RFC 2018); the default implementation returns false,
+     * i.e. no SACK blocks will be sent.
+     */
+    virtual bool getOutOfOrderBlock(uint32 seq, uint32& start, uint32& end) {return false;}
+
 };
 
 #endif
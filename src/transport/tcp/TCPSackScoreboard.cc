@@ -0,0 +1,173 @@
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+
+
+#include "TCPSackScoreboard.h"
+
+// RFC 6675 DupThresh: number of SACKed ranges above a hole to consider it lost
+#define DUPTHRESH  3
+
+
+TCPSackScoreboard::TCPSackScoreboard()
+{
+}
+
+TCPSackScoreboard::~TCPSackScoreboard()
+{
+}
+
+std::string TCPSackScoreboard::info() const
+{
+    std::string res;
+    char buf[32];
+    for (RegionVector::const_iterator i=regions.begin(); i!=regions.end(); ++i)
+    {
+        sprintf(buf, "[%u..%u) ", i->begin, i->end);
+        res+=buf;
+    }
+    return res;
+}
+
+bool TCPSackScoreboard::addBlock(uint32 begin, uint32 end)
+{
+    // skip regions which fall entirely before the block (no overlap or touching)
+    RegionVector::iterator i = regions.begin();
+    while (i!=regions.end() && seqLess(i->end, begin))
+        ++i;
+
+    if (i==regions.end() || seqLess(end, i->begin))
+    {
+        // insert as a separate region before "i"
+        Region region;
+        region.begin = begin;
+        region.end = end;
+        regions.insert(i, region);
+        return true;
+    }
+
+    if (seqLE(i->begin, begin) && seqLE(end, i->end))
+        return false; // nothing new
+
+    if (seqLess(begin, i->begin))
+        i->begin = begin;
+
+    if (seqLess(i->end, end))
+    {
+        // extend region "i", and merge it with the next one(s) it now reaches
+        i->end = end;
+        RegionVector::iterator j = i+1;
+        while (j!=regions.end() && seqGE(i->end, j->begin))
+        {
+            if (seqLess(i->end, j->end))
+                i->end = j->end;
+            ++j;
+        }
+        regions.erase(i+1, j);
+    }
+    return true;
+}
+
+void TCPSackScoreboard::discardUpTo(uint32 seq)
+{
+    RegionVector::iterator i = regions.begin();
+    while (i!=regions.end() && seqLE(i->end, seq))
+        ++i;
+    regions.erase(regions.begin(), i);
+
+    if (!regions.empty() && seqLess(regions.front().begin, seq))
+        regions.front().begin = seq;
+}
+
+bool TCPSackScoreboard::isSacked(uint32 seq) const
+{
+    for (RegionVector::const_iterator i=regions.begin(); i!=regions.end(); ++i)
+    {
+        if (seqLess(seq, i->begin))
+            return false;
+        if (seqLess(seq, i->end))
+            return true;
+    }
+    return false;
+}
+
+uint32 TCPSackScoreboard::getHighestSackedSeq() const
+{
+    ASSERT(!regions.empty());
+    return regions.back().end;
+}
+
+bool TCPSackScoreboard::isLost(uint32 seq, uint32 mss) const
+{
+    int count = 0;
+    ulong sacked = 0;
+    for (RegionVector::const_reverse_iterator i=regions.rbegin(); i!=regions.rend() && seqGreater(i->begin, seq); ++i)
+    {
+        count++;
+        sacked += i->end - i->begin;
+        if (count >= DUPTHRESH || sacked > (DUPTHRESH-1)*mss)
+            return true;
+    }
+    return false;
+}
+
+ulong TCPSackScoreboard::getPipe(uint32 snd_una, uint32 snd_max, uint32 highRxt, uint32 mss) const
+{
+    // Walk the holes from the top down. The same ranges are SACKed above
+    // every octet of a hole, so IsLost() gives the same result for all of them.
+    ulong pipe = 0;
+    int count = 0;
+    ulong sacked = 0;
+    uint32 holeEnd = snd_max;
+    for (RegionVector::const_reverse_iterator i=regions.rbegin(); ; ++i)
+    {
+        uint32 holeBegin = i==regions.rend() ? snd_una : i->end;
+        if (seqLess(holeBegin, holeEnd))
+        {
+            // octets not lost are in flight...
+            bool lost = count >= DUPTHRESH || sacked > (DUPTHRESH-1)*mss;
+            if (!lost)
+                pipe += holeEnd - holeBegin;
+
+            // ...and so are their retransmissions
+            if (seqLess(holeBegin, highRxt))
+                pipe += (seqLess(highRxt, holeEnd) ? highRxt : holeEnd) - holeBegin;
+        }
+        if (i==regions.rend())
+            break;
+
+        count++;
+        sacked += i->end - i->begin;
+        holeEnd = i->begin;
+    }
+    return pipe;
+}
+
+bool TCPSackScoreboard::getNextHole(uint32 seq, uint32 limit, uint32& begin, uint32& end) const
+{
+    RegionVector::const_iterator i = regions.begin();
+    while (i!=regions.end() && seqLE(i->end, seq))
+        ++i;
+
+    if (i!=regions.end() && seqLE(i->begin, seq))
+    {
+        // seq is SACKed: the hole starts where its region ends
+        seq = i->end;
+        ++i;
+    }
+
+    begin = seq;
+    end = (i!=regions.end() && seqLess(i->begin, limit)) ? i->begin : limit;
+    return seqLess(begin, end);
+}
@@ -0,0 +1,119 @@
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef __INET_TCPSACKSCOREBOARD_H
+#define __INET_TCPSACKSCOREBOARD_H
+
+#include <vector>
+#include <string>
+#include <omnetpp.h>
+#include "TCPConnection.h"
+
+
+/**
+ * Sender side SACK scoreboard (RFC 6675): the ranges of sent data which
+ * the receiver has reported in SACK blocks. Everything not in these ranges
+ * between snd_una and snd_max is a "hole", i.e. data that is either still
+ * in flight or lost.
+ *
+ * TCPConnection updates the scoreboard from the SACK options of incoming
+ * ACKs, and discards the ranges that get cumulatively acked. TCPAlgorithm
+ * classes use it to perform loss recovery: IsLost(), SetPipe() and the
+ * retransmission rules of NextSeg() of RFC 6675 are built on isLost(),
+ * getPipe() and getNextHole().
+ *
+ * @see TCPSack
+ */
+class INET_API TCPSackScoreboard : public cPolymorphic
+{
+  protected:
+    struct Region
+    {
+        uint32 begin;
+        uint32 end;
+    };
+    typedef std::vector<Region> RegionVector;
+    RegionVector regions; // SACKed ranges in sequence order, neither overlapping nor touching
+
+  public:
+    /**
+     * Ctor.
+     */
+    TCPSackScoreboard();
+
+    /**
+     * Virtual dtor.
+     */
+    virtual ~TCPSackScoreboard();
+
+    /**
+     * Returns a string with the SACKed ranges.
+     */
+    virtual std::string info() const;
+
+    /**
+     * Forgets all SACK information.
+     */
+    virtual void clear() {regions.clear();}
+
+    /**
+     * Returns true if nothing has been SACKed.
+     */
+    virtual bool isEmpty() const {return regions.empty();}
+
+    /**
+     * Adds a SACK block [begin, end). Returns true if it reported data
+     * that had not been SACKed yet.
+     */
+    virtual bool addBlock(uint32 begin, uint32 end);
+
+    /**
+     * Discards the ranges below seq; to be called when snd_una advances.
+     */
+    virtual void discardUpTo(uint32 seq);
+
+    /**
+     * Returns true if the given octet has been SACKed.
+     */
+    virtual bool isSacked(uint32 seq) const;
+
+    /**
+     * Returns the end of the highest SACKed range. The scoreboard must
+     * not be empty.
+     */
+    virtual uint32 getHighestSackedSeq() const;
+
+    /**
+     * RFC 6675 IsLost(): returns true if the given unSACKed octet is
+     * considered lost, that is, DupThresh discontiguous ranges or more than
+     * (DupThresh-1)*mss octets above it have been SACKed.
+     */
+    virtual bool isLost(uint32 seq, uint32 mss) const;
+
+    /**
+     * RFC 6675 SetPipe(): returns the number of octets estimated to be in
+     * flight between snd_una and snd_max. Data below highRxt is known to
+     * have been retransmitted.
+     */
+    virtual ulong getPipe(uint32 snd_una, uint32 snd_max, uint32 highRxt, uint32 mss) const;
+
+    /**
+     * Finds the first range [begin, end) of unSACKed data at or above seq
+     * and below limit. Returns false if there is no such data.
+     */
+    virtual bool getNextHole(uint32 seq, uint32 limit, uint32& begin, uint32& end) const;
+};
+
+#endif
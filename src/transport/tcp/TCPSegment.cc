@@ -98,3 +98,18 @@ cPacket *TCPSegment::removeFirstPayloadMessage(uint32& endSequenceNo)
     return msg;
 }
 
+unsigned int TCPSegment::getOptionsLength() const
+{
+    // options are aligned with NOPs, like most implementations do
+    unsigned int length = 0;
+    if (getWindowScaleOption())
+        length += 4;  // NOP, kind=3, len=3, shift
+    if (getTimestampOption())
+        length += 12; // NOP, NOP, kind=8, len=10, TSval, TSecr
+    if (getSackPermitted())
+        length += 4;  // NOP, NOP, kind=4, len=2
+    if (getSackBlockArraySize()>0)
+        length += 4 + 8*getSackBlockArraySize();  // NOP, NOP, kind=5, len, blocks
+    return length;
+}
+
@@ -67,6 +67,12 @@ class INET_API TCPSegment : public TCPSegment_Base
      * It also returns the sequence number+1 of its last octet in outEndSequenceNo.
      */
     virtual cPacket *removeFirstPayloadMessage(uint32& outEndSequenceNo);
+
+    /**
+     * Returns the length of the \TCP options in this segment in octets,
+     * including the padding to a multiple of 4 octets.
+     */
+    virtual unsigned int getOptionsLength() const;
 };
 
 #endif
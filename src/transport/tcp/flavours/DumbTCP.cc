@@ -35,14 +35,15 @@ DumbTCP::~DumbTCP()
 {
     // cancel and delete timers
     if (rexmitTimer)
-        delete conn->getTcpMain()->cancelEvent(rexmitTimer);
+        delete conn->getTcpMain()->cancelTimer(rexmitTimer);
 }
 
 void DumbTCP::initialize()
 {
     TCPAlgorithm::initialize();
 
-    rexmitTimer = new cMessage("REXMIT");
+    rexmitTimer = new TCPTimer("REXMIT");
+    rexmitTimer->setContextPointer(conn);
 }
 
 void DumbTCP::established(bool active)
@@ -58,7 +59,7 @@ void DumbTCP::established(bool active)
 
 void DumbTCP::connectionClosed()
 {
-    conn->getTcpMain()->cancelEvent(rexmitTimer);
+    conn->getTcpMain()->cancelTimer(rexmitTimer);
 }
 
 void DumbTCP::processTimer(cMessage *timer, TCPEventCode& event)
@@ -114,9 +115,14 @@ void DumbTCP::ackSent()
 
 void DumbTCP::dataSent(uint32)
 {
-    if (rexmitTimer->isScheduled())
-        conn->getTcpMain()->cancelEvent(rexmitTimer);
+    if (conn->isTimerScheduled(rexmitTimer))
+        conn->getTcpMain()->cancelTimer(rexmitTimer);
     conn->scheduleTimeout(rexmitTimer, REXMIT_TIMEOUT);
 }
 
+void DumbTCP::rttMeasurementCompleteUsingTS(uint32 echoedTS)
+{
+    // no RTT estimation (fixed REXMIT_TIMEOUT)
+}
+
 
@@ -82,6 +82,8 @@ class INET_API DumbTCP : public TCPAlgorithm
 
     virtual void dataSent(uint32 fromseq);
 
+    virtual void rttMeasurementCompleteUsingTS(uint32 echoedTS);
+
 };
 
 #endif
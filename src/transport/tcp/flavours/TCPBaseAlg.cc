@@ -116,10 +116,10 @@ void TCPBaseAlg::initialize()
 {
     TCPAlgorithm::initialize();
 
-    rexmitTimer = new cMessage("REXMIT");
-    persistTimer = new cMessage("PERSIST");
-    delayedAckTimer = new cMessage("DELAYEDACK");
-    keepAliveTimer = new cMessage("KEEPALIVE");
+    rexmitTimer = new TCPTimer("REXMIT");
+    persistTimer = new TCPTimer("PERSIST");
+    delayedAckTimer = new TCPTimer("DELAYEDACK");
+    keepAliveTimer = new TCPTimer("KEEPALIVE");
 
     rexmitTimer->setContextPointer(conn);
     persistTimer->setContextPointer(conn);
@@ -337,7 +337,7 @@ void TCPBaseAlg::receiveSeqChanged()
         // FIXME ACK should be generated for at least every second SMSS-sized segment!
         // schedule delayed ACK timer if not already running
         tcpEV << "rcv_nxt changed to " << state->rcv_nxt << ", scheduling ACK\n";
-        if (!delayedAckTimer->isScheduled())
+        if (!conn->isTimerScheduled(delayedAckTimer))
             conn->scheduleTimeout(delayedAckTimer, DELAYED_ACK_TIMEOUT);
     }
 }
@@ -365,7 +365,7 @@ void TCPBaseAlg::receivedDataAck(uint32 firstSeqAcked)
     //
     if (state->snd_una==state->snd_max)
     {
-        if (rexmitTimer->isScheduled())
+        if (conn->isTimerScheduled(rexmitTimer))
         {
             tcpEV << "ACK acks all outstanding segments, cancel REXMIT timer\n";
             cancelEvent(rexmitTimer);
@@ -415,21 +415,22 @@ void TCPBaseAlg::receivedAckForDataNotYetSent(uint32 seq)
 void TCPBaseAlg::ackSent()
 {
     // if delayed ACK timer is running, cancel it
-    if (delayedAckTimer->isScheduled())
+    if (conn->isTimerScheduled(delayedAckTimer))
         cancelEvent(delayedAckTimer);
 }
 
 void TCPBaseAlg::dataSent(uint32 fromseq)
 {
     // if retransmission timer not running, schedule it
-    if (!rexmitTimer->isScheduled())
+    if (!conn->isTimerScheduled(rexmitTimer))
     {
         tcpEV << "Starting REXMIT timer\n";
         startRexmitTimer();
     }
 
-    // start round-trip time measurement (if not already running)
-    if (state->rtseq_sendtime==0)
+    // start round-trip time measurement (if not already running, and
+    // timestamps don't do it for us)
+    if (state->rtseq_sendtime==0 && !state->ts_enabled)
     {
         // remember this sequence number and when it was sent
         state->rtseq = fromseq;
@@ -438,5 +439,13 @@ void TCPBaseAlg::dataSent(uint32 fromseq)
     }
 }
 
+void TCPBaseAlg::rttMeasurementCompleteUsingTS(uint32 echoedTS)
+{
+    // the echoed timestamp is that of the segment which triggered the ACK
+    // (or, with delayed ACKs, the earliest one acked), so retransmissions
+    // don't make the sample ambiguous (no need for Karn's algorithm)
+    rttMeasurementComplete(conn->convertTSToSimtime(echoedTS), simTime());
+}
+
 
 
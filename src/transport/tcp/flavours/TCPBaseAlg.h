@@ -129,7 +129,7 @@ class INET_API TCPBaseAlg : public TCPAlgorithm
     virtual bool sendData();
 
     /** Utility function */
-    cMessage *cancelEvent(cMessage *msg)  {return conn->getTcpMain()->cancelEvent(msg);}
+    cMessage *cancelEvent(cMessage *msg)  {return conn->getTcpMain()->cancelTimer(msg);}
 
   public:
     /**
@@ -172,6 +172,11 @@ class INET_API TCPBaseAlg : public TCPAlgorithm
 
     virtual void dataSent(uint32 fromseq);
 
+    /**
+     * Update RTT estimate from the echoed timestamp.
+     */
+    virtual void rttMeasurementCompleteUsingTS(uint32 echoedTS);
+
 };
 
 #endif
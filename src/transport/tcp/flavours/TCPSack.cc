@@ -0,0 +1,232 @@
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+
+
+#include <algorithm>   // min,max
+#include "TCPSack.h"
+#include "TCPSackScoreboard.h"
+#include "TCP.h"
+
+
+Register_Class(TCPSack);
+
+#define DUPTHRESH  3   // number of duplicate ACKs that trigger loss recovery
+
+
+TCPSackStateVariables::TCPSackStateVariables()
+{
+    recovery = false;
+    recovery_point = 0;
+    high_rxt = 0;
+}
+
+std::string TCPSackStateVariables::info() const
+{
+    std::stringstream out;
+    out << TCPRenoStateVariables::info();
+    if (recovery)
+        out << " recovery_point=" << recovery_point << " high_rxt=" << high_rxt;
+    return out.str();
+}
+
+std::string TCPSackStateVariables::detailedInfo() const
+{
+    std::stringstream out;
+    out << TCPRenoStateVariables::detailedInfo();
+    out << "recovery = " << recovery << "\n";
+    out << "recovery_point = " << recovery_point << "\n";
+    out << "high_rxt = " << high_rxt << "\n";
+    return out.str();
+}
+
+TCPSack::TCPSack() : TCPReno(),
+  state((TCPSackStateVariables *&)TCPAlgorithm::state)
+{
+}
+
+void TCPSack::established(bool active)
+{
+    // loss recovery may be entered from the first ACK on
+    state->recovery_point = state->high_rxt = state->snd_una;
+
+    TCPReno::established(active);
+}
+
+void TCPSack::retransmitSegment(uint32 seq, ulong bytes)
+{
+    conn->retransmitSegment(seq, bytes);
+    if (seqLess(state->high_rxt, state->snd_nxt))
+        state->high_rxt = state->snd_nxt;
+}
+
+void TCPSack::processRexmitTimer(TCPEventCode& event)
+{
+    if (!state->sack_enabled)
+    {
+        TCPReno::processRexmitTimer(event);
+        return;
+    }
+
+    TCPTahoeRenoFamily::processRexmitTimer(event);
+    if (event==TCP_E_ABORT)
+        return;
+
+    // begin Slow Start (RFC2001)
+    recalculateSlowStartThreshold();
+    state->snd_cwnd = state->snd_mss;
+    if (cwndVector) cwndVector->record(state->snd_cwnd);
+    tcpEV << "Begin Slow Start: resetting cwnd to " << state->snd_cwnd
+          << ", ssthresh=" << state->ssthresh << "\n";
+
+    // RFC 6675 section 5.1: terminate loss recovery, and don't start
+    // a new one until everything outstanding now is acked
+    state->recovery = false;
+    state->recovery_point = state->snd_max;
+
+    // Like Reno, retransmit all data, but skip what the receiver has SACKed.
+    // (Our receive queues never discard out-of-order data, so the SACK
+    // information can be trusted after the timeout too.)
+    TCPSackScoreboard *scoreboard = conn->getSackScoreboard();
+    uint32 begin, end;
+    uint32 seq = state->snd_una;
+    while (scoreboard->getNextHole(seq, state->snd_max, begin, end))
+    {
+        for (seq = begin; seqLess(seq, end); seq = state->snd_nxt)
+            retransmitSegment(seq, std::min((ulong)state->snd_mss, (ulong)(end - seq)));
+    }
+}
+
+void TCPSack::receivedDataAck(uint32 firstSeqAcked)
+{
+    if (!state->sack_enabled || !state->recovery)
+    {
+        // dupacks mean Fast Recovery for Reno; with SACK, loss recovery
+        // is tracked by state->recovery
+        if (state->sack_enabled)
+            state->dupacks = 0;
+        TCPReno::receivedDataAck(firstSeqAcked);
+        return;
+    }
+
+    TCPTahoeRenoFamily::receivedDataAck(firstSeqAcked);
+
+    if (seqGE(state->snd_una, state->recovery_point))
+    {
+        // everything outstanding at the start of loss recovery has been
+        // acked; cwnd is already ssthresh
+        tcpEV << "SACK loss recovery finished, cwnd=" << state->snd_cwnd << "\n";
+        state->recovery = false;
+        sendData();
+    }
+    else
+    {
+        // partial ACK: continue loss recovery
+        if (seqLess(state->high_rxt, state->snd_una))
+            state->high_rxt = state->snd_una;
+        sendDataDuringLossRecovery();
+    }
+}
+
+void TCPSack::receivedDuplicateAck()
+{
+    if (!state->sack_enabled)
+    {
+        TCPReno::receivedDuplicateAck();
+        return;
+    }
+
+    TCPTahoeRenoFamily::receivedDuplicateAck();
+
+    if (state->recovery)
+    {
+        // the ACK may have SACKed data, i.e. taken it out of the pipe
+        sendDataDuringLossRecovery();
+        return;
+    }
+
+    // RFC 6675 section 5: enter loss recovery on DupThresh duplicate ACKs,
+    // or if the scoreboard already shows the first segment lost -- unless
+    // we are still recovering from the previous loss
+    TCPSackScoreboard *scoreboard = conn->getSackScoreboard();
+    if ((state->dupacks < DUPTHRESH && !scoreboard->isLost(state->snd_una, state->snd_mss)) ||
+        seqLess(state->snd_una, state->recovery_point))
+        return;
+
+    state->recovery = true;
+    state->recovery_point = state->snd_max;
+    state->high_rxt = state->snd_una;
+
+    recalculateSlowStartThreshold();
+    state->snd_cwnd = state->ssthresh;
+    if (cwndVector) cwndVector->record(state->snd_cwnd);
+
+    tcpEV << "SACK on dupAck=" << state->dupacks << ": entering loss recovery, recovery_point="
+          << state->recovery_point << ", cwnd=ssthresh=" << state->ssthresh << "\n";
+
+    // retransmit the first segment right away, whatever the pipe is
+    uint32 begin, end;
+    if (scoreboard->getNextHole(state->snd_una, state->snd_max, begin, end))
+        retransmitSegment(begin, std::min((ulong)state->snd_mss, (ulong)(end - begin)));
+
+    // restart retransmission timer, and cancel round-trip time measurement (like Reno)
+    cancelEvent(rexmitTimer);
+    startRexmitTimer();
+    state->rtseq_sendtime = 0;
+
+    sendDataDuringLossRecovery();
+}
+
+void TCPSack::sendDataDuringLossRecovery()
+{
+    TCPSackScoreboard *scoreboard = conn->getSackScoreboard();
+    ulong pipe = scoreboard->getPipe(state->snd_una, state->snd_max, state->high_rxt, state->snd_mss);
+    tcpEV << "SACK loss recovery: cwnd=" << state->snd_cwnd << ", pipe=" << pipe
+          << ", scoreboard: " << scoreboard->info() << "\n";
+
+    // RFC 6675 NextSeg(): send while cwnd-pipe is at least one segment
+    while (pipe + state->snd_mss <= state->snd_cwnd)
+    {
+        // the first hole above what we have already retransmitted, if it
+        // is below SACKed data
+        uint32 begin, end;
+        uint32 seq = seqLess(state->snd_una, state->high_rxt) ? state->high_rxt : state->snd_una;
+        bool isHole = !scoreboard->isEmpty() &&
+                      scoreboard->getNextHole(seq, scoreboard->getHighestSackedSeq(), begin, end);
+        ulong bytes = isHole ? std::min((ulong)state->snd_mss, (ulong)(end - begin)) : 0;
+        uint32 old_snd_max = state->snd_max;
+
+        if (isHole && scoreboard->isLost(begin, state->snd_mss))
+        {
+            // rule (1): retransmit lost data (holes above this one are not
+            // lost if this one isn't, as less data is SACKed above them)
+            retransmitSegment(begin, bytes);
+        }
+        else if (conn->sendData(false, state->snd_max - state->snd_una + state->snd_mss))
+        {
+            // rule (2): one segment of new data, if the advertised window allows
+            bytes = state->snd_max - old_snd_max;
+        }
+        else if (isHole)
+        {
+            // rule (3): retransmit data which is not yet considered lost
+            retransmitSegment(begin, bytes);
+        }
+        else
+        {
+            break;
+        }
+        pipe += bytes;
+    }
+}
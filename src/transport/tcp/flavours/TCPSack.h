@@ -0,0 +1,87 @@
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef __INET_TCPSACK_H
+#define __INET_TCPSACK_H
+
+#include <omnetpp.h>
+#include "TCPReno.h"
+
+
+/**
+ * State variables for TCPSack.
+ */
+class INET_API TCPSackStateVariables : public TCPRenoStateVariables
+{
+  public:
+    TCPSackStateVariables();
+    virtual std::string info() const;
+    virtual std::string detailedInfo() const;
+
+    bool recovery;          ///< whether loss recovery is in progress
+    uint32 recovery_point;  ///< snd_max at the start of loss recovery (RFC 6675 RecoveryPoint)
+    uint32 high_rxt;        ///< end of the highest retransmitted data (RFC 6675 HighRxt)
+};
+
+
+/**
+ * Implements TCP Reno with SACK-based loss recovery as described in
+ * RFC 6675 ("conservative" loss recovery): after the third duplicate ACK
+ * or when the scoreboard shows a loss, cwnd is halved, and then segments
+ * are sent whenever the estimated number of bytes in flight (the "pipe")
+ * allows. Holes reported lost are retransmitted first, then new data,
+ * then other holes. This way several lost segments are repaired in one
+ * round trip, without waiting for the retransmission timer.
+ *
+ * After a retransmission timeout, only the data not SACKed by the
+ * receiver is retransmitted.
+ *
+ * If SACK was not negotiated on the connection (see TCP's sackSupport
+ * parameter), the behaviour is that of TCPReno.
+ */
+class INET_API TCPSack : public TCPReno
+{
+  protected:
+    TCPSackStateVariables *&state; // alias to TCLAlgorithm's 'state'
+
+    /** Create and return a TCPSackStateVariables object. */
+    virtual TCPStateVariables *createStateVariables() {
+        return new TCPSackStateVariables();
+    }
+
+    /** Redefine what should happen on retransmission */
+    virtual void processRexmitTimer(TCPEventCode& event);
+
+    /** Utility function: retransmit a segment, and update high_rxt */
+    virtual void retransmitSegment(uint32 seq, ulong bytes);
+
+    /** Utility function: send as many segments as cwnd and the pipe allow (RFC 6675 NextSeg()) */
+    virtual void sendDataDuringLossRecovery();
+
+  public:
+    /** Ctor */
+    TCPSack();
+
+    /** Redefine to initialize loss recovery state */
+    virtual void established(bool active);
+
+    /** Redefine what should happen when data got acked, to leave or continue loss recovery */
+    virtual void receivedDataAck(uint32 firstSeqAcked);
+
+    /** Redefine what should happen when dupAck was received, to enter or continue loss recovery */
+    virtual void receivedDuplicateAck();
+};
+
+#endif
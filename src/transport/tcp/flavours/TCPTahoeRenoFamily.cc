@@ -15,6 +15,7 @@
 // along with this program; if not, see <http://www.gnu.org/licenses/>.
 //
 
+#include <algorithm>   // min,max
 #include "TCPTahoeRenoFamily.h"
 #include "TCP.h"
 
@@ -48,4 +49,16 @@ TCPTahoeRenoFamily::TCPTahoeRenoFamily() : TCPBaseAlg(),
 {
 }
 
+void TCPTahoeRenoFamily::established(bool active)
+{
+    // The initial ssthresh should be arbitrarily high, e.g. the largest
+    // window the receiver can advertise (RFC 2581). Without window scaling
+    // that's the 65535 set in the ctor; with scaling, keeping 65535 would
+    // end slow start far below the bandwidth-delay product.
+    if (state->ws_enabled)
+        state->ssthresh = std::max(state->ssthresh, (uint)TCP_MAX_WIN << state->snd_wnd_scale);
+
+    TCPBaseAlg::established(active);
+}
+
 
@@ -48,6 +48,9 @@ class INET_API TCPTahoeRenoFamily : public TCPBaseAlg
   public:
     /** Ctor */
     TCPTahoeRenoFamily();
+
+    /** Redefine to raise the initial ssthresh if window scaling is in effect */
+    virtual void established(bool active);
 };
 
 #endif
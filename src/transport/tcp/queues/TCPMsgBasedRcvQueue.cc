@@ -40,12 +40,7 @@ std::string TCPMsgBasedRcvQueue::info() const
     char buf[32];
     sprintf(buf, "rcv_nxt=%u ", rcv_nxt);
     res = buf;
-
-    for (RegionList::const_iterator i=regionList.begin(); i!=regionList.end(); ++i)
-    {
-        sprintf(buf, "[%u..%u) ", i->begin, i->end);
-        res+=buf;
-    }
+    res += regions.info();
     sprintf(buf, "%u msgs", payloadList.size());
     res+=buf;
 
@@ -61,9 +56,8 @@ uint32 TCPMsgBasedRcvQueue::insertBytesFromSegment(TCPSegment *tcpseg)
     while ((msg=tcpseg->removeFirstPayloadMessage(endSeqNo))!=NULL)
     {
         // insert, avoiding duplicates
-        PayloadList::iterator i = payloadList.find(endSeqNo);
-        if (i!=payloadList.end()) {delete msg; continue;}
-        payloadList[endSeqNo] = msg;
+        if (!payloadList.insert(PayloadList::value_type(endSeqNo, msg)).second)
+            delete msg;
     }
 
     return rcv_nxt;
@@ -32,7 +32,8 @@
 class INET_API TCPMsgBasedRcvQueue : public TCPVirtualDataRcvQueue
 {
   protected:
-    typedef std::map<uint32, cPacket *> PayloadList;
+    // payload messages by the sequence number of their last byte+1
+    typedef std::map<uint32, cPacket *, SeqLess, PooledAllocator<std::pair<const uint32, cPacket *> > > PayloadList;
     PayloadList payloadList;
 
   public:
@@ -0,0 +1,128 @@
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+
+
+#include "TCPRegionSet.h"
+
+
+void TCPRegionSet::merge(uint32 segmentBegin, uint32 segmentEnd)
+{
+    if (!seqLess(segmentBegin, segmentEnd))
+        return;
+
+    if (regions.empty())
+    {
+        regions.insert(Region(segmentBegin, segmentEnd));
+        return;
+    }
+
+    // Find the region which will absorb the segment: the last one starting
+    // at or before it, if it overlaps or touches the segment; otherwise
+    // the segment becomes a new region. In-order data (extending the first
+    // region) and data past the last region are the common cases, check
+    // them before searching the tree.
+    RegionMap::iterator i = regions.begin();
+    RegionMap::iterator next;
+    RegionMap::iterator last = --regions.end();
+    if (seqLE(i->first, segmentBegin) && seqLE(segmentBegin, i->second))
+    {
+        next = i;
+        ++next;
+    }
+    else if (seqLE(last->first, segmentBegin))
+    {
+        if (seqLess(last->second, segmentBegin))
+            regions.insert(regions.end(), Region(segmentBegin, segmentEnd));
+        else if (seqLess(last->second, segmentEnd))
+            last->second = segmentEnd;
+        return;
+    }
+    else
+    {
+        next = regions.upper_bound(segmentBegin);
+        i = next;
+        if (i==regions.begin() || seqLess((--i)->second, segmentBegin))
+            i = regions.end();
+    }
+
+    if (i==regions.end())
+        i = regions.insert(next, Region(segmentBegin, segmentEnd));
+    else if (seqLess(i->second, segmentEnd))
+        i->second = segmentEnd;
+    else
+        return; // nothing new
+
+    // merge region "i" with following one(s) which it now overlaps or touches
+    while (next!=regions.end() && seqGE(i->second, next->first))
+    {
+        if (seqLess(i->second, next->second))
+            i->second = next->second;
+        regions.erase(next++);
+    }
+}
+
+ulong TCPRegionSet::extractTo(uint32 seq)
+{
+    if (regions.empty())
+        return 0;
+
+    RegionMap::iterator i = regions.begin();
+    ASSERT(seqLess(i->first, i->second)); // empty regions cannot exist
+
+    // seq below 1st region
+    if (seqLE(seq, i->first))
+        return 0;
+
+    ulong octets;
+    if (seqLess(seq, i->second))
+    {
+        // part of 1st region: the key changes, so re-insert it (at the
+        // front, i.e. in amortized constant time)
+        octets = seq - i->first;
+        uint32 end = i->second;
+        regions.erase(i);
+        regions.insert(regions.begin(), Region(seq, end));
+    }
+    else
+    {
+        // full 1st region
+        octets = i->second - i->first;
+        regions.erase(i);
+    }
+    return octets;
+}
+
+bool TCPRegionSet::getRegionContaining(uint32 seq, uint32& start, uint32& end) const
+{
+    RegionMap::const_iterator i = regions.upper_bound(seq);
+    if (i==regions.begin() || !seqLess(seq, (--i)->second))
+        return false;
+    start = i->first;
+    end = i->second;
+    return true;
+}
+
+std::string TCPRegionSet::info() const
+{
+    std::string res;
+    char buf[32];
+    for (RegionMap::const_iterator i=regions.begin(); i!=regions.end(); ++i)
+    {
+        sprintf(buf, "[%u..%u) ", i->first, i->second);
+        res+=buf;
+    }
+    return res;
+}
+
@@ -0,0 +1,101 @@
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef __INET_TCPREGIONSET_H
+#define __INET_TCPREGIONSET_H
+
+#include <map>
+#include <string>
+#include "TCPConnection.h"
+#include "PooledAllocator.h"
+
+/**
+ * Set of received sequence number ranges, for reassembly in the TCP
+ * receive queues. Ranges are half-open [begin,end) intervals; they are
+ * merged on insertion, so stored regions never overlap or touch.
+ *
+ * Regions are kept in a balanced tree keyed by their begin sequence
+ * number and ordered modulo 2^32 (see SeqLess), so all of them must lie
+ * within 2^31 bytes of each other -- this holds for data inside the
+ * receive window. Inserting a range is O(log n) (plus the cost of
+ * erasing the regions it absorbs); the first region, the in-order data,
+ * is accessed in O(1). Tree nodes come from a PooledAllocator.
+ */
+class INET_API TCPRegionSet
+{
+  protected:
+    typedef std::pair<const uint32, uint32> Region; // begin, end
+    typedef std::map<uint32, uint32, SeqLess, PooledAllocator<Region> > RegionMap;
+    RegionMap regions;
+
+  public:
+    typedef RegionMap::const_iterator const_iterator;
+
+    /**
+     * Returns true if no data are stored.
+     */
+    bool empty() const {return regions.empty();}
+
+    /**
+     * Returns the number of regions.
+     */
+    int size() const {return regions.size();}
+
+    /**
+     * Removes all regions.
+     */
+    void clear() {regions.clear();}
+
+    /**
+     * Iteration over the regions in sequence number order; it->first is
+     * the begin, it->second the end of the region.
+     */
+    const_iterator begin() const {return regions.begin();}
+    const_iterator end() const {return regions.end();}
+
+    /**
+     * Begin and end of the first (lowest) region. Must not be called
+     * on an empty set.
+     */
+    uint32 getFirstBegin() const {return regions.begin()->first;}
+    uint32 getFirstEnd() const {return regions.begin()->second;}
+
+    /**
+     * Adds the range [begin,end), merging it with the regions it overlaps
+     * or touches. Empty ranges are ignored.
+     */
+    void merge(uint32 begin, uint32 end);
+
+    /**
+     * Removes the bytes below seq from the first region, and returns
+     * their number. seq must not be past the end of the first region.
+     */
+    ulong extractTo(uint32 seq);
+
+    /**
+     * Returns in start and end the region which contains seq, or returns
+     * false if there is none.
+     */
+    bool getRegionContaining(uint32 seq, uint32& start, uint32& end) const;
+
+    /**
+     * Returns the regions as a string, e.g. "[100..200) [300..400) ".
+     */
+    std::string info() const;
+};
+
+#endif
+
+
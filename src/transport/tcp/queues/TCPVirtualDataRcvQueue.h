@@ -18,31 +18,25 @@
 #ifndef __INET_TCPVIRTUALDATARCVQUEUE_H
 #define __INET_TCPVIRTUALDATARCVQUEUE_H
 
-#include <list>
 #include <string>
 #include "TCPSegment.h"
 #include "TCPReceiveQueue.h"
+#include "TCPRegionSet.h"
 
 /**
  * Receive queue that manages "virtual bytes", that is, byte counts only.
  *
+ * Received byte ranges are kept in a TCPRegionSet, so out-of-order
+ * segments are merged in logarithmic time, and sequence number
+ * wraparound is handled.
+ *
  * @see TCPVirtualDataSendQueue
  */
 class INET_API TCPVirtualDataRcvQueue : public TCPReceiveQueue
 {
   protected:
     uint32 rcv_nxt;
-
-    struct Region
-    {
-        uint32 begin;
-        uint32 end;
-    };
-    typedef std::list<Region> RegionList;
-    RegionList regionList;
-
-    // merges segment byte range into regionList
-    void merge(uint32 segmentBegin, uint32 segmentEnd);
+    TCPRegionSet regions;  // received byte ranges not yet passed up
 
     // returns number of bytes extracted
     ulong extractTo(uint32 toSeq);
@@ -78,6 +72,11 @@ class INET_API TCPVirtualDataRcvQueue : public TCPReceiveQueue
      */
     virtual cPacket *extractBytesUpTo(uint32 seq);
 
+    /**
+     * Returns the out-of-order region containing seq.
+     */
+    virtual bool getOutOfOrderBlock(uint32 seq, uint32& start, uint32& end);
+
 };
 
 #endif
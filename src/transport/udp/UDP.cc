@@ -24,6 +24,7 @@
 
 #include <omnetpp.h>
 #include <string.h>
+#include <algorithm>
 #include "UDPPacket.h"
 #include "UDP.h"
 #include "IPControlInfo.h"
@@ -70,6 +71,67 @@ static std::ostream & operator<<(std::ostream & os, const UDP::SockDescList& lis
     return os;
 }
 
+static bool bindSeqLess(const UDP::SockDesc *a, const UDP::SockDesc *b)
+{
+    return a->bindSeq < b->bindSeq;
+}
+
+//--------
+
+UDP::ConnectedSocketTable::ConnectedSocketTable()
+{
+    buckets.resize(16, NULL);
+    count = 0;
+}
+
+uint32 UDP::ConnectedSocketTable::hash(short localPort, const IPvXAddress& remoteAddr, short remotePort)
+{
+    uint32 h = remoteAddr.hash();
+    h ^= ((uint32)(unsigned short)localPort << 16) | (unsigned short)remotePort;
+    h *= 0x9e3779b1U;
+    return h ^ (h>>16);
+}
+
+void UDP::ConnectedSocketTable::grow()
+{
+    std::vector<SockDesc *> old(buckets.size()*2, (SockDesc *)NULL);
+    old.swap(buckets);
+    int mask = buckets.size() - 1;
+    for (unsigned int i=0; i<old.size(); i++)
+    {
+        for (SockDesc *sd = old[i], *next; sd; sd = next)
+        {
+            next = sd->nextInHash;
+            SockDesc *& head = buckets[hash(sd->localPort, sd->remoteAddr, sd->remotePort) & mask];
+            sd->nextInHash = head;
+            head = sd;
+        }
+    }
+}
+
+void UDP::ConnectedSocketTable::insert(SockDesc *sd)
+{
+    if (count+1 > (int)buckets.size())
+        grow();
+    SockDesc *& head = buckets[hash(sd->localPort, sd->remoteAddr, sd->remotePort) & (buckets.size()-1)];
+    sd->nextInHash = head;
+    head = sd;
+    count++;
+}
+
+void UDP::ConnectedSocketTable::erase(SockDesc *sd)
+{
+    SockDesc **p = &buckets[hash(sd->localPort, sd->remoteAddr, sd->remotePort) & (buckets.size()-1)];
+    while (*p != sd)
+    {
+        ASSERT(*p != NULL);
+        p = &(*p)->nextInHash;
+    }
+    *p = sd->nextInHash;
+    sd->nextInHash = NULL;
+    count--;
+}
+
 //--------
 
 UDP::~UDP()
@@ -84,6 +146,7 @@ void UDP::initialize()
     WATCH_MAP(socketsByPortMap);
 
     lastEphemeralPort = EPHEMERAL_PORTRANGE_START;
+    lastBindSeq = 0;
     icmp = NULL;
     icmpv6 = NULL;
 
@@ -111,6 +174,8 @@ void UDP::bind(int gateIndex, UDPControlInfo *ctrl)
     sd->localPort = ctrl->getSrcPort();
     sd->remotePort = ctrl->getDestPort();
     sd->interfaceId = ctrl->getInterfaceId();
+    sd->bindSeq = ++lastBindSeq;
+    sd->nextInHash = NULL;
 
     if (sd->sockId==-1)
         error("sockId in BIND message not filled in");
@@ -131,6 +196,8 @@ void UDP::bind(int gateIndex, UDPControlInfo *ctrl)
     // add to socketsByPortMap
     SockDescList& list = socketsByPortMap[sd->localPort]; // create if doesn't exist
     list.push_back(sd);
+
+    addToDemuxTables(sd);
 }
 
 void UDP::connect(int sockId, IPvXAddress addr, int port)
@@ -144,10 +211,12 @@ void UDP::connect(int sockId, IPvXAddress addr, int port)
         opp_error("connect: invalid remote port number %d", port);
 
     SockDesc *sd = it->second;
+    removeFromDemuxTables(sd);
     sd->remoteAddr = addr;
     sd->remotePort = port;
 
     sd->onlyLocalPortIsSet = false;
+    addToDemuxTables(sd);
 
     EV << "Connecting socket: " << *sd << "\n";
 }
@@ -170,9 +239,42 @@ void UDP::unbind(int sockId)
             {list.erase(it); break;}
     if (list.empty())
         socketsByPortMap.erase(sd->localPort);
+
+    removeFromDemuxTables(sd);
     delete sd;
 }
 
+bool UDP::isConnectedSocket(SockDesc *sd)
+{
+    return !sd->remoteAddr.isUnspecified() && sd->remotePort!=0 && sd->interfaceId==-1;
+}
+
+void UDP::addToDemuxTables(SockDesc *sd)
+{
+    if (isConnectedSocket(sd))
+        connectedSockets.insert(sd);
+    else
+        wildcardSocketsByPortMap[sd->localPort].push_back(sd);
+}
+
+void UDP::removeFromDemuxTables(SockDesc *sd)
+{
+    if (isConnectedSocket(sd))
+    {
+        connectedSockets.erase(sd);
+        return;
+    }
+
+    SocketsByPortMap::iterator it = wildcardSocketsByPortMap.find(sd->localPort);
+    ASSERT(it!=wildcardSocketsByPortMap.end());
+    SockDescList& list = it->second;
+    for (SockDescList::iterator i=list.begin(); i!=list.end(); ++i)
+        if (*i == sd)
+            {list.erase(i); break;}
+    if (list.empty())
+        wildcardSocketsByPortMap.erase(it);
+}
+
 short UDP::getEphemeralPort()
 {
     // start at the last allocated port number + 1, and search for an unused one
@@ -309,7 +411,7 @@ void UDP::processUndeliverablePacket(UDPPacket *udpPacket, cPolymorphic *ctrl)
         if (!ctrl4->getDestAddr().isMulticast())
             icmp->sendErrorMessage(udpPacket, ctrl4, ICMP_DESTINATION_UNREACHABLE, ICMP_DU_PORT_UNREACHABLE);
     }
-    else if (dynamic_cast<IPv6ControlInfo *>(udpPacket->getControlInfo())!=NULL)
+    else if (dynamic_cast<IPv6ControlInfo *>(ctrl)!=NULL)
     {
         if (!icmpv6)
             icmpv6 = ICMPv6Access().get();
@@ -421,48 +523,57 @@ void UDP::processUDPPacket(UDPPacket *udpPacket)
     }
 
     int destPort = udpPacket->getDestinationPort();
+    int srcPort = udpPacket->getSourcePort();
     cPolymorphic *ctrl = udpPacket->removeControlInfo();
 
-    // send back ICMP error if no socket is bound to that port
-    SocketsByPortMap::iterator it = socketsByPortMap.find(destPort);
-    if (it==socketsByPortMap.end())
-    {
-        EV << "No socket registered on port " << destPort << "\n";
-        processUndeliverablePacket(udpPacket, ctrl);
-        return;
-    }
-    SockDescList& list = it->second;
-
-    int matches = 0;
+    // connected sockets are looked up in the hash table, the others on the
+    // port are checked one by one; every matching socket gets a copy
+    SocketsByPortMap::iterator it = wildcardSocketsByPortMap.find(destPort);
+    SockDescList *wildcardList = it==wildcardSocketsByPortMap.end() ? NULL : &it->second;
+    matchingSockets.clear();
 
     // deliver a copy of the packet to each matching socket
     cPacket *payload = udpPacket->getEncapsulatedMsg();
     if (dynamic_cast<IPControlInfo *>(ctrl)!=NULL)
     {
         IPControlInfo *ctrl4 = (IPControlInfo *)ctrl;
-        for (SockDescList::iterator it=list.begin(); it!=list.end(); ++it)
+        IPvXAddress srcAddr = ctrl4->getSrcAddr();
+        for (SockDesc *sd = connectedSockets.getBucket(destPort, srcAddr, srcPort); sd; sd = sd->nextInHash)
+            if (sd->localPort==destPort && !sd->remoteAddr.isIPv6() && matchesSocket(sd, udpPacket, ctrl4))
+                matchingSockets.push_back(sd);
+        if (wildcardList)
+            for (SockDescList::iterator it=wildcardList->begin(); it!=wildcardList->end(); ++it)
+                if ((*it)->onlyLocalPortIsSet || matchesSocket(*it, udpPacket, ctrl4))
+                    matchingSockets.push_back(*it);
+        if (matchingSockets.size()>1)
+            std::sort(matchingSockets.begin(), matchingSockets.end(), bindSeqLess);
+
+        for (SockDescVector::iterator it=matchingSockets.begin(); it!=matchingSockets.end(); ++it)
         {
             SockDesc *sd = *it;
-            if (sd->onlyLocalPortIsSet || matchesSocket(sd, udpPacket, ctrl4))
-            {
-                EV << "Socket sockId=" << sd->sockId << " matches, sending up a copy.\n";
-                sendUp((cPacket*)payload->dup(), udpPacket, ctrl4, sd);
-                matches++;
-            }
+            EV << "Socket sockId=" << sd->sockId << " matches, sending up a copy.\n";
+            sendUp((cPacket*)payload->dup(), udpPacket, ctrl4, sd);
         }
     }
-    else if (dynamic_cast<IPv6ControlInfo *>(udpPacket->getControlInfo())!=NULL)
+    else if (dynamic_cast<IPv6ControlInfo *>(ctrl)!=NULL)
     {
         IPv6ControlInfo *ctrl6 = (IPv6ControlInfo *)ctrl;
-        for (SockDescList::iterator it=list.begin(); it!=list.end(); ++it)
+        IPvXAddress srcAddr = ctrl6->getSrcAddr();
+        for (SockDesc *sd = connectedSockets.getBucket(destPort, srcAddr, srcPort); sd; sd = sd->nextInHash)
+            if (sd->localPort==destPort && sd->remoteAddr.isIPv6() && matchesSocket(sd, udpPacket, ctrl6))
+                matchingSockets.push_back(sd);
+        if (wildcardList)
+            for (SockDescList::iterator it=wildcardList->begin(); it!=wildcardList->end(); ++it)
+                if ((*it)->onlyLocalPortIsSet || matchesSocket(*it, udpPacket, ctrl6))
+                    matchingSockets.push_back(*it);
+        if (matchingSockets.size()>1)
+            std::sort(matchingSockets.begin(), matchingSockets.end(), bindSeqLess);
+
+        for (SockDescVector::iterator it=matchingSockets.begin(); it!=matchingSockets.end(); ++it)
         {
             SockDesc *sd = *it;
-            if (sd->onlyLocalPortIsSet || matchesSocket(sd, udpPacket, ctrl6))
-            {
-                EV << "Socket sockId=" << sd->sockId << " matches, sending up a copy.\n";
-                sendUp((cPacket*)payload->dup(), udpPacket, ctrl6, sd);
-                matches++;
-            }
+            EV << "Socket sockId=" << sd->sockId << " matches, sending up a copy.\n";
+            sendUp((cPacket*)payload->dup(), udpPacket, ctrl6, sd);
         }
     }
     else
@@ -471,7 +582,7 @@ void UDP::processUDPPacket(UDPPacket *udpPacket)
     }
 
     // send back ICMP error if there is no matching socket
-    if (matches==0)
+    if (matchingSockets.empty())
     {
         EV << "None of the sockets on port " << destPort << " matches the packet\n";
         processUndeliverablePacket(udpPacket, ctrl);
@@ -27,6 +27,7 @@
 
 #include <map>
 #include <list>
+#include <vector>
 #include "UDPControlInfo_m.h"
 
 class IPControlInfo;
@@ -57,16 +58,50 @@ class INET_API UDP : public cSimpleModule
         short localPort;
         short remotePort;
         int interfaceId; // FIXME do real sockets allow filtering by input interface??
+        int bindSeq; // order of binding; copies of a packet are sent up in this order
+        SockDesc *nextInHash; // next socket in the same ConnectedSocketTable bucket
     };
 
     typedef std::list<SockDesc *> SockDescList;
+    typedef std::vector<SockDesc *> SockDescVector;
     typedef std::map<int,SockDesc *> SocketsByIdMap;
     typedef std::map<int,SockDescList> SocketsByPortMap;
 
+    /**
+     * Hash table of connected sockets (see isConnectedSocket()), keyed by
+     * local port, remote address and remote port. The local address is
+     * not part of the key, and several sockets may have the same key:
+     * sockets in a bucket are chained via SockDesc::nextInHash, and
+     * callers of getBucket() have to check them one by one.
+     */
+    class ConnectedSocketTable
+    {
+      protected:
+        std::vector<SockDesc *> buckets;  // size is a power of 2
+        int count;
+
+        static uint32 hash(short localPort, const IPvXAddress& remoteAddr, short remotePort);
+        void grow();
+
+      public:
+        ConnectedSocketTable();
+        SockDesc *getBucket(short localPort, const IPvXAddress& remoteAddr, short remotePort) const
+            {return buckets[hash(localPort, remoteAddr, remotePort) & (buckets.size()-1)];}
+        void insert(SockDesc *sd);
+        void erase(SockDesc *sd);
+        int size() const  {return count;}
+    };
+
   protected:
-    // sockets
+    // sockets: socketsByPortMap contains all sockets on the port, while
+    // packets are demultiplexed via connectedSockets and, for the rest of
+    // the sockets, wildcardSocketsByPortMap
     SocketsByIdMap socketsByIdMap;
     SocketsByPortMap socketsByPortMap;
+    SocketsByPortMap wildcardSocketsByPortMap;
+    ConnectedSocketTable connectedSockets;
+    int lastBindSeq;
+    SockDescVector matchingSockets; // used in processUDPPacket() only; member to spare allocations
 
     // other state vars
     short lastEphemeralPort;
@@ -95,6 +130,13 @@ class INET_API UDP : public cSimpleModule
     // ephemeral port
     virtual short getEphemeralPort();
 
+    // connected sockets (remote address and port set, no interface filter) are
+    // looked up by hashing; packets are matched against all other sockets
+    // on their port one by one
+    virtual bool isConnectedSocket(SockDesc *sd);
+    virtual void addToDemuxTables(SockDesc *sd);
+    virtual void removeFromDemuxTables(SockDesc *sd);
+
     virtual bool matchesSocket(SockDesc *sd, UDPPacket *udp, IPControlInfo *ctrl);
     virtual bool matchesSocket(SockDesc *sd, UDPPacket *udp, IPv6ControlInfo *ctrl);
     virtual bool matchesSocket(SockDesc *sd, const IPvXAddress& localAddr, const IPvXAddress& remoteAddr, short remotePort);
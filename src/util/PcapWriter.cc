@@ -0,0 +1,385 @@
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include "PcapWriter.h"
+
+#ifdef WITH_ZLIB
+#include <zlib.h>
+#endif
+
+#ifdef WITH_PCAP_WRITER_THREAD
+#define LOCK    pthread_mutex_lock(&mutex)
+#define UNLOCK  pthread_mutex_unlock(&mutex)
+#else
+#define LOCK
+#define UNLOCK
+#endif
+
+#define PCAP_FILE_HEADER_BYTES    ((int64)sizeof(struct pcap_hdr))
+#define PCAP_RECORD_HEADER_BYTES  ((unsigned int)sizeof(struct pcaprec_hdr))
+
+
+PcapWriter::PcapWriter()
+{
+    current = NULL;
+    record = NULL;
+    file = NULL;
+    openFileIndex = -1;
+    stopping = false;
+    numRecords = numBytes = numWaits = 0;
+}
+
+PcapWriter::~PcapWriter()
+{
+    // don't throw from the destructor: errors are only reported by close()
+    try
+    {
+        close();
+    }
+    catch (std::exception&)
+    {
+    }
+}
+
+std::string PcapWriter::getFileName(int index) const
+{
+    std::string name = fileName;
+    if (index > 0)
+    {
+        // insert the sequence number before the extension, if there is one
+        char suffix[16];
+        sprintf(suffix, "-%d", index);
+        std::string::size_type dot = name.rfind('.');
+        std::string::size_type slash = name.find_last_of("/\\");
+        if (dot != std::string::npos && (slash == std::string::npos || dot > slash) && dot > 0)
+            name.insert(dot, suffix);
+        else
+            name += suffix;
+    }
+    if (compress)
+        name += ".gz";
+    return name;
+}
+
+void PcapWriter::open(const char *fileName, uint32 network, uint32 snaplen,
+                      unsigned int bufferSize, unsigned int numBuffers,
+                      int64 maxFileSize, simtime_t rotationInterval, bool compress)
+{
+    if (isOpen())
+        throw cRuntimeError("PcapWriter: already open");
+#ifndef WITH_ZLIB
+    if (compress)
+        throw cRuntimeError("PcapWriter: cannot compress the dump file, INET was compiled without WITH_ZLIB");
+#endif
+    if (bufferSize < snaplen + PCAP_RECORD_HEADER_BYTES)
+        throw cRuntimeError("PcapWriter: buffer size %u is too small for the snapshot length %u", bufferSize, snaplen);
+    if (numBuffers < 2)
+        numBuffers = 2;
+
+    this->fileName = fileName;
+    this->network = network;
+    this->snaplen = snaplen;
+    this->bufferSize = bufferSize;
+    this->maxFileSize = maxFileSize;
+    this->rotationInterval = rotationInterval;
+    this->compress = compress;
+
+#ifdef WITH_PCAP_WRITER_THREAD
+    pthread_mutex_init(&mutex, NULL);
+    pthread_cond_init(&bufferFree, NULL);
+    pthread_cond_init(&bufferFull, NULL);
+#endif
+
+    fileIndex = 0;
+    fileSize = PCAP_FILE_HEADER_BYTES;
+    fileStartTime = 0;
+    try
+    {
+        openFile(0);
+    }
+    catch (std::exception&)
+    {
+        releaseBuffers();
+        throw;
+    }
+
+    // calloc, as records are assumed to be zeroed
+    buffers.resize(numBuffers);
+    for (unsigned int i=0; i<numBuffers; i++)
+    {
+        buffers[i].data = (unsigned char *)calloc(bufferSize, 1);
+        buffers[i].length = 0;
+        buffers[i].dirty = 0;
+        buffers[i].fileIndex = 0;
+        if (i > 0)
+            freeBuffers.push_back(&buffers[i]);
+        if (!buffers[i].data)
+        {
+            releaseBuffers();
+            throw cRuntimeError("PcapWriter: cannot allocate %u capture buffers of %u bytes", numBuffers, bufferSize);
+        }
+    }
+    current = &buffers[0];
+    record = NULL;
+    stopping = false;
+    error = "";
+
+#ifdef WITH_PCAP_WRITER_THREAD
+    if (pthread_create(&thread, NULL, writerThread, this) != 0)
+    {
+        releaseBuffers();
+        throw cRuntimeError("PcapWriter: cannot start the writer thread");
+    }
+#endif
+}
+
+void PcapWriter::releaseBuffers()
+{
+    // the writer thread is not running (any more)
+#ifdef WITH_PCAP_WRITER_THREAD
+    pthread_cond_destroy(&bufferFull);
+    pthread_cond_destroy(&bufferFree);
+    pthread_mutex_destroy(&mutex);
+#endif
+
+    closeFile();
+    for (unsigned int i=0; i<buffers.size(); i++)
+        free(buffers[i].data);
+    buffers.clear();
+    freeBuffers.clear();
+    fullBuffers.clear();
+    current = NULL;
+    record = NULL;
+}
+
+void PcapWriter::close()
+{
+    if (!isOpen())
+        return;
+
+    if (current->length > 0)
+        submitBuffer();
+    current = NULL;
+
+#ifdef WITH_PCAP_WRITER_THREAD
+    LOCK;
+    stopping = true;
+    pthread_cond_signal(&bufferFull);
+    UNLOCK;
+    pthread_join(thread, NULL);
+#endif
+
+    releaseBuffers();
+
+    if (!error.empty())
+        throw cRuntimeError("PcapWriter: %s", error.c_str());
+}
+
+unsigned char *PcapWriter::beginRecord(simtime_t stime)
+{
+    // a record that was begun but not completed may have left data behind
+    if (record != NULL)
+        memset(record, 0, PCAP_RECORD_HEADER_BYTES + snaplen);
+
+    if ((maxFileSize > 0 && fileSize >= maxFileSize) ||
+        (rotationInterval > 0 && stime >= fileStartTime + rotationInterval))
+        rotate(stime);
+
+    if (current->length + PCAP_RECORD_HEADER_BYTES + snaplen > bufferSize)
+        submitBuffer();
+
+    record = current->data + current->length;
+    recordTime = stime;
+    current->dirty = current->length + PCAP_RECORD_HEADER_BYTES + snaplen;
+    return record + PCAP_RECORD_HEADER_BYTES;
+}
+
+void PcapWriter::endRecord(unsigned int length)
+{
+    ASSERT(record != NULL && length <= snaplen);
+
+    struct pcaprec_hdr ph;
+    ph.ts_sec = (int32)recordTime.dbl();
+    ph.ts_usec = (uint32)((recordTime.dbl() - ph.ts_sec) * 1000000);
+    ph.incl_len = length;
+    ph.orig_len = length;
+    memcpy(record, &ph, sizeof(ph));
+
+    current->length += PCAP_RECORD_HEADER_BYTES + length;
+    fileSize += PCAP_RECORD_HEADER_BYTES + length;
+    record = NULL;
+    numRecords++;
+    numBytes += length;
+}
+
+void PcapWriter::rotate(simtime_t stime)
+{
+    if (current->length > 0)
+        submitBuffer();
+    fileIndex++;
+    fileSize = PCAP_FILE_HEADER_BYTES;
+    current->fileIndex = fileIndex;
+
+    // the files cover whole intervals, even if no packet arrives in some of them
+    if (rotationInterval > 0)
+        while (stime >= fileStartTime + rotationInterval)
+            fileStartTime += rotationInterval;
+}
+
+void PcapWriter::submitBuffer()
+{
+#ifdef WITH_PCAP_WRITER_THREAD
+    LOCK;
+    fullBuffers.push_back(current);
+    pthread_cond_signal(&bufferFull);
+    if (freeBuffers.empty())
+        numWaits++;
+    while (freeBuffers.empty())
+        pthread_cond_wait(&bufferFree, &mutex);
+    current = freeBuffers.front();
+    freeBuffers.pop_front();
+    std::string errorText = error;
+    UNLOCK;
+    if (!errorText.empty())
+        throw cRuntimeError("PcapWriter: %s", errorText.c_str());
+#else
+    writeBuffer(current);
+    if (!error.empty())
+        throw cRuntimeError("PcapWriter: %s", error.c_str());
+#endif
+    current->fileIndex = fileIndex;
+}
+
+#ifdef WITH_PCAP_WRITER_THREAD
+void *PcapWriter::writerThread(void *arg)
+{
+    PcapWriter *writer = (PcapWriter *)arg;
+    pthread_mutex_t *mutex = &writer->mutex;
+
+    pthread_mutex_lock(mutex);
+    while (true)
+    {
+        while (writer->fullBuffers.empty() && !writer->stopping)
+            pthread_cond_wait(&writer->bufferFull, mutex);
+        if (writer->fullBuffers.empty())
+            break;
+        Buffer *buffer = writer->fullBuffers.front();
+        writer->fullBuffers.pop_front();
+        pthread_mutex_unlock(mutex);
+
+        writer->writeBuffer(buffer);
+
+        pthread_mutex_lock(mutex);
+        writer->freeBuffers.push_back(buffer);
+        pthread_cond_signal(&writer->bufferFree);
+    }
+    pthread_mutex_unlock(mutex);
+    return NULL;
+}
+#endif
+
+void PcapWriter::writeBuffer(Buffer *buffer)
+{
+    // called from the writer thread: errors are stored, not thrown
+    if (buffer->fileIndex != openFileIndex)
+    {
+        closeFile();
+        openFile(buffer->fileIndex);
+    }
+    writeFile(buffer->data, buffer->length);
+
+    // everything handed out is zeroed here, not only the bytes that were
+    // counted, so the simulation doesn't have to
+    memset(buffer->data, 0, buffer->dirty);
+    buffer->length = 0;
+    buffer->dirty = 0;
+}
+
+void PcapWriter::openFile(int index)
+{
+    std::string name = getFileName(index);
+    openFileIndex = index;
+#ifdef WITH_ZLIB
+    if (compress)
+        file = gzopen(name.c_str(), "wb1");  // fastest level, pcap compresses well anyway
+    else
+#endif
+    {
+        file = fopen(name.c_str(), "wb");
+        if (file)
+            setvbuf((FILE *)file, NULL, _IONBF, 0);  // we write whole buffers
+    }
+
+    if (!file)
+    {
+        std::string text = "cannot open file " + name + " for writing: " + strerror(errno);
+        if (index == 0)
+            throw cRuntimeError("PcapWriter: %s", text.c_str());
+        LOCK;
+        error = text;
+        UNLOCK;
+        return;
+    }
+
+    struct pcap_hdr fh;
+    fh.magic = PCAP_MAGIC;
+    fh.version_major = 2;
+    fh.version_minor = 4;
+    fh.thiszone = 0;
+    fh.sigfigs = 0;
+    fh.snaplen = snaplen;
+    fh.network = network;
+    writeFile(&fh, sizeof(fh));
+}
+
+void PcapWriter::closeFile()
+{
+    if (!file)
+        return;
+#ifdef WITH_ZLIB
+    if (compress)
+        gzclose((gzFile)file);
+    else
+#endif
+        fclose((FILE *)file);
+    file = NULL;
+}
+
+void PcapWriter::writeFile(const void *data, unsigned int length)
+{
+    if (!file || length == 0)
+        return;
+
+    bool ok;
+#ifdef WITH_ZLIB
+    if (compress)
+        ok = gzwrite((gzFile)file, data, length) == (int)length;
+    else
+#endif
+        ok = fwrite(data, length, 1, (FILE *)file) == 1;
+
+    if (!ok)
+    {
+        LOCK;
+        error = "cannot write file " + getFileName(openFileIndex) + ": " + strerror(errno);
+        UNLOCK;
+        closeFile();
+    }
+}
+
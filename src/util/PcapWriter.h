@@ -0,0 +1,173 @@
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef __INET_PCAPWRITER_H
+#define __INET_PCAPWRITER_H
+
+#include <string>
+#include <vector>
+#include <deque>
+#include "INETDefs.h"
+
+// the buffers are flushed by a background thread where POSIX threads are
+// available, and by the simulation itself everywhere else
+#if !defined(_WIN32) && !defined(__WIN32__) && !defined(WIN32) && !defined(__CYGWIN__) && !defined(_WIN64)
+#define WITH_PCAP_WRITER_THREAD
+#include <pthread.h>
+#endif
+
+#define PCAP_MAGIC          0xa1b2c3d4
+
+/* "libpcap" file header (minus magic number). */
+struct pcap_hdr {
+    uint32  magic;      /* magic */
+    uint16  version_major;  /* major version number */
+    uint16  version_minor;  /* minor version number */
+    uint32  thiszone;   /* GMT to local correction */
+    uint32  sigfigs;    /* accuracy of timestamps */
+    uint32  snaplen;    /* max length of captured packets, in octets */
+    uint32  network;    /* data link type */
+};
+
+/* "libpcap" record header. */
+struct pcaprec_hdr {
+    int32           ts_sec;     /* timestamp seconds */
+    uint32  ts_usec;    /* timestamp microseconds */
+    uint32  incl_len;   /* number of octets of packet saved in file */
+    uint32  orig_len;   /* actual length of packet */
+};
+
+/**
+ * Writes a capture in libpcap format. Records are serialized directly
+ * into a ring of large buffers, and full buffers are written to disk in
+ * one piece by a background thread (see WITH_PCAP_WRITER_THREAD), so the
+ * simulation only blocks when all buffers are waiting to be written.
+ *
+ * The capture can be split into several files by size or by simulation
+ * time: the first file has the given name, the following ones get a
+ * sequence number before the extension (dump.pcap, dump-1.pcap, ...).
+ * If compiled with WITH_ZLIB, the files can be gzip compressed on the
+ * fly; ".gz" is appended to their names.
+ *
+ * Usage: open(), then for every packet beginRecord(), write at most
+ * getSnaplen() bytes to the returned pointer, endRecord(); finally close().
+ */
+class INET_API PcapWriter
+{
+  protected:
+    struct Buffer
+    {
+        unsigned char *data;
+        unsigned int length;
+        unsigned int dirty;  // high-water mark of the memory handed out by beginRecord()
+        int fileIndex;   // the file this buffer belongs to
+    };
+
+    // settings
+    std::string fileName;
+    uint32 network;
+    uint32 snaplen;
+    unsigned int bufferSize;
+    int64 maxFileSize;          // 0: no rotation by size
+    simtime_t rotationInterval; // 0: no rotation by time
+    bool compress;
+
+    // simulation side
+    std::vector<Buffer> buffers;
+    Buffer *current;            // buffer being filled
+    unsigned char *record;      // record being written into current
+    simtime_t recordTime;
+    int fileIndex;
+    int64 fileSize;
+    simtime_t fileStartTime;
+
+    // writer side
+    void *file;                 // FILE* or gzFile
+    int openFileIndex;
+
+    // shared, protected by mutex
+    std::deque<Buffer *> freeBuffers;
+    std::deque<Buffer *> fullBuffers;
+    std::string error;
+    bool stopping;
+
+    // statistics
+    uint64 numRecords;
+    uint64 numBytes;
+    uint64 numWaits;           // times the simulation had to wait for a free buffer
+
+#ifdef WITH_PCAP_WRITER_THREAD
+    pthread_t thread;
+    pthread_mutex_t mutex;
+    pthread_cond_t bufferFree;
+    pthread_cond_t bufferFull;
+    static void *writerThread(void *writer);
+#endif
+
+  protected:
+    virtual void releaseBuffers();
+    virtual void submitBuffer();
+    virtual void rotate(simtime_t stime);
+    virtual void writeBuffer(Buffer *buffer);
+    virtual void openFile(int index);
+    virtual void closeFile();
+    virtual void writeFile(const void *data, unsigned int length);
+
+  public:
+    PcapWriter();
+    virtual ~PcapWriter();
+
+    /**
+     * Creates the (first) file and starts the writer. The file is created
+     * here, so that an invalid file name is reported right away.
+     */
+    virtual void open(const char *fileName, uint32 network, uint32 snaplen,
+                      unsigned int bufferSize, unsigned int numBuffers,
+                      int64 maxFileSize, simtime_t rotationInterval, bool compress);
+
+    /**
+     * Writes the buffered records and closes the file. Does nothing if
+     * the writer is not open.
+     */
+    virtual void close();
+
+    bool isOpen() const {return current!=NULL;}
+    uint32 getSnaplen() const {return snaplen;}
+
+    /**
+     * Starts a record with the given timestamp, and returns where to write
+     * its data: at most getSnaplen() bytes. The memory is zeroed, provided
+     * that earlier records wrote nothing past the length given to endRecord().
+     */
+    virtual unsigned char *beginRecord(simtime_t stime);
+
+    /**
+     * Completes the record started by beginRecord(), with the number of
+     * bytes written.
+     */
+    virtual void endRecord(unsigned int length);
+
+    /**
+     * Returns the name of the index'th file of the capture.
+     */
+    virtual std::string getFileName(int index) const;
+
+    uint64 getNumRecords() const {return numRecords;}
+    uint64 getNumBytes() const {return numBytes;}
+    uint64 getNumWaits() const {return numWaits;}
+};
+
+#endif
+
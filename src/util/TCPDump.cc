@@ -22,6 +22,7 @@
 #include "SCTPMessage.h"
 #include "SCTPAssociation.h"
 #include "IPSerializer.h"
+#include "IPv6Serializer.h"
 #include "ICMPMessage.h"
 #include "UDPPacket_m.h"
 
@@ -29,7 +30,7 @@
 #include <netinet/in.h>  // htonl, ntohl, ...
 #endif
 
-#define MAXBUFLENGTH 65536
+#define PCAP_SNAPLEN 65535
 
 TCPDumper::TCPDumper(std::ostream& out)
 {
@@ -495,7 +496,32 @@ void TCPDumper::tcpDump(bool l2r, const char *label, TCPSegment *tcpseg, const s
     if (tcpseg->getUrgBit())
         out << "urg " << tcpseg->getUrgentPointer() << " ";
 
-    // options (not supported by TCPSegment yet)
+    // options
+    const char *sep = "<";
+    if (tcpseg->getSackPermitted())
+    {
+        out << sep << "sackOK";
+        sep = ",";
+    }
+    if (tcpseg->getTimestampOption())
+    {
+        out << sep << "timestamp " << tcpseg->getTsVal() << " " << tcpseg->getTsEcr();
+        sep = ",";
+    }
+    if (tcpseg->getWindowScaleOption())
+    {
+        out << sep << "wscale " << tcpseg->getWindowScale();
+        sep = ",";
+    }
+    if (tcpseg->getSackBlockArraySize()>0)
+    {
+        out << sep << "sack " << tcpseg->getSackBlockArraySize() << " ";
+        for (unsigned int i=0; i<tcpseg->getSackBlockArraySize(); i++)
+            out << "{" << tcpseg->getSackBlock(i).start << ":" << tcpseg->getSackBlock(i).end << "}";
+        sep = ",";
+    }
+    if (*sep==',')
+        out << "> ";
 
     // comment
     if (comment)
@@ -506,41 +532,20 @@ void TCPDumper::tcpDump(bool l2r, const char *label, TCPSegment *tcpseg, const s
 
 void TCPDump::initialize()
 {
-struct pcap_hdr fh;
 const char* file = this->par("dumpFile");
     if (strcmp(file,"")!=0)
     {
-        tcpdump.dumpfile = fopen(file, "wb");
-        if (!tcpdump.dumpfile)
-        {
-                    fprintf(stderr, "Cannot open file [%s] for writing: %s\n", file, strerror(errno));
-                    exit(-1);
-            }
-
-        fh.magic = PCAP_MAGIC;
-        fh.version_major = 2;
-        fh.version_minor = 4;
-        fh.thiszone = 0;
-        fh.sigfigs = 0;
-        fh.snaplen = 65535;
-        fh.network = 0;
-        fwrite(&fh, sizeof(fh), 1, tcpdump.dumpfile);
+        pcapWriter.open(file, 0, PCAP_SNAPLEN,
+                        (int)par("bufferSize"), (int)par("numBuffers"),
+                        (int64)par("maxFileSize").doubleValue(), par("rotationInterval").doubleValue(), par("compress"));
     }
-    else
-        tcpdump.dumpfile = NULL;
 }
 
 void TCPDump::handleMessage(cMessage *msg)
 {
-struct pcaprec_hdr ph;
-simtime_t stime;
-int32 i;
-uint8 buf[MAXBUFLENGTH];
 bool l2r;
 uint32 hdr;
 
-for (i=0; i<MAXBUFLENGTH; i++)
-    buf[i]=0;
     // dump
 
 
@@ -618,26 +623,26 @@ for (i=0; i<MAXBUFLENGTH; i++)
     }
 
 
-    if (tcpdump.dumpfile!=NULL && dynamic_cast<IPDatagram *>(msg))
+    if (pcapWriter.isOpen() && (dynamic_cast<IPDatagram *>(msg) || dynamic_cast<IPv6Datagram *>(msg)))
     {
-        stime = simulation.getSimTime();
-        // Write PCap header
-
-        ph.ts_sec = (int32)stime.dbl();
-        ph.ts_usec = (uint32)((stime.dbl()-ph.ts_sec)*1000000);
+        // the record is serialized right into the buffers of the writer
+        uint8 *buf = pcapWriter.beginRecord(simulation.getSimTime());
+        int32 serialized_ip;
          // Write link layer header
-        hdr = 2; //AF_INET
-        IPDatagram *ipPacket = check_and_cast<IPDatagram *>(msg);
-        // IP header:
-        //struct sockaddr_in *to = (struct sockaddr_in*) malloc(sizeof(struct sockaddr_in));
-        //int32 tosize = sizeof(struct sockaddr_in);
-        int32 serialized_ip = IPSerializer().serialize(ipPacket,buf, sizeof(buf));
-        ph.incl_len = serialized_ip+sizeof(uint32);
-        ph.orig_len = ph.incl_len;
-        fwrite(&ph, sizeof(ph), 1, tcpdump.dumpfile);
-        fwrite(&hdr, sizeof(uint32), 1, tcpdump.dumpfile);
-
-        fwrite(buf, serialized_ip, 1, tcpdump.dumpfile);
+        if (dynamic_cast<IPDatagram *>(msg))
+        {
+            hdr = 2; //AF_INET
+            IPDatagram *ipPacket = check_and_cast<IPDatagram *>(msg);
+            serialized_ip = IPSerializer().serialize(ipPacket, buf+sizeof(uint32), PCAP_SNAPLEN-sizeof(uint32));
+        }
+        else
+        {
+            hdr = 24; //AF_INET6 of the BSDs, which is what DLT_NULL readers expect
+            IPv6Datagram *ipv6Packet = check_and_cast<IPv6Datagram *>(msg);
+            serialized_ip = IPv6Serializer().serialize(ipv6Packet, buf+sizeof(uint32), PCAP_SNAPLEN-sizeof(uint32));
+        }
+        memcpy(buf, &hdr, sizeof(uint32));
+        pcapWriter.endRecord(serialized_ip+sizeof(uint32));
     }
 
 
@@ -655,7 +660,11 @@ for (i=0; i<MAXBUFLENGTH; i++)
 void TCPDump::finish()
 {
     tcpdump.dump("", "tcpdump finished");
-    if (strcmp(this->par("dumpFile"),"")!=0)
-        fclose(tcpdump.dumpfile);
+    if (pcapWriter.isOpen())
+    {
+        EV << "pcap: " << pcapWriter.getNumRecords() << " packets, " << pcapWriter.getNumBytes() << " bytes written, "
+           << pcapWriter.getNumWaits() << " waits for the writer\n";
+        pcapWriter.close();
+    }
 }
 
@@ -26,27 +26,7 @@
 #include "SCTPMessage.h"
 #include "TCPSegment.h"
 #include "IPv6Datagram_m.h"
-
-#define PCAP_MAGIC          0xa1b2c3d4
-
-/* "libpcap" file header (minus magic number). */
-struct pcap_hdr {
-    uint32  magic;      /* magic */
-    uint16  version_major;  /* major version number */
-    uint16  version_minor;  /* minor version number */
-    uint32  thiszone;   /* GMT to local correction */
-    uint32  sigfigs;    /* accuracy of timestamps */
-    uint32  snaplen;    /* max length of captured packets, in octets */
-    uint32  network;    /* data link type */
-};
-
-/* "libpcap" record header. */
-struct pcaprec_hdr {
-    int32           ts_sec;     /* timestamp seconds */
-    uint32  ts_usec;    /* timestamp microseconds */
-    uint32  incl_len;   /* number of octets of packet saved in file */
-    uint32  orig_len;   /* actual length of packet */
-};
+#include "PcapWriter.h"
 
 typedef struct {
     uint8  dest_addr[6];
@@ -79,7 +59,6 @@ class TCPDumper
         void dumpIPv6(bool l2r, const char *label, IPv6Datagram_Base *dgram, const char *comment=NULL);//FIXME: Temporary hack
         void udpDump(bool l2r, const char *label, IPDatagram *dgram, const char *comment);
         char* intToChunk(int32 type);
-        FILE *dumpfile;
 
 };
 
@@ -91,6 +70,7 @@ class TCPDump : public cSimpleModule
 {
     protected:
         TCPDumper tcpdump;
+        PcapWriter pcapWriter;
     public:
 
         TCPDump();
@@ -0,0 +1,231 @@
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+
+#include <string.h>
+#include "Checksum.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+// the SSE4.2 code is compiled with a target attribute and selected at
+// runtime, so that the binary still runs on CPUs without SSE4.2
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && \
+    (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))
+#define WITH_SSE42_CRC32C
+#include <nmmintrin.h>
+#endif
+
+#define CRC32C_POLY  0x82F63B78  // reversed Castagnoli polynomial
+
+
+// folds a sum of 16- or 32-bit words into 16 bits
+static uint16 foldSum(uint64 sum)
+{
+    sum = (sum & 0xffffffff) + (sum >> 32);
+    sum = (sum & 0xffffffff) + (sum >> 32);
+    sum = (sum & 0xffff) + (sum >> 16);
+    sum = (sum & 0xffff) + (sum >> 16);
+    sum = (sum & 0xffff) + (sum >> 16);
+    return (uint16)sum;
+}
+
+uint16 Checksum::internetSum(const void *buf, unsigned int len, uint16 initialSum)
+{
+    const unsigned char *p = (const unsigned char *)buf;
+    uint64 sum = initialSum;
+
+    // The ones' complement sum of 16-bit words can be computed as the sum
+    // of 32-bit words folded at the end (RFC 1071, 2.(C)). The words are
+    // added to 64-bit accumulators, so carries never get lost.
+#ifdef __SSE2__
+    __m128i zero = _mm_setzero_si128();
+    __m128i acc0 = zero, acc1 = zero;
+    while (len >= 32)
+    {
+        __m128i v0 = _mm_loadu_si128((const __m128i *)p);
+        __m128i v1 = _mm_loadu_si128((const __m128i *)(p + 16));
+        acc0 = _mm_add_epi64(acc0, _mm_unpacklo_epi32(v0, zero));
+        acc1 = _mm_add_epi64(acc1, _mm_unpackhi_epi32(v0, zero));
+        acc0 = _mm_add_epi64(acc0, _mm_unpacklo_epi32(v1, zero));
+        acc1 = _mm_add_epi64(acc1, _mm_unpackhi_epi32(v1, zero));
+        p += 32;
+        len -= 32;
+    }
+    uint64 lanes[2];
+    _mm_storeu_si128((__m128i *)lanes, _mm_add_epi64(acc0, acc1));
+    sum += foldSum(lanes[0]);
+    sum += foldSum(lanes[1]);
+#endif
+
+    uint64 sum0 = 0, sum1 = 0;
+    uint32 word;
+    while (len >= 8)
+    {
+        memcpy(&word, p, 4);
+        sum0 += word;
+        memcpy(&word, p + 4, 4);
+        sum1 += word;
+        p += 8;
+        len -= 8;
+    }
+    sum += foldSum(sum0) + foldSum(sum1);
+
+    uint16 halfword;
+    while (len >= 2)
+    {
+        memcpy(&halfword, p, 2);
+        sum += halfword;
+        p += 2;
+        len -= 2;
+    }
+
+    // a trailing odd byte is padded with a zero byte
+    if (len)
+    {
+        halfword = 0;
+        memcpy(&halfword, p, 1);
+        sum += halfword;
+    }
+
+    return foldSum(sum);
+}
+
+uint16 Checksum::updateInternetChecksum(uint16 checksum, uint16 oldValue, uint16 newValue)
+{
+    // RFC 1624, eqn. 3: HC' = ~(~HC + ~m + m')
+    uint32 sum = (uint16)~checksum + (uint32)(uint16)~oldValue + newValue;
+    return ~foldSum(sum);
+}
+
+
+//
+// CRC32C
+//
+
+// slicing-by-8 tables: table[0] is the usual byte-wise table, table[k][b]
+// is the CRC of byte b followed by k zero bytes
+static uint32 crc32cTable[8][256];
+
+static bool initCRC32CTable()
+{
+    for (int i = 0; i < 256; i++)
+    {
+        uint32 crc = i;
+        for (int j = 0; j < 8; j++)
+            crc = (crc >> 1) ^ (CRC32C_POLY & (0 - (crc & 1)));
+        crc32cTable[0][i] = crc;
+    }
+    for (int i = 0; i < 256; i++)
+        for (int k = 1; k < 8; k++)
+            crc32cTable[k][i] = (crc32cTable[k-1][i] >> 8) ^ crc32cTable[0][crc32cTable[k-1][i] & 0xff];
+    return true;
+}
+
+static bool crc32cTableInitialized = initCRC32CTable();
+
+static uint32 crc32cSlicingBy8(uint32 crc, const unsigned char *p, unsigned int len)
+{
+    while (len > 0 && ((unsigned long)p & 7) != 0)
+    {
+        crc = (crc >> 8) ^ crc32cTable[0][(crc ^ *p++) & 0xff];
+        len--;
+    }
+
+    while (len >= 8)
+    {
+        // the tables assume little endian byte order of the words
+        uint32 lo = p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32)p[3] << 24);
+        uint32 hi = p[4] | (p[5] << 8) | (p[6] << 16) | ((uint32)p[7] << 24);
+        lo ^= crc;
+        crc = crc32cTable[7][lo & 0xff] ^ crc32cTable[6][(lo >> 8) & 0xff] ^
+              crc32cTable[5][(lo >> 16) & 0xff] ^ crc32cTable[4][lo >> 24] ^
+              crc32cTable[3][hi & 0xff] ^ crc32cTable[2][(hi >> 8) & 0xff] ^
+              crc32cTable[1][(hi >> 16) & 0xff] ^ crc32cTable[0][hi >> 24];
+        p += 8;
+        len -= 8;
+    }
+
+    while (len-- > 0)
+        crc = (crc >> 8) ^ crc32cTable[0][(crc ^ *p++) & 0xff];
+
+    return crc;
+}
+
+#ifdef WITH_SSE42_CRC32C
+__attribute__((target("sse4.2")))
+static uint32 crc32cSSE42(uint32 crc, const unsigned char *p, unsigned int len)
+{
+    while (len > 0 && ((unsigned long)p & 7) != 0)
+    {
+        crc = _mm_crc32_u8(crc, *p++);
+        len--;
+    }
+
+#ifdef __x86_64__
+    uint64 crc64 = crc;
+    while (len >= 8)
+    {
+        crc64 = _mm_crc32_u64(crc64, *(const uint64 *)p);
+        p += 8;
+        len -= 8;
+    }
+    crc = (uint32)crc64;
+#endif
+
+    while (len >= 4)
+    {
+        crc = _mm_crc32_u32(crc, *(const uint32 *)p);
+        p += 4;
+        len -= 4;
+    }
+
+    while (len-- > 0)
+        crc = _mm_crc32_u8(crc, *p++);
+
+    return crc;
+}
+
+static bool detectSSE42()
+{
+    __builtin_cpu_init(); // we may run before the constructors of libgcc
+    return __builtin_cpu_supports("sse4.2");
+}
+
+static bool cpuHasSSE42 = detectSSE42();
+#endif
+
+bool Checksum::hasHardwareCRC32C()
+{
+#ifdef WITH_SSE42_CRC32C
+    return cpuHasSSE42;
+#else
+    return false;
+#endif
+}
+
+uint32 Checksum::crc32c(const void *buf, unsigned int len, uint32 crc)
+{
+    const unsigned char *p = (const unsigned char *)buf;
+    crc = ~crc;
+
+#ifdef WITH_SSE42_CRC32C
+    if (cpuHasSSE42)
+        return ~crc32cSSE42(crc, p, len);
+#endif
+
+    return ~crc32cSlicingBy8(crc, p, len);
+}
+
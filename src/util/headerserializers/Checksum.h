@@ -0,0 +1,77 @@
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef __INET_CHECKSUM_H
+#define __INET_CHECKSUM_H
+
+#include "INETDefs.h"
+
+/**
+ * Checksum functions shared by the header serializers: the Internet
+ * checksum of IP, ICMP, UDP and TCP (RFC 1071), its incremental update
+ * (RFC 1624), and the CRC32C of SCTP (RFC 3309).
+ *
+ * The Internet checksum functions work on data in network byte order,
+ * and they take and return 16-bit values as they are stored in the
+ * packet, i.e. also in network byte order. (The ones' complement sum does
+ * not depend on the byte order, see RFC 1071.)
+ *
+ * The sum is computed with SSE2 where available. CRC32C uses the crc32
+ * instruction of SSE4.2 if the CPU supports it (checked at runtime),
+ * and the slicing-by-8 algorithm otherwise.
+ */
+class INET_API Checksum
+{
+  public:
+    /**
+     * Adds the 16-bit words of the buffer to the ones' complement sum
+     * 'sum', and returns the new sum (not complemented). Use it to checksum
+     * data that is not contiguous, e.g. a pseudo header and a segment;
+     * all parts but the last one must have an even length.
+     */
+    static uint16 internetSum(const void *buf, unsigned int len, uint16 sum = 0);
+
+    /**
+     * Returns the Internet checksum of the buffer, i.e. the complement of
+     * internetSum(buf, len, sum). The checksum field in the buffer must be
+     * zero; when verifying a received packet, the result is zero if the
+     * checksum is correct.
+     */
+    static uint16 internetChecksum(const void *buf, unsigned int len, uint16 sum = 0) {
+        return ~internetSum(buf, len, sum);
+    }
+
+    /**
+     * Returns the Internet checksum after a 16-bit word covered by it
+     * changed from oldValue to newValue (RFC 1624, eqn. 3), e.g. after
+     * decrementing the TTL of an IPv4 header (which shares its word with
+     * the protocol field).
+     */
+    static uint16 updateInternetChecksum(uint16 checksum, uint16 oldValue, uint16 newValue);
+
+    /**
+     * Returns the CRC32C of the buffer. To compute it over several buffers,
+     * pass the result for the previous ones as crc.
+     */
+    static uint32 crc32c(const void *buf, unsigned int len, uint32 crc = 0);
+
+    /**
+     * Returns true if crc32c() uses the SSE4.2 crc32 instruction.
+     */
+    static bool hasHardwareCRC32C();
+};
+
+#endif
+
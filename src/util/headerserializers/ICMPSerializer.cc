@@ -26,6 +26,7 @@ namespace INETFw // load headers into a namespace, to avoid conflicts with platf
 };
 #include "IPSerializer.h"
 #include "ICMPSerializer.h"
+#include "Checksum.h"
 #include "PingPayload_m.h"
 
 #if !defined(_WIN32) && !defined(__WIN32__) && !defined(WIN32) && !defined(__CYGWIN__) && !defined(_WIN64)
@@ -158,20 +159,5 @@ void ICMPSerializer::parse(unsigned char *buf, unsigned int bufsize, ICMPMessage
 
 unsigned short ICMPSerializer::checksum(unsigned char *addr, unsigned int count)
 {
-    long sum = 0;
-
-    while (count > 1)  {
-        sum += *((unsigned short *&)addr)++;
-        if (sum & 0x80000000)
-            sum = (sum & 0xFFFF) + (sum >> 16);
-        count -= 2;
-    }
-
-    if (count)
-        sum += *(unsigned char *)addr;
-
-    while (sum >> 16)
-        sum = (sum & 0xffff) + (sum >> 16);
-
-    return ~sum;
+    return Checksum::internetChecksum(addr, count);
 }
@@ -0,0 +1,441 @@
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+
+#include <algorithm> // std::min
+#include <string.h>
+#include "headers/defs.h"
+namespace INETFw // load headers into a namespace, to avoid conflicts with platform definitions of the same stuff
+{
+#include "headers/bsdint.h"
+#include "headers/in.h"
+#include "headers/in_systm.h"
+#include "headers/ip6.h"
+#include "headers/icmp6.h"
+};
+#include "IPv6Serializer.h"
+#include "ICMPv6Serializer.h"
+#include "IPv6NDMessage_m.h"
+#include "PingPayload_m.h"
+
+#if !defined(_WIN32) && !defined(__WIN32__) && !defined(WIN32) && !defined(__CYGWIN__) && !defined(_WIN64)
+#include <netinet/in.h>  // htonl, ntohl, ...
+#endif
+
+
+using namespace INETFw;
+
+
+static void checkBufferSize(unsigned int length, unsigned int bufsize)
+{
+    if (length > bufsize)
+        opp_error("ICMPv6Serializer: buffer of %d bytes is too short for the ICMPv6 message", bufsize);
+}
+
+// Writes a Source or Target Link-Layer Address option, if the address is specified
+static int writeLinkLayerAddressOption(unsigned char *buf, unsigned int bufsize, int type, const MACAddress& address)
+{
+    if (address.isUnspecified())
+        return 0;
+    checkBufferSize(8, bufsize);
+    buf[0] = type;
+    buf[1] = 1;
+    for (int k=0; k<6; k++)
+        buf[2+k] = address.getAddressByte(k);
+    return 8;
+}
+
+// Returns the Link-Layer Address option of the given type, or an unspecified address
+static MACAddress readLinkLayerAddressOption(const unsigned char *options, unsigned int length, int type)
+{
+    MACAddress address;
+    for (unsigned int pos = 0; pos + 2 <= length; )
+    {
+        const struct nd_opt_hdr *opt = (struct nd_opt_hdr *) (options + pos);
+        unsigned int optLength = opt->nd_opt_len * 8;
+        if (optLength == 0 || pos + optLength > length)
+            break;
+        if (opt->nd_opt_type == type && optLength >= 8)
+            address.setAddressBytes((unsigned char *)options + pos + 2);
+        pos += optLength;
+    }
+    return address;
+}
+
+int ICMPv6Serializer::serialize(ICMPv6Message *pkt, unsigned char *buf, unsigned int bufsize)
+{
+    struct icmp6_hdr *icmp6 = (struct icmp6_hdr *) buf;
+    int packetLength;
+
+    packetLength = ICMPv6_HEADER_BYTES;
+
+    checkBufferSize(packetLength, bufsize);
+    icmp6->icmp6_type = pkt->getType();
+    icmp6->icmp6_code = 0;
+    icmp6->icmp6_cksum = 0;
+    icmp6->icmp6_data32[0] = 0;
+
+    switch(pkt->getType())
+    {
+        case ICMPv6_ECHO_REQUEST:
+        case ICMPv6_ECHO_REPLY:
+        {
+            // identifier and sequence number are taken from the ping payload, as in ICMPSerializer
+            cPacket *payload = pkt->getEncapsulatedMsg();
+            PingPayload *pp = dynamic_cast<PingPayload *>(payload);
+            unsigned int datalen = 0;
+            if (pp)
+            {
+                icmp6->icmp6_id  = htons(pp->getOriginatorId());
+                icmp6->icmp6_seq = htons(pp->getSeqNo());
+                datalen = std::min((unsigned int)std::max(pp->getByteLength() - 4, (int64)0), bufsize - packetLength);
+                unsigned int arraylen = std::min(datalen, pp->getDataArraySize());
+                for (unsigned int i=0; i < arraylen; i++)
+                    buf[packetLength + i] = pp->getData(i);
+                memset(buf + packetLength + arraylen, 'a', datalen - arraylen);
+            }
+            else if (payload)
+            {
+                datalen = std::min((unsigned int)payload->getByteLength(), bufsize - packetLength);
+                memset(buf + packetLength, 0, datalen);
+            }
+            packetLength += datalen;
+            break;
+        }
+        case ICMPv6_DESTINATION_UNREACHABLE:
+        case ICMPv6_PACKET_TOO_BIG:
+        case ICMPv6_TIME_EXCEEDED:
+        case ICMPv6_PARAMETER_PROBLEM:
+        {
+            if (dynamic_cast<ICMPv6DestUnreachableMsg *>(pkt))
+                icmp6->icmp6_code = ((ICMPv6DestUnreachableMsg *)pkt)->getCode();
+            else if (dynamic_cast<ICMPv6PacketTooBigMsg *>(pkt))
+            {
+                icmp6->icmp6_code = ((ICMPv6PacketTooBigMsg *)pkt)->getCode();
+                icmp6->icmp6_mtu  = htonl(((ICMPv6PacketTooBigMsg *)pkt)->getMTU());
+            }
+            else if (dynamic_cast<ICMPv6TimeExceededMsg *>(pkt))
+                icmp6->icmp6_code = ((ICMPv6TimeExceededMsg *)pkt)->getCode();
+            else if (dynamic_cast<ICMPv6ParamProblemMsg *>(pkt))
+                icmp6->icmp6_code = ((ICMPv6ParamProblemMsg *)pkt)->getCode();
+
+            // as much of the invoking packet as fits into the minimum MTU (RFC 4443 2.4)
+            IPv6Datagram *dgram = check_and_cast<IPv6Datagram *>(pkt->getEncapsulatedMsg());
+            int dgramLength = IPv6Serializer().serialize(dgram, buf + packetLength, bufsize - packetLength);
+            int quotedLength = std::min(dgramLength, IPV6_MMTU - (int)sizeof(struct ip6_hdr) - ICMPv6_HEADER_BYTES);
+            // leave nothing behind the message (see PcapWriter::beginRecord())
+            memset(buf + packetLength + quotedLength, 0, dgramLength - quotedLength);
+            packetLength += quotedLength;
+            break;
+        }
+        case ICMPv6_ROUTER_SOL:
+        {
+            IPv6RouterSolicitation *rs = check_and_cast<IPv6RouterSolicitation *>(pkt);
+            packetLength = sizeof(struct nd_router_solicit);
+            checkBufferSize(packetLength, bufsize);
+            packetLength += writeLinkLayerAddressOption(buf + packetLength, bufsize - packetLength, ND_OPT_SOURCE_LINKADDR, rs->getSourceLinkLayerAddress());
+            break;
+        }
+        case ICMPv6_ROUTER_AD:
+        {
+            IPv6RouterAdvertisement *ra = check_and_cast<IPv6RouterAdvertisement *>(pkt);
+            struct nd_router_advert *nd_ra = (struct nd_router_advert *) buf;
+            checkBufferSize(sizeof(struct nd_router_advert), bufsize);
+            nd_ra->nd_ra_curhoplimit     = ra->getCurHopLimit();
+            nd_ra->nd_ra_flags_reserved  = (ra->getManagedAddrConfFlag() ? ND_RA_FLAG_MANAGED : 0) |
+                                           (ra->getOtherStatefulConfFlag() ? ND_RA_FLAG_OTHER : 0) |
+                                           (ra->getHomeAgentFlag() ? ND_RA_FLAG_HOME_AGENT : 0);
+            nd_ra->nd_ra_router_lifetime = htons(ra->getRouterLifetime());
+            nd_ra->nd_ra_reachable       = htonl(ra->getReachableTime());
+            nd_ra->nd_ra_retransmit      = htonl(ra->getRetransTimer());
+            packetLength = sizeof(struct nd_router_advert);
+            packetLength += writeLinkLayerAddressOption(buf + packetLength, bufsize - packetLength, ND_OPT_SOURCE_LINKADDR, ra->getSourceLinkLayerAddress());
+            if (ra->getMTU() != 0)
+            {
+                checkBufferSize(packetLength + sizeof(struct nd_opt_mtu), bufsize);
+                struct nd_opt_mtu *mtu = (struct nd_opt_mtu *) (buf + packetLength);
+                mtu->nd_opt_mtu_type     = ND_OPT_MTU;
+                mtu->nd_opt_mtu_len      = sizeof(struct nd_opt_mtu) / 8;
+                mtu->nd_opt_mtu_reserved = 0;
+                mtu->nd_opt_mtu_mtu      = htonl(ra->getMTU());
+                packetLength += sizeof(struct nd_opt_mtu);
+            }
+            for (unsigned int i=0; i<ra->getPrefixInformationArraySize(); i++)
+            {
+                IPv6NDPrefixInformation& info = ra->getPrefixInformation(i);
+                checkBufferSize(packetLength + sizeof(struct nd_opt_prefix_info), bufsize);
+                struct nd_opt_prefix_info *pi = (struct nd_opt_prefix_info *) (buf + packetLength);
+                pi->nd_opt_pi_type           = ND_OPT_PREFIX_INFORMATION;
+                pi->nd_opt_pi_len            = sizeof(struct nd_opt_prefix_info) / 8;
+                pi->nd_opt_pi_prefix_len     = info.getPrefixLength();
+                pi->nd_opt_pi_flags_reserved = (info.getOnlinkFlag() ? ND_OPT_PI_FLAG_ONLINK : 0) |
+                                               (info.getAutoAddressConfFlag() ? ND_OPT_PI_FLAG_AUTO : 0) |
+                                               (info.getRouterAddress() ? ND_OPT_PI_FLAG_ROUTER : 0);
+                pi->nd_opt_pi_valid_time     = htonl(info.getValidLifetime());
+                pi->nd_opt_pi_preferred_time = htonl(info.getPreferredLifetime());
+                pi->nd_opt_pi_reserved2      = 0;
+                IPv6Serializer::writeAddress(info.getPrefix(), pi->nd_opt_pi_prefix);
+                packetLength += sizeof(struct nd_opt_prefix_info);
+            }
+            break;
+        }
+        case ICMPv6_NEIGHBOUR_SOL:
+        {
+            IPv6NeighbourSolicitation *ns = check_and_cast<IPv6NeighbourSolicitation *>(pkt);
+            struct nd_neighbor_solicit *nd_ns = (struct nd_neighbor_solicit *) buf;
+            checkBufferSize(sizeof(struct nd_neighbor_solicit), bufsize);
+            IPv6Serializer::writeAddress(ns->getTargetAddress(), nd_ns->nd_ns_target);
+            packetLength = sizeof(struct nd_neighbor_solicit);
+            packetLength += writeLinkLayerAddressOption(buf + packetLength, bufsize - packetLength, ND_OPT_SOURCE_LINKADDR, ns->getSourceLinkLayerAddress());
+            break;
+        }
+        case ICMPv6_NEIGHBOUR_AD:
+        {
+            IPv6NeighbourAdvertisement *na = check_and_cast<IPv6NeighbourAdvertisement *>(pkt);
+            struct nd_neighbor_advert *nd_na = (struct nd_neighbor_advert *) buf;
+            checkBufferSize(sizeof(struct nd_neighbor_advert), bufsize);
+            nd_na->nd_na_flags_reserved = htonl((na->getRouterFlag() ? ND_NA_FLAG_ROUTER : 0) |
+                                                (na->getSolicitedFlag() ? ND_NA_FLAG_SOLICITED : 0) |
+                                                (na->getOverrideFlag() ? ND_NA_FLAG_OVERRIDE : 0));
+            IPv6Serializer::writeAddress(na->getTargetAddress(), nd_na->nd_na_target);
+            packetLength = sizeof(struct nd_neighbor_advert);
+            packetLength += writeLinkLayerAddressOption(buf + packetLength, bufsize - packetLength, ND_OPT_TARGET_LINKADDR, na->getTargetLinkLayerAddress());
+            break;
+        }
+        case ICMPv6_REDIRECT:
+        {
+            IPv6Redirect *redirect = check_and_cast<IPv6Redirect *>(pkt);
+            struct nd_redirect *nd_rd = (struct nd_redirect *) buf;
+            checkBufferSize(sizeof(struct nd_redirect), bufsize);
+            IPv6Serializer::writeAddress(redirect->getTargetAddress(), nd_rd->nd_rd_target);
+            IPv6Serializer::writeAddress(redirect->getDestinationAddress(), nd_rd->nd_rd_dst);
+            packetLength = sizeof(struct nd_redirect);
+            packetLength += writeLinkLayerAddressOption(buf + packetLength, bufsize - packetLength, ND_OPT_TARGET_LINKADDR, redirect->getTargetLinkLayerAddress());
+            break;
+        }
+        default:
+        {
+            packetLength = 0;
+            EV << "Can not serialize ICMPv6 packet: type " << pkt->getType() << " not supported.";
+            break;
+        }
+    }
+    return packetLength;
+}
+
+ICMPv6Message *ICMPv6Serializer::parse(unsigned char *buf, unsigned int bufsize)
+{
+    struct icmp6_hdr *icmp6 = (struct icmp6_hdr *) buf;
+    ICMPv6Message *pkt = NULL;
+
+    if (bufsize < ICMPv6_HEADER_BYTES)
+    {
+        EV << "Can not create ICMPv6 packet of " << bufsize << " bytes.";
+        return NULL;
+    }
+
+    switch(icmp6->icmp6_type)
+    {
+        case ICMPv6_ECHO_REQUEST:
+        case ICMPv6_ECHO_REPLY:
+        {
+            PingPayload *pp;
+            char name[32];
+
+            if (icmp6->icmp6_type == ICMPv6_ECHO_REQUEST)
+            {
+                ICMPv6EchoRequestMsg *request = new ICMPv6EchoRequestMsg();
+                request->setIdentifier(ntohs(icmp6->icmp6_id));
+                request->setSeqNumber(ntohs(icmp6->icmp6_seq));
+                sprintf(name,"ping%d", ntohs(icmp6->icmp6_seq));
+                pkt = request;
+            }
+            else
+            {
+                ICMPv6EchoReplyMsg *reply = new ICMPv6EchoReplyMsg();
+                reply->setIdentifier(ntohs(icmp6->icmp6_id));
+                reply->setSeqNumber(ntohs(icmp6->icmp6_seq));
+                sprintf(name,"ping%d-reply", ntohs(icmp6->icmp6_seq));
+                pkt = reply;
+            }
+            pkt->setByteLength(4);
+            pp = new PingPayload(name);
+            pp->setOriginatorId(ntohs(icmp6->icmp6_id));
+            pp->setSeqNo(ntohs(icmp6->icmp6_seq));
+            pp->setByteLength(bufsize - 4);
+            pp->setDataArraySize(bufsize - ICMPv6_HEADER_BYTES);
+            for (unsigned int i=0; i<bufsize - ICMPv6_HEADER_BYTES; i++)
+                pp->setData(i, buf[ICMPv6_HEADER_BYTES + i]);
+            pkt->encapsulate(pp);
+            pkt->setName(pp->getName());
+            break;
+        }
+        case ICMPv6_DESTINATION_UNREACHABLE:
+        case ICMPv6_PACKET_TOO_BIG:
+        case ICMPv6_TIME_EXCEEDED:
+        case ICMPv6_PARAMETER_PROBLEM:
+        {
+            switch (icmp6->icmp6_type)
+            {
+              case ICMPv6_DESTINATION_UNREACHABLE:
+              {
+                ICMPv6DestUnreachableMsg *msg = new ICMPv6DestUnreachableMsg("unreachable-from-wire");
+                msg->setCode(icmp6->icmp6_code);
+                pkt = msg;
+                break;
+              }
+              case ICMPv6_PACKET_TOO_BIG:
+              {
+                ICMPv6PacketTooBigMsg *msg = new ICMPv6PacketTooBigMsg("toobig-from-wire");
+                msg->setCode(icmp6->icmp6_code);
+                msg->setMTU(ntohl(icmp6->icmp6_mtu));
+                pkt = msg;
+                break;
+              }
+              case ICMPv6_TIME_EXCEEDED:
+              {
+                ICMPv6TimeExceededMsg *msg = new ICMPv6TimeExceededMsg("timeexceeded-from-wire");
+                msg->setCode(icmp6->icmp6_code);
+                pkt = msg;
+                break;
+              }
+              default:
+              {
+                ICMPv6ParamProblemMsg *msg = new ICMPv6ParamProblemMsg("paramproblem-from-wire");
+                msg->setCode(icmp6->icmp6_code);
+                pkt = msg;
+                break;
+              }
+            }
+            pkt->setByteLength(ICMPv6_HEADER_BYTES);
+            if (bufsize >= ICMPv6_HEADER_BYTES + sizeof(struct ip6_hdr))
+            {
+                IPv6Datagram *dgram = new IPv6Datagram("ipv6-from-wire");
+                IPv6Serializer().parse(buf + ICMPv6_HEADER_BYTES, bufsize - ICMPv6_HEADER_BYTES, dgram);
+                pkt->encapsulate(dgram);
+            }
+            break;
+        }
+        case ICMPv6_ROUTER_SOL:
+        {
+            if (bufsize < sizeof(struct nd_router_solicit))
+                break;
+            IPv6RouterSolicitation *rs = new IPv6RouterSolicitation("RSpacket");
+            rs->setSourceLinkLayerAddress(readLinkLayerAddressOption(buf + sizeof(struct nd_router_solicit),
+                    bufsize - sizeof(struct nd_router_solicit), ND_OPT_SOURCE_LINKADDR));
+            pkt = rs;
+            break;
+        }
+        case ICMPv6_ROUTER_AD:
+        {
+            if (bufsize < sizeof(struct nd_router_advert))
+                break;
+            struct nd_router_advert *nd_ra = (struct nd_router_advert *) buf;
+            IPv6RouterAdvertisement *ra = new IPv6RouterAdvertisement("RApacket");
+            ra->setCurHopLimit(nd_ra->nd_ra_curhoplimit);
+            ra->setManagedAddrConfFlag(nd_ra->nd_ra_flags_reserved & ND_RA_FLAG_MANAGED);
+            ra->setOtherStatefulConfFlag(nd_ra->nd_ra_flags_reserved & ND_RA_FLAG_OTHER);
+            ra->setHomeAgentFlag(nd_ra->nd_ra_flags_reserved & ND_RA_FLAG_HOME_AGENT);
+            ra->setRouterLifetime(ntohs(nd_ra->nd_ra_router_lifetime));
+            ra->setReachableTime(ntohl(nd_ra->nd_ra_reachable));
+            ra->setRetransTimer(ntohl(nd_ra->nd_ra_retransmit));
+
+            unsigned char *options = buf + sizeof(struct nd_router_advert);
+            unsigned int length = bufsize - sizeof(struct nd_router_advert);
+            ra->setSourceLinkLayerAddress(readLinkLayerAddressOption(options, length, ND_OPT_SOURCE_LINKADDR));
+
+            for (unsigned int pos = 0; pos + 2 <= length; )
+            {
+                const struct nd_opt_hdr *opt = (struct nd_opt_hdr *) (options + pos);
+                unsigned int optLength = opt->nd_opt_len * 8;
+                if (optLength == 0 || pos + optLength > length)
+                    break;
+                if (opt->nd_opt_type == ND_OPT_MTU && optLength >= sizeof(struct nd_opt_mtu))
+                    ra->setMTU(ntohl(((struct nd_opt_mtu *)opt)->nd_opt_mtu_mtu));
+                else if (opt->nd_opt_type == ND_OPT_PREFIX_INFORMATION && optLength >= sizeof(struct nd_opt_prefix_info))
+                {
+                    const struct nd_opt_prefix_info *pi = (struct nd_opt_prefix_info *) opt;
+                    unsigned int k = ra->getPrefixInformationArraySize();
+                    ra->setPrefixInformationArraySize(k+1);
+                    IPv6NDPrefixInformation& info = ra->getPrefixInformation(k);
+                    info.setPrefixLength(pi->nd_opt_pi_prefix_len);
+                    info.setOnlinkFlag(pi->nd_opt_pi_flags_reserved & ND_OPT_PI_FLAG_ONLINK);
+                    info.setAutoAddressConfFlag(pi->nd_opt_pi_flags_reserved & ND_OPT_PI_FLAG_AUTO);
+                    info.setRouterAddress(pi->nd_opt_pi_flags_reserved & ND_OPT_PI_FLAG_ROUTER);
+                    info.setValidLifetime(ntohl(pi->nd_opt_pi_valid_time));
+                    info.setPreferredLifetime(ntohl(pi->nd_opt_pi_preferred_time));
+                    info.setPrefix(IPv6Serializer::readAddress(pi->nd_opt_pi_prefix));
+                }
+                pos += optLength;
+            }
+            pkt = ra;
+            break;
+        }
+        case ICMPv6_NEIGHBOUR_SOL:
+        {
+            if (bufsize < sizeof(struct nd_neighbor_solicit))
+                break;
+            struct nd_neighbor_solicit *nd_ns = (struct nd_neighbor_solicit *) buf;
+            IPv6NeighbourSolicitation *ns = new IPv6NeighbourSolicitation("NSpacket");
+            ns->setTargetAddress(IPv6Serializer::readAddress(nd_ns->nd_ns_target));
+            ns->setSourceLinkLayerAddress(readLinkLayerAddressOption(buf + sizeof(struct nd_neighbor_solicit),
+                    bufsize - sizeof(struct nd_neighbor_solicit), ND_OPT_SOURCE_LINKADDR));
+            pkt = ns;
+            break;
+        }
+        case ICMPv6_NEIGHBOUR_AD:
+        {
+            if (bufsize < sizeof(struct nd_neighbor_advert))
+                break;
+            struct nd_neighbor_advert *nd_na = (struct nd_neighbor_advert *) buf;
+            IPv6NeighbourAdvertisement *na = new IPv6NeighbourAdvertisement("NApacket");
+            uint32 flags = ntohl(nd_na->nd_na_flags_reserved);
+            na->setRouterFlag(flags & ND_NA_FLAG_ROUTER);
+            na->setSolicitedFlag(flags & ND_NA_FLAG_SOLICITED);
+            na->setOverrideFlag(flags & ND_NA_FLAG_OVERRIDE);
+            na->setTargetAddress(IPv6Serializer::readAddress(nd_na->nd_na_target));
+            na->setTargetLinkLayerAddress(readLinkLayerAddressOption(buf + sizeof(struct nd_neighbor_advert),
+                    bufsize - sizeof(struct nd_neighbor_advert), ND_OPT_TARGET_LINKADDR));
+            pkt = na;
+            break;
+        }
+        case ICMPv6_REDIRECT:
+        {
+            if (bufsize < sizeof(struct nd_redirect))
+                break;
+            struct nd_redirect *nd_rd = (struct nd_redirect *) buf;
+            IPv6Redirect *redirect = new IPv6Redirect("redirectMsg");
+            redirect->setTargetAddress(IPv6Serializer::readAddress(nd_rd->nd_rd_target));
+            redirect->setDestinationAddress(IPv6Serializer::readAddress(nd_rd->nd_rd_dst));
+            redirect->setTargetLinkLayerAddress(readLinkLayerAddressOption(buf + sizeof(struct nd_redirect),
+                    bufsize - sizeof(struct nd_redirect), ND_OPT_TARGET_LINKADDR));
+            pkt = redirect;
+            break;
+        }
+        default:
+        {
+            EV << "Can not create ICMPv6 packet: type " << (int)icmp6->icmp6_type << " not supported.";
+            break;
+        }
+    }
+
+    if (pkt)
+    {
+        pkt->setType(icmp6->icmp6_type);
+        // ND messages are not encapsulating anything, so their length is that of the message
+        if (dynamic_cast<IPv6NDMessage *>(pkt))
+            pkt->setByteLength(bufsize);
+    }
+    return pkt;
+}
@@ -0,0 +1,48 @@
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef __INET_ICMPV6SERIALIZER_H
+#define __INET_ICMPV6SERIALIZER_H
+
+#include "ICMPv6Message_m.h"
+
+
+/**
+ * Converts between ICMPv6Message (including the IPv6NDMessage subclasses)
+ * and binary (network byte order) ICMPv6 message.
+ */
+class ICMPv6Serializer
+{
+    public:
+        ICMPv6Serializer() {}
+
+        /**
+         * Serializes an ICMPv6Message for transmission on the wire.
+         * The checksum is NOT filled in, because it covers the IPv6 pseudo
+         * header: IPv6Serializer does that.
+         * Returns the length of data written into buffer.
+         */
+        int serialize(ICMPv6Message *pkt, unsigned char *buf, unsigned int bufsize);
+
+        /**
+         * Creates an ICMPv6Message of the subclass matching the type of
+         * a packet sniffed from the wire, or returns NULL if the type is
+         * not supported.
+         */
+        ICMPv6Message *parse(unsigned char *buf, unsigned int bufsize);
+};
+
+#endif
+
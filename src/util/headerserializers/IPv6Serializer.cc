@@ -0,0 +1,404 @@
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+
+#include <algorithm> // std::min
+#include <string.h>
+#include "headers/defs.h"
+
+namespace INETFw // load headers into a namespace, to avoid conflicts with platform definitions of the same stuff
+{
+#include "headers/bsdint.h"
+#include "headers/in.h"
+#include "headers/in_systm.h"
+#include "headers/ip6.h"
+};
+
+#include "IPv6Serializer.h"
+#include "IPv6ExtensionHeaders.h"
+#include "ICMPv6Serializer.h"
+#include "MobilityHeaderSerializer.h"
+#include "UDPSerializer.h"
+#include "SCTPSerializer.h"
+#include "TCPSerializer.h"
+#include "Checksum.h"
+
+#if !defined(_WIN32) && !defined(__WIN32__) && !defined(WIN32) && !defined(__CYGWIN__) && !defined(_WIN64)
+#include <netinet/in.h>  // htonl, ntohl, ...
+#endif
+
+
+using namespace INETFw;
+
+#define IPv6_HEADER_BYTES  ((unsigned int)sizeof(struct ip6_hdr))
+#define HAO_HEADER_BYTES   24   // Destination Options header with PadN and Home Address option
+
+
+// The ones' complement sum of the pseudo header of upper-layer checksums
+static uint16 pseudoHeaderSum(const IPv6Address& src, const IPv6Address& dest, uint32 length, uint8 nextHeader)
+{
+    unsigned char pseudo[40];
+    IPv6Serializer::writeAddress(src, pseudo);
+    IPv6Serializer::writeAddress(dest, pseudo+16);
+    length = htonl(length);
+    memcpy(pseudo+32, &length, 4);
+    pseudo[36] = pseudo[37] = pseudo[38] = 0;
+    pseudo[39] = nextHeader;
+    return Checksum::internetSum(pseudo, sizeof(pseudo));
+}
+
+static void checkBufferSize(unsigned int length, unsigned int bufsize)
+{
+    if (length > bufsize)
+        opp_error("IPv6Serializer: buffer of %d bytes is too short for the IPv6 header", bufsize);
+}
+
+// Fills the options area of a Hop-by-Hop or Destination Options header with one PadN option
+static void writePadding(unsigned char *buf, unsigned int len)
+{
+    struct ip6_opt *opt = (struct ip6_opt *) buf;
+    opt->ip6o_type = IP6OPT_PADN;
+    opt->ip6o_len  = len - 2;
+    memset(buf + 2, 0, len - 2);
+}
+
+void IPv6Serializer::writeAddress(const IPv6Address& addr, unsigned char *buf)
+{
+    const uint32 *words = addr.words();
+    for (int i=0; i<4; i++)
+    {
+        uint32 word = htonl(words[i]);
+        memcpy(buf + 4*i, &word, 4);
+    }
+}
+
+IPv6Address IPv6Serializer::readAddress(const unsigned char *buf)
+{
+    uint32 words[4];
+    memcpy(words, buf, 16);
+    return IPv6Address(ntohl(words[0]), ntohl(words[1]), ntohl(words[2]), ntohl(words[3]));
+}
+
+int IPv6Serializer::serialize(IPv6Datagram *dgram, unsigned char *buf, unsigned int bufsize)
+{
+    struct ip6_hdr *ip6 = (struct ip6_hdr *) buf;
+    unsigned int headerLength = IPv6_HEADER_BYTES;
+
+    checkBufferSize(headerLength, bufsize);
+
+    ip6->ip6_flow = htonl(IPV6_VERSION | (dgram->getTrafficClass() & 0xff) << IPV6_TCLASS_SHIFT | (dgram->getFlowLabel() & IPV6_FLOWLABEL_MASK));
+    ip6->ip6_hlim = dgram->getHopLimit();
+    writeAddress(dgram->getSrcAddress(), ip6->ip6_src);
+    writeAddress(dgram->getDestAddress(), ip6->ip6_dst);
+
+    // the upper-layer checksum is computed with the home address as source
+    // if there's a Home Address option (RFC 3775 6.3), and with the final
+    // destination if there's a Routing header (RFC 2460 8.1)
+    IPv6Address checksumSrc = dgram->getSrcAddress();
+    IPv6Address checksumDest = dgram->getDestAddress();
+
+    // only the first fragment starts with the upper-layer header
+    bool firstFragment = true;
+
+    uint8 *nextHeader = &ip6->ip6_nxt;
+    for (unsigned int i=0; i<dgram->getExtensionHeaderArraySize(); i++)
+    {
+        IPv6ExtensionHeader *eh = dgram->getExtensionHeader(i);
+        unsigned char *ext = buf + headerLength;
+        unsigned int extLength;
+
+        if (dynamic_cast<HomeAddressOption *>(eh))
+        {
+            // the option must be at 8n+6 (RFC 3775 6.3), after a PadN of 4 octets
+            HomeAddressOption *hao = (HomeAddressOption *)eh;
+            extLength = HAO_HEADER_BYTES;
+            checkBufferSize(headerLength + extLength, bufsize);
+            writePadding(ext + 2, 4);
+            struct ip6_opt *opt = (struct ip6_opt *) (ext + 6);
+            opt->ip6o_type = IP6OPT_HOME_ADDRESS;
+            opt->ip6o_len  = 16;
+            writeAddress(hao->getHomeAddress(), ext + 8);
+            checksumSrc = hao->getHomeAddress();
+        }
+        else if (dynamic_cast<IPv6DestinationOptionsHeader *>(eh) || dynamic_cast<IPv6HopByHopOptionsHeader *>(eh))
+        {
+            // options are not modelled
+            extLength = 8;
+            checkBufferSize(headerLength + extLength, bufsize);
+            writePadding(ext + 2, 6);
+        }
+        else if (dynamic_cast<IPv6RoutingHeader *>(eh))
+        {
+            IPv6RoutingHeader *rh = (IPv6RoutingHeader *)eh;
+            struct ip6_rthdr *rthdr = (struct ip6_rthdr *) ext;
+            unsigned int numAddresses = rh->getAddressArraySize();
+            extLength = sizeof(struct ip6_rthdr) + 16 * numAddresses;
+            checkBufferSize(headerLength + extLength, bufsize);
+            rthdr->ip6r_type     = rh->getRoutingType();
+            rthdr->ip6r_segleft  = rh->getSegmentsLeft();
+            rthdr->ip6r_reserved = 0;
+            for (unsigned int k=0; k<numAddresses; k++)
+                writeAddress(rh->getAddress(k), ext + sizeof(struct ip6_rthdr) + 16*k);
+            if (numAddresses > 0 && rh->getSegmentsLeft() > 0)
+                checksumDest = rh->getAddress(numAddresses-1);
+        }
+        else if (dynamic_cast<IPv6FragmentHeader *>(eh))
+        {
+            // the fragment offset of the model is in octets
+            IPv6FragmentHeader *fh = (IPv6FragmentHeader *)eh;
+            struct ip6_frag *frag = (struct ip6_frag *) ext;
+            extLength = sizeof(struct ip6_frag);
+            checkBufferSize(headerLength + extLength, bufsize);
+            frag->ip6f_reserved = 0;
+            frag->ip6f_offlg = htons((fh->getFragmentOffset() & IP6F_OFF_MASK) | (fh->getMoreFragments() ? IP6F_MORE_FRAG : 0));
+            frag->ip6f_ident = htonl(fh->getIdentification());
+            firstFragment = fh->getFragmentOffset() == 0;
+        }
+        else
+        {
+            opp_error("IPv6Serializer: cannot serialize extension header %s", eh->getClassName());
+        }
+
+        // the length is in 8-octet units, not including the first 8 octets
+        ((struct ip6_ext *)ext)->ip6e_len = extLength / 8 - 1;
+        *nextHeader = eh->getExtensionType();
+        nextHeader = &((struct ip6_ext *)ext)->ip6e_nxt;
+        headerLength += extLength;
+    }
+
+    *nextHeader = dgram->getTransportProtocol();
+
+    unsigned char *payload = buf + headerLength;
+    unsigned int payloadBufsize = bufsize - headerLength;
+    int payloadLength = 0;
+    int checksumOffset = -1;  // of the upper-layer checksum in the payload
+
+    cPacket *encapPacket = dgram->getEncapsulatedMsg();
+    switch (firstFragment ? dgram->getTransportProtocol() : IP_PROT_NONE)
+    {
+      case IP_PROT_IPv6_ICMP:
+        payloadLength = ICMPv6Serializer().serialize(check_and_cast<ICMPv6Message *>(encapPacket), payload, payloadBufsize);
+        checksumOffset = 2;
+        break;
+      case IP_PROT_IPv6EXT_MOB:
+        payloadLength = MobilityHeaderSerializer().serialize(check_and_cast<MobilityHeader *>(encapPacket), payload, payloadBufsize);
+        checksumOffset = 4;
+        break;
+      case IP_PROT_UDP:
+        payloadLength = UDPSerializer().serialize(check_and_cast<UDPPacket *>(encapPacket), payload, payloadBufsize);
+        checksumOffset = 6;
+        break;
+      case IP_PROT_TCP:
+      {
+        // TCPSerializer adds the sum of the IPv4 pseudo header; it's recomputed below
+        pseudoheader pseudo;
+        memset(&pseudo, 0, sizeof(pseudo));
+        payloadLength = TCPSerializer().serialize(check_and_cast<TCPSegment *>(encapPacket), payload, payloadBufsize, &pseudo);
+        checksumOffset = 16;
+        break;
+      }
+      case IP_PROT_SCTP:
+        payloadLength = SCTPSerializer().serialize(check_and_cast<SCTPMessage *>(encapPacket), payload, payloadBufsize);
+        break;
+      case IP_PROT_IPv6:
+        payloadLength = IPv6Serializer().serialize(check_and_cast<IPv6Datagram *>(encapPacket), payload, payloadBufsize);
+        break;
+      case IP_PROT_NONE:
+        // fragments other than the first one carry opaque payload
+        if (encapPacket)
+        {
+            payloadLength = std::min((unsigned int)encapPacket->getByteLength(), payloadBufsize);
+            memset(payload, 0, payloadLength);
+        }
+        break;
+      default:
+        opp_error("IPv6Serializer: cannot serialize protocol %d", dgram->getTransportProtocol());
+    }
+
+    if (checksumOffset >= 0 && payloadLength > checksumOffset)
+    {
+        uint16 *checksum = (uint16 *)(payload + checksumOffset);
+        *checksum = 0;
+        *checksum = Checksum::internetChecksum(payload, payloadLength,
+                pseudoHeaderSum(checksumSrc, checksumDest, payloadLength, dgram->getTransportProtocol()));
+    }
+
+    ip6->ip6_plen = htons(headerLength - IPv6_HEADER_BYTES + payloadLength);
+    return headerLength + payloadLength;
+}
+
+void IPv6Serializer::parse(unsigned char *buf, unsigned int bufsize, IPv6Datagram *dest)
+{
+    const struct ip6_hdr *ip6 = (struct ip6_hdr *) buf;
+    unsigned int totalLength, headerLength;
+
+    if (bufsize < IPv6_HEADER_BYTES)
+    {
+        EV << "Can not handle IPv6 packet of " << bufsize << " bytes.\n";
+        return;
+    }
+
+    uint32 flow = ntohl(ip6->ip6_flow);
+    dest->setTrafficClass((flow >> IPV6_TCLASS_SHIFT) & 0xff);
+    dest->setFlowLabel(flow & IPV6_FLOWLABEL_MASK);
+    dest->setHopLimit(ip6->ip6_hlim);
+    dest->setSrcAddress(readAddress(ip6->ip6_src));
+    dest->setDestAddress(readAddress(ip6->ip6_dst));
+    totalLength = IPv6_HEADER_BYTES + ntohs(ip6->ip6_plen);
+    headerLength = IPv6_HEADER_BYTES;
+
+    if (totalLength > bufsize)
+    {
+        EV << "Can not handle IPv6 packet of total length " << totalLength << "(captured only " << bufsize << " bytes).\n";
+        totalLength = bufsize;
+    }
+
+    HomeAddressOption *hao = NULL;
+    bool firstFragment = true;
+    int nextHeader = ip6->ip6_nxt;
+    bool isExtensionHeader = true;
+    while (isExtensionHeader && headerLength + 8 <= totalLength)
+    {
+        const unsigned char *ext = buf + headerLength;
+        unsigned int extLength = (((struct ip6_ext *)ext)->ip6e_len + 1) * 8;
+
+        switch (nextHeader)
+        {
+          case IP_PROT_IPv6EXT_HOP:
+            dest->addExtensionHeader(new IPv6HopByHopOptionsHeader());
+            break;
+          case IP_PROT_IPv6EXT_DEST:
+          {
+            // look for a Home Address option, the other options are not modelled
+            for (unsigned int pos = 2; !hao && pos + 2 <= extLength && headerLength + pos + 2 <= totalLength; )
+            {
+                const struct ip6_opt *opt = (struct ip6_opt *) (ext + pos);
+                if (opt->ip6o_type == IP6OPT_PAD1)
+                {
+                    pos++;
+                    continue;
+                }
+                if (opt->ip6o_type == IP6OPT_HOME_ADDRESS && opt->ip6o_len == 16 && headerLength + pos + 18 <= totalLength)
+                {
+                    hao = new HomeAddressOption();
+                    hao->setHomeAddress(readAddress(ext + pos + 2));
+                }
+                pos += 2 + opt->ip6o_len;
+            }
+            if (hao)
+                dest->addExtensionHeader(hao);
+            else
+                dest->addExtensionHeader(new IPv6DestinationOptionsHeader());
+            break;
+          }
+          case IP_PROT_IPv6EXT_ROUTING:
+          {
+            const struct ip6_rthdr *rthdr = (struct ip6_rthdr *) ext;
+            IPv6RoutingHeader *rh = new IPv6RoutingHeader();
+            rh->setRoutingType(rthdr->ip6r_type);
+            rh->setSegmentsLeft(rthdr->ip6r_segleft);
+            if (rthdr->ip6r_type == IPV6_RTHDR_TYPE_0 || rthdr->ip6r_type == IPV6_RTHDR_TYPE_2)
+            {
+                unsigned int numAddresses = rthdr->ip6r_len / 2;
+                while (numAddresses > 0 && headerLength + sizeof(struct ip6_rthdr) + 16 * numAddresses > totalLength)
+                    numAddresses--;
+                rh->setAddressArraySize(numAddresses);
+                for (unsigned int k=0; k<numAddresses; k++)
+                    rh->setAddress(k, readAddress(ext + sizeof(struct ip6_rthdr) + 16*k));
+            }
+            dest->addExtensionHeader(rh);
+            break;
+          }
+          case IP_PROT_IPv6EXT_FRAGMENT:
+          {
+            // only the first fragment starts with the upper-layer header
+            const struct ip6_frag *frag = (struct ip6_frag *) ext;
+            IPv6FragmentHeader *fh = new IPv6FragmentHeader();
+            fh->setFragmentOffset(ntohs(frag->ip6f_offlg) & IP6F_OFF_MASK);
+            fh->setMoreFragments(ntohs(frag->ip6f_offlg) & IP6F_MORE_FRAG);
+            fh->setIdentification(ntohl(frag->ip6f_ident));
+            firstFragment = fh->getFragmentOffset() == 0;
+            extLength = sizeof(struct ip6_frag);
+            dest->addExtensionHeader(fh);
+            break;
+          }
+          case IP_PROT_IPv6EXT_AUTH:
+            // the length is in 4-octet units, not including the first 8 octets
+            extLength = (((struct ip6_ext *)ext)->ip6e_len + 2) * 4;
+            dest->addExtensionHeader(new IPv6AuthenticationHeader());
+            break;
+          default:
+            isExtensionHeader = false;
+            continue;
+        }
+
+        nextHeader = ((struct ip6_ext *)ext)->ip6e_nxt;
+        headerLength = std::min(headerLength + extLength, totalLength);
+    }
+
+    dest->setTransportProtocol(nextHeader);
+    dest->setByteLength(headerLength);
+
+    unsigned char *payload = buf + headerLength;
+    unsigned int payloadLength = totalLength - headerLength;
+    cPacket *encapPacket = NULL;
+    switch (firstFragment ? nextHeader : IP_PROT_NONE)
+    {
+      case IP_PROT_IPv6_ICMP:
+        encapPacket = ICMPv6Serializer().parse(payload, payloadLength);
+        break;
+      case IP_PROT_IPv6EXT_MOB:
+      {
+        MobilityHeader *mh = MobilityHeaderSerializer().parse(payload, payloadLength);
+        // the address the binding is for is that of the Home Address option, or the source
+        const IPv6Address& homeAddress = hao ? hao->getHomeAddress() : dest->getSrcAddress();
+        if (dynamic_cast<BindingUpdate *>(mh))
+            ((BindingUpdate *)mh)->setHomeAddressMN(homeAddress);
+        else if (dynamic_cast<FastBindingUpdate *>(mh))
+            ((FastBindingUpdate *)mh)->setPreviousCareOfAddress(homeAddress);
+        encapPacket = mh;
+        break;
+      }
+      case IP_PROT_UDP:
+        if (payloadLength >= 8)
+        {
+            encapPacket = new UDPPacket("udp-from-wire");
+            UDPSerializer().parse(payload, payloadLength, (UDPPacket *)encapPacket);
+        }
+        break;
+      case IP_PROT_SCTP:
+        encapPacket = new SCTPMessage("sctp-from-wire");
+        SCTPSerializer().parse(payload, payloadLength, (SCTPMessage *)encapPacket);
+        break;
+      case IP_PROT_IPv6:
+        encapPacket = new IPv6Datagram("ipv6-from-wire");
+        parse(payload, payloadLength, (IPv6Datagram *)encapPacket);
+        break;
+    }
+
+    // protocols without serializer, fragments, and messages that could not be parsed;
+    // TCP is among them: TCPSerializer has no parse(), and IPSerializer::parse has no TCP case either
+    if (!encapPacket && payloadLength > 0)
+    {
+        encapPacket = new cPacket("payload-from-wire");
+        encapPacket->setByteLength(payloadLength);
+    }
+
+    if (encapPacket)
+    {
+        dest->encapsulate(encapPacket);
+        dest->setName(encapPacket->getName());
+    }
+}
+
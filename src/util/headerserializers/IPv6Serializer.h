@@ -0,0 +1,61 @@
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef __INET_IPV6SERIALIZER_H
+#define __INET_IPV6SERIALIZER_H
+
+#include "IPv6Datagram.h"
+
+
+/**
+ * Converts between IPv6Datagram and binary (network byte order) IPv6
+ * header with its extension headers (Hop-by-Hop Options, Destination
+ * Options with the Home Address option, Routing, Fragment).
+ *
+ * The payload is serialized with ICMPv6Serializer, MobilityHeaderSerializer,
+ * UDPSerializer, TCPSerializer, SCTPSerializer, or recursively for IPv6 in
+ * IPv6 tunnels. The upper-layer checksums are computed here, because they
+ * cover the IPv6 pseudo header (RFC 2460 8.1).
+ */
+class IPv6Serializer
+{
+    public:
+        IPv6Serializer() {}
+
+        /**
+         * Serializes an IPv6Datagram for transmission on the wire.
+         * Returns the length of data written into buffer.
+         */
+        int serialize(IPv6Datagram *dgram, unsigned char *buf, unsigned int bufsize);
+
+        /**
+         * Puts a packet sniffed from the wire into an IPv6Datagram. Does NOT
+         * verify the checksums.
+         */
+        void parse(unsigned char *buf, unsigned int bufsize, IPv6Datagram *dest);
+
+        /**
+         * Helper: write an address in network byte order
+         */
+        static void writeAddress(const IPv6Address& addr, unsigned char *buf);
+
+        /**
+         * Helper: read an address in network byte order
+         */
+        static IPv6Address readAddress(const unsigned char *buf);
+};
+
+#endif
+
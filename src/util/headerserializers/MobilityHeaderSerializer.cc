@@ -0,0 +1,612 @@
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+
+#include <algorithm> // std::min
+#include <vector>
+#include <string.h>
+#include "headers/defs.h"
+namespace INETFw // load headers into a namespace, to avoid conflicts with platform definitions of the same stuff
+{
+#include "headers/bsdint.h"
+#include "headers/in.h"
+#include "headers/in_systm.h"
+#include "headers/icmp6.h"
+#include "headers/ip6mh.h"
+};
+#include "IPv6Serializer.h"
+#include "MobilityHeaderSerializer.h"
+
+#if !defined(_WIN32) && !defined(__WIN32__) && !defined(WIN32) && !defined(__CYGWIN__) && !defined(_WIN64)
+#include <netinet/in.h>  // htonl, ntohl, ...
+#endif
+
+
+using namespace INETFw;
+
+static void checkBufferSize(unsigned int length, unsigned int bufsize)
+{
+    if (length > bufsize)
+        opp_error("MobilityHeaderSerializer: buffer of %d bytes is too short for the Mobility Header", bufsize);
+}
+
+//
+// Mobility options (RFC 3775 6.2)
+//
+
+// Pads with Pad1 or PadN so that the next option starts at 8n+alignment
+static int writePadding(unsigned char *buf, unsigned int bufsize, int offset, int alignment)
+{
+    int len = (alignment - offset % 8 + 8) % 8;
+    checkBufferSize(offset + len, bufsize);
+    if (len == 1)
+        buf[offset] = IP6_MHOPT_PAD1;
+    else if (len > 1)
+    {
+        buf[offset] = IP6_MHOPT_PADN;
+        buf[offset+1] = len - 2;
+        memset(buf + offset + 2, 0, len - 2);
+    }
+    return offset + len;
+}
+
+// Writes the Binding Authorization Data option if the model uses it (non-zero value)
+static int writeBindingAuthorizationData(unsigned char *buf, unsigned int bufsize, int offset, int bindingAuthorizationData)
+{
+    if (bindingAuthorizationData != 0)
+    {
+        // the model's value goes into the last 32 bits of the authenticator
+        offset = writePadding(buf, bufsize, offset, 2);
+        checkBufferSize(offset + 2 + IP6_MHOPT_BAUTH_LEN, bufsize);
+        struct ip6_mh_opt *opt = (struct ip6_mh_opt *) (buf + offset);
+        opt->ip6mhopt_type = IP6_MHOPT_BAUTH;
+        opt->ip6mhopt_len = IP6_MHOPT_BAUTH_LEN;
+        memset(buf + offset + 2, 0, IP6_MHOPT_BAUTH_LEN - 4);
+        uint32 value = htonl(bindingAuthorizationData);
+        memcpy(buf + offset + 2 + IP6_MHOPT_BAUTH_LEN - 4, &value, 4);
+        offset += 2 + IP6_MHOPT_BAUTH_LEN;
+    }
+    return writePadding(buf, bufsize, offset, 0);
+}
+
+// Returns the data of the first mobility option of the given type and length, or NULL
+static const unsigned char *findMobilityOption(const unsigned char *buf, unsigned int offset, unsigned int length, int type, int optLength)
+{
+    while (offset + 2 <= length)
+    {
+        const struct ip6_mh_opt *opt = (struct ip6_mh_opt *) (buf + offset);
+        if (opt->ip6mhopt_type == IP6_MHOPT_PAD1)
+        {
+            offset++;
+            continue;
+        }
+        if (offset + 2 + opt->ip6mhopt_len > length)
+            break;
+        if (opt->ip6mhopt_type == type && opt->ip6mhopt_len == optLength)
+            return buf + offset + 2;
+        offset += 2 + opt->ip6mhopt_len;
+    }
+    return NULL;
+}
+
+static int readBindingAuthorizationData(const unsigned char *buf, unsigned int offset, unsigned int length)
+{
+    const unsigned char *data = findMobilityOption(buf, offset, length, IP6_MHOPT_BAUTH, IP6_MHOPT_BAUTH_LEN);
+    uint32 value = 0;
+    if (data)
+        memcpy(&value, data + IP6_MHOPT_BAUTH_LEN - 4, 4);
+    return ntohl(value);
+}
+
+//
+// ICMPv6 options of FMIPv6 (RFC 5568 6.4), which follow the FMIPv6
+// messages aligned to 8 octets
+//
+
+static int writeAddressOption(unsigned char *buf, unsigned int bufsize, int offset, int code, const IPv6Address& address, int prefixLength)
+{
+    checkBufferSize(offset + sizeof(struct nd_opt_ip_address), bufsize);
+    struct nd_opt_ip_address *opt = (struct nd_opt_ip_address *) (buf + offset);
+    opt->nd_opt_ipa_type       = ND_OPT_IP_ADDRESS_PREFIX;
+    opt->nd_opt_ipa_len        = sizeof(struct nd_opt_ip_address) / 8;
+    opt->nd_opt_ipa_code       = code;
+    opt->nd_opt_ipa_prefix_len = prefixLength;
+    opt->nd_opt_ipa_reserved   = 0;
+    IPv6Serializer::writeAddress(address, opt->nd_opt_ipa_address);
+    return offset + sizeof(struct nd_opt_ip_address);
+}
+
+static int writeLinkLayerAddressOption(unsigned char *buf, unsigned int bufsize, int offset, int code, const MACAddress& address)
+{
+    checkBufferSize(offset + sizeof(struct nd_opt_lla), bufsize);
+    struct nd_opt_lla *opt = (struct nd_opt_lla *) (buf + offset);
+    opt->nd_opt_lla_type = ND_OPT_LINK_LAYER_ADDRESS;
+    opt->nd_opt_lla_len  = sizeof(struct nd_opt_lla) / 8;
+    opt->nd_opt_lla_code = code;
+    for (int k=0; k<6; k++)
+        opt->nd_opt_lla_address[k] = address.getAddressByte(k);
+    memset(opt->nd_opt_lla_pad, 0, sizeof(opt->nd_opt_lla_pad));
+    return offset + sizeof(struct nd_opt_lla);
+}
+
+// Returns the next ICMPv6 option, or NULL at the end of the message
+static const struct nd_opt_hdr *nextOption(const unsigned char *buf, unsigned int& offset, unsigned int length)
+{
+    if (offset + 2 > length)
+        return NULL;
+    const struct nd_opt_hdr *opt = (struct nd_opt_hdr *) (buf + offset);
+    unsigned int optLength = opt->nd_opt_len * 8;
+    if (optLength == 0 || offset + optLength > length)
+        return NULL;
+    offset += optLength;
+    return opt;
+}
+
+static bool isAddressOption(const struct nd_opt_hdr *opt, int code)
+{
+    return opt->nd_opt_type == ND_OPT_IP_ADDRESS_PREFIX && opt->nd_opt_len * 8 >= (int)sizeof(struct nd_opt_ip_address) &&
+           ((struct nd_opt_ip_address *)opt)->nd_opt_ipa_code == code;
+}
+
+static bool isLinkLayerAddressOption(const struct nd_opt_hdr *opt, int code)
+{
+    return opt->nd_opt_type == ND_OPT_LINK_LAYER_ADDRESS && opt->nd_opt_len * 8 >= 9 &&
+           ((struct nd_opt_lla *)opt)->nd_opt_lla_code == code;
+}
+
+static MACAddress readLinkLayerAddressOption(const struct nd_opt_hdr *opt)
+{
+    MACAddress address;
+    address.setAddressBytes(((struct nd_opt_lla *)opt)->nd_opt_lla_address);
+    return address;
+}
+
+
+int MobilityHeaderSerializer::serialize(MobilityHeader *pkt, unsigned char *buf, unsigned int bufsize)
+{
+    struct ip6_mh *mh = (struct ip6_mh *) buf;
+    int packetLength;
+
+    checkBufferSize(sizeof(struct ip6_mh), bufsize);
+    mh->ip6mh_proto    = IP_PROT_NONE;
+    mh->ip6mh_type     = pkt->getMobilityHeaderType();
+    mh->ip6mh_reserved = 0;
+    mh->ip6mh_cksum    = 0;
+
+    switch (pkt->getMobilityHeaderType())
+    {
+        case BINDING_REFRESH_REQUEST:
+        {
+            checkBufferSize(sizeof(struct ip6_mh_binding_request), bufsize);
+            struct ip6_mh_binding_request *brr = (struct ip6_mh_binding_request *) buf;
+            brr->ip6mhbr_reserved = 0;
+            packetLength = sizeof(struct ip6_mh_binding_request);
+            break;
+        }
+        case HOME_TEST_INIT:
+        case CARE_OF_TEST_INIT:
+        {
+            // the model's cookies are 32 bits: they go into the low half of the 64 bit cookies
+            checkBufferSize(sizeof(struct ip6_mh_home_test_init), bufsize);
+            struct ip6_mh_home_test_init *ti = (struct ip6_mh_home_test_init *) buf;
+            ti->ip6mhhti_reserved  = 0;
+            ti->ip6mhhti_cookie[0] = 0;
+            if (pkt->getMobilityHeaderType() == HOME_TEST_INIT)
+                ti->ip6mhhti_cookie[1] = htonl(check_and_cast<HomeTestInit *>(pkt)->getHomeInitCookie());
+            else
+                ti->ip6mhhti_cookie[1] = htonl(check_and_cast<CareOfTestInit *>(pkt)->getCareOfInitCookie());
+            packetLength = sizeof(struct ip6_mh_home_test_init);
+            break;
+        }
+        case HOME_TEST:
+        case CARE_OF_TEST:
+        {
+            // nonce indices are not modelled
+            checkBufferSize(sizeof(struct ip6_mh_home_test), bufsize);
+            struct ip6_mh_home_test *t = (struct ip6_mh_home_test *) buf;
+            t->ip6mhht_nonce_index = 0;
+            t->ip6mhht_cookie[0] = 0;
+            t->ip6mhht_keygen[0] = 0;
+            if (pkt->getMobilityHeaderType() == HOME_TEST)
+            {
+                HomeTest *hot = check_and_cast<HomeTest *>(pkt);
+                t->ip6mhht_cookie[1] = htonl(hot->getHomeInitCookie());
+                t->ip6mhht_keygen[1] = htonl(hot->getHomeKeyGenToken());
+            }
+            else
+            {
+                CareOfTest *cot = check_and_cast<CareOfTest *>(pkt);
+                t->ip6mhht_cookie[1] = htonl(cot->getCareOfInitCookie());
+                t->ip6mhht_keygen[1] = htonl(cot->getCareOfKeyGenToken());
+            }
+            packetLength = sizeof(struct ip6_mh_home_test);
+            break;
+        }
+        case BINDING_UPDATE:
+        {
+            // the home address goes into the Home Address option, see IPv6Serializer
+            BindingUpdate *bu = check_and_cast<BindingUpdate *>(pkt);
+            checkBufferSize(sizeof(struct ip6_mh_binding_update), bufsize);
+            struct ip6_mh_binding_update *mhbu = (struct ip6_mh_binding_update *) buf;
+            mhbu->ip6mhbu_seqno    = htons(bu->getSequence());
+            mhbu->ip6mhbu_flags    = htons((bu->getAckFlag() ? IP6_MH_BU_ACK : 0) |
+                                           (bu->getHomeRegistrationFlag() ? IP6_MH_BU_HOME : 0) |
+                                           (bu->getLinkLocalAddressCompatibilityFlag() ? IP6_MH_BU_LLOCAL : 0) |
+                                           (bu->getKeyManagementFlag() ? IP6_MH_BU_KEYM : 0));
+            mhbu->ip6mhbu_lifetime = htons(bu->getLifetime());
+            packetLength = writeBindingAuthorizationData(buf, bufsize, sizeof(struct ip6_mh_binding_update), bu->getBindingAuthorizationData());
+            break;
+        }
+        case BINDING_ACKNOWLEDGEMENT:
+        {
+            BindingAcknowledgement *ba = check_and_cast<BindingAcknowledgement *>(pkt);
+            checkBufferSize(sizeof(struct ip6_mh_binding_ack), bufsize);
+            struct ip6_mh_binding_ack *mhba = (struct ip6_mh_binding_ack *) buf;
+            mhba->ip6mhba_status   = ba->getStatus();
+            mhba->ip6mhba_flags    = ba->getKeyManagementFlag() ? IP6_MH_BA_KEYM : 0;
+            mhba->ip6mhba_seqno    = htons(ba->getSequenceNumber());
+            mhba->ip6mhba_lifetime = htons(ba->getLifetime());
+            packetLength = writeBindingAuthorizationData(buf, bufsize, sizeof(struct ip6_mh_binding_ack), ba->getBindingAuthorizationData());
+            break;
+        }
+        case BINDING_ERROR:
+        {
+            BindingError *be = check_and_cast<BindingError *>(pkt);
+            checkBufferSize(sizeof(struct ip6_mh_binding_error), bufsize);
+            struct ip6_mh_binding_error *mhbe = (struct ip6_mh_binding_error *) buf;
+            mhbe->ip6mhbe_status   = be->getStatus();
+            mhbe->ip6mhbe_reserved = 0;
+            IPv6Serializer::writeAddress(be->getHomeAddress(), mhbe->ip6mhbe_homeaddr);
+            packetLength = sizeof(struct ip6_mh_binding_error);
+            break;
+        }
+        case FAST_BINDING_UPDATE:
+        {
+            // same as the BU; the PCoA is the address the binding is for, the NCoA
+            // is in the Alternate Care-of Address option (RFC 5568 6.3.1)
+            FastBindingUpdate *fbu = check_and_cast<FastBindingUpdate *>(pkt);
+            checkBufferSize(sizeof(struct ip6_mh_binding_update), bufsize);
+            struct ip6_mh_binding_update *mhbu = (struct ip6_mh_binding_update *) buf;
+            mhbu->ip6mhbu_seqno    = htons(fbu->getSequence());
+            mhbu->ip6mhbu_flags    = htons(fbu->getAckFlag() ? IP6_MH_BU_ACK : 0);
+            mhbu->ip6mhbu_lifetime = htons(fbu->getLifetime());
+            packetLength = writePadding(buf, bufsize, sizeof(struct ip6_mh_binding_update), 6);
+            checkBufferSize(packetLength + 18, bufsize);
+            struct ip6_mh_opt *opt = (struct ip6_mh_opt *) (buf + packetLength);
+            opt->ip6mhopt_type = IP6_MHOPT_ALTCOA;
+            opt->ip6mhopt_len  = 16;
+            IPv6Serializer::writeAddress(fbu->getNewCareOfAddress(), buf + packetLength + 2);
+            packetLength = writePadding(buf, bufsize, packetLength + 18, 0);
+            break;
+        }
+        case FAST_BINDING_ACKNOWLEDGEMENT:
+        {
+            FastBindingAcknowledgement *fback = check_and_cast<FastBindingAcknowledgement *>(pkt);
+            checkBufferSize(sizeof(struct ip6_mh_binding_ack), bufsize);
+            struct ip6_mh_binding_ack *mhba = (struct ip6_mh_binding_ack *) buf;
+            mhba->ip6mhba_status   = fback->getStatus();
+            mhba->ip6mhba_flags    = 0;
+            mhba->ip6mhba_seqno    = htons(fback->getSequence());
+            mhba->ip6mhba_lifetime = htons(fback->getLifetime());
+            packetLength = writePadding(buf, bufsize, sizeof(struct ip6_mh_binding_ack), 0);
+            break;
+        }
+        case HANDOVER_INITIATE:
+        {
+            HandoverInitiate *hi = check_and_cast<HandoverInitiate *>(pkt);
+            checkBufferSize(sizeof(struct ip6_mh_handover_initiate), bufsize);
+            struct ip6_mh_handover_initiate *mhhi = (struct ip6_mh_handover_initiate *) buf;
+            mhhi->ip6mhhi_seqno     = htons(hi->getSequence());
+            mhhi->ip6mhhi_flags     = hi->getBufferFlag() ? IP6_MH_HI_BUFFER : 0;
+            mhhi->ip6mhhi_reserved  = 0;
+            mhhi->ip6mhhi_reserved2 = 0;
+            mhhi->ip6mhhi_reserved3 = 0;
+            packetLength = sizeof(struct ip6_mh_handover_initiate);
+            packetLength = writeAddressOption(buf, bufsize, packetLength, ND_OPT_IPA_OLD_COA, hi->getPreviousCareOfAddress(), 128);
+            packetLength = writeAddressOption(buf, bufsize, packetLength, ND_OPT_IPA_NEW_COA, hi->getNewCareOfAddress(), 128);
+            break;
+        }
+        case HANDOVER_ACKNOWLEDGE:
+        {
+            HandoverAcknowledge *hack = check_and_cast<HandoverAcknowledge *>(pkt);
+            checkBufferSize(sizeof(struct ip6_mh_handover_ack), bufsize);
+            struct ip6_mh_handover_ack *mhha = (struct ip6_mh_handover_ack *) buf;
+            mhha->ip6mhha_seqno     = htons(hack->getSequence());
+            mhha->ip6mhha_status    = hack->getStatus();
+            mhha->ip6mhha_reserved  = 0;
+            mhha->ip6mhha_reserved2 = 0;
+            mhha->ip6mhha_reserved3 = 0;
+            packetLength = sizeof(struct ip6_mh_handover_ack);
+            break;
+        }
+        case ROUTER_SOLICITATION_FOR_PROXY_ADV:
+        {
+            RouterSolicitationForProxyAdv *rtSolPr = check_and_cast<RouterSolicitationForProxyAdv *>(pkt);
+            checkBufferSize(sizeof(struct ip6_mh_proxy_router), bufsize);
+            struct ip6_mh_proxy_router *mhpr = (struct ip6_mh_proxy_router *) buf;
+            mhpr->ip6mhpr_seqno = htons(rtSolPr->getSequence());
+            packetLength = sizeof(struct ip6_mh_proxy_router);
+            // no option asks for all neighbouring access points
+            if (!rtSolPr->getNewAccessPoint().isUnspecified())
+                packetLength = writeLinkLayerAddressOption(buf, bufsize, packetLength, ND_OPT_LLA_NAP, rtSolPr->getNewAccessPoint());
+            break;
+        }
+        case PROXY_ROUTER_ADVERTISEMENT:
+        {
+            // per access point: its address, then the link-layer address, IP address,
+            // and the prefix of its router. The prefix is in a Prefix Information
+            // option, with the router lifetime in the second reserved field.
+            ProxyRouterAdvertisement *prRtAdv = check_and_cast<ProxyRouterAdvertisement *>(pkt);
+            checkBufferSize(sizeof(struct ip6_mh_proxy_router), bufsize);
+            struct ip6_mh_proxy_router *mhpr = (struct ip6_mh_proxy_router *) buf;
+            mhpr->ip6mhpr_seqno = htons(prRtAdv->getSequence());
+            packetLength = sizeof(struct ip6_mh_proxy_router);
+            for (unsigned int i=0; i<prRtAdv->getNeighbourRoutersArraySize(); i++)
+            {
+                NeighbourRouterInfo& info = prRtAdv->getNeighbourRouters(i);
+                packetLength = writeLinkLayerAddressOption(buf, bufsize, packetLength, ND_OPT_LLA_NAP, info.accessPoint);
+                packetLength = writeLinkLayerAddressOption(buf, bufsize, packetLength, ND_OPT_LLA_NAR, info.routerLinkLayerAddress);
+                packetLength = writeAddressOption(buf, bufsize, packetLength, ND_OPT_IPA_NAR_ADDRESS, info.routerAddress, 128);
+                checkBufferSize(packetLength + sizeof(struct nd_opt_prefix_info), bufsize);
+                struct nd_opt_prefix_info *pi = (struct nd_opt_prefix_info *) (buf + packetLength);
+                pi->nd_opt_pi_type           = ND_OPT_PREFIX_INFORMATION;
+                pi->nd_opt_pi_len            = sizeof(struct nd_opt_prefix_info) / 8;
+                pi->nd_opt_pi_prefix_len     = info.prefixLength;
+                pi->nd_opt_pi_flags_reserved = ND_OPT_PI_FLAG_ONLINK | ND_OPT_PI_FLAG_AUTO;
+                pi->nd_opt_pi_valid_time     = htonl((uint32)info.validLifetime);
+                pi->nd_opt_pi_preferred_time = htonl((uint32)info.preferredLifetime);
+                pi->nd_opt_pi_reserved2      = htonl((uint32)info.routerLifetime);
+                IPv6Serializer::writeAddress(info.prefix, pi->nd_opt_pi_prefix);
+                packetLength += sizeof(struct nd_opt_prefix_info);
+            }
+            break;
+        }
+        default:
+        {
+            packetLength = 0;
+            EV << "Can not serialize Mobility Header: type " << pkt->getMobilityHeaderType() << " not supported.";
+            return packetLength;
+        }
+    }
+
+    // the length is in 8-octet units, not including the first 8 octets
+    mh->ip6mh_hdrlen = packetLength / 8 - 1;
+    return packetLength;
+}
+
+MobilityHeader *MobilityHeaderSerializer::parse(unsigned char *buf, unsigned int bufsize)
+{
+    struct ip6_mh *mh = (struct ip6_mh *) buf;
+    MobilityHeader *pkt = NULL;
+    unsigned int length;
+
+    if (bufsize < sizeof(struct ip6_mh) + 2)
+    {
+        EV << "Can not create Mobility Header of " << bufsize << " bytes.";
+        return NULL;
+    }
+    length = std::min((unsigned int)(mh->ip6mh_hdrlen + 1) * 8, bufsize);
+
+    switch (mh->ip6mh_type)
+    {
+        case BINDING_REFRESH_REQUEST:
+        {
+            pkt = new BindingRefreshRequest("Binding Refresh Request");
+            break;
+        }
+        case HOME_TEST_INIT:
+        case CARE_OF_TEST_INIT:
+        {
+            if (length < sizeof(struct ip6_mh_home_test_init))
+                break;
+            struct ip6_mh_home_test_init *ti = (struct ip6_mh_home_test_init *) buf;
+            if (mh->ip6mh_type == HOME_TEST_INIT)
+            {
+                HomeTestInit *hoti = new HomeTestInit("HoTI");
+                hoti->setHomeInitCookie(ntohl(ti->ip6mhhti_cookie[1]));
+                pkt = hoti;
+            }
+            else
+            {
+                CareOfTestInit *coti = new CareOfTestInit("CoTI");
+                coti->setCareOfInitCookie(ntohl(ti->ip6mhhti_cookie[1]));
+                pkt = coti;
+            }
+            break;
+        }
+        case HOME_TEST:
+        case CARE_OF_TEST:
+        {
+            if (length < sizeof(struct ip6_mh_home_test))
+                break;
+            struct ip6_mh_home_test *t = (struct ip6_mh_home_test *) buf;
+            if (mh->ip6mh_type == HOME_TEST)
+            {
+                HomeTest *hot = new HomeTest("HoT");
+                hot->setHomeInitCookie(ntohl(t->ip6mhht_cookie[1]));
+                hot->setHomeKeyGenToken(ntohl(t->ip6mhht_keygen[1]));
+                pkt = hot;
+            }
+            else
+            {
+                CareOfTest *cot = new CareOfTest("CoT");
+                cot->setCareOfInitCookie(ntohl(t->ip6mhht_cookie[1]));
+                cot->setCareOfKeyGenToken(ntohl(t->ip6mhht_keygen[1]));
+                pkt = cot;
+            }
+            break;
+        }
+        case BINDING_UPDATE:
+        {
+            if (length < sizeof(struct ip6_mh_binding_update))
+                break;
+            struct ip6_mh_binding_update *mhbu = (struct ip6_mh_binding_update *) buf;
+            BindingUpdate *bu = new BindingUpdate("Binding Update");
+            uint16 flags = ntohs(mhbu->ip6mhbu_flags);
+            bu->setSequence(ntohs(mhbu->ip6mhbu_seqno));
+            bu->setAckFlag(flags & IP6_MH_BU_ACK);
+            bu->setHomeRegistrationFlag(flags & IP6_MH_BU_HOME);
+            bu->setLinkLocalAddressCompatibilityFlag(flags & IP6_MH_BU_LLOCAL);
+            bu->setKeyManagementFlag(flags & IP6_MH_BU_KEYM);
+            bu->setLifetime(ntohs(mhbu->ip6mhbu_lifetime));
+            bu->setBindingAuthorizationData(readBindingAuthorizationData(buf, sizeof(struct ip6_mh_binding_update), length));
+            pkt = bu;
+            break;
+        }
+        case BINDING_ACKNOWLEDGEMENT:
+        {
+            if (length < sizeof(struct ip6_mh_binding_ack))
+                break;
+            struct ip6_mh_binding_ack *mhba = (struct ip6_mh_binding_ack *) buf;
+            BindingAcknowledgement *ba = new BindingAcknowledgement("Binding Acknowledgement");
+            ba->setStatus(mhba->ip6mhba_status);
+            ba->setKeyManagementFlag(mhba->ip6mhba_flags & IP6_MH_BA_KEYM);
+            ba->setSequenceNumber(ntohs(mhba->ip6mhba_seqno));
+            ba->setLifetime(ntohs(mhba->ip6mhba_lifetime));
+            ba->setBindingAuthorizationData(readBindingAuthorizationData(buf, sizeof(struct ip6_mh_binding_ack), length));
+            pkt = ba;
+            break;
+        }
+        case BINDING_ERROR:
+        {
+            if (length < sizeof(struct ip6_mh_binding_error))
+                break;
+            struct ip6_mh_binding_error *mhbe = (struct ip6_mh_binding_error *) buf;
+            BindingError *be = new BindingError("Binding Error");
+            be->setStatus(mhbe->ip6mhbe_status);
+            be->setHomeAddress(IPv6Serializer::readAddress(mhbe->ip6mhbe_homeaddr));
+            pkt = be;
+            break;
+        }
+        case FAST_BINDING_UPDATE:
+        {
+            if (length < sizeof(struct ip6_mh_binding_update))
+                break;
+            struct ip6_mh_binding_update *mhbu = (struct ip6_mh_binding_update *) buf;
+            FastBindingUpdate *fbu = new FastBindingUpdate("Fast Binding Update");
+            fbu->setSequence(ntohs(mhbu->ip6mhbu_seqno));
+            fbu->setAckFlag(ntohs(mhbu->ip6mhbu_flags) & IP6_MH_BU_ACK);
+            fbu->setLifetime(ntohs(mhbu->ip6mhbu_lifetime));
+            const unsigned char *altCoA = findMobilityOption(buf, sizeof(struct ip6_mh_binding_update), length, IP6_MHOPT_ALTCOA, 16);
+            if (altCoA)
+                fbu->setNewCareOfAddress(IPv6Serializer::readAddress(altCoA));
+            pkt = fbu;
+            break;
+        }
+        case FAST_BINDING_ACKNOWLEDGEMENT:
+        {
+            if (length < sizeof(struct ip6_mh_binding_ack))
+                break;
+            struct ip6_mh_binding_ack *mhba = (struct ip6_mh_binding_ack *) buf;
+            FastBindingAcknowledgement *fback = new FastBindingAcknowledgement("Fast Binding Acknowledgement");
+            fback->setStatus(mhba->ip6mhba_status);
+            fback->setSequence(ntohs(mhba->ip6mhba_seqno));
+            fback->setLifetime(ntohs(mhba->ip6mhba_lifetime));
+            pkt = fback;
+            break;
+        }
+        case HANDOVER_INITIATE:
+        {
+            if (length < sizeof(struct ip6_mh_handover_initiate))
+                break;
+            struct ip6_mh_handover_initiate *mhhi = (struct ip6_mh_handover_initiate *) buf;
+            HandoverInitiate *hi = new HandoverInitiate("Handover Initiate");
+            hi->setSequence(ntohs(mhhi->ip6mhhi_seqno));
+            hi->setBufferFlag(mhhi->ip6mhhi_flags & IP6_MH_HI_BUFFER);
+            unsigned int offset = sizeof(struct ip6_mh_handover_initiate);
+            while (const struct nd_opt_hdr *opt = nextOption(buf, offset, length))
+            {
+                if (isAddressOption(opt, ND_OPT_IPA_OLD_COA))
+                    hi->setPreviousCareOfAddress(IPv6Serializer::readAddress(((struct nd_opt_ip_address *)opt)->nd_opt_ipa_address));
+                else if (isAddressOption(opt, ND_OPT_IPA_NEW_COA))
+                    hi->setNewCareOfAddress(IPv6Serializer::readAddress(((struct nd_opt_ip_address *)opt)->nd_opt_ipa_address));
+            }
+            pkt = hi;
+            break;
+        }
+        case HANDOVER_ACKNOWLEDGE:
+        {
+            if (length < sizeof(struct ip6_mh_handover_ack))
+                break;
+            struct ip6_mh_handover_ack *mhha = (struct ip6_mh_handover_ack *) buf;
+            HandoverAcknowledge *hack = new HandoverAcknowledge("Handover Acknowledge");
+            hack->setSequence(ntohs(mhha->ip6mhha_seqno));
+            hack->setStatus(mhha->ip6mhha_status);
+            pkt = hack;
+            break;
+        }
+        case ROUTER_SOLICITATION_FOR_PROXY_ADV:
+        {
+            struct ip6_mh_proxy_router *mhpr = (struct ip6_mh_proxy_router *) buf;
+            RouterSolicitationForProxyAdv *rtSolPr = new RouterSolicitationForProxyAdv("RtSolPr");
+            rtSolPr->setSequence(ntohs(mhpr->ip6mhpr_seqno));
+            unsigned int offset = sizeof(struct ip6_mh_proxy_router);
+            while (const struct nd_opt_hdr *opt = nextOption(buf, offset, length))
+                if (isLinkLayerAddressOption(opt, ND_OPT_LLA_NAP))
+                    rtSolPr->setNewAccessPoint(readLinkLayerAddressOption(opt));
+            pkt = rtSolPr;
+            break;
+        }
+        case PROXY_ROUTER_ADVERTISEMENT:
+        {
+            // a link-layer address option for an access point starts a new entry
+            struct ip6_mh_proxy_router *mhpr = (struct ip6_mh_proxy_router *) buf;
+            ProxyRouterAdvertisement *prRtAdv = new ProxyRouterAdvertisement("PrRtAdv");
+            prRtAdv->setSequence(ntohs(mhpr->ip6mhpr_seqno));
+            std::vector<NeighbourRouterInfo> neighbours;
+            unsigned int offset = sizeof(struct ip6_mh_proxy_router);
+            while (const struct nd_opt_hdr *opt = nextOption(buf, offset, length))
+            {
+                if (isLinkLayerAddressOption(opt, ND_OPT_LLA_NAP))
+                {
+                    neighbours.push_back(NeighbourRouterInfo());
+                    neighbours.back().accessPoint = readLinkLayerAddressOption(opt);
+                }
+                else if (neighbours.empty())
+                    continue;
+                else if (isLinkLayerAddressOption(opt, ND_OPT_LLA_NAR))
+                    neighbours.back().routerLinkLayerAddress = readLinkLayerAddressOption(opt);
+                else if (isAddressOption(opt, ND_OPT_IPA_NAR_ADDRESS))
+                    neighbours.back().routerAddress = IPv6Serializer::readAddress(((struct nd_opt_ip_address *)opt)->nd_opt_ipa_address);
+                else if (opt->nd_opt_type == ND_OPT_PREFIX_INFORMATION && opt->nd_opt_len * 8 >= (int)sizeof(struct nd_opt_prefix_info))
+                {
+                    const struct nd_opt_prefix_info *pi = (struct nd_opt_prefix_info *) opt;
+                    NeighbourRouterInfo& info = neighbours.back();
+                    info.prefix = IPv6Serializer::readAddress(pi->nd_opt_pi_prefix);
+                    info.prefixLength = pi->nd_opt_pi_prefix_len;
+                    info.validLifetime = ntohl(pi->nd_opt_pi_valid_time);
+                    info.preferredLifetime = ntohl(pi->nd_opt_pi_preferred_time);
+                    info.routerLifetime = ntohl(pi->nd_opt_pi_reserved2);
+                }
+            }
+            prRtAdv->setNeighbourRoutersArraySize(neighbours.size());
+            for (unsigned int i=0; i<neighbours.size(); i++)
+                prRtAdv->setNeighbourRouters(i, neighbours[i]);
+            pkt = prRtAdv;
+            break;
+        }
+        default:
+        {
+            EV << "Can not create Mobility Header: type " << (int)mh->ip6mh_type << " not supported.";
+            break;
+        }
+    }
+
+    if (pkt)
+    {
+        pkt->setMobilityHeaderType(mh->ip6mh_type);
+        pkt->setByteLength(length);
+    }
+    return pkt;
+}
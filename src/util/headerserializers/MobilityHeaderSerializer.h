@@ -0,0 +1,54 @@
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef __INET_MOBILITYHEADERSERIALIZER_H
+#define __INET_MOBILITYHEADERSERIALIZER_H
+
+#include "MobilityHeader.h"
+
+
+/**
+ * Converts between MobilityHeader and binary (network byte order)
+ * Mobility Header of Mobile IPv6 (RFC 3775), including the FMIPv6
+ * messages (RFC 5568) that the model carries in the Mobility Header.
+ *
+ * Fields that are not part of the message on the wire are not restored
+ * by parse(): the home address of a BindingUpdate and the previous
+ * care-of address of a FastBindingUpdate are that of the Home Address
+ * option or the source address, which IPv6Serializer fills in.
+ */
+class MobilityHeaderSerializer
+{
+    public:
+        MobilityHeaderSerializer() {}
+
+        /**
+         * Serializes a MobilityHeader for transmission on the wire.
+         * The checksum is NOT filled in, because it covers the IPv6 pseudo
+         * header: IPv6Serializer does that.
+         * Returns the length of data written into buffer.
+         */
+        int serialize(MobilityHeader *pkt, unsigned char *buf, unsigned int bufsize);
+
+        /**
+         * Creates a MobilityHeader of the subclass matching the type of
+         * a packet sniffed from the wire, or returns NULL if the type is
+         * not supported.
+         */
+        MobilityHeader *parse(unsigned char *buf, unsigned int bufsize);
+};
+
+#endif
+
@@ -26,6 +26,7 @@ namespace INETFw // load headers into a namespace, to avoid conflicts with platf
 };
 
 #include "SCTPSerializer.h"
+#include "Checksum.h"
 #include "SCTPAssociation.h"
 #include "platdep/intxtypes.h"
 
@@ -508,11 +509,7 @@ uint32 SCTPSerializer::checksum(unsigned char *buf, register uint32 len)
   uint32 h;
   unsigned char byte0, byte1, byte2, byte3;
   uint32 crc32c;
-  register uint32 i;
-  register uint32 res = (~0L);
-  for (i = 0; i < len; i++)
-    CRC32C(res, buf[i]);
-  h      = ~res;
+  h      = Checksum::crc32c(buf, len);
   byte0  = h & 0xff;
   byte1  = (h>>8) & 0xff;
   byte2  = (h>>16) & 0xff;
@@ -40,6 +40,7 @@ using namespace INETFw;*/
 
 //Define_Module(SCTPSerializer);
 #include "TCPSerializer.h"
+#include "Checksum.h"
 
 int TCPSerializer::serialize(TCPSegment *msg, unsigned char *buf, unsigned int bufsize,  pseudoheader *pseudo)
 {
@@ -74,37 +75,15 @@ int TCPSerializer::serialize(TCPSegment *msg, unsigned char *buf, unsigned int b
 	tcp->th_urp = htons(msg->getUrgentPointer());
 	
 
-		// for computation of the checksum we need the pseudo header infront of the tcp header
-	int wholeheadersize = sizeof(pseudoheader) + writtenbytes;
-	char *wholeheader = (char*) malloc(wholeheadersize);
-
-	memcpy(wholeheader, pseudo, sizeof(pseudoheader));
-	memcpy(wholeheader + sizeof(pseudoheader), buf, writtenbytes);
-
-	tcp->th_sum = checksum((unsigned char*)wholeheader, wholeheadersize);
-	free(wholeheader);
+	// the checksum covers the pseudo header in front of the tcp header as well
+	tcp->th_sum = Checksum::internetChecksum(buf, writtenbytes, Checksum::internetSum(pseudo, sizeof(pseudoheader)));
 	//tcp->th_sum =checksum((unsigned char*)tcp, writtenbytes);
 	return writtenbytes;
 }
 
 unsigned short TCPSerializer::checksum(unsigned char *addr, unsigned int count)
 {
-    long sum = 0;
-
-    while (count > 1)  {
-        sum += *((unsigned short *&)addr)++;
-        if (sum & 0x80000000)
-            sum = (sum & 0xFFFF) + (sum >> 16);
-        count -= 2;
-    }
-
-    if (count)
-        sum += *(unsigned char *)addr;
-
-    while (sum >> 16)
-        sum = (sum & 0xffff) + (sum >> 16);
-
-    return ~sum;
+    return Checksum::internetChecksum(addr, count);
 }
 
 
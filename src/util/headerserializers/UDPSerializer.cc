@@ -25,6 +25,7 @@ namespace INETFw // load headers into a namespace, to avoid conflicts with platf
 };
 
 #include "UDPSerializer.h"
+#include "Checksum.h"
 
 #if !defined(_WIN32) && !defined(__WIN32__) && !defined(WIN32) && !defined(__CYGWIN__) && !defined(_WIN64)
 #include <netinet/in.h>  // htonl, ntohl, ...
@@ -63,20 +64,5 @@ void UDPSerializer::parse(unsigned char *buf, unsigned int bufsize, UDPPacket *d
 
 unsigned short UDPSerializer::checksum(unsigned char *addr, unsigned int count)
 {
-    long sum = 0;
-
-    while (count > 1)  {
-        sum += *((unsigned short *&)addr)++;
-        if (sum & 0x80000000)
-            sum = (sum & 0xFFFF) + (sum >> 16);
-        count -= 2;
-    }
-
-    if (count)
-        sum += *(unsigned char *)addr;
-
-    while (sum >> 16)
-        sum = (sum & 0xffff) + (sum >> 16);
-
-    return ~sum;
+    return Checksum::internetChecksum(addr, count);
 }
@@ -0,0 +1,155 @@
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef __INET_HEADERS_ICMP6_H
+#define __INET_HEADERS_ICMP6_H
+
+/*
+ * Definitions for ICMPv6 (RFC 4443) and Neighbour Discovery (RFC 4861),
+ * with the names of the BSD <netinet/icmp6.h>. The message types are
+ * those of the ICMPv6Type enum. Flags are in host byte order.
+ */
+
+struct icmp6_hdr {
+        u_int8_t  icmp6_type;           /* type field */
+        u_int8_t  icmp6_code;           /* code field */
+        u_int16_t icmp6_cksum;          /* checksum field */
+        union {
+                u_int32_t icmp6_un_data32[1];   /* type-specific field */
+                u_int16_t icmp6_un_data16[2];   /* type-specific field */
+                u_int8_t  icmp6_un_data8[4];    /* type-specific field */
+        } icmp6_dataun;
+};
+
+#define icmp6_data32    icmp6_dataun.icmp6_un_data32
+#define icmp6_data16    icmp6_dataun.icmp6_un_data16
+#define icmp6_data8     icmp6_dataun.icmp6_un_data8
+#define icmp6_pptr      icmp6_data32[0]         /* parameter prob */
+#define icmp6_mtu       icmp6_data32[0]         /* packet too big */
+#define icmp6_id        icmp6_data16[0]         /* echo request/reply */
+#define icmp6_seq       icmp6_data16[1]         /* echo request/reply */
+
+struct nd_router_solicit {
+        struct icmp6_hdr nd_rs_hdr;
+        /* could be followed by options */
+};
+
+struct nd_router_advert {
+        struct icmp6_hdr nd_ra_hdr;
+        u_int32_t nd_ra_reachable;      /* reachable time */
+        u_int32_t nd_ra_retransmit;     /* retransmit timer */
+        /* could be followed by options */
+};
+
+#define nd_ra_curhoplimit       nd_ra_hdr.icmp6_data8[0]
+#define nd_ra_flags_reserved    nd_ra_hdr.icmp6_data8[1]
+#define nd_ra_router_lifetime   nd_ra_hdr.icmp6_data16[1]
+
+#define ND_RA_FLAG_MANAGED      0x80
+#define ND_RA_FLAG_OTHER        0x40
+#define ND_RA_FLAG_HOME_AGENT   0x20    /* Mobile IPv6, RFC 3775 */
+
+struct nd_neighbor_solicit {
+        struct icmp6_hdr nd_ns_hdr;
+        u_int8_t nd_ns_target[16];      /* target address */
+        /* could be followed by options */
+};
+
+struct nd_neighbor_advert {
+        struct icmp6_hdr nd_na_hdr;
+        u_int8_t nd_na_target[16];      /* target address */
+        /* could be followed by options */
+};
+
+#define nd_na_flags_reserved    nd_na_hdr.icmp6_data32[0]
+
+#define ND_NA_FLAG_ROUTER       0x80000000
+#define ND_NA_FLAG_SOLICITED    0x40000000
+#define ND_NA_FLAG_OVERRIDE     0x20000000
+
+struct nd_redirect {
+        struct icmp6_hdr nd_rd_hdr;
+        u_int8_t nd_rd_target[16];      /* target address */
+        u_int8_t nd_rd_dst[16];         /* destination address */
+        /* could be followed by options */
+};
+
+/*
+ * Options. The length is in units of 8 octets, including the type and
+ * length fields.
+ */
+struct nd_opt_hdr {
+        u_int8_t nd_opt_type;
+        u_int8_t nd_opt_len;
+        /* followed by option specific data */
+};
+
+#define ND_OPT_SOURCE_LINKADDR      1
+#define ND_OPT_TARGET_LINKADDR      2
+#define ND_OPT_PREFIX_INFORMATION   3
+#define ND_OPT_MTU                  5
+#define ND_OPT_IP_ADDRESS_PREFIX    17  /* FMIPv6, RFC 5568 */
+#define ND_OPT_LINK_LAYER_ADDRESS   19  /* FMIPv6, RFC 5568 */
+
+struct nd_opt_prefix_info {
+        u_int8_t  nd_opt_pi_type;
+        u_int8_t  nd_opt_pi_len;
+        u_int8_t  nd_opt_pi_prefix_len;
+        u_int8_t  nd_opt_pi_flags_reserved;
+        u_int32_t nd_opt_pi_valid_time;
+        u_int32_t nd_opt_pi_preferred_time;
+        u_int32_t nd_opt_pi_reserved2;
+        u_int8_t  nd_opt_pi_prefix[16];
+};
+
+#define ND_OPT_PI_FLAG_ONLINK       0x80
+#define ND_OPT_PI_FLAG_AUTO         0x40
+#define ND_OPT_PI_FLAG_ROUTER       0x20    /* Mobile IPv6, RFC 3775 */
+
+struct nd_opt_mtu {
+        u_int8_t  nd_opt_mtu_type;
+        u_int8_t  nd_opt_mtu_len;
+        u_int16_t nd_opt_mtu_reserved;
+        u_int32_t nd_opt_mtu_mtu;
+};
+
+/* IP Address/Prefix option of RFC 5568 */
+struct nd_opt_ip_address {
+        u_int8_t  nd_opt_ipa_type;
+        u_int8_t  nd_opt_ipa_len;
+        u_int8_t  nd_opt_ipa_code;
+        u_int8_t  nd_opt_ipa_prefix_len;
+        u_int32_t nd_opt_ipa_reserved;
+        u_int8_t  nd_opt_ipa_address[16];
+};
+
+#define ND_OPT_IPA_OLD_COA          1
+#define ND_OPT_IPA_NEW_COA          2
+#define ND_OPT_IPA_NAR_ADDRESS      3
+#define ND_OPT_IPA_NAR_PREFIX       4
+
+/* Link-Layer Address option of RFC 5568, padded to 16 octets for Ethernet */
+struct nd_opt_lla {
+        u_int8_t nd_opt_lla_type;
+        u_int8_t nd_opt_lla_len;
+        u_int8_t nd_opt_lla_code;
+        u_int8_t nd_opt_lla_address[6];
+        u_int8_t nd_opt_lla_pad[7];
+};
+
+#define ND_OPT_LLA_NAP              1   /* link-layer address of the new access point */
+#define ND_OPT_LLA_NAR              3   /* link-layer address of the new access router */
+
+#endif
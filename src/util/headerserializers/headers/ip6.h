@@ -0,0 +1,84 @@
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef __INET_HEADERS_IP6_H
+#define __INET_HEADERS_IP6_H
+
+/*
+ * Definitions for the IPv6 header and its extension headers (RFC 2460),
+ * with the names of the BSD <netinet/ip6.h>. Addresses are plain byte
+ * arrays, because some platforms define s6_addr as a macro.
+ */
+
+#define IPV6_VERSION        0x60000000  /* in ip6_flow, host byte order */
+#define IPV6_VERSION_MASK   0xf0000000
+#define IPV6_FLOWLABEL_MASK 0x000fffff
+#define IPV6_TCLASS_SHIFT   20
+#define IPV6_MMTU           1280        /* minimal MTU */
+
+struct ip6_hdr {
+        u_int32_t ip6_flow;             /* version, traffic class, flow label */
+        u_int16_t ip6_plen;             /* payload length */
+        u_int8_t  ip6_nxt;              /* next header */
+        u_int8_t  ip6_hlim;             /* hop limit */
+        u_int8_t  ip6_src[16];          /* source address */
+        u_int8_t  ip6_dst[16];          /* destination address */
+};
+
+/*
+ * Extension headers have the next header and the length in their first
+ * two octets. The length is in 8-octet units, not including the first
+ * 8 octets.
+ */
+struct ip6_ext {
+        u_int8_t ip6e_nxt;
+        u_int8_t ip6e_len;
+};
+
+/* Routing header */
+struct ip6_rthdr {
+        u_int8_t  ip6r_nxt;             /* next header */
+        u_int8_t  ip6r_len;             /* length in units of 8 octets */
+        u_int8_t  ip6r_type;            /* routing type */
+        u_int8_t  ip6r_segleft;         /* segments left */
+        u_int32_t ip6r_reserved;
+        /* followed by the addresses */
+};
+
+#define IPV6_RTHDR_TYPE_0   0
+#define IPV6_RTHDR_TYPE_2   2           /* Mobile IPv6, RFC 3775 */
+
+/* Fragment header */
+struct ip6_frag {
+        u_int8_t  ip6f_nxt;             /* next header */
+        u_int8_t  ip6f_reserved;
+        u_int16_t ip6f_offlg;           /* offset, reserved, and flag */
+        u_int32_t ip6f_ident;           /* identification */
+};
+
+#define IP6F_OFF_MASK       0xfff8      /* in ip6f_offlg, host byte order */
+#define IP6F_MORE_FRAG      0x0001
+
+/* Options of the Hop-by-Hop and Destination Options headers */
+struct ip6_opt {
+        u_int8_t ip6o_type;
+        u_int8_t ip6o_len;              /* in octets, not including type and length */
+};
+
+#define IP6OPT_PAD1         0x00
+#define IP6OPT_PADN         0x01
+#define IP6OPT_HOME_ADDRESS 0xc9        /* Mobile IPv6, RFC 3775 */
+
+#endif
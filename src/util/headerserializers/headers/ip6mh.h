@@ -0,0 +1,150 @@
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef __INET_HEADERS_IP6MH_H
+#define __INET_HEADERS_IP6MH_H
+
+/*
+ * Definitions for the Mobility Header of Mobile IPv6 (RFC 3775), with the
+ * names of <netinet/ip6mh.h> (RFC 4584). The message types are those of
+ * the MobilityHeaderType enum. Flags are in host byte order.
+ */
+
+struct ip6_mh {
+        u_int8_t  ip6mh_proto;          /* payload proto, always no next header */
+        u_int8_t  ip6mh_hdrlen;         /* in 8-octet units, not including the first 8 octets */
+        u_int8_t  ip6mh_type;           /* message type */
+        u_int8_t  ip6mh_reserved;
+        u_int16_t ip6mh_cksum;          /* checksum */
+        /* followed by type specific data */
+};
+
+struct ip6_mh_binding_request {
+        struct ip6_mh ip6mhbr_hdr;
+        u_int16_t     ip6mhbr_reserved;
+        /* followed by optional mobility options */
+};
+
+struct ip6_mh_home_test_init {
+        struct ip6_mh ip6mhhti_hdr;
+        u_int16_t     ip6mhhti_reserved;
+        u_int32_t     ip6mhhti_cookie[2];   /* 64 bit cookie */
+        /* followed by optional mobility options */
+};
+
+struct ip6_mh_careof_test_init {
+        struct ip6_mh ip6mhcti_hdr;
+        u_int16_t     ip6mhcti_reserved;
+        u_int32_t     ip6mhcti_cookie[2];   /* 64 bit cookie */
+        /* followed by optional mobility options */
+};
+
+struct ip6_mh_home_test {
+        struct ip6_mh ip6mhht_hdr;
+        u_int16_t     ip6mhht_nonce_index;
+        u_int32_t     ip6mhht_cookie[2];    /* 64 bit cookie */
+        u_int32_t     ip6mhht_keygen[2];    /* 64 bit keygen token */
+        /* followed by optional mobility options */
+};
+
+struct ip6_mh_careof_test {
+        struct ip6_mh ip6mhct_hdr;
+        u_int16_t     ip6mhct_nonce_index;
+        u_int32_t     ip6mhct_cookie[2];    /* 64 bit cookie */
+        u_int32_t     ip6mhct_keygen[2];    /* 64 bit keygen token */
+        /* followed by optional mobility options */
+};
+
+/* Binding Update, and Fast Binding Update of RFC 5568 */
+struct ip6_mh_binding_update {
+        struct ip6_mh ip6mhbu_hdr;
+        u_int16_t     ip6mhbu_seqno;        /* sequence number */
+        u_int16_t     ip6mhbu_flags;        /* flags */
+        u_int16_t     ip6mhbu_lifetime;     /* in units of 4 seconds */
+        /* followed by optional mobility options */
+};
+
+#define IP6_MH_BU_ACK       0x8000  /* request a binding ack */
+#define IP6_MH_BU_HOME      0x4000  /* home registration */
+#define IP6_MH_BU_LLOCAL    0x2000  /* link-local compatibility */
+#define IP6_MH_BU_KEYM      0x1000  /* key management mobility */
+
+/* Binding Acknowledgement, and Fast Binding Acknowledgement of RFC 5568 */
+struct ip6_mh_binding_ack {
+        struct ip6_mh ip6mhba_hdr;
+        u_int8_t      ip6mhba_status;       /* status code */
+        u_int8_t      ip6mhba_flags;
+        u_int16_t     ip6mhba_seqno;
+        u_int16_t     ip6mhba_lifetime;
+        /* followed by optional mobility options */
+};
+
+#define IP6_MH_BA_KEYM      0x80    /* key management mobility */
+
+struct ip6_mh_binding_error {
+        struct ip6_mh ip6mhbe_hdr;
+        u_int8_t      ip6mhbe_status;       /* error status */
+        u_int8_t      ip6mhbe_reserved;
+        u_int8_t      ip6mhbe_homeaddr[16]; /* home address */
+        /* followed by optional mobility options */
+};
+
+/*
+ * Router Solicitation for Proxy Advertisement and Proxy Router
+ * Advertisement of FMIPv6, which the model carries in the Mobility Header
+ * (see MobilityHeader.msg). Followed by ICMPv6 options as in RFC 5568.
+ */
+struct ip6_mh_proxy_router {
+        struct ip6_mh ip6mhpr_hdr;
+        u_int16_t     ip6mhpr_seqno;        /* identifier */
+};
+
+/* Handover Initiate of FMIPv6, followed by ICMPv6 options as in RFC 5568 */
+struct ip6_mh_handover_initiate {
+        struct ip6_mh ip6mhhi_hdr;
+        u_int16_t     ip6mhhi_seqno;        /* identifier */
+        u_int8_t      ip6mhhi_flags;
+        u_int8_t      ip6mhhi_reserved;
+        u_int16_t     ip6mhhi_reserved2;    /* aligns the options to 8 octets */
+        u_int32_t     ip6mhhi_reserved3;
+};
+
+#define IP6_MH_HI_BUFFER    0x40    /* U flag: buffer packets for the NCoA */
+
+/* Handover Acknowledge of FMIPv6 */
+struct ip6_mh_handover_ack {
+        struct ip6_mh ip6mhha_hdr;
+        u_int16_t     ip6mhha_seqno;        /* identifier */
+        u_int8_t      ip6mhha_status;       /* the code of RFC 5568 */
+        u_int8_t      ip6mhha_reserved;
+        u_int16_t     ip6mhha_reserved2;    /* pads the message to 8 octets */
+        u_int32_t     ip6mhha_reserved3;
+};
+
+/* Mobility options */
+struct ip6_mh_opt {
+        u_int8_t ip6mhopt_type;
+        u_int8_t ip6mhopt_len;              /* in octets, not including type and length */
+        /* followed by option specific data */
+};
+
+#define IP6_MHOPT_PAD1      0x00
+#define IP6_MHOPT_PADN      0x01
+#define IP6_MHOPT_ALTCOA    0x03    /* alternate care-of address */
+#define IP6_MHOPT_BAUTH     0x05    /* binding authorization data */
+
+#define IP6_MHOPT_BAUTH_LEN 12      /* 96 bit authenticator */
+
+#endif
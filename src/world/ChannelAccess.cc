@@ -58,38 +58,35 @@ void ChannelAccess::initialize(int stage)
  */
 void ChannelAccess::sendToChannel(AirFrame *msg)
 {
-    const ChannelControl::ModuleList& neighbors = cc->getNeighbors(myHostRef);
+    const ChannelControl::HostRefSet& neighbors = cc->getNeighborHosts(myHostRef);
     coreEV << "sendToChannel: sending to gates\n";
 
     // loop through all hosts in range
-    ChannelControl::ModuleList::const_iterator it;
+    ChannelControl::HostRefSet::const_iterator it;
     for (it = neighbors.begin(); it != neighbors.end(); ++it)
     {
-        cModule *mod = *it;
+        ChannelControl::HostRef h = *it;
 
         // we need to send to each radioIn[] gate
-        cGate *radioGate = mod->gate("radioIn");
+        cGate *radioGate = cc->getRadioInGate(h);
 
-        if (radioGate == NULL)
-            error("module %s must have a gate called radioIn", mod->getFullPath().c_str());
-
-        for (int i = 0; i < radioGate->size(); i++)
+        if (h->channel != msg->getChannelNumber())
         {
-            ChannelControl::HostRef h = cc->lookupHost(mod);
+            coreEV << "skipping host listening on a different channel\n";
+            continue;
+        }
 
-            if (h == NULL)
-                error("cannot find module in channel control");
+        coreEV << "sending message to host listening on the same channel\n";
+        // account for propagation delay, based on distance in meters
+        // Over 300m, dt=1us=10 bit times @ 10Mbps
+        simtime_t delay = myHostRef->pos.distance(h->pos) / LIGHT_SPEED;
 
-            if (h->channel == msg->getChannelNumber())
-            {
-                coreEV << "sending message to host listening on the same channel\n";
-                // account for propagation delay, based on distance in meters
-                // Over 300m, dt=1us=10 bit times @ 10Mbps
-                sendDirect((cMessage *)msg->dup(), myHostRef->pos.distance(h->pos) / LIGHT_SPEED, msg->getDuration(), mod, radioGate->getId() + i);
-            }
-            else
-                coreEV << "skipping host listening on a different channel\n";
-        }
+        // Each receiver gets its own copy of the AirFrame, but the copies
+        // share the encapsulated frame (cPacket reference-counts it); a
+        // receiver only gets a private copy of the frame when it accesses
+        // it via getEncapsulatedMsg() or decapsulate().
+        for (int i = 0; i < radioGate->size(); i++)
+            sendDirect((cMessage *)msg->dup(), delay, msg->getDuration(), h->host, radioGate->getId() + i);
     }
 
     // register transmission in ChannelControl
@@ -18,6 +18,7 @@
 #include "ChannelControl.h"
 #include "FWMath.h"
 #include <cassert>
+#include <algorithm>
 
 
 #define coreEV (ev.isDisabled()||!coreDebug) ? ev : ev << "ChannelControl: "
@@ -41,6 +42,8 @@ std::ostream& operator<<(std::ostream& os, const ChannelControl::TransmissionLis
 
 ChannelControl::ChannelControl()
 {
+    gridSizeX = gridSizeY = 0;
+    gridCellSize = 0;
 }
 
 ChannelControl::~ChannelControl()
@@ -82,6 +85,8 @@ void ChannelControl::initialize()
 
     maxInterferenceDistance = calcInterfDist();
 
+    initGrid();
+
     WATCH(maxInterferenceDistance);
     WATCH_LIST(hosts);
     WATCH_VECTOR(transmissions);
@@ -136,6 +141,68 @@ double ChannelControl::calcInterfDist()
     return interfDistance;
 }
 
+void ChannelControl::initGrid()
+{
+    // cells must not be smaller than the interference distance; also limit
+    // the number of cells, in case the interference distance is very small
+    // compared to the playground
+    gridCellSize = maxInterferenceDistance;
+    if (!(gridCellSize > 0) || gridCellSize > std::max(playgroundSize.x, playgroundSize.y))
+        gridCellSize = std::max(std::max(playgroundSize.x, playgroundSize.y), 1.0);
+    while ((playgroundSize.x / gridCellSize + 1) * (playgroundSize.y / gridCellSize + 1) > MAX_GRID_CELLS)
+        gridCellSize *= 2;
+
+    gridSizeX = std::max(1, (int)ceil(playgroundSize.x / gridCellSize));
+    gridSizeY = std::max(1, (int)ceil(playgroundSize.y / gridCellSize));
+    grid.clear();
+    grid.resize(gridSizeX * gridSizeY);
+
+    // hosts may have registered before we got initialized (e.g. when
+    // channelcontrol is declared after them in the network); file them now
+    for (HostList::iterator it = hosts.begin(); it != hosts.end(); ++it)
+        addToGrid(&(*it));
+
+    coreEV << "using a grid of " << gridSizeX << "x" << gridSizeY << " cells of size " << gridCellSize << endl;
+}
+
+void ChannelControl::getGridCellCoords(const Coord& pos, int& cx, int& cy) const
+{
+    cx = (int)floor(pos.x / gridCellSize);
+    cy = (int)floor(pos.y / gridCellSize);
+    cx = std::min(std::max(cx, 0), gridSizeX - 1);
+    cy = std::min(std::max(cy, 0), gridSizeY - 1);
+}
+
+void ChannelControl::addToGrid(HostRef h)
+{
+    // grid not set up yet: initGrid() will file the host
+    if (grid.empty())
+    {
+        h->gridCell = h->gridCellSlot = -1;
+        return;
+    }
+
+    int cx, cy;
+    getGridCellCoords(h->pos, cx, cy);
+    GridCell& cell = grid[cy * gridSizeX + cx];
+    h->gridCell = cy * gridSizeX + cx;
+    h->gridCellSlot = cell.size();
+    cell.push_back(h);
+}
+
+void ChannelControl::removeFromGrid(HostRef h)
+{
+    if (h->gridCell < 0)
+        return;
+
+    // move the last host of the cell into the vacated slot
+    GridCell& cell = grid[h->gridCell];
+    HostRef last = cell.back();
+    cell[h->gridCellSlot] = last;
+    last->gridCellSlot = h->gridCellSlot;
+    cell.pop_back();
+}
+
 ChannelControl::HostRef ChannelControl::registerHost(cModule * host, const Coord& initialPos)
 {
     Enter_Method_Silent();
@@ -147,10 +214,14 @@ ChannelControl::HostRef ChannelControl::registerHost(cModule * host, const Coord
     he.host = host;
     he.pos = initialPos;
     he.isModuleListValid = false;
+    he.radioInGate = NULL;
+    he.posEpoch = 0;
     // TODO: get it from caller
     he.channel = 0;
     hosts.push_back(he);
-    return &hosts.back(); // last element
+    HostRef h = &hosts.back(); // last element
+    addToGrid(h);
+    return h;
 }
 
 ChannelControl::HostRef ChannelControl::lookupHost(cModule *host)
@@ -168,43 +239,66 @@ const ChannelControl::ModuleList& ChannelControl::getNeighbors(HostRef h)
     if (!h->isModuleListValid)
     {
         h->neighborModules.clear();
-        for (std::set<HostRef>::const_iterator it = h->neighbors.begin(); it != h->neighbors.end(); it++)
+        for (HostRefSet::const_iterator it = h->neighbors.begin(); it != h->neighbors.end(); it++)
             h->neighborModules.push_back((*it)->host);
         h->isModuleListValid = true;
     }
     return h->neighborModules;
 }
 
+cGate *ChannelControl::getRadioInGate(HostRef h)
+{
+    if (h->radioInGate == NULL)
+    {
+        h->radioInGate = h->host->gate("radioIn");
+        if (h->radioInGate == NULL)
+            error("module %s must have a gate called radioIn", h->host->getFullPath().c_str());
+    }
+    return h->radioInGate;
+}
+
 void ChannelControl::updateConnections(HostRef h)
 {
     Coord& hpos = h->pos;
     double maxDistSquared = maxInterferenceDistance * maxInterferenceDistance;
-    for (HostList::iterator it = hosts.begin(); it != hosts.end(); ++it)
+
+    // out of range: disconnect. Only current neighbors need to be checked.
+    // (omitting the square root (calling sqrdist() instead of distance()) saves about 5% CPU)
+    for (HostRefSet::iterator it = h->neighbors.begin(); it != h->neighbors.end(); )
     {
-        HostEntry *hi = &(*it);
-        if (hi == h)
+        HostEntry *hi = *it;
+        if (hpos.sqrdist(hi->pos) < maxDistSquared)
+        {
+            ++it;
             continue;
+        }
+        h->neighbors.erase(it++);
+        hi->neighbors.erase(h);
+        h->isModuleListValid = hi->isModuleListValid = false;
+    }
 
-        // get the distance between the two hosts.
-        // (omitting the square root (calling sqrdist() instead of distance()) saves about 5% CPU)
-        bool inRange = hpos.sqrdist(hi->pos) < maxDistSquared;
+    if (grid.empty())
+        return;
 
-        if (inRange)
-        {
-            // nodes within communication range: connect
-            if (h->neighbors.insert(hi).second == true)
-            {
-                hi->neighbors.insert(h);
-                h->isModuleListValid = hi->isModuleListValid = false;
-            }
-        }
-        else
+    // nodes within communication range: connect. These can only be
+    // in the host's grid cell or in the ones around it
+    int cx, cy;
+    getGridCellCoords(hpos, cx, cy);
+    for (int y = std::max(cy - 1, 0); y <= std::min(cy + 1, gridSizeY - 1); y++)
+    {
+        for (int x = std::max(cx - 1, 0); x <= std::min(cx + 1, gridSizeX - 1); x++)
         {
-            // out of range: disconnect
-            if (h->neighbors.erase(hi))
+            const GridCell& cell = grid[y * gridSizeX + x];
+            for (GridCell::const_iterator it = cell.begin(); it != cell.end(); ++it)
             {
-                hi->neighbors.erase(h);
-                h->isModuleListValid = hi->isModuleListValid = false;
+                HostEntry *hi = *it;
+                if (hi == h || hpos.sqrdist(hi->pos) >= maxDistSquared)
+                    continue;
+                if (h->neighbors.insert(hi).second == true)
+                {
+                    hi->neighbors.insert(h);
+                    h->isModuleListValid = hi->isModuleListValid = false;
+                }
             }
         }
     }
@@ -219,7 +313,10 @@ void ChannelControl::checkChannel(const int channel)
 void ChannelControl::updateHostPosition(HostRef h, const Coord& pos)
 {
     Enter_Method_Silent();
+    removeFromGrid(h);
     h->pos = pos;
+    h->posEpoch++;
+    addToGrid(h);
     updateConnections(h);
 }
 
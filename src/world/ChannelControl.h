@@ -27,6 +27,7 @@
 
 #define LIGHT_SPEED 3.0E+8
 #define TRANSMISSION_PURGE_INTERVAL 1.0
+#define MAX_GRID_CELLS 1000000
 
 /**
  * @brief Monitors which hosts are "in range". Supports multiple channels.
@@ -45,6 +46,7 @@ class INET_API ChannelControl : public cSimpleModule
     typedef HostEntry *HostRef; // handle for ChannelControl's clients
     typedef std::vector<cModule*> ModuleList;
     typedef std::list<AirFrame*> TransmissionList;
+    typedef std::set<HostRef> HostRefSet;
 
   protected:
     /**
@@ -55,15 +57,30 @@ class INET_API ChannelControl : public cSimpleModule
     struct HostEntry {
         cModule *host;
         Coord pos; // cached
-        std::set<HostRef> neighbors;  // cached neighbour list
+        HostRefSet neighbors;  // cached neighbour list
         // TODO: use ChannelAccess vector instead
         int channel;
 
         bool isModuleListValid;  // "neighborModules" is produced from "neighbors" on demand
         ModuleList neighborModules; // derived from "neighbors"
+        cGate *radioInGate;  // the host's "radioIn" gate; looked up on first use
+        unsigned int posEpoch;  // incremented whenever the host moves
+
+        int gridCell;      // index of the grid cell the host is in
+        int gridCellSlot;  // position of the host within that cell
     };
     HostList hosts;
 
+    /** @brief Uniform grid over the playground, for finding the hosts near a position.
+     * Cells are at least maxInterferenceDistance wide, so hosts within range of each
+     * other are always in the same or in adjacent cells. Hosts outside the playground
+     * are filed under the nearest border cell.
+     */
+    typedef std::vector<HostRef> GridCell;
+    std::vector<GridCell> grid;
+    int gridSizeX, gridSizeY;
+    double gridCellSize;
+
     /** @brief keeps track of ongoing transmissions; this is needed when a host
      * switches to another channel (then it needs to know whether the target channel
      * is empty or busy)
@@ -92,6 +109,18 @@ class INET_API ChannelControl : public cSimpleModule
   protected:
     virtual void updateConnections(HostRef h);
 
+    /** @brief Sets up the grid according to playgroundSize and maxInterferenceDistance, and files the hosts registered so far */
+    virtual void initGrid();
+
+    /** @brief Returns the coordinates of the grid cell containing the given position */
+    void getGridCellCoords(const Coord& pos, int& cx, int& cy) const;
+
+    /** @brief Files the host under the grid cell of its current position */
+    void addToGrid(HostRef h);
+
+    /** @brief Removes the host from its grid cell */
+    void removeFromGrid(HostRef h);
+
     /** @brief Calculate interference distance*/
     virtual double calcInterfDist();
 
@@ -135,9 +164,18 @@ class INET_API ChannelControl : public cSimpleModule
     /** @brief Returns the host's position */
     const Coord& getHostPosition(HostRef h)  {return h->pos;}
 
+    /** @brief Returns a counter that changes whenever the host's position is updated */
+    unsigned int getHostPositionEpoch(HostRef h)  {return h->posEpoch;}
+
     /** @brief Get the list of modules in range of the given host */
     const ModuleList& getNeighbors(HostRef h);
 
+    /** @brief Get the hosts in range of the given host */
+    const HostRefSet& getNeighborHosts(HostRef h)  {return h->neighbors;}
+
+    /** @brief Returns the "radioIn" gate of the given host */
+    cGate *getRadioInGate(HostRef h);
+
     /** @brief Reads init parameters and calculates a maximal interference distance*/
     virtual double getCommunicationRange(HostRef h) {
         return maxInterferenceDistance;
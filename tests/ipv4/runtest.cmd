@@ -16,7 +16,7 @@ call opp_test -g -v %TESTFILES% || goto end
 
 cd work || goto end
 set root=..\..\..
-call opp_nmakemake -f -N -w -u cmdenv -c %root%\inetconfig.vc -I%root%\Network\IPv4 -I%root%\Network\IPv4\Core -I%root%\Base -I%root%\Util || goto end
+call opp_nmakemake -f -N -w -u cmdenv -c %root%\inetconfig.vc -I%root%\Network\IPv4 -I%root%\Network\IPv4\Core -I%root%\Base -I%root%\Util -I%root%\src\util\headerserializers -I%root%\src\base -I%root%\src\networklayer\ipv4 -I%root%\src\networklayer\contract -I%root%\src\networklayer\common -I%root%\src\linklayer\contract || goto end
 nmake -f makefile.vc || cd .. && goto end
 cd .. || goto end
 
@@ -16,7 +16,7 @@ call opp_test -N -g -v %TESTFILES% || goto end
 
 cd work || goto end
 set root=..\..\..
-call opp_nmakemake -f -N -w -u cmdenv -c %root%\inetconfig.vc -I%root%\Network\Contract -I%root%\Network\IPv6 -I%root%\Base -I%root%\Util -I%root%\Network\ICMPv6 -I%root%\NetworkInterfaces\Contract || goto end
+call opp_nmakemake -f -N -w -u cmdenv -c %root%\inetconfig.vc -I%root%\Network\Contract -I%root%\Network\IPv6 -I%root%\Base -I%root%\Util -I%root%\Network\ICMPv6 -I%root%\NetworkInterfaces\Contract -I%root%\src\util\headerserializers -I%root%\src\base -I%root%\src\networklayer\contract -I%root%\src\networklayer\common -I%root%\src\networklayer\ipv6 -I%root%\src\networklayer\icmpv6 -I%root%\src\networklayer\xmipv6 -I%root%\src\linklayer\contract -I%root%\src\transport\udp -I%root%\src\applications\pingapp || goto end
 nmake -f makefile.vc || cd .. && goto end
 cd .. || goto end
 
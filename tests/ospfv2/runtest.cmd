@@ -0,0 +1,29 @@
+@echo off
+rem
+rem usage: runtest [<testfile>...]
+rem without args, runs all *.test files in the current directory
+rem uncomment opp_test line with -N to test with dynamic NED loading
+rem
+
+set TESTFILES=%*
+if "x%TESTFILES%" == "x" set TESTFILES=*.test
+
+path %~dp0\..\bin;%PATH%
+mkdir work 2>nul
+del work\work.exe 2>nul
+
+call opp_test -g -v %TESTFILES% || goto end
+
+cd work || goto end
+set root=..\..\..
+call opp_nmakemake -f -N -w -u cmdenv -c %root%\inetconfig.vc -I%root%\src\networklayer\ospfv2 -I%root%\src\networklayer\ospfv2\router -I%root%\src\networklayer\ospfv2\interface -I%root%\src\networklayer\ospfv2\neighbor -I%root%\src\networklayer\ospfv2\messagehandler -I%root%\src\networklayer\ipv4 -I%root%\src\networklayer\contract -I%root%\src\networklayer\common -I%root%\src\linklayer\contract -I%root%\src\base || goto end
+nmake -f makefile.vc || cd .. && goto end
+cd .. || goto end
+
+call opp_test -r -v %TESTFILES% || goto end
+:# call opp_test -N -r -v %TESTFILES% || goto end
+
+echo.
+echo Results can be found in work/
+
+:end
\ No newline at end of file